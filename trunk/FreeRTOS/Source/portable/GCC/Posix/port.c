@@ -0,0 +1,293 @@
+/*
+    FreeRTOS V7.4.0 port for POSIX hosts (Linux, gcc)
+
+    Used by the MIOS32 host build (MIOS32_FAMILY=HOST, see
+    mios32/HOST/README.txt).  See portmacro.h for an overview.
+*/
+
+/*-----------------------------------------------------------
+ * Implementation of functions defined in portable.h for the POSIX port.
+ *----------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <signal.h>
+#include <ucontext.h>
+#include <time.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* The host context of a task.  A pointer to it is stored at the top of the
+FreeRTOS stack, so that it can be found via pxCurrentTCB->pxTopOfStack. */
+typedef struct
+{
+	ucontext_t xContext;
+	pdTASK_CODE pxCode;
+	void *pvParameters;
+	unsigned portBASE_TYPE uxCriticalNesting;
+	void *pvStack;
+} xHostTask;
+
+/* The first member of the TCB is pxTopOfStack. */
+extern void * volatile pxCurrentTCB;
+#define prvCurrentHostTask()	( *( xHostTask ** ) ( *( portSTACK_TYPE ** ) pxCurrentTCB ) )
+
+/* Each task maintains its own critical nesting count, it's swapped on each
+context switch. */
+static unsigned portBASE_TYPE uxCriticalNesting = 0;
+
+/* Set by portDISABLE_INTERRUPTS(), ticks are deferred while set. */
+static volatile unsigned long ulInterruptsMasked = pdTRUE;
+
+/* Set while the port switches the context, ticks are deferred while set. */
+static volatile sig_atomic_t xSwitchingContext = pdFALSE;
+
+/* Set if a tick had to be deferred. */
+static volatile sig_atomic_t xTickPending = pdFALSE;
+
+/* Context of xPortStartScheduler(), resumed by vPortEndScheduler(). */
+static ucontext_t xSchedulerContext;
+
+/* Timer of the tick slice.  A real time clock is used, since CPU time timers
+only have the resolution of the kernel tick. */
+static timer_t xTickSliceTimer;
+
+/*
+ * Entry point of all tasks, calls the task function.
+ */
+static void prvTaskStart( void );
+
+/*
+ * Increments the tick and selects the next task.
+ */
+static void prvTick( void );
+
+/*
+ * Processes a deferred tick once ticks are allowed again.
+ */
+static void prvCheckPendingTick( void );
+
+/*
+ * Restarts the time slice after which the simulated clock is forced to
+ * advance.
+ */
+static void prvRestartTickSlice( void );
+
+/*
+ * SIGALRM handler: the running code exceeded the tick slice.
+ */
+static void prvTickSliceHandler( int iSignal );
+
+/*-----------------------------------------------------------*/
+
+/*
+ * See header file for description.
+ */
+portSTACK_TYPE *pxPortInitialiseStack( portSTACK_TYPE *pxTopOfStack, pdTASK_CODE pxCode, void *pvParameters )
+{
+xHostTask *pxHostTask;
+
+	pxHostTask = ( xHostTask * ) malloc( sizeof( xHostTask ) );
+	configASSERT( pxHostTask );
+	pxHostTask->pvStack = malloc( portHOST_TASK_STACK_SIZE );
+	configASSERT( pxHostTask->pvStack );
+
+	pxHostTask->pxCode = pxCode;
+	pxHostTask->pvParameters = pvParameters;
+	pxHostTask->uxCriticalNesting = 0;
+
+	getcontext( &( pxHostTask->xContext ) );
+	pxHostTask->xContext.uc_stack.ss_sp = pxHostTask->pvStack;
+	pxHostTask->xContext.uc_stack.ss_size = portHOST_TASK_STACK_SIZE;
+	pxHostTask->xContext.uc_link = NULL;
+	sigdelset( &( pxHostTask->xContext.uc_sigmask ), SIGALRM );
+	makecontext( &( pxHostTask->xContext ), prvTaskStart, 0 );
+
+	*pxTopOfStack = ( portSTACK_TYPE ) pxHostTask;
+
+	return pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+void vPortCleanUpTCB( void *pxTCB )
+{
+xHostTask *pxHostTask = *( xHostTask ** ) ( *( portSTACK_TYPE ** ) pxTCB );
+
+	/* Deleted tasks are cleaned up by the idle task, so the stack isn't in
+	use anymore. */
+	free( pxHostTask->pvStack );
+	free( pxHostTask );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTaskStart( void )
+{
+xHostTask *pxHostTask = prvCurrentHostTask();
+
+	xSwitchingContext = pdFALSE;
+	prvCheckPendingTick();
+
+	pxHostTask->pxCode( pxHostTask->pvParameters );
+
+	/* Tasks must not return. */
+	configASSERT( 0 );
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * See header file for description.
+ */
+portBASE_TYPE xPortStartScheduler( void )
+{
+struct sigaction xAction;
+struct sigevent xEvent;
+
+	xAction.sa_handler = prvTickSliceHandler;
+	xAction.sa_flags = SA_RESTART;
+	sigemptyset( &xAction.sa_mask );
+	sigaction( SIGALRM, &xAction, NULL );
+
+	xEvent.sigev_notify = SIGEV_SIGNAL;
+	xEvent.sigev_signo = SIGALRM;
+	xEvent.sigev_value.sival_ptr = NULL;
+	timer_create( CLOCK_MONOTONIC, &xEvent, &xTickSliceTimer );
+
+	uxCriticalNesting = 0;
+	ulInterruptsMasked = pdFALSE;
+	prvRestartTickSlice();
+
+	/* Start the first task. */
+	xSwitchingContext = pdTRUE;
+	swapcontext( &xSchedulerContext, &( prvCurrentHostTask()->xContext ) );
+
+	/* Only reached from vPortEndScheduler(). */
+	timer_delete( xTickSliceTimer );
+	xSwitchingContext = pdFALSE;
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+	xSwitchingContext = pdTRUE;
+	setcontext( &xSchedulerContext );
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+xHostTask *pxPrevious, *pxNext;
+
+	xSwitchingContext = pdTRUE;
+
+	pxPrevious = prvCurrentHostTask();
+	vTaskSwitchContext();
+	pxNext = prvCurrentHostTask();
+
+	if( pxNext != pxPrevious )
+	{
+		pxPrevious->uxCriticalNesting = uxCriticalNesting;
+		swapcontext( &( pxPrevious->xContext ), &( pxNext->xContext ) );
+
+		/* Resumed. */
+		uxCriticalNesting = pxPrevious->uxCriticalNesting;
+	}
+
+	xSwitchingContext = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimulatedTick( void )
+{
+	xTickPending = pdTRUE;
+	prvCheckPendingTick();
+}
+/*-----------------------------------------------------------*/
+
+static void prvTick( void )
+{
+	xTickPending = pdFALSE;
+	prvRestartTickSlice();
+
+	/* Like the SysTick handler of the target: no other tick while the tick
+	is processed. */
+	ulInterruptsMasked = pdTRUE;
+	vTaskIncrementTick();
+	xSwitchingContext = pdTRUE;
+	ulInterruptsMasked = pdFALSE;
+
+	/* Preemption: continue with the highest priority task. */
+	vPortYield();
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckPendingTick( void )
+{
+	if( xTickPending && uxCriticalNesting == 0 && !ulInterruptsMasked && !xSwitchingContext && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING )
+	{
+		prvTick();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRestartTickSlice( void )
+{
+struct itimerspec xTimer;
+
+	xTimer.it_interval.tv_sec = 0;
+	xTimer.it_interval.tv_nsec = portHOST_TICK_SLICE_US * 1000;
+	xTimer.it_value = xTimer.it_interval;
+	timer_settime( xTickSliceTimer, 0, &xTimer, NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTickSliceHandler( int iSignal )
+{
+	( void ) iSignal;
+
+	xTickPending = pdTRUE;
+
+	/* The tick (and the context switch) is only processed immediately if the
+	interrupted code isn't in a critical section.  Otherwise it's processed
+	when the critical section is left, or with the next signal. */
+	prvCheckPendingTick();
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+	uxCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+	uxCriticalNesting--;
+	if( uxCriticalNesting == 0 )
+	{
+		prvCheckPendingTick();
+	}
+}
+/*-----------------------------------------------------------*/
+
+unsigned long ulPortSetInterruptMask( void )
+{
+unsigned long ulPrevious = ulInterruptsMasked;
+
+	ulInterruptsMasked = pdTRUE;
+	return ulPrevious;
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( unsigned long ulNewMaskValue )
+{
+	ulInterruptsMasked = ulNewMaskValue;
+	if( !ulNewMaskValue && uxCriticalNesting == 0 )
+	{
+		prvCheckPendingTick();
+	}
+}
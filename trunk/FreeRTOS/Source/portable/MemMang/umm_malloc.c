@@ -572,7 +572,10 @@ UMM_H_ATTPACKPRE typedef struct umm_block_t {
 
   #define umm_free    vPortFree
   #define umm_malloc  pvPortMalloc
+#if !defined(MIOS32_FAMILY_HOST)
+  // on the host, realloc() belongs to the C library which has its own heap
   #define umm_realloc realloc
+#endif
 
 #if defined(MIOS32_FAMILY_LPC17xx) && !defined(UMM_HEAP_SECTION)
 # define UMM_HEAP_SECTION __attribute__ ((section (".bss_ahb")))
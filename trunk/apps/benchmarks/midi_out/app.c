@@ -41,6 +41,7 @@ volatile u8 print_msg;
 
 static u32 benchmark_cycles;
 static u8 tested_port;
+static u8 tested_batched;
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -143,6 +144,7 @@ void APP_MIDI_NotifyPackage(mios32_midi_port_t port, mios32_midi_package_t midi_
 
     // determine test number (use note number, remove octave)
     u8 test_number = midi_package.note % 12;
+    tested_batched = 0;
 
     // set the tested port and RS optimisation
     switch( test_number ) {
@@ -197,6 +199,20 @@ void APP_MIDI_NotifyPackage(mios32_midi_port_t port, mios32_midi_package_t midi_
 	MIOS32_MIDI_SendDebugMessage("Testing Port 0x%02x (SPI0)\n", tested_port);
 	break;
 
+      case 9:
+	tested_port = USB0;
+	tested_batched = 1;
+	MIOS32_MIDI_RS_OptimisationSet(tested_port, 0);
+	MIOS32_MIDI_SendDebugMessage("Testing Port 0x%02x (USB0) with MIOS32_MIDI_SendPackages\n", tested_port);
+	break;
+
+      case 10:
+	tested_port = UART0;
+	tested_batched = 1;
+	MIOS32_MIDI_RS_OptimisationSet(tested_port, 1);
+	MIOS32_MIDI_SendDebugMessage("Testing Port 0x%02x (UART0) with RS enabled and MIOS32_MIDI_SendPackages\n", tested_port);
+	break;
+
 
       default:
 	MIOS32_MIDI_SendDebugMessage("This note isn't mapped to a test function.\n", tested_port);
@@ -206,6 +222,10 @@ void APP_MIDI_NotifyPackage(mios32_midi_port_t port, mios32_midi_package_t midi_
     // add some delay to ensure that there a no USB background traffic caused by the debug message
     MIOS32_DELAY_Wait_uS(50000);
 
+    // the Tx callback is only required for OSC
+    // (otherwise MIOS32_MIDI_SendPackages would forward each package individually to the callback)
+    MIOS32_MIDI_DirectTxCallback_Init((tested_port >= 0xf0) ? NOTIFY_MIDI_Tx : NULL);
+
     // reset benchmark
     BENCHMARK_Reset();
 
@@ -218,7 +238,10 @@ void APP_MIDI_NotifyPackage(mios32_midi_port_t port, mios32_midi_package_t midi_
     MIOS32_STOPWATCH_Reset();
 
     // start benchmark
-    BENCHMARK_Start(tested_port);
+    if( tested_batched )
+      BENCHMARK_StartBatched(tested_port);
+    else
+      BENCHMARK_Start(tested_port);
 
     // capture counter value
     benchmark_cycles = MIOS32_STOPWATCH_ValueGet();
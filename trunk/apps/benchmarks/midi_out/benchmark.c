@@ -20,6 +20,14 @@
 #include "benchmark.h"
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of packages per MIOS32_MIDI_SendPackages call
+#define BURST_SIZE 16
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Initialisation
 /////////////////////////////////////////////////////////////////////////////
@@ -56,3 +64,33 @@ s32 BENCHMARK_Start(mios32_midi_port_t port)
 
   return 0; // no error
 }
+
+/////////////////////////////////////////////////////////////////////////////
+// same events, but sent with MIOS32_MIDI_SendPackages in bursts of 16 packages
+// (e.g. like a sequencer which plays 16 tracks on the same step)
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_StartBatched(mios32_midi_port_t port)
+{
+  mios32_midi_package_t packages[BURST_SIZE];
+  int i, j;
+
+  for(i=0; i<256; i+=BURST_SIZE) {
+    for(j=0; j<BURST_SIZE; ++j) {
+      u8 note = (i+j) & 0x7f;
+      packages[j].ALL = 0;
+      packages[j].type = NoteOn;
+      packages[j].event = NoteOn;
+      packages[j].chn = Chn16;
+      packages[j].note = note;
+      packages[j].velocity = (i < 128) ? 0x7f : 0x00;
+    }
+
+    MIOS32_MIDI_SendPackages(port, packages, BURST_SIZE);
+  }
+
+  // if UART: wait until all bytes transmitted
+  if( (port & 0xf0) == UART0 )
+    while( MIOS32_UART_TxBufferUsed(port&0xf) );
+
+  return 0; // no error
+}
@@ -32,6 +32,7 @@ extern s32 BENCHMARK_Init(u32 mode);
 
 extern s32 BENCHMARK_Reset(void);
 extern s32 BENCHMARK_Start(mios32_midi_port_t port);
+extern s32 BENCHMARK_StartBatched(mios32_midi_port_t port);
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,233 @@
+// $Id$
+/*
+ * Benchmark for the MIDI router
+ * See README.txt for details
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <midi_router.h>
+#include "benchmark.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+#define NUM_IN_PORTS  16
+#define NUM_OUT_PORTS 12
+
+// size of the SysEx dump, incl. F0 and F7
+#define SYSEX_DUMP_SIZE 8192
+
+// port which receives the SysEx dump
+#define SYSEX_DUMP_PORT UART0
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////////////////////////////////
+
+static const mios32_midi_port_t in_ports[NUM_IN_PORTS] = {
+  USB0, USB1, USB2, USB3,
+  UART0, UART1, UART2, UART3,
+  IIC0, IIC1, IIC2, IIC3,
+  OSC0, OSC1, OSC2, OSC3,
+};
+
+// OSC destinations are not used, since the OSC client would send UDP packets
+static const mios32_midi_port_t out_ports[NUM_OUT_PORTS] = {
+  USB0, USB1, USB2, USB3,
+  UART0, UART1, UART2, UART3,
+  IIC0, IIC1, IIC2, IIC3,
+};
+
+static u32 num_received;
+static u32 num_forwarded;
+
+static u8 sysex_dump[SYSEX_DUMP_SIZE];
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Initialisation
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_Init(u32 mode)
+{
+  // SysEx dump with a foreign header, so that it's ignored by the MIOS32 SysEx parser
+  int i;
+  sysex_dump[0] = 0xf0;
+  sysex_dump[1] = 0x00;
+  sysex_dump[2] = 0x00;
+  sysex_dump[3] = 0x7e;
+  sysex_dump[4] = 0x4b;
+  for(i=5; i<(SYSEX_DUMP_SIZE-1); ++i)
+    sysex_dump[i] = i & 0x7f;
+  sysex_dump[SYSEX_DUMP_SIZE-1] = 0xf7;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Installed with MIOS32_MIDI_DirectTxCallback_Init() during the benchmark:
+// forwarded packages are only counted, so that the interface drivers
+// are not part of the measurement
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_TxCallback(mios32_midi_port_t port, mios32_midi_package_t package)
+{
+  ++num_forwarded;
+
+  return 1; // filter package
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Results
+/////////////////////////////////////////////////////////////////////////////
+u32 BENCHMARK_NumReceivedGet(void)
+{
+  return num_received;
+}
+
+u32 BENCHMARK_NumForwardedGet(void)
+{
+  return num_forwarded;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Node setups
+/////////////////////////////////////////////////////////////////////////////
+
+// each node listens to a different input port
+s32 BENCHMARK_Reset_AllPorts(u32 par)
+{
+  int node;
+  midi_router_node_entry_t *n = (midi_router_node_entry_t *)&midi_router_node[0];
+  for(node=0; node<MIDI_ROUTER_NUM_NODES; ++node, ++n) {
+    n->src_port = in_ports[node % NUM_IN_PORTS];
+    n->src_chn = (node & 1) ? 17 : (1 + (node % 16)); // all channels or a dedicated channel
+    n->dst_port = out_ports[(node+1) % NUM_OUT_PORTS];
+    n->dst_chn = ((node & 3) == 3) ? (1 + (node % 16)) : 17; // channel remapped or kept
+  }
+
+  MIDI_ROUTER_Init(0);
+
+  num_received = 0;
+  num_forwarded = 0;
+
+  return 0; // no error
+}
+
+// all nodes listen to USB0 (e.g. a layer/split setup)
+s32 BENCHMARK_Reset_SamePort(u32 par)
+{
+  int node;
+  midi_router_node_entry_t *n = (midi_router_node_entry_t *)&midi_router_node[0];
+  for(node=0; node<MIDI_ROUTER_NUM_NODES; ++node, ++n) {
+    n->src_port = USB0;
+    n->src_chn = (node & 1) ? 17 : (1 + (node % 16));
+    n->dst_port = out_ports[(node+1) % NUM_OUT_PORTS];
+    n->dst_chn = ((node & 3) == 3) ? (1 + (node % 16)) : 17;
+  }
+
+  MIDI_ROUTER_Init(0);
+
+  num_received = 0;
+  num_forwarded = 0;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Benchmarks
+/////////////////////////////////////////////////////////////////////////////
+
+// a Note On event for each channel of each input port
+s32 BENCHMARK_Start_Channel(u32 par)
+{
+  mios32_midi_package_t p;
+  p.ALL = 0;
+  p.type = NoteOn;
+  p.event = NoteOn;
+  p.note = 0x3c;
+  p.velocity = 0x7f;
+
+  int port_ix;
+  for(port_ix=0; port_ix<NUM_IN_PORTS; ++port_ix) {
+    int chn;
+    for(chn=0; chn<16; ++chn) {
+      p.chn = chn;
+      MIDI_ROUTER_Receive(in_ports[port_ix], p);
+    }
+  }
+
+  num_received += NUM_IN_PORTS*16;
+
+  return 0; // no error
+}
+
+// a large SysEx dump, received like from a USB MIDI interface
+// the SysEx callback has to be installed before (see APP_SYSEX_Parser and APP_SYSEX_SpanParser)
+s32 BENCHMARK_Start_SysEx(u32 par)
+{
+  mios32_midi_package_t p;
+  u8 *ptr = sysex_dump;
+  u32 len = SYSEX_DUMP_SIZE;
+
+  while( len ) {
+    p.ALL = 0;
+    if( len > 3 ) {
+      p.type = 0x4; // SysEx starts or continues
+      p.evnt0 = ptr[0];
+      p.evnt1 = ptr[1];
+      p.evnt2 = ptr[2];
+      ptr += 3;
+      len -= 3;
+    } else {
+      p.type = 0x5 + len - 1; // SysEx ends with 1..3 bytes
+      p.evnt0 = ptr[0];
+      if( len >= 2 ) p.evnt1 = ptr[1];
+      if( len >= 3 ) p.evnt2 = ptr[2];
+      len = 0;
+    }
+
+    MIOS32_MIDI_ReceivePackage(SYSEX_DUMP_PORT, p, NULL);
+    ++num_received;
+  }
+
+  return 0; // no error
+}
+
+// 16 MIDI clock events for each input port
+s32 BENCHMARK_Start_Realtime(u32 par)
+{
+  mios32_midi_package_t p;
+  p.ALL = 0;
+  p.type = 0x5; // Single-byte system common message
+  p.evnt0 = 0xf8;
+
+  int port_ix;
+  for(port_ix=0; port_ix<NUM_IN_PORTS; ++port_ix) {
+    int i;
+    for(i=0; i<16; ++i) {
+      MIDI_ROUTER_Receive(in_ports[port_ix], p);
+    }
+  }
+
+  num_received += NUM_IN_PORTS*16;
+
+  return 0; // no error
+}
@@ -0,0 +1,50 @@
+// $Id$
+/*
+ * Header file for benchmark routines
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+/////////////////////////////////////////////////////////////////////////////
+// Global definitions
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global Types
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+extern s32 BENCHMARK_Init(u32 mode);
+
+extern s32 BENCHMARK_TxCallback(mios32_midi_port_t port, mios32_midi_package_t package);
+extern u32 BENCHMARK_NumReceivedGet(void);
+extern u32 BENCHMARK_NumForwardedGet(void);
+
+extern s32 BENCHMARK_Reset_AllPorts(u32 par);
+extern s32 BENCHMARK_Reset_SamePort(u32 par);
+
+extern s32 BENCHMARK_Start_Channel(u32 par);
+extern s32 BENCHMARK_Start_Realtime(u32 par);
+extern s32 BENCHMARK_Start_SysEx(u32 par);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Export global variables
+/////////////////////////////////////////////////////////////////////////////
+
+
+#endif /* _BENCHMARK_H */
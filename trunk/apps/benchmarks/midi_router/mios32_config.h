@@ -0,0 +1,27 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file
+ *
+ * this file allows to disable (or re-configure) default functions of MIOS32
+ * available switches are listed in $MIOS32_PATH/modules/mios32/MIOS32_CONFIG.txt
+ *
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+// The boot message which is print during startup and returned on a SysEx query
+#define MIOS32_LCD_BOOT_MSG_LINE1 "MIDI Router Benchmark"
+#define MIOS32_LCD_BOOT_MSG_LINE2 "(c) 2012 T.Klose"
+
+
+// routing method which should be measured (see midi_router.h)
+// 0: all nodes are checked for each package, one mutex take per destination
+// 1: routing table, one mutex take per package
+#define MIDI_ROUTER_USE_TABLE 1
+
+
+// function used to output debug messages (must be printf compatible!)
+#define DEBUG_MSG MIOS32_MIDI_SendDebugMessage
+
+#endif /* _MIOS32_CONFIG_H */
@@ -69,6 +69,8 @@ void APP_Init(void)
   MIOS32_MIDI_SendDebugMessage("Settings:\n");
   MIOS32_MIDI_SendDebugMessage("#define SEQ_MIDI_OUT_MALLOC_METHOD %d\n", SEQ_MIDI_OUT_MALLOC_METHOD);
   MIOS32_MIDI_SendDebugMessage("#define SEQ_MIDI_OUT_MAX_EVENTS %d\n", SEQ_MIDI_OUT_MAX_EVENTS);
+  MIOS32_MIDI_SendDebugMessage("#define SEQ_MIDI_OUT_QUEUE_METHOD %d\n", SEQ_MIDI_OUT_QUEUE_METHOD);
+  MIOS32_MIDI_SendDebugMessage("#define MID_PARSER_TRACK_CACHE_SIZE %d\n", MID_PARSER_TRACK_CACHE_SIZE);
   MIOS32_MIDI_SendDebugMessage("\n");
   MIOS32_MIDI_SendDebugMessage("Play any MIDI note to start the benchmark\n");
 }
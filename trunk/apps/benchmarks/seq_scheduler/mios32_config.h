@@ -22,6 +22,7 @@
 // 3: internal static allocation with 32bit flags
 // 4: FreeRTOS based pvPortMalloc
 // 5: malloc provided by library
+// 6: internal static allocation with a free slot stack
 #define SEQ_MIDI_OUT_MALLOC_METHOD 3
 
 // max number of scheduled events which will allocate memory
@@ -29,8 +30,16 @@
 // MAX_EVENTS must be a power of two! (e.g. 64, 128, 256, 512, ...)
 #define SEQ_MIDI_OUT_MAX_EVENTS 128
 
+// queue method:
+// 0: sorted linked list
+// 1: binary heap
+#define SEQ_MIDI_OUT_QUEUE_METHOD 0
+
 // enable seq_midi_out_max_allocated and seq_midi_out_dropouts
 #define SEQ_MIDI_OUT_MALLOC_ANALYSIS 1
 
+// read-ahead cache for each track of the MIDI file parser (0: disabled)
+#define MID_PARSER_TRACK_CACHE_SIZE 256
+
 
 #endif /* _MIOS32_CONFIG_H */
@@ -0,0 +1,565 @@
+// $Id$
+/*
+ * Host test for the event pool lookups of MBNG_EVENT
+ *
+ * Builds the default pool and random pools (duplicate IDs and HW IDs,
+ * banks, matrices, "any" key/CC events, NRPNs, forwards, labels), and
+ * changes them with ItemModify, ItemAdd, SelectedBankSet and by deleting
+ * items (PoolClear and adding the remaining items again).
+ * After each step, it checks that
+ *   - MBNG_EVENT_ItemSearchById() and MBNG_EVENT_ItemSearchByHwId()
+ *     (incl. continued searches) return the same items in the same order
+ *     like a search through the pool with MBNG_EVENT_ItemGet()
+ *   - incoming MIDI events notify items; with "-trace" each notification
+ *     and search result is printed
+ *
+ * "make test" builds and runs the test with the index
+ * (MBNG_EVENT_INDEX_MAX_ITEMS=2048), without the index (0) and with an
+ * index which is too small for the larger pools (64), and compares the
+ * traces of all variants.
+ *
+ * With "-bench", lookups in a large pool are timed (host measurement,
+ * not representative for the core).
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include <gnu_test.h>
+
+#include "app.h"
+#include "tasks.h"
+#include "mbng_event.h"
+#include "mbng_patch.h"
+#include "mbng_file_s.h"
+
+#define MAX_ITEMS      400
+#define MAX_STREAM_LEN 8
+#define MAX_LABEL_LEN  16
+
+static u8  print_trace;
+static u32 num_notified;
+
+static void TRACE(const char *format, ...)
+{
+  if( print_trace ) {
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32 stand-ins
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_SendDebugHexDump(const u8 *src, u32 len) { return 0; }
+s32 MIOS32_MIDI_SendSysEx(mios32_midi_port_t port, u8 *stream, u32 count)
+{
+  TRACE("  sysex %02x len %u\n", port, count);
+  return 0;
+}
+s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t package)
+{
+  TRACE("  send %02x %02x %02x %02x\n", port, package.evnt0, package.evnt1, package.evnt2);
+  return 0;
+}
+s32 MIOS32_TIMESTAMP_Get(void) { return 0; }
+s32 MIOS32_AIN_PinGet(u32 pin) { return 0; }
+s32 MIOS32_LCD_TypeIsGLCD(void) { return 0; }
+
+s32 MIDIMON_Print(char *prefix_str, mios32_midi_port_t port, mios32_midi_package_t package, u32 timestamp, u8 filter_sysex) { return 0; }
+s32 AINSER_EnabledSet(u8 module, u8 enabled) { return 0; }
+s32 AINSER_PinGet(u8 module, u8 pin) { return 0; }
+s32 WS2812_LED_SetRGB(u16 led, u8 colour, u8 value) { return 0; }
+s32 WS2812_LED_SetHSV(u16 led, float h, float s, float v) { return 0; }
+float SEQ_BPM_Get(void) { return 120.0; }
+s32 SEQ_BPM_Set(float bpm) { return 0; }
+s32 SCS_DIN_NotifyToggle(u8 pin, u8 depressed) { return 0; }
+s32 SCS_ENC_MENU_NotifyChange(s32 incrementer) { return 0; }
+s32 SCS_NumMenuItemsGet(void) { return 4; }
+
+
+/////////////////////////////////////////////////////////////////////////////
+// stand-ins for the other MIDIbox NG modules
+/////////////////////////////////////////////////////////////////////////////
+u8 debug_verbose_level = DEBUG_VERBOSE_LEVEL_ERROR;
+mbng_patch_cfg_t mbng_patch_cfg;
+mbng_patch_matrix_din_entry_t mbng_patch_matrix_din[MBNG_PATCH_NUM_MATRIX_DIN];
+mbng_patch_matrix_dout_entry_t mbng_patch_matrix_dout[MBNG_PATCH_NUM_MATRIX_DOUT];
+char mbng_file_s_patch_name[MBNG_FILE_S_FILENAME_LEN+1];
+
+void TASKS_LCDSemaphoreTake(void) {}
+void TASKS_LCDSemaphoreGive(void) {}
+void TASKS_MIDIOUTSemaphoreTake(void) {}
+void TASKS_MIDIOUTSemaphoreGive(void) {}
+void TASKS_SDCardSemaphoreTake(void) {}
+void TASKS_SDCardSemaphoreGive(void) {}
+
+static s32 NotifyReceivedValue(const char *name, mbng_event_item_t *item)
+{
+  ++num_notified;
+  TRACE("  %s id %04x hw_id %04x value %d secondary %d pin %d\n",
+	name, item->id, item->hw_id, item->value, item->secondary_value, item->matrix_pin);
+  return 0;
+}
+
+s32 MBNG_DIN_NotifyReceivedValue(mbng_event_item_t *item) { return NotifyReceivedValue("DIN", item); }
+s32 MBNG_DOUT_NotifyReceivedValue(mbng_event_item_t *item) { return NotifyReceivedValue("DOUT", item); }
+s32 MBNG_MATRIX_DIN_NotifyReceivedValue(mbng_event_item_t *item) { return NotifyReceivedValue("MATRIX_DIN", item); }
+s32 MBNG_MATRIX_DOUT_NotifyReceivedValue(mbng_event_item_t *item) { return NotifyReceivedValue("MATRIX_DOUT", item); }
+s32 MBNG_ENC_NotifyReceivedValue(mbng_event_item_t *item) { return NotifyReceivedValue("ENC", item); }
+s32 MBNG_AIN_NotifyReceivedValue(mbng_event_item_t *item) { return NotifyReceivedValue("AIN", item); }
+s32 MBNG_AINSER_NotifyReceivedValue(mbng_event_item_t *item) { return NotifyReceivedValue("AINSER", item); }
+s32 MBNG_MF_NotifyReceivedValue(mbng_event_item_t *item) { return NotifyReceivedValue("MF", item); }
+s32 MBNG_CV_NotifyReceivedValue(mbng_event_item_t *item) { return NotifyReceivedValue("CV", item); }
+s32 MBNG_KB_NotifyReceivedValue(mbng_event_item_t *item) { return NotifyReceivedValue("KB", item); }
+s32 MBNG_RGBLED_NotifyReceivedValue(mbng_event_item_t *item) { return NotifyReceivedValue("RGBLED", item); }
+
+s32 MBNG_AIN_NotifyChange(u32 pin, u32 pin_value, u8 no_midi) { return 0; }
+s32 MBNG_AINSER_NotifyChange(u32 module, u32 pin, u32 pin_value, u8 no_midi) { return 0; }
+s32 MBNG_ENC_NotifyChange(u32 encoder, s32 incrementer) { return 0; }
+s32 MBNG_ENC_FastModeSet(u8 multiplier) { return 0; }
+s32 MBNG_DOUT_Init(u32 mode) { return 0; }
+s32 MBNG_KB_BreakIsMakeSet(mbng_event_item_t *item, u8 value) { return 0; }
+s32 MBNG_CV_PitchRangeSet(mbng_event_item_t *item, u8 range) { return 0; }
+s32 MBNG_CV_PitchSet(mbng_event_item_t *item, s16 value) { return 0; }
+s32 MBNG_CV_TransposeOctaveSet(mbng_event_item_t *item, s8 value) { return 0; }
+s32 MBNG_CV_TransposeSemitonesSet(mbng_event_item_t *item, s8 value) { return 0; }
+s32 MBNG_MATRIX_DOUT_PatternSet_LCMeter(u8 matrix, u8 color, u16 row, u8 meter_value, u8 from_midi) { return 0; }
+s32 MBNG_RGBLED_Init(u32 mode) { return 0; }
+s32 MBNG_RGBLED_RainbowSpeedSet(u8 speed) { return 0; }
+s32 MBNG_RGBLED_RainbowBrightnessSet(u8 brightness) { return 0; }
+s32 MBNG_LCD_CursorSet(u8 lcd, u16 x, u16 y) { return 0; }
+s32 MBNG_LCD_FontInit(char font_name) { return 0; }
+u8 *MBNG_LCD_FontGet(void) { return NULL; }
+s32 MBNG_LCD_PrintChar(char c) { return 0; }
+s32 MBNG_LCD_PrintItemLabel(mbng_event_item_t *item, char *out_buffer, u32 max_len) { return 0; }
+s32 MBNG_FILE_R_ReadRequest(char *filename, u8 section, s16 value, u8 notify_done) { return 0; }
+s32 MBNG_FILE_R_RunStop(void) { return 0; }
+s32 MBNG_FILE_S_Read(char *filename, int snapshot) { return 0; }
+s32 MBNG_FILE_S_Write(char *filename, int snapshot) { return 0; }
+s32 MBNG_FILE_S_RequestDelayedSnapshot(u8 delay_s) { return 0; }
+s32 MBNG_FILE_S_SnapshotGet(void) { return 0; }
+s32 MBNG_FILE_S_SnapshotSet(u8 snapshot) { return 0; }
+s32 MBNG_SEQ_PlayButton(void) { return 0; }
+s32 MBNG_SEQ_StopButton(void) { return 0; }
+s32 MBNG_SEQ_PauseButton(void) { return 0; }
+s32 MBNG_SEQ_PlayStopButton(void) { return 0; }
+
+
+/////////////////////////////////////////////////////////////////////////////
+// random items
+/////////////////////////////////////////////////////////////////////////////
+
+// a copy of an item with its own stream and label, so that it can be added
+// again after the pool has been cleared
+typedef struct {
+  mbng_event_item_t item;
+  u8 stream[MAX_STREAM_LEN];
+  char label[MAX_LABEL_LEN];
+} item_copy_t;
+
+static item_copy_t items[MAX_ITEMS];
+
+static const u16 controllers[] = {
+  MBNG_EVENT_CONTROLLER_SENDER,
+  MBNG_EVENT_CONTROLLER_RECEIVER,
+  MBNG_EVENT_CONTROLLER_BUTTON,
+  MBNG_EVENT_CONTROLLER_LED,
+  MBNG_EVENT_CONTROLLER_BUTTON_MATRIX,
+  MBNG_EVENT_CONTROLLER_LED_MATRIX,
+  MBNG_EVENT_CONTROLLER_ENC,
+  MBNG_EVENT_CONTROLLER_AIN,
+  MBNG_EVENT_CONTROLLER_AINSER,
+  MBNG_EVENT_CONTROLLER_MF,
+  MBNG_EVENT_CONTROLLER_CV,
+  MBNG_EVENT_CONTROLLER_KB,
+  MBNG_EVENT_CONTROLLER_RGBLED,
+};
+#define NUM_CONTROLLERS (sizeof(controllers)/sizeof(u16))
+#define NUM_IDS_PER_CONTROLLER 24 // small number to get duplicates
+
+static u16 RandomId(void)
+{
+  u16 controller = controllers[rand() % NUM_CONTROLLERS];
+  if( controller == MBNG_EVENT_CONTROLLER_BUTTON_MATRIX || controller == MBNG_EVENT_CONTROLLER_LED_MATRIX )
+    return controller | (1 + (rand() % 3)); // the first two matrices are configured
+  return controller | (1 + (rand() % NUM_IDS_PER_CONTROLLER));
+}
+
+static void RandomItem(item_copy_t *c, u16 id)
+{
+  mbng_event_item_t *item = &c->item;
+
+  MBNG_EVENT_ItemInit(item, id);
+
+  if( (rand() % 4) == 0 )
+    item->hw_id = (id & 0xf000) | (1 + (rand() % NUM_IDS_PER_CONTROLLER));
+  if( (rand() % 2) == 0 )
+    item->bank = rand() % 4;
+  if( (rand() % 8) == 0 )
+    item->enabled_ports = 0x00010; // UART1 only
+  if( (rand() % 8) == 0 )
+    item->fwd_id = RandomId();
+  if( (rand() % 16) == 0 )
+    item->flags.radio_group = 1 + (rand() % 2);
+  item->min = 0;
+  item->max = (rand() % 2) ? 127 : 16383;
+
+  static const mbng_event_type_t types[] = {
+    MBNG_EVENT_TYPE_NOTE_OFF, MBNG_EVENT_TYPE_NOTE_ON, MBNG_EVENT_TYPE_POLY_PRESSURE, MBNG_EVENT_TYPE_CC,
+    MBNG_EVENT_TYPE_CC, MBNG_EVENT_TYPE_PROGRAM_CHANGE, MBNG_EVENT_TYPE_AFTERTOUCH,
+    MBNG_EVENT_TYPE_PITCHBEND, MBNG_EVENT_TYPE_NRPN, MBNG_EVENT_TYPE_UNDEFINED,
+  };
+  item->flags.type = types[rand() % (sizeof(types)/sizeof(mbng_event_type_t))];
+
+  u8 chn = rand() % 2;
+  item->stream = c->stream;
+  switch( item->flags.type ) {
+  case MBNG_EVENT_TYPE_UNDEFINED:
+    item->stream = NULL;
+    item->stream_size = 0;
+    break;
+  case MBNG_EVENT_TYPE_NRPN:
+    c->stream[0] = 0xb0 | chn;
+    c->stream[1] = rand() % 4; // address LSB
+    c->stream[2] = rand() % 2; // address MSB
+    c->stream[3] = (rand() % 2) ? MBNG_EVENT_NRPN_FORMAT_MSB_ONLY : MBNG_EVENT_NRPN_FORMAT_UNSIGNED;
+    item->stream_size = 4;
+    break;
+  default: {
+    u8 status = 0x80 + 0x10*(item->flags.type - MBNG_EVENT_TYPE_NOTE_OFF);
+    c->stream[0] = status | chn;
+    c->stream[1] = rand() % 8;
+    item->stream_size = 2;
+    if( item->flags.type <= MBNG_EVENT_TYPE_CC ) {
+      if( (rand() % 8) == 0 )
+	item->flags.use_any_key_or_cc = 1;
+      if( (rand() % 8) == 0 )
+	item->flags.use_key_or_cc = 1;
+    }
+  }
+  }
+  item->secondary_value = c->stream[1];
+
+  if( (rand() % 2) == 0 ) {
+    sprintf(c->label, "L%d", rand() % 1000);
+    item->label = c->label;
+  } else {
+    item->label = NULL;
+  }
+}
+
+// copies a pool item into *c, incl. stream and label
+static void CopyItem(item_copy_t *c, u32 item_ix)
+{
+  MBNG_EVENT_ItemGet(item_ix, &c->item);
+
+  if( c->item.stream ) {
+    memcpy(c->stream, c->item.stream, c->item.stream_size);
+    c->item.stream = c->stream;
+  }
+
+  if( c->item.label ) {
+    strncpy(c->label, c->item.label, MAX_LABEL_LEN-1);
+    c->label[MAX_LABEL_LEN-1] = 0;
+    c->item.label = c->label;
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// lookups
+/////////////////////////////////////////////////////////////////////////////
+
+// the pool items, taken with MBNG_EVENT_ItemGet() to search for the expected results
+typedef struct {
+  u16 id;
+  u16 hw_id;
+  u16 pool_address;
+  u8  active;
+} ref_item_t;
+
+static ref_item_t ref_items[MAX_ITEMS+128];
+static u32 num_ref_items;
+
+static void ReferenceUpdate(void)
+{
+  num_ref_items = MBNG_EVENT_PoolNumItemsGet();
+  u32 i;
+  for(i=0; i<num_ref_items; ++i) {
+    mbng_event_item_t item;
+    MBNG_EVENT_ItemGet(i, &item);
+    ref_items[i].id = item.id;
+    ref_items[i].hw_id = item.hw_id;
+    ref_items[i].pool_address = item.pool_address;
+    ref_items[i].active = item.flags.active;
+  }
+}
+
+static u32 ReferenceSearch(u16 id, u8 by_hw_id, u16 *pool_addresses)
+{
+  u32 num = 0;
+  u32 i;
+  for(i=0; i<num_ref_items; ++i) {
+    ref_item_t *r = &ref_items[i];
+    if( by_hw_id ? (r->active && r->hw_id == id) : (r->id == id) )
+      pool_addresses[num++] = r->pool_address;
+  }
+  return num;
+}
+
+static void CheckSearch(const char *step, u16 id, u8 by_hw_id)
+{
+  static u16 expected[MAX_ITEMS+128];
+  u32 num_expected = ReferenceSearch(id, by_hw_id, expected);
+
+  u32 num = 0;
+  u32 continue_ix = 0;
+  do {
+    mbng_event_item_t item;
+    s32 status = by_hw_id
+      ? MBNG_EVENT_ItemSearchByHwId(id, &item, &continue_ix)
+      : MBNG_EVENT_ItemSearchById(id, &item, &continue_ix);
+    if( status < 0 )
+      break;
+
+    TRACE("  %s %04x: %04x\n", by_hw_id ? "hw_id" : "id", id, item.pool_address);
+    CHECK(num < num_expected && item.pool_address == expected[num],
+	  "%s: %s %04x found item at %04x, expected %04x (result #%d)",
+	  step, by_hw_id ? "hw_id" : "id", id, item.pool_address, (num < num_expected) ? expected[num] : 0xffff, num);
+    ++num;
+  } while( continue_ix && num <= num_expected );
+
+  CHECK(num == num_expected, "%s: %s %04x found %d items, expected %d", step, by_hw_id ? "hw_id" : "id", id, num, num_expected);
+}
+
+static void SendPackage(mios32_midi_port_t port, u8 evnt0, u8 evnt1, u8 evnt2)
+{
+  mios32_midi_package_t p;
+  p.ALL = 0;
+  p.type = evnt0 >> 4;
+  p.evnt0 = evnt0;
+  p.evnt1 = evnt1;
+  p.evnt2 = evnt2;
+  TRACE(" receive %02x %02x %02x %02x\n", port, evnt0, evnt1, evnt2);
+  MBNG_EVENT_MIDI_NotifyPackage(port, p);
+}
+
+static void CheckLookups(const char *step)
+{
+  TRACE("%s: %d items, bank %d\n", step, MBNG_EVENT_PoolNumItemsGet(), MBNG_EVENT_SelectedBankGet());
+
+  // search by ID and HW ID
+  ReferenceUpdate();
+  int c, i;
+  for(c=0; c<NUM_CONTROLLERS; ++c) {
+    for(i=0; i<=64+1; ++i) {
+      CheckSearch(step, controllers[c] | i, 0);
+      CheckSearch(step, controllers[c] | i, 1);
+    }
+  }
+
+  // incoming MIDI events
+  mios32_midi_port_t port;
+  for(port=USB0; port<=UART0; port+=(UART0-USB0)) {
+    int status, chn;
+    for(status=0x80; status<=0xe0; status+=0x10) {
+      for(chn=0; chn<2; ++chn) {
+	for(i=0; i<10; ++i)
+	  SendPackage(port, status | chn, i, rand() % 128);
+      }
+    }
+    // matrix pins and the default items
+    for(i=0x10; i<0x70; i+=5)
+      SendPackage(port, 0x90, i, 0x7f);
+
+    // NRPNs
+    for(chn=0; chn<2; ++chn) {
+      for(i=0; i<8; ++i) {
+	SendPackage(port, 0xb0 | chn, 0x63, i / 4);
+	SendPackage(port, 0xb0 | chn, 0x62, i % 4);
+	SendPackage(port, 0xb0 | chn, 0x06, rand() % 128);
+	SendPackage(port, 0xb0 | chn, 0x26, rand() % 128);
+      }
+    }
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// test sequences
+/////////////////////////////////////////////////////////////////////////////
+
+static void CreatePool(u32 num_items)
+{
+  MBNG_EVENT_PoolClear();
+  u32 i;
+  for(i=0; i<num_items; ++i) {
+    RandomItem(&items[0], RandomId());
+    CHECK(MBNG_EVENT_ItemAdd(&items[0].item) >= 0, "ItemAdd #%d failed", i);
+  }
+  MBNG_EVENT_PoolUpdate();
+}
+
+// removes items from the pool, like a new configuration with less items
+static void DeleteItems(u32 keep_each)
+{
+  u32 num_items = MBNG_EVENT_PoolNumItemsGet();
+  u32 i;
+  for(i=0; i<num_items; ++i)
+    CopyItem(&items[i], i);
+
+  MBNG_EVENT_PoolClear();
+  for(i=0; i<num_items; ++i) {
+    if( (rand() % keep_each) == 0 )
+      MBNG_EVENT_ItemAdd(&items[i].item);
+  }
+  MBNG_EVENT_PoolUpdate();
+}
+
+static void ModifyItems(u32 num)
+{
+  u32 i;
+  for(i=0; i<num; ++i) {
+    u32 num_items = MBNG_EVENT_PoolNumItemsGet();
+    CopyItem(&items[0], rand() % num_items);
+    item_copy_t *c = &items[0];
+
+    // change the search keys (a new item with the same ID), or only the value
+    if( rand() % 4 ) {
+      u16 value = c->item.value;
+      RandomItem(c, c->item.id);
+      c->item.value = value;
+    } else {
+      c->item.value = rand() % 128;
+    }
+    CHECK(MBNG_EVENT_ItemModify(&c->item) >= 0, "ItemModify %04x failed", c->item.id);
+  }
+}
+
+static void RunTest(void)
+{
+  // configure two matrices which receive on a pin range
+  mbng_patch_matrix_din[0].sr_din1 = 1;
+  mbng_patch_matrix_din[1].sr_din1 = 2;
+  mbng_patch_matrix_din[1].sr_din2 = 3;
+  mbng_patch_matrix_dout[0].sr_dout_r1 = 1;
+  mbng_patch_matrix_dout[1].sr_dout_r1 = 2;
+  mbng_patch_matrix_dout[1].sr_dout_r2 = 3;
+
+  srand(1);
+
+  MBNG_EVENT_Init(0);
+  MBNG_EVENT_PoolUpdate();
+  CheckLookups("default items");
+
+  int round;
+  for(round=0; round<3; ++round) {
+    char step[40];
+
+    CreatePool(300);
+    sprintf(step, "round %d: create", round);
+    CheckLookups(step);
+
+    int i;
+    for(i=0; i<3; ++i) {
+      ModifyItems(20);
+      sprintf(step, "round %d: modify %d", round, i);
+      CheckLookups(step);
+    }
+
+    for(i=0; i<10; ++i) {
+      RandomItem(&items[0], RandomId());
+      MBNG_EVENT_ItemAdd(&items[0].item);
+    }
+    sprintf(step, "round %d: add", round);
+    CheckLookups(step);
+
+    int bank;
+    for(bank=2; bank<=MBNG_EVENT_NumBanksGet(); ++bank) {
+      MBNG_EVENT_SelectedBankSet(bank);
+      sprintf(step, "round %d: bank %d", round, bank);
+      CheckLookups(step);
+    }
+    MBNG_EVENT_SelectedBankSet(1);
+
+    // reduce the pool until it fits into a small index
+    for(i=0; MBNG_EVENT_PoolNumItemsGet() >= 32; ++i) {
+      DeleteItems(2);
+      sprintf(step, "round %d: delete %d", round, i);
+      CheckLookups(step);
+
+      ModifyItems(5);
+      sprintf(step, "round %d: delete %d + modify", round, i);
+      CheckLookups(step);
+    }
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// host benchmark
+/////////////////////////////////////////////////////////////////////////////
+static void RunBench(void)
+{
+  const u32 num_loops = 20000;
+
+  srand(1);
+  CreatePool(MAX_ITEMS);
+
+  clock_t start = clock();
+  u32 i;
+  for(i=0; i<num_loops; ++i) {
+    mbng_event_item_t item;
+    u32 continue_ix = 0;
+    MBNG_EVENT_ItemSearchById(RandomId(), &item, &continue_ix);
+  }
+  double search_us = 1E6 * (double)(clock() - start) / CLOCKS_PER_SEC / num_loops;
+
+  start = clock();
+  for(i=0; i<num_loops; ++i) {
+    mios32_midi_package_t p;
+    p.ALL = 0;
+    p.type = CC;
+    p.evnt0 = 0xb0 | (rand() % 2);
+    p.evnt1 = rand() % 8;
+    p.evnt2 = rand() % 128;
+    MBNG_EVENT_MIDI_NotifyPackage(USB0, p);
+  }
+  double midi_us = 1E6 * (double)(clock() - start) / CLOCKS_PER_SEC / num_loops;
+
+  printf("MBNG_EVENT_INDEX_MAX_ITEMS=%d, %d items (host): ItemSearchById %.3f uS, MIDI_NotifyPackage %.3f uS\n",
+	 MBNG_EVENT_INDEX_MAX_ITEMS, MBNG_EVENT_PoolNumItemsGet(), search_us, midi_us);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  if( argc >= 2 && strcmp(argv[1], "-bench") == 0 ) {
+    RunBench();
+    return 0;
+  }
+
+  print_trace = argc >= 2 && strcmp(argv[1], "-trace") == 0;
+
+  RunTest();
+
+  if( print_trace ) {
+    printf("%d notifications\n", num_notified);
+  } else {
+    printf("mbng_event_test (MBNG_EVENT_INDEX_MAX_ITEMS=%d): %d notifications - %s\n",
+	   MBNG_EVENT_INDEX_MAX_ITEMS, num_notified, num_errors ? "FAILED" : "PASSED");
+  }
+
+  return num_errors ? 1 : 0;
+}
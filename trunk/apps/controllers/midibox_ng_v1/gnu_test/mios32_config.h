@@ -0,0 +1,14 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host test
+ *
+ * Takes over the configuration of the application.
+ * MBNG_EVENT_INDEX_MAX_ITEMS is passed by the makefile
+ */
+
+// (it has the same include guard, therefore no separate guard here)
+#include "../src/mios32_config.h"
+
+// no FreeRTOS on the host
+#define portENTER_CRITICAL()
+#define portEXIT_CRITICAL()
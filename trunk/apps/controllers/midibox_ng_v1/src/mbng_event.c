@@ -128,6 +128,33 @@ static u16 event_pool_size;
 static u16 event_pool_maps_begin;
 static u16 event_pool_num_items;
 static u16 event_pool_num_maps;
+static u16 event_pool_num_sysex_items; // incoming SysEx bytes are ignored if there are no SysEx events
+
+// lookup index for the event pool, built by MBNG_EVENT_PoolUpdate()
+// it allows to find items by ID, HW ID and incoming MIDI event without searching through the whole pool
+#ifndef MBNG_EVENT_INDEX_MAX_ITEMS
+# if defined(MIOS32_FAMILY_STM32F4xx)
+#  define MBNG_EVENT_INDEX_MAX_ITEMS 2048
+# else
+#  define MBNG_EVENT_INDEX_MAX_ITEMS 0 // disabled to save RAM - the pool will be searched linear
+# endif
+#endif
+
+#if MBNG_EVENT_INDEX_MAX_ITEMS
+# define MBNG_EVENT_INDEX_NUM_BUCKETS     256 // must be a power of two
+# define MBNG_EVENT_INDEX_NUM_ANY_BUCKETS 128 // for MIDI events which only match on the status byte
+# define MBNG_EVENT_INDEX_CONTINUE_FLAG   0x80000000 // marks a continue_ix which points into an index
+
+// each index contains the pool offsets of the items, sorted by bucket, and by pool position within a bucket.
+// Bucket b is located at entries[begin[b]]..entries[begin[b+1]-1]
+static u8  index_valid;
+static u16 index_id_begin[MBNG_EVENT_INDEX_NUM_BUCKETS+1];
+static u16 index_id_entries[MBNG_EVENT_INDEX_MAX_ITEMS];
+static u16 index_hw_id_begin[MBNG_EVENT_INDEX_NUM_BUCKETS+1];
+static u16 index_hw_id_entries[MBNG_EVENT_INDEX_MAX_ITEMS];
+static u16 index_midi_begin[MBNG_EVENT_INDEX_NUM_BUCKETS+MBNG_EVENT_INDEX_NUM_ANY_BUCKETS+1];
+static u16 index_midi_entries[MBNG_EVENT_INDEX_MAX_ITEMS];
+#endif
 
 // last active event
 mbng_event_item_id_t last_event_item_id;
@@ -185,6 +212,10 @@ static u8 lc_meters[LC_METERS_NUM_PORTS][LC_METERS_NUM_ITEMS];
 static s32 MBNG_EVENT_ItemCopy2User(mbng_event_pool_item_t* pool_item, mbng_event_item_t *item);
 static s32 MBNG_EVENT_ItemCopy2Pool(mbng_event_item_t *item, mbng_event_pool_item_t* pool_item);
 
+#if MBNG_EVENT_INDEX_MAX_ITEMS
+static s32 MBNG_EVENT_IndexUpdate(void);
+#endif
+
 static s32 MBNG_EVENT_LCMeters_Update(void);
 static s32 MBNG_EVENT_LCMeters_Set(u8 port_ix, u8 lc_meter_value);
 static s32 MBNG_EVENT_LCMeters_Tick(void);
@@ -370,6 +401,11 @@ s32 MBNG_EVENT_PoolClear(void)
   event_pool_maps_begin = 0;
   event_pool_num_items = 0;
   event_pool_num_maps = 0;
+  event_pool_num_sysex_items = 0;
+
+#if MBNG_EVENT_INDEX_MAX_ITEMS
+  index_valid = 0;
+#endif
 
   last_event_item_id = 0;
 
@@ -406,8 +442,126 @@ s32 MBNG_EVENT_PoolUpdate(void)
     pool_ptr += pool_item->len;
   }
 
+#if MBNG_EVENT_INDEX_MAX_ITEMS
+  MBNG_EVENT_IndexUpdate();
+#endif
+
+  return 0; // no error
+}
+
+
+#if MBNG_EVENT_INDEX_MAX_ITEMS
+/////////////////////////////////////////////////////////////////////////////
+//! Hash functions for the pool index
+/////////////////////////////////////////////////////////////////////////////
+static inline u32 MBNG_EVENT_IndexIdHash(u16 id)
+{
+  // the controller type is located in the upper 4 bits, the number in the lower 12 bits
+  return (id + (id >> 12)*0x35) & (MBNG_EVENT_INDEX_NUM_BUCKETS-1);
+}
+
+static inline u32 MBNG_EVENT_IndexMidiHash(u8 evnt0, u8 evnt1)
+{
+  return (evnt1 ^ (evnt0 * 0x1d)) & (MBNG_EVENT_INDEX_NUM_BUCKETS-1);
+}
+
+static s32 MBNG_EVENT_IndexIdBucket(mbng_event_pool_item_t *pool_item)
+{
+  return MBNG_EVENT_IndexIdHash(pool_item->id);
+}
+
+static s32 MBNG_EVENT_IndexHwIdBucket(mbng_event_pool_item_t *pool_item)
+{
+  return MBNG_EVENT_IndexIdHash(pool_item->hw_id);
+}
+
+static s32 MBNG_EVENT_IndexMidiBucket(mbng_event_pool_item_t *pool_item)
+{
+  if( !pool_item->len_stream )
+    return -1; // no MIDI event
+
+  // see MBNG_EVENT_MIDI_NotifyPoolItem(): Note and CC events match on the first two bytes,
+  // all others (and matrices or ANY key/CC events) only on the status byte
+  u8 *stream = &pool_item->data_begin;
+  mbng_event_type_t event_type = ((mbng_event_flags_t)pool_item->flags).type;
+  u16 controller = pool_item->hw_id & 0xf000;
+  if( event_type <= MBNG_EVENT_TYPE_CC && pool_item->len_stream >= 2 &&
+      !pool_item->flags.use_any_key_or_cc &&
+      controller != MBNG_EVENT_CONTROLLER_BUTTON_MATRIX &&
+      controller != MBNG_EVENT_CONTROLLER_LED_MATRIX ) {
+    return MBNG_EVENT_IndexMidiHash(stream[0], stream[1]);
+  }
+
+  return MBNG_EVENT_INDEX_NUM_BUCKETS + (stream[0] & 0x7f);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Sorts the pool offsets of all items into the buckets of an index
+/////////////////////////////////////////////////////////////////////////////
+static void MBNG_EVENT_IndexBuild(u16 *begin, u16 *entries, u32 num_buckets, s32 (*get_bucket)(mbng_event_pool_item_t *pool_item))
+{
+  u32 i;
+
+  // count the items of each bucket
+  for(i=0; i<=num_buckets; ++i)
+    begin[i] = 0;
+
+  u8 *pool_ptr = (u8 *)&event_pool[0];
+  for(i=0; i<event_pool_num_items; ++i) {
+    mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
+    s32 bucket = get_bucket(pool_item);
+    if( bucket >= 0 )
+      ++begin[bucket];
+    pool_ptr += pool_item->len;
+  }
+
+  // convert to start positions
+  u32 pos = 0;
+  for(i=0; i<num_buckets; ++i) {
+    u32 num = begin[i];
+    begin[i] = pos;
+    pos += num;
+  }
+
+  // store the offsets, begin[b] is incremented to the end of the bucket
+  pool_ptr = (u8 *)&event_pool[0];
+  for(i=0; i<event_pool_num_items; ++i) {
+    mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
+    s32 bucket = get_bucket(pool_item);
+    if( bucket >= 0 )
+      entries[begin[bucket]++] = (u32)pool_ptr - (u32)&event_pool[0];
+    pool_ptr += pool_item->len;
+  }
+
+  // shift back to the start positions
+  for(i=num_buckets; i>0; --i)
+    begin[i] = begin[i-1];
+  begin[0] = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! (Re-)builds the pool index.
+//! Called by MBNG_EVENT_PoolUpdate(), and whenever the pool has been changed
+//! while the index is valid.
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNG_EVENT_IndexUpdate(void)
+{
+  index_valid = 0;
+
+  if( event_pool_num_items > MBNG_EVENT_INDEX_MAX_ITEMS ) {
+    DEBUG_MSG("[MBNG_EVENT] more than %d events in pool - searching without index!\n", MBNG_EVENT_INDEX_MAX_ITEMS);
+    return -1; // linear search will be used
+  }
+
+  MBNG_EVENT_IndexBuild(index_id_begin, index_id_entries, MBNG_EVENT_INDEX_NUM_BUCKETS, MBNG_EVENT_IndexIdBucket);
+  MBNG_EVENT_IndexBuild(index_hw_id_begin, index_hw_id_entries, MBNG_EVENT_INDEX_NUM_BUCKETS, MBNG_EVENT_IndexHwIdBucket);
+  MBNG_EVENT_IndexBuild(index_midi_begin, index_midi_entries, MBNG_EVENT_INDEX_NUM_BUCKETS+MBNG_EVENT_INDEX_NUM_ANY_BUCKETS, MBNG_EVENT_IndexMidiBucket);
+
+  index_valid = 1;
+
   return 0; // no error
 }
+#endif
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1420,8 +1574,16 @@ s32 MBNG_EVENT_ItemAdd(mbng_event_item_t *item)
   MBNG_EVENT_ItemCopy2Pool(item, pool_item);
   event_pool_size += pool_item->len;
   ++event_pool_num_items;
+  if( item->flags.type == MBNG_EVENT_TYPE_SYSEX )
+    ++event_pool_num_sysex_items;
   event_pool_maps_begin += pool_item_len;
 
+#if MBNG_EVENT_INDEX_MAX_ITEMS
+  // while a configuration is loaded, the index will be built by MBNG_EVENT_PoolUpdate()
+  if( index_valid )
+    MBNG_EVENT_IndexUpdate();
+#endif
+
   return 0; // no error
 }
 
@@ -1446,6 +1608,18 @@ s32 MBNG_EVENT_ItemModify(mbng_event_item_t *item)
       if( len_diff >= 0 && (event_pool_size+len_diff) > MBNG_EVENT_POOL_MAX_SIZE )
 	return -2; // out of storage 
 
+#if MBNG_EVENT_INDEX_MAX_ITEMS
+      // index buckets of the unmodified item (the ID bucket can't change, since the ID is the same)
+      s32 old_hw_id_bucket = MBNG_EVENT_IndexHwIdBucket(pool_item);
+      s32 old_midi_bucket = MBNG_EVENT_IndexMidiBucket(pool_item);
+#endif
+
+      // the event type could be changed
+      if( ((mbng_event_flags_t)pool_item->flags).type == MBNG_EVENT_TYPE_SYSEX )
+	--event_pool_num_sysex_items;
+      if( item->flags.type == MBNG_EVENT_TYPE_SYSEX )
+	++event_pool_num_sysex_items;
+
       if( len_diff != 0 ) {
 	// make room
 	u8 *old_next_pool_item = (u8 *)((u32)pool_item + pool_item->len);
@@ -1480,6 +1654,16 @@ s32 MBNG_EVENT_ItemModify(mbng_event_item_t *item)
 	MBNG_EVENT_ItemCopy2Pool(item, pool_item);
       }
 
+#if MBNG_EVENT_INDEX_MAX_ITEMS
+      // only rebuild the index if the pool offsets of the following items or the buckets have been changed
+      // (e.g. not if only the value, colour or min/max range has been modified)
+      if( index_valid &&
+	  (len_diff != 0 ||
+	   MBNG_EVENT_IndexHwIdBucket(pool_item) != old_hw_id_bucket ||
+	   MBNG_EVENT_IndexMidiBucket(pool_item) != old_midi_bucket) )
+	MBNG_EVENT_IndexUpdate();
+#endif
+
       return 0; // operation was successfull
     }
     pool_ptr += pool_item->len;
@@ -1495,6 +1679,30 @@ s32 MBNG_EVENT_ItemModify(mbng_event_item_t *item)
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNG_EVENT_ItemSearchById(mbng_event_item_id_t id, mbng_event_item_t *item, u32 *continue_ix)
 {
+#if MBNG_EVENT_INDEX_MAX_ITEMS
+  // (if the search has been started without index, it will be continued linear)
+  if( index_valid && (!*continue_ix || (*continue_ix & MBNG_EVENT_INDEX_CONTINUE_FLAG)) ) {
+    // lower half of continue_ix: position in the index
+    u32 bucket = MBNG_EVENT_IndexIdHash(id);
+    u32 pos = (*continue_ix & MBNG_EVENT_INDEX_CONTINUE_FLAG) ? (*continue_ix & 0xffff) : index_id_begin[bucket];
+    u32 end = index_id_begin[bucket+1];
+    for(; pos<end; ++pos) {
+      mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)&event_pool[index_id_entries[pos]];
+      if( pool_item->id == id ) {
+	MBNG_EVENT_ItemCopy2User(pool_item, item);
+
+	// pass position of next bucket entry in continue_ix for continued search
+	*continue_ix = ((pos+1) < end) ? (MBNG_EVENT_INDEX_CONTINUE_FLAG | (pos+1)) : 0;
+	return 0; // item found
+      }
+    }
+
+    return -1; // not found
+  } else if( *continue_ix & MBNG_EVENT_INDEX_CONTINUE_FLAG ) {
+    return -1; // index has been invalidated meanwhile
+  }
+#endif
+
   u8 *pool_ptr = (u8 *)&event_pool[0];
   u32 i = 0;
 
@@ -1536,6 +1744,30 @@ s32 MBNG_EVENT_ItemSearchById(mbng_event_item_id_t id, mbng_event_item_t *item,
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNG_EVENT_ItemSearchByHwId(mbng_event_item_id_t hw_id, mbng_event_item_t *item, u32 *continue_ix)
 {
+#if MBNG_EVENT_INDEX_MAX_ITEMS
+  // (if the search has been started without index, it will be continued linear)
+  if( index_valid && (!*continue_ix || (*continue_ix & MBNG_EVENT_INDEX_CONTINUE_FLAG)) ) {
+    // lower half of continue_ix: position in the index
+    u32 bucket = MBNG_EVENT_IndexIdHash(hw_id);
+    u32 pos = (*continue_ix & MBNG_EVENT_INDEX_CONTINUE_FLAG) ? (*continue_ix & 0xffff) : index_hw_id_begin[bucket];
+    u32 end = index_hw_id_begin[bucket+1];
+    for(; pos<end; ++pos) {
+      mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)&event_pool[index_hw_id_entries[pos]];
+      if( pool_item->flags.active && pool_item->hw_id == hw_id ) {
+	MBNG_EVENT_ItemCopy2User(pool_item, item);
+
+	// pass position of next bucket entry in continue_ix for continued search
+	*continue_ix = ((pos+1) < end) ? (MBNG_EVENT_INDEX_CONTINUE_FLAG | (pos+1)) : 0;
+	return 0; // item found
+      }
+    }
+
+    return -1; // not found
+  } else if( *continue_ix & MBNG_EVENT_INDEX_CONTINUE_FLAG ) {
+    return -1; // index has been invalidated meanwhile
+  }
+#endif
+
   u8 *pool_ptr = (u8 *)&event_pool[0];
   u32 i = 0;
 
@@ -4369,6 +4601,101 @@ s32 MBNG_EVENT_Dump(void)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Checks if a received MIDI event matches with the given pool item, and
+//! notifies the item if this is the case.
+//! The first byte of the event stream already has been compared by the caller.
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNG_EVENT_MIDI_NotifyPoolItem(mbng_event_pool_item_t *pool_item, mios32_midi_port_t port, u32 port_mask, mios32_midi_package_t midi_package, u16 nrpn_address, u16 nrpn_value, u8 nrpn_msb_only)
+{
+  u8 evnt1 = midi_package.evnt1;
+
+  if( (pool_item->hw_id & 0xf000) == MBNG_EVENT_CONTROLLER_SENDER ) // a sender doesn't receive
+    return 0;
+
+  if( !(pool_item->enabled_ports & port_mask) ) // port not enabled
+    return 0;
+
+  mbng_event_type_t event_type = ((mbng_event_flags_t)pool_item->flags).type;
+  if( event_type <= MBNG_EVENT_TYPE_CC ) {
+    u8 *stream = &pool_item->data_begin;
+    if( pool_item->flags.use_any_key_or_cc || stream[1] == evnt1 ) { // || pool_item->secondary_value >= 128 || evnt1 == pool_item->secondary_value ) {
+      mbng_event_item_t item;
+      MBNG_EVENT_ItemCopy2User(pool_item, &item);
+      if( item.flags.use_key_or_cc ) {
+	item.secondary_value = midi_package.value;
+	MBNG_EVENT_ItemReceive(&item, midi_package.evnt1, 1, 1);
+      } else {
+	item.secondary_value = midi_package.evnt1;
+	MBNG_EVENT_ItemReceive(&item, midi_package.value, 1, 1);
+      }
+    } else {
+      // EXTRA for button/led matrices
+      int matrix = (pool_item->hw_id & 0x0fff) - 1;
+      int num_pins = -1;
+
+      switch( pool_item->hw_id & 0xf000 ) {
+      case MBNG_EVENT_CONTROLLER_BUTTON_MATRIX: {
+	if( matrix >= 0 && matrix < MBNG_PATCH_NUM_MATRIX_DIN ) {
+	  mbng_patch_matrix_din_entry_t *m = (mbng_patch_matrix_din_entry_t *)&mbng_patch_matrix_din[matrix];
+
+	  if( m->sr_din1 ) {
+	    u8 row_size = m->sr_din2 ? 16 : 8;
+	    num_pins = row_size * row_size;
+	  }
+	}
+      } break;
+      case MBNG_EVENT_CONTROLLER_LED_MATRIX: {
+	if( matrix >= 0 && matrix < MBNG_PATCH_NUM_MATRIX_DOUT ) {
+	  mbng_patch_matrix_dout_entry_t *m = (mbng_patch_matrix_dout_entry_t *)&mbng_patch_matrix_dout[matrix];
+
+	  if( m->sr_dout_r1 && !pool_item->flags.led_matrix_pattern ) {
+	    u8 row_size = m->sr_dout_r2 ? 16 : 8; // we assume that the same condition is valid for dout_g2 and dout_b2
+	    num_pins = row_size * row_size;
+	  }
+	}
+      } break;
+      }
+
+      if( num_pins >= 0 ) {
+	int first_evnt1 = stream[1];
+	if( evnt1 >= first_evnt1 && evnt1 < (first_evnt1 + num_pins) ) {
+	  mbng_event_item_t item;
+	  MBNG_EVENT_ItemCopy2User(pool_item, &item);
+	  item.matrix_pin = evnt1 - first_evnt1;
+	  MBNG_EVENT_ItemReceive(&item, midi_package.value, 1, 1);
+	}
+      }
+    }
+  } else if( event_type <= MBNG_EVENT_TYPE_AFTERTOUCH ) {
+    mbng_event_item_t item;
+    MBNG_EVENT_ItemCopy2User(pool_item, &item);
+    MBNG_EVENT_ItemReceive(&item, evnt1, 1, 1);
+  } else if( event_type == MBNG_EVENT_TYPE_PITCHBEND ) {
+    mbng_event_item_t item;
+    MBNG_EVENT_ItemCopy2User(pool_item, &item);
+    MBNG_EVENT_ItemReceive(&item, evnt1 | ((u16)midi_package.value << 7), 1, 1);
+  } else if( event_type == MBNG_EVENT_TYPE_NRPN ) {
+    u8 *stream = &pool_item->data_begin;
+    u16 expected_address = stream[1] | ((u16)stream[2] << 7);
+    mbng_event_nrpn_format_t nrpn_format = stream[3];
+    if( nrpn_address == expected_address &&
+	(!nrpn_msb_only || nrpn_format == MBNG_EVENT_NRPN_FORMAT_MSB_ONLY) ) {
+      mbng_event_item_t item;
+      MBNG_EVENT_ItemCopy2User(pool_item, &item);
+
+      if( nrpn_format == MBNG_EVENT_NRPN_FORMAT_MSB_ONLY )
+	MBNG_EVENT_ItemReceive(&item, nrpn_value / 128, 1, 1);
+      else
+	MBNG_EVENT_ItemReceive(&item, nrpn_value, 1, 1);
+    }
+  } else {
+    // no additional event types yet...
+  }
+
+  return 0; // no error
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //! This function should be called from APP_MIDI_NotifyPackage whenver a new
 //! MIDI event has been received
@@ -4564,100 +4891,44 @@ s32 MBNG_EVENT_MIDI_NotifyPackage(mios32_midi_port_t port, mios32_midi_package_t
 
   // search in pool for matching events
   u8 evnt0 = midi_package.evnt0;
-  u8 evnt1 = midi_package.evnt1;
+
+#if MBNG_EVENT_INDEX_MAX_ITEMS
+  if( index_valid ) {
+    // merge the items which match on evnt0+evnt1 with the items which only match on evnt0,
+    // so that they are notified in the same order like stored in the pool
+    u8 evnt1 = midi_package.evnt1;
+    u16 *begin = &index_midi_begin[0];
+    u32 bucket = MBNG_EVENT_IndexMidiHash(evnt0, evnt1);
+    u32 pos = begin[bucket];
+    u32 end = begin[bucket+1];
+    u32 any_bucket = MBNG_EVENT_INDEX_NUM_BUCKETS + (evnt0 & 0x7f);
+    u32 any_pos = begin[any_bucket];
+    u32 any_end = begin[any_bucket+1];
+
+    while( pos < end || any_pos < any_end ) {
+      u16 pool_offset;
+      if( any_pos >= any_end || (pos < end && index_midi_entries[pos] < index_midi_entries[any_pos]) )
+	pool_offset = index_midi_entries[pos++];
+      else
+	pool_offset = index_midi_entries[any_pos++];
+
+      mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)&event_pool[pool_offset];
+      if( pool_item->data_begin == evnt0 && pool_item->len_stream ) {
+	MBNG_EVENT_MIDI_NotifyPoolItem(pool_item, port, port_mask, midi_package, nrpn_address, nrpn_value, nrpn_msb_only);
+      }
+    }
+
+    return 0; // no error
+  }
+#endif
+
   u8 *pool_ptr = (u8 *)&event_pool[0];
   u32 i;
   for(i=0; i<event_pool_num_items; ++i) {
     mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
     if( pool_item->data_begin == evnt0 && pool_item->len_stream ) { // timing critical
       // first byte is matching - now we've a bit more time for checking
-      
-      if( (pool_item->hw_id & 0xf000) == MBNG_EVENT_CONTROLLER_SENDER ) { // a sender doesn't receive
-	pool_ptr += pool_item->len;
-	continue;
-      }
-
-      if( !(pool_item->enabled_ports & port_mask) ) { // port not enabled
-	pool_ptr += pool_item->len;
-	continue;
-      }
-
-      mbng_event_type_t event_type = ((mbng_event_flags_t)pool_item->flags).type;
-      if( event_type <= MBNG_EVENT_TYPE_CC ) {
-	u8 *stream = &pool_item->data_begin;
-	if( pool_item->flags.use_any_key_or_cc || stream[1] == evnt1 ) { // || pool_item->secondary_value >= 128 || evnt1 == pool_item->secondary_value ) {
-	  mbng_event_item_t item;
-	  MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	  if( item.flags.use_key_or_cc ) {
-	    item.secondary_value = midi_package.value;
-	    MBNG_EVENT_ItemReceive(&item, midi_package.evnt1, 1, 1);
-	  } else {
-	    item.secondary_value = midi_package.evnt1;
-	    MBNG_EVENT_ItemReceive(&item, midi_package.value, 1, 1);
-	  }
-	} else {
-	  // EXTRA for button/led matrices
-	  int matrix = (pool_item->hw_id & 0x0fff) - 1;
-	  int num_pins = -1;
-
-	  switch( pool_item->hw_id & 0xf000 ) {
-	  case MBNG_EVENT_CONTROLLER_BUTTON_MATRIX: {
-	    if( matrix >= 0 && matrix < MBNG_PATCH_NUM_MATRIX_DIN ) {
-	      mbng_patch_matrix_din_entry_t *m = (mbng_patch_matrix_din_entry_t *)&mbng_patch_matrix_din[matrix];
-
-	      if( m->sr_din1 ) {
-		u8 row_size = m->sr_din2 ? 16 : 8;
-		num_pins = row_size * row_size;
-	      }
-	    }
-	  } break;
-	  case MBNG_EVENT_CONTROLLER_LED_MATRIX: {
-	    if( matrix >= 0 && matrix < MBNG_PATCH_NUM_MATRIX_DOUT ) {
-	      mbng_patch_matrix_dout_entry_t *m = (mbng_patch_matrix_dout_entry_t *)&mbng_patch_matrix_dout[matrix];
-
-	      if( m->sr_dout_r1 && !pool_item->flags.led_matrix_pattern ) {
-		u8 row_size = m->sr_dout_r2 ? 16 : 8; // we assume that the same condition is valid for dout_g2 and dout_b2
-		num_pins = row_size * row_size;
-	      }
-	    }
-	  } break;
-	  }
-
-	  if( num_pins >= 0 ) {
-	    int first_evnt1 = stream[1];
-	    if( evnt1 >= first_evnt1 && evnt1 < (first_evnt1 + num_pins) ) {
-	      mbng_event_item_t item;
-	      MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	      item.matrix_pin = evnt1 - first_evnt1;
-	      MBNG_EVENT_ItemReceive(&item, midi_package.value, 1, 1);
-	    }
-	  }
-	}
-      } else if( event_type <= MBNG_EVENT_TYPE_AFTERTOUCH ) {
-	mbng_event_item_t item;
-	MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	MBNG_EVENT_ItemReceive(&item, evnt1, 1, 1);
-      } else if( event_type == MBNG_EVENT_TYPE_PITCHBEND ) {
-	mbng_event_item_t item;
-	MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	MBNG_EVENT_ItemReceive(&item, evnt1 | ((u16)midi_package.value << 7), 1, 1);
-      } else if( event_type == MBNG_EVENT_TYPE_NRPN ) {
-	u8 *stream = &pool_item->data_begin;
-	u16 expected_address = stream[1] | ((u16)stream[2] << 7);
-	mbng_event_nrpn_format_t nrpn_format = stream[3];
-	if( nrpn_address == expected_address &&
-	    (!nrpn_msb_only || nrpn_format == MBNG_EVENT_NRPN_FORMAT_MSB_ONLY) ) {
-	  mbng_event_item_t item;
-	  MBNG_EVENT_ItemCopy2User(pool_item, &item);
-
-	  if( nrpn_format == MBNG_EVENT_NRPN_FORMAT_MSB_ONLY )
-	    MBNG_EVENT_ItemReceive(&item, nrpn_value / 128, 1, 1);
-	  else
-	    MBNG_EVENT_ItemReceive(&item, nrpn_value, 1, 1);
-	}
-      } else {
-	// no additional event types yet...
-      }
+      MBNG_EVENT_MIDI_NotifyPoolItem(pool_item, port, port_mask, midi_package, nrpn_address, nrpn_value, nrpn_msb_only);
     }
     pool_ptr += pool_item->len;
   }
@@ -4670,6 +4941,10 @@ s32 MBNG_EVENT_MIDI_NotifyPackage(mios32_midi_port_t port, mios32_midi_package_t
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNG_EVENT_ReceiveSysEx(mios32_midi_port_t port, u8 midi_in)
 {
+  // no SysEx event: large dumps don't have to be checked byte by byte
+  if( !event_pool_num_sysex_items )
+    return 0; // no error
+
   // create port mask, and check if this is a supported port (USB0..3, UART0..3, IIC0..3, OSC0..3)
   u8 subport_mask = (1 << (port&3));
   u8 port_class = ((port-0x10) & 0x70)>>2;
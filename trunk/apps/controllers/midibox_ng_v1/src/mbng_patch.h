@@ -52,7 +52,8 @@
 // STM32F1: none
 // STM32F4: J10A and J10B
 // LPC17: J10 and J28
-#if defined(MIOS32_FAMILY_STM32F10x)
+// HOST: none
+#if defined(MIOS32_FAMILY_STM32F10x) || defined(MIOS32_FAMILY_HOST)
 # define MBNG_PATCH_NUM_DIO 0
 #else
 # define MBNG_PATCH_NUM_DIO 2
@@ -700,6 +700,7 @@ s32 MIDIO_FILE_P_Read(char *filename)
 	      n->src_chn = values[1];
 	      n->dst_port = values[2];
 	      n->dst_chn = values[3];
+	      MIDI_ROUTER_NodesChanged();
 	    }
 	  }
 	} else if( strcmp(parameter, "ForwardIO") == 0 ) {
@@ -804,16 +804,16 @@ static u16  routerNodeGet(u32 ix)             { return selectedRouterNode; }
 static void routerNodeSet(u32 ix, u16 value)  { selectedRouterNode = value; }
 
 static u16  routerSrcPortGet(u32 ix)             { return MIDI_PORT_InIxGet((mios32_midi_port_t)midi_router_node[selectedRouterNode].src_port); }
-static void routerSrcPortSet(u32 ix, u16 value)  { midi_router_node[selectedRouterNode].src_port = MIDI_PORT_InPortGet(value); }
+static void routerSrcPortSet(u32 ix, u16 value)  { midi_router_node[selectedRouterNode].src_port = MIDI_PORT_InPortGet(value); MIDI_ROUTER_NodesChanged(); }
 
 static u16  routerSrcChnGet(u32 ix)              { return midi_router_node[selectedRouterNode].src_chn; }
-static void routerSrcChnSet(u32 ix, u16 value)   { midi_router_node[selectedRouterNode].src_chn = value; }
+static void routerSrcChnSet(u32 ix, u16 value)   { midi_router_node[selectedRouterNode].src_chn = value; MIDI_ROUTER_NodesChanged(); }
 
 static u16  routerDstPortGet(u32 ix)             { return MIDI_PORT_OutIxGet((mios32_midi_port_t)midi_router_node[selectedRouterNode].dst_port); }
-static void routerDstPortSet(u32 ix, u16 value)  { midi_router_node[selectedRouterNode].dst_port = MIDI_PORT_OutPortGet(value); }
+static void routerDstPortSet(u32 ix, u16 value)  { midi_router_node[selectedRouterNode].dst_port = MIDI_PORT_OutPortGet(value); MIDI_ROUTER_NodesChanged(); }
 
 static u16  routerDstChnGet(u32 ix)              { return midi_router_node[selectedRouterNode].dst_chn; }
-static void routerDstChnSet(u32 ix, u16 value)   { midi_router_node[selectedRouterNode].dst_chn = value; }
+static void routerDstChnSet(u32 ix, u16 value)   { midi_router_node[selectedRouterNode].dst_chn = value; MIDI_ROUTER_NodesChanged(); }
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -784,7 +784,7 @@ void SEQ_TASK_MIDI(void)
 /////////////////////////////////////////////////////////////////////////////
 void SEQ_TASK_Pattern(void)
 {
-  SEQ_PATTERN_Handler();
+  SEQ_PATTERN_PrefetchHandler();
 }
 
 
@@ -127,6 +127,10 @@ static u8 cached_pattern_name[21];
 static u8 cached_bank;
 static u8 cached_pattern;
 
+// incremented whenever a bank file is opened or written
+// prefetched patterns are only taken over if the value hasn't changed meanwhile
+static u32 bank_modification_ctr;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Initialisation
@@ -183,6 +187,8 @@ s32 SEQ_FILE_B_UnloadAllBanks(void)
   for(bank=0; bank<SEQ_FILE_B_NUM_BANKS; ++bank)
     seq_file_b_info[bank].valid = 0;
 
+  ++bank_modification_ctr;
+
   return 0; // no error
 }
 
@@ -234,6 +240,7 @@ s32 SEQ_FILE_B_Create(char *session, u8 bank)
 
   seq_file_b_info_t *info = &seq_file_b_info[bank];
   info->valid = 0; // set to invalid as long as we are not sure if file can be accessed
+  ++bank_modification_ctr;
 
   char filepath[MAX_PATH];
   sprintf(filepath, "%s/%s/MBSEQ_B%d.V4", SEQ_FILE_SESSION_PATH, session, bank+1);
@@ -319,6 +326,7 @@ s32 SEQ_FILE_B_Open(char *session, u8 bank)
   seq_file_b_info_t *info = &seq_file_b_info[bank];
 
   info->valid = 0; // will be set to valid if bank header has been read successfully
+  ++bank_modification_ctr;
 
   char filepath[MAX_PATH];
   sprintf(filepath, "%s/%s/MBSEQ_B%d.V4", SEQ_FILE_SESSION_PATH, session, bank+1);
@@ -586,6 +594,180 @@ DEBUG_MSG("Skipping Track %d\n", track);
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// reads a pattern from bank into a RAM buffer w/o changing the tracks
+// The data is taken over with SEQ_FILE_B_PatternApply(), which doesn't
+// access the SD Card anymore - this allows to preload a requested pattern
+// in a low-prio task, and to switch to the new pattern at the step boundary
+// with a simple copy operation.
+// returns < 0 on errors (error codes are documented in seq_file.h)
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_FILE_B_PatternPrefetch(u8 bank, u8 pattern, seq_file_b_prefetch_t *prefetch)
+{
+  prefetch->valid = 0;
+  u32 modification_ctr = bank_modification_ctr;
+
+  if( bank >= SEQ_FILE_B_NUM_BANKS )
+    return SEQ_FILE_B_ERR_INVALID_BANK;
+
+  seq_file_b_info_t *info = &seq_file_b_info[bank];
+
+  if( !info->valid )
+    return SEQ_FILE_B_ERR_NO_FILE;
+
+  if( pattern >= info->header.num_patterns )
+    return SEQ_FILE_B_ERR_INVALID_PATTERN;
+
+  // re-open file
+  if( FILE_ReadReOpen((file_t*)&info->file) < 0 )
+    return -1; // file cannot be re-opened
+
+  // change to file position
+  s32 status;
+  u32 offset = 10 + sizeof(seq_file_b_header_t) + pattern * info->header.pattern_size;
+  if( (status=FILE_ReadSeek(offset)) < 0 ) {
+#if DEBUG_VERBOSE_LEVEL >= 1
+    DEBUG_MSG("[SEQ_FILE_B] failed to change pattern offset in file, status: %d\n", status);
+#endif
+    // close file (so that it can be re-opened)
+    FILE_ReadClose((file_t*)&info->file);
+    return SEQ_FILE_B_ERR_READ;
+  }
+
+  // name, num_tracks, mixer_map, sysex_setup, reserved1 in a single read
+  u8 pattern_header[sizeof(seq_file_b_pattern_t)];
+  status |= FILE_ReadBuffer(pattern_header, sizeof(seq_file_b_pattern_t));
+  memcpy(prefetch->name, pattern_header, 20);
+  prefetch->num_tracks = pattern_header[20];
+
+  // reduce number of tracks if required
+  if( prefetch->num_tracks > SEQ_CORE_NUM_TRACKS_PER_GROUP )
+    prefetch->num_tracks = SEQ_CORE_NUM_TRACKS_PER_GROUP;
+
+  u8 track_i;
+  for(track_i=0; track_i<prefetch->num_tracks && status >= 0; ++track_i) {
+    // name, followed by the number of instruments/layers
+    // (read separately, the struct members could be padded)
+    u8 trk_header[4];
+    status |= FILE_ReadBuffer((u8 *)prefetch->trk[track_i].name, 80);
+    status |= FILE_ReadBuffer(trk_header, 4);
+    prefetch->trk[track_i].num_p_instruments = trk_header[0];
+    prefetch->trk[track_i].num_t_instruments = trk_header[1];
+    prefetch->trk[track_i].num_p_layers = trk_header[2];
+    prefetch->trk[track_i].num_t_layers = trk_header[3];
+    status |= FILE_ReadHWord(&prefetch->trk[track_i].p_layer_size);
+    status |= FILE_ReadHWord(&prefetch->trk[track_i].t_layer_size);
+    status |= FILE_ReadBuffer(prefetch->trk[track_i].cc, 128);
+
+    if( status < 0 )
+      break;
+
+    // reading Parameter layers
+    u32 par_size = prefetch->trk[track_i].num_p_instruments * prefetch->trk[track_i].num_p_layers * prefetch->trk[track_i].p_layer_size;
+    u32 par_size_taken = (par_size > SEQ_PAR_MAX_BYTES) ? SEQ_PAR_MAX_BYTES : par_size;
+    if( par_size_taken )
+      status |= FILE_ReadBuffer(prefetch->trk[track_i].par, par_size_taken);
+
+    // skip remaining bytes
+    if( par_size > par_size_taken )
+      status |= FILE_ReadSeek(FILE_ReadGetCurrentPosition() + par_size - par_size_taken);
+
+    // reading Trigger layers
+    u32 trg_size = prefetch->trk[track_i].num_t_instruments * prefetch->trk[track_i].num_t_layers * prefetch->trk[track_i].t_layer_size;
+    u32 trg_size_taken = (trg_size > SEQ_TRG_MAX_BYTES) ? SEQ_TRG_MAX_BYTES : trg_size;
+    if( trg_size_taken )
+      status |= FILE_ReadBuffer(prefetch->trk[track_i].trg, trg_size_taken);
+
+    // skip remaining bytes
+    if( trg_size > trg_size_taken )
+      status |= FILE_ReadSeek(FILE_ReadGetCurrentPosition() + trg_size - trg_size_taken);
+  }
+
+  // close file (so that it can be re-opened)
+  FILE_ReadClose((file_t*)&info->file);
+
+  if( status < 0 ) {
+#if DEBUG_VERBOSE_LEVEL >= 1
+    DEBUG_MSG("[SEQ_FILE_B] error while prefetching pattern B%d:P%d, status: %d\n", bank+1, pattern, status);
+#endif
+    return SEQ_FILE_B_ERR_READ;
+  }
+
+#if DEBUG_VERBOSE_LEVEL >= 2
+  DEBUG_MSG("[SEQ_FILE_B] prefetched pattern B%d:P%d, %d tracks\n", bank+1, pattern, prefetch->num_tracks);
+#endif
+
+  prefetch->bank = bank;
+  prefetch->pattern = pattern;
+  prefetch->modification_ctr = modification_ctr;
+  prefetch->valid = 1;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// takes over a pattern which has been read by SEQ_FILE_B_PatternPrefetch()
+// into the given group. Doesn't access the SD Card.
+// returns < 0 on errors (error codes are documented in seq_file.h)
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_FILE_B_PatternApply(seq_file_b_prefetch_t *prefetch, u8 target_group, u16 remix_map)
+{
+  if( target_group >= SEQ_CORE_NUM_GROUPS )
+    return SEQ_FILE_B_ERR_INVALID_GROUP;
+
+  // bank has been changed after the prefetch?
+  if( !prefetch->valid || prefetch->modification_ctr != bank_modification_ctr )
+    return SEQ_FILE_B_ERR_READ;
+
+  memcpy(seq_pattern_name[target_group], prefetch->name, 20);
+  seq_pattern_name[target_group][20] = 0;
+
+  u8 track_i;
+  u8 track = target_group * SEQ_CORE_NUM_TRACKS_PER_GROUP;
+  for(track_i=0; track_i<prefetch->num_tracks; ++track_i, ++track) {
+    // if we got the track bit setup inside our remix_map, them do not change him, let it be mixed down
+    if( ((1 << track) | remix_map) == remix_map )
+      continue;
+
+    memcpy(seq_core_trk[track].name, prefetch->trk[track_i].name, 80);
+    seq_core_trk[track].name[80] = 0;
+
+    // reading CCs
+    u8 cc;
+    for(cc=0; cc<128; ++cc)
+      SEQ_CC_Set(track, cc, prefetch->trk[track_i].cc[cc]);
+
+    // partitionate parameter layer and copy the steps
+    u16 p_layer_size = prefetch->trk[track_i].p_layer_size;
+    u8 num_p_layers = prefetch->trk[track_i].num_p_layers;
+    u8 num_p_instruments = prefetch->trk[track_i].num_p_instruments;
+    SEQ_PAR_TrackInit(track, p_layer_size, num_p_layers, num_p_instruments);
+
+    u32 par_size = num_p_instruments * num_p_layers * p_layer_size;
+    if( par_size > SEQ_PAR_MAX_BYTES )
+      par_size = SEQ_PAR_MAX_BYTES;
+    memcpy((u8 *)&seq_par_layer_value[track], prefetch->trk[track_i].par, par_size);
+
+    // partitionate trigger layer and copy the steps
+    u16 t_layer_size = prefetch->trk[track_i].t_layer_size;
+    u8 num_t_layers = prefetch->trk[track_i].num_t_layers;
+    u8 num_t_instruments = prefetch->trk[track_i].num_t_instruments;
+    SEQ_TRG_TrackInit(track, t_layer_size*8, num_t_layers, num_t_instruments);
+
+    u32 trg_size = num_t_instruments * num_t_layers * t_layer_size;
+    if( trg_size > SEQ_TRG_MAX_BYTES )
+      trg_size = SEQ_TRG_MAX_BYTES;
+    memcpy((u8 *)&seq_trg_layer_value[track], prefetch->trk[track_i].trg, trg_size);
+
+    // finally update CC links again, because some of them depend on SEQ_PAR_NumLayersGet()!!!
+    SEQ_CC_LinkUpdate(track);
+  }
+
+  return 0; // no error
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // writes a pattern of a given group into bank
 // returns < 0 on errors (error codes are documented in seq_file.h)
@@ -606,6 +788,8 @@ s32 SEQ_FILE_B_PatternWrite(char *session, u8 bank, u8 pattern, u8 source_group,
   if( pattern >= info->header.num_patterns )
     return SEQ_FILE_B_ERR_INVALID_PATTERN;
 
+  ++bank_modification_ctr; // invalidates prefetched patterns
+
 
   // TODO: before writing into pattern slot, we should check if it already exists, and then
   // compare layer parameters with given constraints available in following defines/variables:
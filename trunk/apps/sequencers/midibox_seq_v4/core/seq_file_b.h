@@ -15,6 +15,11 @@
 #define _SEQ_FILE_B_H
 
 
+#include "seq_core.h"
+#include "seq_par.h"
+#include "seq_trg.h"
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Global definitions
 /////////////////////////////////////////////////////////////////////////////
@@ -26,6 +31,30 @@
 // Global Types
 /////////////////////////////////////////////////////////////////////////////
 
+// a pattern which has been read by SEQ_FILE_B_PatternPrefetch()
+// it's taken over by SEQ_FILE_B_PatternApply() w/o accessing the SD Card
+typedef struct {
+  u8   valid;         // set by SEQ_FILE_B_PatternPrefetch() on success
+  u8   bank;
+  u8   pattern;
+  u8   num_tracks;
+  u32  modification_ctr; // to detect bank changes after the prefetch
+  char name[20];
+
+  struct {
+    char name[80];
+    u8   num_p_instruments;
+    u8   num_t_instruments;
+    u8   num_p_layers;
+    u8   num_t_layers;
+    u16  p_layer_size;
+    u16  t_layer_size;
+    u8   cc[128];
+    u8   par[SEQ_PAR_MAX_BYTES];
+    u8   trg[SEQ_TRG_MAX_BYTES];
+  } trk[SEQ_CORE_NUM_TRACKS_PER_GROUP];
+} seq_file_b_prefetch_t;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Prototypes
@@ -42,6 +71,8 @@ extern s32 SEQ_FILE_B_Create(char *session, u8 bank);
 extern s32 SEQ_FILE_B_Open(char *session, u8 bank);
 
 extern s32 SEQ_FILE_B_PatternRead(u8 bank, u8 pattern, u8 target_group,  u16 remix_map);
+extern s32 SEQ_FILE_B_PatternPrefetch(u8 bank, u8 pattern, seq_file_b_prefetch_t *prefetch);
+extern s32 SEQ_FILE_B_PatternApply(seq_file_b_prefetch_t *prefetch, u8 target_group, u16 remix_map);
 extern s32 SEQ_FILE_B_PatternWrite(char *session, u8 bank, u8 pattern, u8 source_group, u8 rename_if_empty_name);
 
 extern s32 SEQ_FILE_B_PatternPeekName(u8 bank, u8 pattern, u8 non_cached, char *pattern_name);
@@ -74,9 +74,6 @@ static mios32_midi_port_t seq_midply_port;
 static u32 midifile_pos;
 static u32 midifile_len;
 
-// for FFWD function
-static u8 ffwd_silent_mode;
-
 // next tick at which the prefetch should take place
 static u32 next_prefetch;
 
@@ -376,9 +373,8 @@ s32 SEQ_MIDPLY_Reset(void)
   // (otherwise they will be played much later...)
   SEQ_MIDPLY_PlayOffEvents();
 
-  // release pause and FFWD mode
+  // release pause
   ui_seq_pause = 0;
-  ffwd_silent_mode = 0;
   next_prefetch = 0;
   prefetch_offset = 0;
   loop_req = 0;
@@ -451,9 +447,9 @@ s32 SEQ_MIDPLY_SongPos(u16 new_song_pos, u8 from_midi)
 
   if( new_song_pos > 1 ) {
     // (silently) fast forward to requested position
-    ffwd_silent_mode = 1;
-    MID_PARSER_FetchEvents(0, new_tick - 1);
-    ffwd_silent_mode = 0;
+    // the parser continues from the nearest checkpoint of its seek index, and plays
+    // the last program change/controller values (if MID_PARSER_SEEK_INDEX_SIZE > 0)
+    MID_PARSER_SeekTick(new_tick - 1, 1);
   }
 
   // when do we expect the next prefetch:
@@ -632,11 +628,8 @@ static s32 SEQ_MIDPLY_PlayEvent(u8 track, mios32_midi_package_t midi_package, u3
   DEBUG_MSG("Play %u -> %u (current: %u)\n", old_tick, tick, SEQ_BPM_TickGet());
 #endif
 
-  // ignore all events in silent mode (for SEQ_MIDPLY_SongPos function)
-  // we could implement a more intelligent parser, which stores the sent CC/program change, etc...
-  // and sends the last received values before restarting the song...
-  if( ffwd_silent_mode )
-    return 0;
+  // note: events which are skipped by SEQ_MIDPLY_SongPos() are not forwarded to this function,
+  // only the chased program change/controller values are played at the new position
   
   seq_midi_out_event_type_t event_type = SEQ_MIDI_OUT_OnEvent;
   if( midi_package.event == NoteOff || (midi_package.event == NoteOn && midi_package.velocity == 0) ) {
@@ -46,9 +46,23 @@
 
 
 // debug messages on pattern req/load for time measurements
+// also reports the time spent in the critical section of SEQ_PATTERN_Handler() and the worst case
+// (uses the MIOS32_STOPWATCH, therefore it can't be combined with STOPWATCH_PERFORMANCE_MEASURING)
 #define CHECK_PATTERN_REQ_LOAD_TIMINGS 0
 
 
+// number of buffers which are used to preload requested patterns, so that
+// SEQ_PATTERN_Handler() doesn't need to access the SD Card at the pattern change point.
+// Each buffer allocates ca. 5.8k - can be overruled in mios32_config.h (0 disables the prefetch)
+#ifndef SEQ_PATTERN_PREFETCH_NUM
+#define SEQ_PATTERN_PREFETCH_NUM 1
+#endif
+
+#ifndef AHB_SECTION
+#define AHB_SECTION
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Global variables
 /////////////////////////////////////////////////////////////////////////////
@@ -61,6 +75,25 @@ mios32_sys_time_t seq_pattern_start_time;
 u8 seq_pattern_mixer_num;
 u16 seq_pattern_remix_map;
 
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+// set by SEQ_PATTERN_Change() if SEQ_PATTERN_PrefetchHandler() should switch to the new patterns
+static volatile u8 pattern_handler_req;
+
+#if SEQ_PATTERN_PREFETCH_NUM
+// only accessed while MUTEX_SDCARD is taken!
+static seq_file_b_prefetch_t AHB_SECTION pattern_prefetch[SEQ_PATTERN_PREFETCH_NUM];
+static u8 pattern_prefetch_group[SEQ_PATTERN_PREFETCH_NUM];
+#endif
+
+#if CHECK_PATTERN_REQ_LOAD_TIMINGS
+static u8 pattern_load_prefetched;
+static u32 pattern_load_us_max;
+#endif
+
 /////////////////////////////////////////////////////////////////////////////
 // Initialisation
 /////////////////////////////////////////////////////////////////////////////
@@ -69,6 +102,17 @@ s32 SEQ_PATTERN_Init(u32 mode)
   seq_pattern_start_time.seconds = 0;
   seq_pattern_mixer_num = 0;
   seq_pattern_remix_map = 0;
+  pattern_handler_req = 0;
+
+#if SEQ_PATTERN_PREFETCH_NUM
+  {
+    int i;
+    for(i=0; i<SEQ_PATTERN_PREFETCH_NUM; ++i) {
+      pattern_prefetch[i].valid = 0;
+      pattern_prefetch_group[i] = 0;
+    }
+  }
+#endif
 	
   // pre-init pattern numbers
   u8 group;
@@ -100,6 +144,11 @@ s32 SEQ_PATTERN_Init(u32 mode)
   SEQ_STATISTICS_StopwatchInit();
 #endif
 
+#if CHECK_PATTERN_REQ_LOAD_TIMINGS
+  pattern_load_us_max = 0;
+  MIOS32_STOPWATCH_Init(1); // 1 uS resolution
+#endif
+
   return 0; // no error
 }
 
@@ -153,10 +202,14 @@ s32 SEQ_PATTERN_Change(u8 group, seq_pattern_t pattern, u8 force_immediate_chang
 
     if( seq_core_options.SYNCHED_PATTERN_CHANGE && !SEQ_SONG_ActiveGet() ) {
       // done in SEQ_CORE_Tick() when last step reached
+      // in the meantime the low-prio pattern handler preloads the pattern
+      SEQ_TASK_PatternResume();
     } else {
 #if CHECK_PATTERN_REQ_LOAD_TIMINGS
       DEBUG_MSG("[%d] Req G%d %c%d", SEQ_BPM_TickGet(), group+1, 'A'+pattern.group, pattern.num+1);
 #endif
+      pattern_handler_req = 1;
+
       // pregenerate bpm ticks
       // (won't be generated again if there is already an ongoing request)
       MUTEX_MIDIOUT_TAKE;
@@ -177,8 +230,88 @@ s32 SEQ_PATTERN_Change(u8 group, seq_pattern_t pattern, u8 force_immediate_chang
 
 
 /////////////////////////////////////////////////////////////////////////////
-// This function should be called from a separate task to handle pattern
-// change requests
+// Returns the prefetch buffer which contains the given pattern for a group
+// Returns -1 if the pattern hasn't been preloaded
+/////////////////////////////////////////////////////////////////////////////
+#if SEQ_PATTERN_PREFETCH_NUM
+static s32 SEQ_PATTERN_PrefetchSearch(u8 group, seq_pattern_t pattern)
+{
+  int i;
+  for(i=0; i<SEQ_PATTERN_PREFETCH_NUM; ++i) {
+    seq_file_b_prefetch_t *prefetch = &pattern_prefetch[i];
+    if( prefetch->valid && pattern_prefetch_group[i] == group &&
+	prefetch->bank == pattern.bank && prefetch->pattern == pattern.pattern )
+      return i;
+  }
+
+  return -1; // not preloaded
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This function should be called from a separate low-prio task
+// It preloads requested patterns into the prefetch buffers, so that the
+// pattern change point only has to copy the data (see SEQ_PATTERN_Load())
+// Thereafter pattern changes which aren't synchronized to the measure are
+// handled immediately.
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_PATTERN_PrefetchHandler(void)
+{
+#if SEQ_PATTERN_PREFETCH_NUM
+  u8 group;
+
+  for(group=0; group<SEQ_CORE_NUM_GROUPS; ++group) {
+    seq_pattern_t pattern = seq_pattern_req[group];
+
+    if( !pattern.REQ )
+      continue;
+
+    MUTEX_SDCARD_TAKE;
+
+    if( SEQ_PATTERN_PrefetchSearch(group, pattern) < 0 ) {
+      // take the buffer which has been used for this group before, otherwise a free one
+      s32 buffer = -1;
+      int i;
+      for(i=0; i<SEQ_PATTERN_PREFETCH_NUM && buffer < 0; ++i) {
+	if( pattern_prefetch[i].valid && pattern_prefetch_group[i] == group )
+	  buffer = i;
+      }
+      for(i=0; i<SEQ_PATTERN_PREFETCH_NUM && buffer < 0; ++i) {
+	if( !pattern_prefetch[i].valid )
+	  buffer = i;
+      }
+
+      // if no buffer is free, the pattern will be loaded by SEQ_PATTERN_Handler()
+      if( buffer >= 0 ) {
+	pattern_prefetch_group[buffer] = group;
+#if CHECK_PATTERN_REQ_LOAD_TIMINGS
+	DEBUG_MSG("[%d] Prefetch begin G%d %c%d", SEQ_BPM_TickGet(), group+1, 'A'+pattern.group, pattern.num+1);
+#endif
+	SEQ_FILE_B_PatternPrefetch(pattern.bank, pattern.pattern, &pattern_prefetch[buffer]);
+#if CHECK_PATTERN_REQ_LOAD_TIMINGS
+	DEBUG_MSG("[%d] Prefetch end G%d %c%d", SEQ_BPM_TickGet(), group+1, 'A'+pattern.group, pattern.num+1);
+#endif
+      }
+    }
+
+    MUTEX_SDCARD_GIVE;
+  }
+#endif
+
+  if( pattern_handler_req ) {
+    pattern_handler_req = 0;
+    SEQ_PATTERN_Handler();
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This function handles pattern change requests
+// Called from SEQ_PATTERN_PrefetchHandler(), and from SEQ_CORE_Handler()
+// when synchronized pattern changes are enabled
 /////////////////////////////////////////////////////////////////////////////
 s32 SEQ_PATTERN_Handler(void)
 {
@@ -222,10 +355,18 @@ s32 SEQ_PATTERN_Handler(void)
 
 #if CHECK_PATTERN_REQ_LOAD_TIMINGS
       DEBUG_MSG("[%d] Load begin G%d %c%d", SEQ_BPM_TickGet(), group+1, 'A'+seq_pattern_req[group].group, seq_pattern_req[group].num+1);
+      MIOS32_STOPWATCH_Reset();
 #endif
       SEQ_PATTERN_Load(group, seq_pattern_req[group]);
 #if CHECK_PATTERN_REQ_LOAD_TIMINGS
-      DEBUG_MSG("[%d] Load end G%d %c%d", SEQ_BPM_TickGet(), group+1, 'A'+seq_pattern_req[group].group, seq_pattern_req[group].num+1);
+      {
+	u32 load_us = MIOS32_STOPWATCH_ValueGet();
+	if( load_us > pattern_load_us_max )
+	  pattern_load_us_max = load_us;
+	DEBUG_MSG("[%d] Load end G%d %c%d (%s): %d uS, worst case: %d uS",
+		  SEQ_BPM_TickGet(), group+1, 'A'+seq_pattern_req[group].group, seq_pattern_req[group].num+1,
+		  pattern_load_prefetched ? "prefetched" : "SD Card", load_us, pattern_load_us_max);
+      }
 #endif
 
       // restart *all* patterns?
@@ -261,8 +402,25 @@ s32 SEQ_PATTERN_Load(u8 group, seq_pattern_t pattern)
 #if STOPWATCH_PERFORMANCE_MEASURING == 1
   SEQ_STATISTICS_StopwatchReset();
 #endif
-  if( (status=SEQ_FILE_B_PatternRead(pattern.bank, pattern.pattern, group, seq_pattern_remix_map)) < 0 )
-    SEQ_UI_SDCardErrMsg(2000, status);
+
+  status = -1;
+#if SEQ_PATTERN_PREFETCH_NUM
+  // take over the preloaded pattern w/o SD Card access if available
+  s32 buffer = SEQ_PATTERN_PrefetchSearch(group, pattern);
+  if( buffer >= 0 ) {
+    status = SEQ_FILE_B_PatternApply(&pattern_prefetch[buffer], group, seq_pattern_remix_map);
+    pattern_prefetch[buffer].valid = 0;
+  }
+#endif
+#if CHECK_PATTERN_REQ_LOAD_TIMINGS
+  pattern_load_prefetched = status >= 0;
+#endif
+
+  // otherwise read it from SD Card (also if the bank has been changed after the prefetch)
+  if( status < 0 ) {
+    if( (status=SEQ_FILE_B_PatternRead(pattern.bank, pattern.pattern, group, seq_pattern_remix_map)) < 0 )
+      SEQ_UI_SDCardErrMsg(2000, status);
+  }
 	
   seq_pattern_start_time = MIOS32_SYS_TimeGet();
 #if STOPWATCH_PERFORMANCE_MEASURING == 1
@@ -34,6 +34,9 @@ volatile u8 mios32_srio_din_buffer[MIOS32_SRIO_NUM_SR];
 // change notification flags
 volatile u8 mios32_srio_din_changed[MIOS32_SRIO_NUM_SR];
 
+// one bit per SR which has change notification flags
+volatile u32 mios32_srio_din_changed_map[MIOS32_SRIO_DIN_CHANGED_MAP_SIZE];
+
 //////////////////////////////////////////////////////////////////////////////
 // local variables to bridge objects to C functions
 //////////////////////////////////////////////////////////////////////////////
@@ -74,6 +77,9 @@ s32 MIOS32_SRIO_Init(u32 mode)
 		mios32_srio_din_changed[i] = 0;   // no change
 	}
 
+	for(i=0; i<MIOS32_SRIO_DIN_CHANGED_MAP_SIZE; ++i)
+		mios32_srio_din_changed_map[i] = 0;
+
 	return 0;
 }
 
@@ -95,7 +101,11 @@ s32 MIOS32_SRIO_ScanStart(void *_notify_hook)
 	// copy/or buffered DIN values/changed flags
 	int i;
 	for(i=0; i<MIOS32_SRIO_NUM_SR; ++i) {
-		mios32_srio_din_changed[i] |= mios32_srio_din[i] ^ mios32_srio_din_buffer[i];
+		u8 changed = mios32_srio_din[i] ^ mios32_srio_din_buffer[i];
+		if( changed ) {
+			mios32_srio_din_changed[i] |= changed;
+			mios32_srio_din_changed_map[i / 32] |= 0x80000000 >> (i % 32);
+		}
 		mios32_srio_din[i] = mios32_srio_din_buffer[i];
 	}
 
@@ -54,6 +54,12 @@ extern void APP_SendDebugMessage(char *format, ...);
 # define AHB_SECTION
 #endif
 
+// number of buffers to preload requested patterns (see seq_pattern.c)
+// each buffer allocates ca. 5.8k - not enough RAM available on STM32F103
+#if defined(MIOS32_FAMILY_STM32F10x)
+# define SEQ_PATTERN_PREFETCH_NUM 0
+#endif
+
 
 // increased number of SRs (MBSEQ uses 16 SRs by default, but it's possible to increase the number in MBSEQ_HW.V4)
 #define MIOS32_SRIO_NUM_SR 23
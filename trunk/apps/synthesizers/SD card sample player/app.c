@@ -20,35 +20,39 @@
 #include <mios32.h>
 #include "app.h"
 #include <file.h>
+#include <sample_stream.h>
 #include <string.h>
 
 // Task stuff - the bank switch scanning is lower priority than the voice processing
+// sample data is fetched from SD card with highest priority
+#define PRIORITY_STREAM_TASK	( tskIDLE_PRIORITY + 4 )
 #define PRIORITY_VOICE_TASK	( tskIDLE_PRIORITY + 3 )
 #define PRIORITY_BANKSWITCH_TASK	( tskIDLE_PRIORITY + 2 )
+static void TASK_SAMPLE_STREAM(void *pvParameters);
 static void TASK_VOICE_SCAN(void *pvParameters);
 static void TASK_BANKSWITCH_SCAN(void *pvParameters);
 
+// SD card semaphore: taken by the stream task while fetching sample data, and while a bank is loaded
+xSemaphoreHandle xSDCardSemaphore;
+#define MUTEX_SDCARD_TAKE { while( xSemaphoreTakeRecursive(xSDCardSemaphore, (portTickType)1) != pdTRUE ); }
+#define MUTEX_SDCARD_GIVE { xSemaphoreGiveRecursive(xSDCardSemaphore); }
+
 /////////////////////////////////////////////////////////////////////////////
 // Local definitions
 /////////////////////////////////////////////////////////////////////////////
 
-#define NUM_SAMPLES_TO_OPEN 64	// Maximum number of file handles to use, and how many samples to open
-#define POLYPHONY 8				// Max voices to sound simultaneously
+#define NUM_SAMPLES_TO_OPEN SAMPLE_STREAM_NUM_STREAMS	// Maximum number of file handles to use, and how many samples to open
+#define POLYPHONY SAMPLE_STREAM_NUM_VOICES		// Max voices to sound simultaneously (configured in mios32_config.h)
 
 // Following accounts for: 7 bits (envelope decay) + 7 bits (velocity related volume) + 1-3 bits (mixing up to 8 samples but depends how hot your samples are)
 #define SAMPLE_SCALING 15        // Number of bits to scale samples down by in order to not distort - added 7 bits for midi volume now
 
-#define MAX_TIME_IN_DMA 45		// Time (*0.1ms) to read sample data for, e.g. 40 = 4.0 mS
-
 #define SAMPLE_BUFFER_SIZE 512  // -> 512 L/R samples, 80 Hz refill rate (11.6~ mS period). DMA refill routine called every 5.8mS.
 // NB sample rate and SPI prescaler set in mios32_config file - at 44.1kHz, reading 2 bytes per sample is SD card average rate of 86.13kB/s for a single sample
 
 #define DEBUG_VERBOSE_LEVEL 10
 #define DEBUG_MSG MIOS32_MIDI_SendDebugMessage
 
-// Now mandatory to have this set as legacy read code removed
-#define CLUSTER_CACHE_SIZE 32 // typically for 32 * 64*512 bytes = max sample file length of 1 MB !!!
-
 // set to 1 to perform right channel inversion for PCM1725 DAC
 #define DAC_FIX 0
 
@@ -81,7 +85,6 @@ u8 no_samples_loaded;								// Stores number of samples we read in from bank fi
 
 static u32 sample_buffer[SAMPLE_BUFFER_SIZE]; // sample buffer used for DMA
 
-static u32 samplefile_pos[NUM_SAMPLES_TO_OPEN];	// Current position in the sample file
 static u32 samplefile_len[NUM_SAMPLES_TO_OPEN];	// Length of the sample file
 static s16 sample_on[NUM_SAMPLES_TO_OPEN];	// To track whether each sample should be on or not
 static s8 sample_vel[NUM_SAMPLES_TO_OPEN];	// Sample velocity
@@ -90,8 +93,6 @@ static u8 sample_decval[NUM_SAMPLES_TO_OPEN];	// Decay time read in from bank fi
 static u8 no_decay;								// Used to speed up decay routine if this bank has no decay time
 static u8 hold_sample[NUM_SAMPLES_TO_OPEN];		// Used to hold sample (for drums)
 static file_t samplefile_fileinfo[NUM_SAMPLES_TO_OPEN];	// Create the right number of file descriptors
-static u8 samplebyte_buf[POLYPHONY][SAMPLE_BUFFER_SIZE];	// Create a buffer for each voice
-static u32 sample_cluster_cache[NUM_SAMPLES_TO_OPEN][CLUSTER_CACHE_SIZE];	// Array of sample cluster positions on SD card
 
 static u8 sample_bank_no=1;	// The sample bank number being played
 static u8 switch_bank_no=1;	// The sample bank selected via switch for J10 
@@ -126,7 +127,6 @@ s32 SAMP_FILE_open(u8 sample_n, char fname[])
   } else {
 
     // got it
-    samplefile_pos[sample_n] = 0;
     samplefile_len[sample_n] = samplefile_fileinfo[sample_n].fsize;
 
     DEBUG_MSG("[APP] Sample no %d filename %s opened of length %u\n", sample_n,fname,samplefile_len[sample_n]);
@@ -135,27 +135,6 @@ s32 SAMP_FILE_open(u8 sample_n, char fname[])
   return status;
 }
 
-/////////////////////////////////////////////////////////////////////////////
-// reads <len> bytes from the .mid file into <buffer>
-// returns number of read bytes
-/////////////////////////////////////////////////////////////////////////////
-int SAMP_FILE_read(void *buffer, u32 len, u8 sample_n)
-{
-  // determine sector based on sample position
-  u32 pos = samplefile_pos[sample_n];
-  u32 sector_ix = pos / 512;
-  u32 sectors_per_cluster = FILE_VolumeSectorsPerCluster();
-  u32 cluster_ix = sector_ix / sectors_per_cluster;
-  if( cluster_ix >= CLUSTER_CACHE_SIZE )
-    return -1;
-
-  u32 cluster = sample_cluster_cache[sample_n][cluster_ix];
-  u32 phys_sector = FILE_VolumeCluster2Sector(cluster) + (sector_ix % sectors_per_cluster);
-  if( MIOS32_SDCARD_SectorRead(phys_sector, buffer) < 0 )
-    return -2;
-  return len;
-}
-
 void Open_Bank(u8 b_num)	// Open the bank number passed and parse the bank information, load samples, set midi notes, number of samples and cache cluster positions
 {
   u8 samp_no;
@@ -171,6 +150,9 @@ void Open_Bank(u8 b_num)	// Open the bank number passed and parse the bank infor
   strcat(b_file,b_num_char);		// Create the final filename
   
   MIOS32_BOARD_LED_Set(0x1, 0x1);	// Turn on LED during bank load
+
+  MUTEX_SDCARD_TAKE;
+  SAMPLE_STREAM_Init(0);			// Stop all voices and close the streams of the previous bank
   
   no_samples_loaded=0;
   no_decay=1;						// Default to no decay for bank
@@ -200,11 +182,12 @@ void Open_Bank(u8 b_num)	// Open the bank number passed and parse the bank infor
 		   if(SAMP_FILE_open(samp_no,sample_filenames[samp_no])) {
 		   DEBUG_MSG("Open sample file failed.");
 		   } else {
-			 // Pre-read all the cluster positions for all samples to open
+			 // Pre-read all the cluster positions for all samples to open, and pass them as sector ranges to the streaming module
 			 u32 num_sectors_per_cluster = FILE_VolumeSectorsPerCluster();
 			 u32 cluster_ix;
-			 for(cluster_ix=0; cluster_ix < CLUSTER_CACHE_SIZE; ++cluster_ix) {
-			   u32 pos = cluster_ix*num_sectors_per_cluster*SAMPLE_BUFFER_SIZE;
+			 SAMPLE_STREAM_Open(samp_no, samplefile_len[samp_no]);
+			 for(cluster_ix=0; ; ++cluster_ix) {
+			   u32 pos = cluster_ix*num_sectors_per_cluster*512;
 
 			   if( pos >= samplefile_len[samp_no] )
 			 break; // end of file reached
@@ -222,14 +205,23 @@ void Open_Bank(u8 b_num)	// Open the bank number passed and parse the bank infor
 			   break;
 			   }
 
-			   sample_cluster_cache[samp_no][cluster_ix] = samplefile_fileinfo[samp_no].curr_clust;
-			   DEBUG_MSG("Cluster %d: %d ", cluster_ix, sample_cluster_cache[samp_no][cluster_ix]);
+			   u32 cluster = samplefile_fileinfo[samp_no].curr_clust;
+			   DEBUG_MSG("Cluster %d: %d ", cluster_ix, cluster);
+			   if( SAMPLE_STREAM_ExtentAdd(samp_no, FILE_VolumeCluster2Sector(cluster), num_sectors_per_cluster) < 0 ) {
+			 DEBUG_MSG("Sample file too fragmented - truncated after %d clusters", cluster_ix);
+			 break;
+			   }
 			 }
+
+			 // Preload the attack into RAM
+			 if( SAMPLE_STREAM_Preload(samp_no) < 0 )
+			   DEBUG_MSG("Preloading sample %d failed.", samp_no);
 		   }
 
 		   sample_on[samp_no]=0;	// Set sample to off
 		 }
 	}
+	MUTEX_SDCARD_GIVE;
 	MIOS32_BOARD_LED_Set(0x1, 0x0);	// Turn off LED after bank load
 }
 
@@ -292,6 +284,10 @@ void APP_Init(void)
   print_msg = PRINT_MSG_INIT;
   DEBUG_MSG(MIOS32_LCD_BOOT_MSG_LINE1);
   DEBUG_MSG(MIOS32_LCD_BOOT_MSG_LINE2);  
+
+  // create semaphore for SD card access
+  xSDCardSemaphore = xSemaphoreCreateRecursiveMutex();
+
   DEBUG_MSG("Initialising SD card..");
   
   if(FILE_Init(0)<0) { DEBUG_MSG("Error initialising SD card"); } // initialise SD card
@@ -330,9 +326,8 @@ void APP_Init(void)
   SYNTH_Init(0);
   DEBUG_MSG("Synth init done."); 
 
-  MIOS32_STOPWATCH_Init(100);		// Use stopwatch in 100uS accuracy
-  
-  // Start tasks for voice processing and bank switch scanning
+  // Start tasks for sample streaming, voice processing and bank switch scanning
+  xTaskCreate(TASK_SAMPLE_STREAM, (signed portCHAR *)"SAMPLE_STREAM", configMINIMAL_STACK_SIZE, NULL, PRIORITY_STREAM_TASK, NULL);
   xTaskCreate(TASK_VOICE_SCAN, (signed portCHAR *)"VOICE_SCAN", configMINIMAL_STACK_SIZE, NULL, PRIORITY_VOICE_TASK, NULL);
   xTaskCreate(TASK_BANKSWITCH_SCAN, (signed portCHAR *)"BANKSWITCH_SCAN", configMINIMAL_STACK_SIZE, NULL, PRIORITY_BANKSWITCH_TASK, NULL);
 }
@@ -443,51 +438,40 @@ void SYNTH_ReloadSampleBuffer(u32 state)
 
   // Each sample buffer entry contains the L/R 32 bit values
   // Each call of this routine will need to read in SAMPLE_BUFFER_SIZE/2 samples, each of which requires 16 bits
-  // Therefore for mono samples, we'll need to read in SAMPLE_BUFFER_SIZE bytes
+  // Therefore for mono samples, we'll need one sector (512 bytes) of each playing sample
+  // The sectors have been prefetched by TASK_SAMPLE_STREAM, so no SD card access is required here
 
   u8 voice;
+  u8 mix_no=0;	// number of voices to mix
+  u8 *mix_buf[POLYPHONY];	// sector of each voice
+  s16 mix_velocity[POLYPHONY];	// velocity of each voice
 
   s16 OutWavs16;	// 16 bit output to DAC
   s32 OutWavs32;	// 32 bit accumulator to mix samples into
-  u32 ms_so_far;		// used to measure time of DMA routine
 
-  MIOS32_STOPWATCH_Reset();			// Reset the stopwatch at start of DMA routine
   MIOS32_BOARD_LED_Set(0x1, 0x1);	// Turn on LED at start of DMA routine
   
 
 	// Here we have voice_no samples to play simultaneously, and the samples contained in voice_samples array
-
-	if(voice_no)	// if there's anything to play, read the samples and mix otherwise output silence
+	for(voice=0;voice<voice_no;voice++)
 	{
-		for(voice=0;voice<voice_no;voice++) 	// read up to SAMPLE_BUFFER_SIZE characters into buffer for each voice
+		// get the next sector of each sample; a sample which hasn't been fetched in time is muted for this buffer
+		// the streaming module frees the voice once the end of the sample has been reached
+		if(SAMPLE_STREAM_Read(voice_samples[voice],&mix_buf[mix_no])>0)
 		{
-			if(SAMP_FILE_read(samplebyte_buf[voice],SAMPLE_BUFFER_SIZE,voice_samples[voice])<0) // Read in the appropriate number of sectors for each sample thats on
-			{	// if <0 then there was an error reading, so turn this sample off and mute it
-			 sample_on[voice_samples[voice]]=0; // Turn sample off
-			 voice_velocity[voice]=0;			// Silence it in the mix as we don't have a complete buffer
-			}
-			
-			samplefile_pos[voice_samples[voice]]+=SAMPLE_BUFFER_SIZE;	// Move along the file position by the read buffer size
-			if(samplefile_pos[voice_samples[voice]] >= samplefile_len[voice_samples[voice]]) // We've reached EOF - don't play this sample next time and also free up the voice
-			{ 
-				sample_on[voice_samples[voice]]=0; // Turn sample off
-				//DEBUG_MSG("Reached EOF on sample %d",voice_samples[voice]);
-			}
-			 ms_so_far= MIOS32_STOPWATCH_ValueGet();	// Check how long we've been in the routine up until this point
-			if(ms_so_far>MAX_TIME_IN_DMA)				
-				{ 
-				 DEBUG_MSG("Abandoning DMA routine after %d.%d ms, after %d voices out of %d",ms_so_far/10,ms_so_far%10,voice+1,voice_no);
-				 voice_no=voice+1;	// don't mix un-read voices (eg if break after 1st voice, voice_no should =1)
-				 break;	// go straight to sample mixing
-				}
+			mix_velocity[mix_no]=voice_velocity[voice];
+			mix_no++;
 		}
+	}
 
+	if(mix_no)	// if there's anything to play mix the samples, otherwise output silence
+	{
 		for(i=0; i<SAMPLE_BUFFER_SIZE; i+=2) // Fill half the sample buffer
 			{	
 				OutWavs32=0;	// zero the voice accumulator for this sample output
-				for(voice=0;voice<voice_no;voice++)
+				for(voice=0;voice<mix_no;voice++)
 				{
-						OutWavs32+=voice_velocity[voice]*(s16)((samplebyte_buf[voice][i+1] << 8) + samplebyte_buf[voice][i]);		// else mix it in
+						OutWavs32+=mix_velocity[voice]*(s16)((mix_buf[voice][i+1] << 8) + mix_buf[voice][i]);		// else mix it in
 				}
 				OutWavs32 = (OutWavs32>>SAMPLE_SCALING);	// Round down the wave to prevent distortion, and factor in the velocity multiply
 				if(OutWavs32>32767) { OutWavs32=32767; }	// Saturate positive
@@ -508,8 +492,6 @@ void SYNTH_ReloadSampleBuffer(u32 state)
 	 }
 
 	 MIOS32_BOARD_LED_Set(0x1, 0x0);	// Turn off LED at end of DMA routine
-	//ms_so_far= MIOS32_STOPWATCH_ValueGet();	// Check how long we've been in the routine up until this point
-	//DEBUG_MSG("%d.%d ms,%d.%d ms,%d.%d ms, %d voices",ms2_so_far/10,ms2_so_far%10,ms3_so_far/10,ms3_so_far%10,ms_so_far/10,ms_so_far%10,voice_no);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -544,6 +526,73 @@ void APP_AIN_NotifyChange(u32 pin, u32 pin_value)
 {
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// Fetches the sample data of all playing voices from SD card
+/////////////////////////////////////////////////////////////////////////////
+static void TASK_SAMPLE_STREAM(void *pvParameters)
+{
+  s32 status;
+
+  portTickType xLastExecutionTime;
+
+  // Initialise the xLastExecutionTime variable on task entry
+  xLastExecutionTime = xTaskGetTickCount();
+
+  while( 1 ) 
+  {
+    vTaskDelayUntil(&xLastExecutionTime, 1 / portTICK_RATE_MS);		// Run this every 1 ms, this WILL be interrupted every now and again by the DMA fill interrupt
+
+	if( sdcard_access_allowed )
+	{
+		MUTEX_SDCARD_TAKE;
+		// fetch sectors in deadline order until all prefetch buffers are filled
+		do {
+			status=SAMPLE_STREAM_Service();
+		} while( status > 0 );
+		MUTEX_SDCARD_GIVE;
+
+		if( status < 0 )
+			DEBUG_MSG("SD card read error %d - sample stopped", status);
+	}
+  }
+}
+
+s32 Steal_Voice(u8 *new_voice_no)	// Stops the quietest decaying sample to free its voice, returns the sample number or -1 if no sample is decaying
+{
+  u8 samp_no;
+  s32 steal_no=-1;
+  u8 voice;
+
+	for(samp_no=0;samp_no<no_samples_loaded;samp_no++)
+	{
+		if(sample_on[samp_no]>0 && SAMPLE_STREAM_IsPlaying(samp_no) && (steal_no<0 || sample_vel[samp_no]<sample_vel[steal_no]))
+		 steal_no=samp_no;
+	}
+
+	if(steal_no<0)	// All voices are playing held or sustained samples
+	 return -1;
+
+	SAMPLE_STREAM_Stop(steal_no);
+	sample_on[steal_no]=0;
+	sample_vel[steal_no]=0;
+
+	for(voice=0;voice<*new_voice_no;voice++)	// Remove it from the voices which have already been collected in this scan
+	{
+		if(voice_samples[voice]==steal_no)
+		{
+			for(;voice<(*new_voice_no-1);voice++)
+			{
+				voice_samples[voice]=voice_samples[voice+1];
+				voice_velocity[voice]=voice_velocity[voice+1];
+			}
+			(*new_voice_no)--;
+			break;
+		}
+	}
+
+	return steal_no;
+}
+
 static void TASK_VOICE_SCAN(void *pvParameters)
 {
   u8 samp_no;
@@ -561,59 +610,55 @@ static void TASK_VOICE_SCAN(void *pvParameters)
 		// toggle Status LED to as a sign of live
 		//MIOS32_BOARD_LED_Set(1, ~MIOS32_BOARD_LED_Get());
 
+		if( !sdcard_access_allowed )	// bank is loading
+			continue;
+
 		new_voice_no=0;
 		
-		// Work out which voices need to play which sample, this has lowest sample number priority
+		// Start newly triggered samples, and collect the samples which are played by the streaming module
+		// If all voices are in use, the voice of the quietest decaying sample is taken
 		for(samp_no=0;samp_no<no_samples_loaded;samp_no++)
 		{
-			if(new_voice_no<POLYPHONY)	// As long as not already at max voices, otherwise don't trigger/play
+			if(sample_on[samp_no]==-1)					// Newly triggered sample (set to -1 by midi receive routine)
+			{
+				s32 status=SAMPLE_STREAM_Start(samp_no);	// (Re)start the sample from position zero
+				if(status==-1 && Steal_Voice(&new_voice_no)>=0)	// No free voice
+				 status=SAMPLE_STREAM_Start(samp_no);
+				if(status<0)
+				 sample_on[samp_no]=0;				// No free voice
+				else
+				 sample_on[samp_no]=-2;				// Mark as on and don't retrigger on next loop
+			}
+
+			if(!SAMPLE_STREAM_IsPlaying(samp_no))	// Reached EOF (or read error)
+			{
+				sample_on[samp_no]=0;
+				continue;
+			}
+
+			if(sample_on[samp_no]>0)	// positive number = decaying
+			{
+				sample_on[samp_no]--;				// Decrement decay time
+				if(sample_on[samp_no]<0) { sample_vel[samp_no]=0; sample_on[samp_no]=0;}	// If finished decaying mark as off
+				else
 				{
-				 if(sample_on[samp_no]<0)	// We want to play this voice (either newly triggered =1 or continue playing =2)
-					{
-						voice_samples[new_voice_no]=samp_no;	// Assign the next available voice to this sample number
-						//voice_velocity[new_voice_no]=(s16)(sample_vel[samp_no]);	// Assign velocity to voice - cast required to ensure the voice accumulation multiply is fast signed 16 bit
-						voice_velocity[new_voice_no]=(s16)(sample_vel[samp_no]*midi_volume);    // Assign velocity to voice - cast required to ensure the voice accumulation multiply is fast signed 16 bit
-						new_voice_no++;							// And increment number of voices in use
-						if(sample_on[samp_no]==-1)					// Newly triggered sample (set to -1 by midi receive routine)
-						{
-						 samplefile_pos[samp_no]=0;	// Mark at position zero (used for sector reads and EOF calculations)
-						 sample_on[samp_no]=-2;		// Mark as on and don't retrigger on next loop
-						 }
-					}
-				
+					if((sample_on[samp_no]%8)==0) { 
+						sample_vel[samp_no]-=sample_decay[samp_no];		// decrement volume by appropriate amount 
+						//DEBUG_MSG("vel is %d, sample on is %d, sample_decay is %d",sample_vel[samp_no],sample_on[samp_no],sample_decay[samp_no]);
+					   }
 				}
-				else
-				{ break; }		// stop looking if we're full!
-		}
+				if(sample_vel[samp_no]<=0) { sample_vel[samp_no]=0; sample_on[samp_no]=0; }
+			}
 
-		if(!no_decay || new_voice_no<POLYPHONY)	// Only process decaying notes if decay is enabled or we have any voices left
-		{
-			// now new notes allocated, fill up any remaining voices with decaying ones
-			for(samp_no=0;samp_no<no_samples_loaded;samp_no++)
+			if(sample_on[samp_no]==0)	// Turned off by note off or finished decaying: free the voice
 			{
-				if(new_voice_no<POLYPHONY)	// As long as not already at max voices, otherwise don't trigger/play
-					{
-					if(sample_on[samp_no]>0)	// positive number = decaying
-						{
-							voice_samples[new_voice_no]=samp_no;	// Assign the next available voice to this sample number
-							voice_velocity[new_voice_no]=(s16)(sample_vel[samp_no]*midi_volume);					
-							new_voice_no++;							// And increment number of voices in use				
-							sample_on[samp_no]--;				// Decrement decay time
-							if(sample_on[samp_no]<0) { sample_vel[samp_no]=0; sample_on[samp_no]=0;}	// If finished decaying mark as off
-							else
-							{
-								if((sample_on[samp_no]%8)==0) { 
-									sample_vel[samp_no]-=sample_decay[samp_no];		// decrement volume by appropriate amount 
-									//DEBUG_MSG("vel is %d, sample on is %d, sample_decay is %d",sample_vel[samp_no],sample_on[samp_no],sample_decay[samp_no]);
-								   }
-							}
-							if(sample_vel[samp_no]<=0) { sample_vel[samp_no]=0; sample_on[samp_no]=0; }
-						}
-					
-					}
-					else
-					{ break;}	// stop looking if we're full
+				SAMPLE_STREAM_Stop(samp_no);
+				continue;
 			}
+
+			voice_samples[new_voice_no]=samp_no;	// Assign the next voice to this sample number
+			voice_velocity[new_voice_no]=(s16)(sample_vel[samp_no]*midi_volume);    // Assign velocity to voice - cast required to ensure the voice accumulation multiply is fast signed 16 bit
+			new_voice_no++;							// And increment number of voices in use
 		}
 
 	voice_no=new_voice_no;	// Set the global voice count now we're done
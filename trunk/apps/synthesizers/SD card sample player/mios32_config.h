@@ -31,6 +31,24 @@
 #define FILE_NO_DISK_READ_ON_READREOPEN 1
 
 
+// Sample streaming: number of samples per bank, polyphony and buffer sizes
+// (see $MIOS32_PATH/modules/sample_stream/sample_stream.h)
+#define SAMPLE_STREAM_NUM_STREAMS 64
+#if defined(MIOS32_FAMILY_STM32F4xx)
+// 16 voices * 8 sectors prefetch buffer + 64 samples * 1 preloaded sector = 96k RAM
+# define SAMPLE_STREAM_NUM_VOICES      16
+# define SAMPLE_STREAM_RING_SECTORS    8
+# define SAMPLE_STREAM_READ_SECTORS    4
+# define SAMPLE_STREAM_PRELOAD_SECTORS 1
+#else
+// 8 voices * 4 sectors prefetch buffer = 16k RAM, no preload
+# define SAMPLE_STREAM_NUM_VOICES      8
+# define SAMPLE_STREAM_RING_SECTORS    4
+# define SAMPLE_STREAM_READ_SECTORS    2
+# define SAMPLE_STREAM_PRELOAD_SECTORS 0
+#endif
+
+
 // I2S support has to be enabled explicitely
 #define MIOS32_USE_I2S
 
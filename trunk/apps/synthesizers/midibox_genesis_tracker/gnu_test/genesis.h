@@ -0,0 +1,25 @@
+// $Id$
+/*
+ * MBHP_Genesis stand-in for the host test: the chip writes are
+ * implemented by vgmplayer_test.cpp
+ */
+
+#ifndef _GENESIS_H
+#define _GENESIS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef GENESIS_COUNT
+#define GENESIS_COUNT 1
+#endif
+
+extern void Genesis_OPN2Write(u8 board, u8 addrhi, u8 address, u8 data);
+extern void Genesis_PSGWrite(u8 board, u8 data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GENESIS_H */
@@ -0,0 +1,13 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host test
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+#define DBG MIOS32_MIDI_SendDebugMessage
+
+#define GENESIS_COUNT 4
+
+#endif /* _MIOS32_CONFIG_H */
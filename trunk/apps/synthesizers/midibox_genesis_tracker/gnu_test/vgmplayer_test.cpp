@@ -0,0 +1,390 @@
+// $Id$
+/*
+ * Host harness for the VGM player
+ *
+ * Plays random VGM streams with 1..VGMP_MAXHEADS heads on GENESIS_COUNT
+ * boards in simulated time: VgmPlayer_WorkCallback() is called again after
+ * the delay it returns. The chip writes are logged by Genesis_OPN2Write()
+ * and Genesis_PSGWrite(), and the harness checks that
+ *   - every head writes its stream in order, to its own board
+ *   - no write is done before its VGM time
+ *   - the busy delays of each board are respected
+ * and prints the CPU time spent in the callback for the number of heads.
+ *
+ * The VGMs are decoded by VgmPlayer_Background() each simulated mS. One run
+ * stalls the decoder for 500 mS (e.g. SD card latency): the heads have to
+ * continue without early writes once the decoder is back.
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <gnu_test.h>
+
+#include <genesis.h>
+#include "vgmplayer.h"
+#include "vgmplayer_ll.h"
+
+#define SIM_SAMPLES   (44100*10) // simulated time per run: 10 seconds
+#define BG_PERIOD     (VGMP_HRTICKSPERSAMPLE*44) // VgmPlayer_Background() each mS
+#define STALL_START   (VGMP_HRTICKSPERSAMPLE*44100) // stall: from 1 second...
+#define STALL_END     (VGMP_HRTICKSPERSAMPLE*66150) // ...to 1.5 seconds
+#define MAX_WRITES    2048       // logged writes per head
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32 stand-ins
+/////////////////////////////////////////////////////////////////////////////
+extern "C" {
+s32 MIOS32_BOARD_LED_Set(u32 leds, u32 value) { return 0; }
+u32 MIOS32_BOARD_LED_Get(void) { return 0; }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// simulated timers
+/////////////////////////////////////////////////////////////////////////////
+static uint32_t sim_hr_time;
+static u16 (*work_callback)(u32 hr_time, u32 vgm_time);
+
+extern "C" {
+void VgmPlayerLL_Init() {}
+void VgmPlayerLL_RegisterCallback(u16 (*_vgm_work_callback)(u32 hr_time, u32 vgm_time)) { work_callback = _vgm_work_callback; }
+u32 VgmPlayerLL_GetHRTime() { return sim_hr_time; }
+u32 VgmPlayerLL_GetVGMTime() { return sim_hr_time / VGMP_HRTICKSPERSAMPLE; }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// VGM source stand-in: streams are generated into buffer1
+/////////////////////////////////////////////////////////////////////////////
+VgmSourceStream::VgmSourceStream() {
+  buffer1 = NULL;
+  datalen = 0;
+  block = NULL;
+  blocklen = 0;
+  vgmdatastartaddr = 0;
+}
+VgmSourceStream::~VgmSourceStream() { delete[] buffer1; }
+static u8 *generated_data;
+static u32 generated_len;
+s32 VgmSourceStream::startStream(char* filename) { buffer1 = generated_data; datalen = generated_len; return 0; }
+void VgmSourceStream::bg_streamBuffer() {}
+u8 VgmSourceStream::getByte(u32 addr) { return (addr < datalen) ? buffer1[addr] : 0x66; }
+void VgmSourceStream::loadBlock(u32 startaddr, u32 len) {}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// streams and write log
+/////////////////////////////////////////////////////////////////////////////
+typedef struct {
+  u8  cmd;        // 0x50 or 0x52
+  u8  addr;
+  u8  data;
+  u32 vgm_time;   // earliest VGM time (relative to the start)
+} expected_write_t;
+
+typedef struct {
+  VgmSourceStream *src;
+  VgmHead *head;
+  u8 board;
+  expected_write_t expected[MAX_WRITES];
+  int num_expected;
+  int num_written;
+} test_head_t;
+
+static test_head_t heads[VGMP_MAXHEADS];
+static int num_heads;
+static uint32_t start_vgm_time;
+
+static uint32_t last_opn2_write[GENESIS_COUNT];
+static uint32_t last_psg_write[GENESIS_COUNT];
+static uint8_t  last_opn2_nodelay[GENESIS_COUNT];
+static uint8_t  board_written[GENESIS_COUNT];
+
+static uint64_t total_writes;
+static uint64_t total_lateness;
+static uint32_t max_lateness;
+
+// the head is identified by the data byte of OPN2 writes, and by the channel and
+// attenuation bits of PSG writes (see generate_stream())
+static u8 psg_data(int head_num)
+{
+  return 0x90 | ((head_num & 0x30) << 1) | (head_num & 0x0f);
+}
+
+static test_head_t *find_head(u8 cmd, u8 data)
+{
+  int head_num = (cmd == 0x50) ? (((data >> 1) & 0x30) | (data & 0x0f)) : data;
+  if( head_num >= num_heads )
+    return NULL;
+
+  test_head_t *t = &heads[head_num];
+  if( t->num_written >= t->num_expected || t->expected[t->num_written].cmd != cmd || t->expected[t->num_written].data != data )
+    return NULL;
+
+  return t;
+}
+
+static void check_write(u8 board, u8 cmd, u8 addr, u8 data)
+{
+  uint32_t vgm_time = sim_hr_time / VGMP_HRTICKSPERSAMPLE;
+  test_head_t *t = find_head(cmd, data);
+
+  CHECK(t != NULL, "unexpected write %02x %02x %02x to board %d", cmd, addr, data, board);
+  if( t == NULL )
+    return;
+
+  expected_write_t *e = &t->expected[t->num_written++];
+  CHECK(t->board == board, "head %d wrote to board %d instead of %d", (int)(t - heads), board, t->board);
+  CHECK(cmd == 0x50 || e->addr == addr, "head %d: wrong address %02x instead of %02x", (int)(t - heads), addr, e->addr);
+
+  uint32_t due = start_vgm_time + e->vgm_time;
+  CHECK((int32_t)(vgm_time - due) >= 0, "head %d: write %d at VGM time %u, before %u", (int)(t - heads), t->num_written-1, vgm_time, due);
+  uint32_t lateness = vgm_time - due;
+  total_lateness += lateness;
+  if( lateness > max_lateness )
+    max_lateness = lateness;
+  ++total_writes;
+}
+
+extern "C" {
+void Genesis_OPN2Write(u8 board, u8 addrhi, u8 address, u8 data)
+{
+  CHECK(board < GENESIS_COUNT, "OPN2 write to invalid board %d", board);
+  if( board >= GENESIS_COUNT )
+    return;
+  if( (board_written[board] & 1) && !last_opn2_nodelay[board] ) {
+    CHECK(sim_hr_time - last_opn2_write[board] >= VGMP_OPN2BUSYDELAY, "board %d: OPN2 written while busy", board);
+  }
+  board_written[board] |= 1;
+  last_opn2_write[board] = sim_hr_time;
+  last_opn2_nodelay[board] = address >= 0x20 && address < 0x2f && address != 0x28;
+
+  check_write(board, 0x52, address, data);
+}
+
+void Genesis_PSGWrite(u8 board, u8 data)
+{
+  CHECK(board < GENESIS_COUNT, "PSG write to invalid board %d", board);
+  if( board >= GENESIS_COUNT )
+    return;
+  if( board_written[board] & 2 ) {
+    CHECK(sim_hr_time - last_psg_write[board] >= VGMP_PSGBUSYDELAY, "board %d: PSG written while busy", board);
+  }
+  board_written[board] |= 2;
+  last_psg_write[board] = sim_hr_time;
+
+  check_write(board, 0x50, 0, data);
+}
+}
+
+// generates a random stream with OPN2 writes (data: head number), PSG attenuation
+// writes (channel and attenuation: head number) and waits
+static void generate_stream(test_head_t *t, int head_num)
+{
+  u8 *buffer = new u8[4*MAX_WRITES + 16];
+  u32 len = 0;
+  u32 vgm_time = 0;
+
+  t->num_expected = 0;
+  t->num_written = 0;
+  while( t->num_expected < MAX_WRITES ) {
+    int r = rand() % 100;
+    if( r < 50 ) {
+      expected_write_t *e = &t->expected[t->num_expected++];
+      e->cmd = 0x52;
+      e->addr = 0x30 + (rand() % 0x60); // operator registers, no frequency writes
+      if( (rand() % 16) == 0 )
+        e->addr = 0x22 + (rand() % 2); // no busy delay
+      e->data = head_num;
+      e->vgm_time = vgm_time;
+      buffer[len++] = 0x52 + (rand() & 1);
+      buffer[len++] = e->addr;
+      buffer[len++] = e->data;
+    } else if( r < 65 ) {
+      expected_write_t *e = &t->expected[t->num_expected++];
+      e->cmd = 0x50;
+      e->addr = 0;
+      e->data = psg_data(head_num);
+      e->vgm_time = vgm_time;
+      buffer[len++] = 0x50;
+      buffer[len++] = e->data;
+    } else if( r < 95 ) {
+      u8 wait = rand() % 16;
+      buffer[len++] = 0x70 + wait;
+      vgm_time += wait + 1;
+    } else {
+      u16 wait = 100 + (rand() % 2000);
+      buffer[len++] = 0x61;
+      buffer[len++] = wait & 0xff;
+      buffer[len++] = wait >> 8;
+      vgm_time += wait;
+    }
+  }
+  buffer[len++] = 0x66;
+
+  generated_data = buffer;
+  generated_len = len;
+  t->src = new VgmSourceStream();
+  t->src->startStream((char *)"generated");
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// plays n heads for SIM_SAMPLES, returns the time spent in the callback
+static void run(int n, int stall, double *ns_per_callback, double *ns_per_write)
+{
+  int i;
+  uint32_t underruns = 0;
+  uint32_t num_callbacks = 0;
+  uint64_t callback_time = 0;
+  uint64_t write_callback_time = 0;
+
+  VgmPlayer_Init();
+  memset(board_written, 0, sizeof(board_written));
+  total_writes = total_lateness = 0;
+  max_lateness = 0;
+  sim_hr_time = 12345; // arbitrary start
+
+  num_heads = n;
+  start_vgm_time = sim_hr_time / VGMP_HRTICKSPERSAMPLE;
+  for(i=0; i<n; ++i) {
+    test_head_t *t = &heads[i];
+    generate_stream(t, i);
+    t->board = i % GENESIS_COUNT;
+    t->head = new VgmHead(t->src);
+    t->head->setBoard(t->board);
+    t->head->restart(start_vgm_time);
+    CHECK(VgmPlayer_AddHead(t->head), "head %d not added", i);
+  }
+  CHECK(VgmPlayer_GetNumHeads() == n, "%d heads added, player has %d", n, VgmPlayer_GetNumHeads());
+
+  uint32_t begin = sim_hr_time;
+  uint32_t end = sim_hr_time + SIM_SAMPLES * VGMP_HRTICKSPERSAMPLE;
+  uint32_t next_bg = sim_hr_time;
+  while( (int32_t)(sim_hr_time - end) < 0 ) {
+    if( (int32_t)(sim_hr_time - next_bg) >= 0 ) {
+      next_bg += BG_PERIOD;
+      if( !stall || (sim_hr_time - begin) < STALL_START || (sim_hr_time - begin) >= STALL_END )
+	VgmPlayer_Background();
+    }
+
+    uint64_t writes_before = total_writes;
+    uint64_t start = now_ns();
+    u16 delay = work_callback(sim_hr_time, sim_hr_time / VGMP_HRTICKSPERSAMPLE);
+    uint64_t t = now_ns() - start;
+    callback_time += t;
+    if( total_writes != writes_before )
+      write_callback_time += t; // callbacks which have written to the chips
+    ++num_callbacks;
+
+    CHECK(delay >= 100 && delay <= VGMP_MAXDELAY, "invalid delay %d", delay);
+    sim_hr_time += delay;
+  }
+
+  // all writes which were due have been done
+  for(i=0; i<n; ++i) {
+    test_head_t *t = &heads[i];
+    int w;
+    for(w=0; w<t->num_expected; ++w) {
+      if( t->expected[w].vgm_time + 100 >= SIM_SAMPLES )
+	break;
+    }
+    CHECK(t->num_written >= w, "head %d: only %d of %d writes done", i, t->num_written, w);
+  }
+
+  for(i=0; i<n; ++i)
+    underruns += heads[i].head->getUnderruns();
+  CHECK(stall || underruns == 0, "%u underruns without a stall", underruns);
+  CHECK(!stall || underruns > 0, "no underrun during the stall");
+
+  // remove every second head, the remaining ones keep playing
+  for(i=0; i<n; i+=2)
+    VgmPlayer_RemoveHead(heads[i].head);
+  CHECK(VgmPlayer_GetNumHeads() == n/2, "%d heads after removing, expected %d", VgmPlayer_GetNumHeads(), n/2);
+  for(i=1; i<n; i+=2) {
+    test_head_t *t = &heads[i];
+    int num_written = t->num_written;
+    int c;
+    for(c=0; c<2000; ++c) {
+      if( (c % 100) == 0 )
+	VgmPlayer_Background();
+      sim_hr_time += work_callback(sim_hr_time, sim_hr_time / VGMP_HRTICKSPERSAMPLE);
+    }
+    CHECK(t->num_written > num_written || t->num_written == t->num_expected, "head %d stopped after removing other heads", i);
+    break;
+  }
+
+  for(i=0; i<n; ++i) {
+    VgmPlayer_RemoveHead(heads[i].head);
+    delete heads[i].head;
+    delete heads[i].src;
+  }
+  CHECK(VgmPlayer_GetNumHeads() == 0, "%d heads left", VgmPlayer_GetNumHeads());
+
+  *ns_per_callback = (double)callback_time / num_callbacks;
+  *ns_per_write = total_writes ? ((double)write_callback_time / total_writes) : 0;
+
+  printf("%2d heads%s: %7u callbacks, %7u writes, %u underruns, lateness avg %.2f max %u samples\n",
+	 n, stall ? " (stall)" : "", num_callbacks, (unsigned)total_writes, underruns,
+	 total_writes ? (double)total_lateness / total_writes : 0.0, max_lateness);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  static const int head_counts[] = { 1, 2, 4, 8, 16, 32, VGMP_MAXHEADS };
+  double ns_per_callback[sizeof(head_counts)/sizeof(int)];
+  double ns_per_write[sizeof(head_counts)/sizeof(int)];
+  unsigned i;
+
+  srand(1);
+  for(i=0; i<sizeof(head_counts)/sizeof(int); ++i)
+    run(head_counts[i], 0, &ns_per_callback[i], &ns_per_write[i]);
+
+  {
+    double dummy1, dummy2;
+    run(8, 1, &dummy1, &dummy2);
+  }
+
+  // the player is full
+  {
+    VgmSourceStream src;
+    VgmHead *h[VGMP_MAXHEADS+1];
+    int n;
+    VgmPlayer_Init();
+    for(n=0; n<=VGMP_MAXHEADS; ++n) {
+      h[n] = new VgmHead(&src);
+      h[n]->restart(0);
+      CHECK(VgmPlayer_AddHead(h[n]) == (n < VGMP_MAXHEADS), "head %d of %d", n, VGMP_MAXHEADS);
+    }
+    // the rejected head hasn't been started
+    CHECK(!h[VGMP_MAXHEADS]->cmdIsWait() && !h[VGMP_MAXHEADS]->cmdIsChipWrite(), "rejected head consumed a command");
+    VgmHead invalid(&src);
+    invalid.setBoard(GENESIS_COUNT);
+    CHECK(!VgmPlayer_AddHead(&invalid), "head with invalid board added");
+    for(n=0; n<=VGMP_MAXHEADS; ++n) {
+      VgmPlayer_RemoveHead(h[n]);
+      delete h[n];
+    }
+  }
+
+  for(i=0; i<sizeof(head_counts)/sizeof(int); ++i)
+    fprintf(stderr, "%2d heads: %6.1f ns per callback, %6.1f ns per write in callbacks with writes (host)\n",
+	    head_counts[i], ns_per_callback[i], ns_per_write[i]);
+
+  return GNU_TEST_Result();
+}
@@ -296,6 +296,9 @@ extern "C" void APP_Tick(void){
     */
     s32 res;
     
+    //Decode the VGMs ahead of the player
+    VgmPlayer_Background();
+    
     ++prescaler;
     char* tempbuf; u8 i;
     if(prescaler == 500){
@@ -24,16 +24,122 @@ VgmHead::VgmHead(VgmSourceStream* src){
     psgmult = 0x1000; //TODO adjust in real time
     psgfreq0to1 = 1;
     subbufferlen = 0;
+    board = 0;
+    ring = new u8[VGMHEAD_RINGSIZE];
+    ringread = ringwrite = 0;
+    runleft = 0;
+    underruns = 0;
+    iswait = iswrite = starved = false;
+    decdone = true;
 }
 
 VgmHead::~VgmHead(){
-    //do nothing special
+    delete[] ring;
 }
 
 void VgmHead::restart(u32 vgm_time){
+    //Must not be called while the head is playing
     srcaddr = source->vgmdatastartaddr;
     srcblockaddr = 0;
+    subbufferlen = 0;
+    decdone = false;
+    ringread = ringwrite = 0;
+    runleft = 0;
+    iswait = iswrite = starved = false;
+    isdone = false;
     ticks = vgm_time;
+    //Decode the beginning, so that playback can start immediately
+    bg_fillBuffer();
+}
+
+void VgmHead::cmdNext(u32 vgm_time){
+    u8 op;
+    u16 w;
+    iswait = iswrite = starved = false;
+    while(!(iswait || iswrite || isdone)){
+        if(runleft){
+            //Next write of a run
+            writecmd.cmd = runcmd;
+            if(runcmd != 0x50){
+                writecmd.addr = ring[ringread];
+                ringread = (ringread + 1) & (VGMHEAD_RINGSIZE-1);
+            }
+            writecmd.data = ring[ringread];
+            ringread = (ringread + 1) & (VGMHEAD_RINGSIZE-1);
+            --runleft;
+            iswrite = true;
+        }else if(ringread == ringwrite){
+            //The decoder hasn't kept up (e.g. SD card latency), wait for it
+            //without changing the time base: the commands are played late
+            //instead of shifting the rest of the song
+            starved = true;
+            iswait = true;
+            ++underruns;
+        }else{
+            op = ring[ringread];
+            ringread = (ringread + 1) & (VGMHEAD_RINGSIZE-1);
+            if(op == VGMHEAD_OP_WAIT){
+                w = ring[ringread];
+                ringread = (ringread + 1) & (VGMHEAD_RINGSIZE-1);
+                w |= (u16)ring[ringread] << 8;
+                ringread = (ringread + 1) & (VGMHEAD_RINGSIZE-1);
+                ticks += w;
+                iswait = true;
+            }else if(op == VGMHEAD_OP_END){
+                isdone = true;
+            }else{
+                //Run of writes to the same port
+                runcmd = (op == VGMHEAD_OP_PSG) ? 0x50 : ((op == VGMHEAD_OP_OPN2_1) ? 0x53 : 0x52);
+                runleft = ring[ringread];
+                ringread = (ringread + 1) & (VGMHEAD_RINGSIZE-1);
+            }
+        }
+    }
+}
+
+void VgmHead::bg_fillBuffer(){
+    if(decdone) return;
+    source->bg_streamBuffer();
+    u16 w = ringwrite;
+    u16 runpos = 0xFFFF; //Position of the count of the current run, only in the unpublished part of the ring
+    u8 op, runop = 0;
+    //Each command needs up to 4 bytes (new run + OPN2 address and data)
+    while(!decdone && ((ringread - w - 1) & (VGMHEAD_RINGSIZE-1)) >= 4){
+        decodeNext();
+        if(decwrite){
+            op = (decwritecmd.cmd == 0x50) ? VGMHEAD_OP_PSG : ((decwritecmd.cmd & 0x01) ? VGMHEAD_OP_OPN2_1 : VGMHEAD_OP_OPN2_0);
+            if(runpos == 0xFFFF || op != runop || ring[runpos] == 0xFF){
+                //Start a new run
+                ring[w] = op;
+                runpos = (w + 1) & (VGMHEAD_RINGSIZE-1);
+                ring[runpos] = 0;
+                w = (w + 2) & (VGMHEAD_RINGSIZE-1);
+                runop = op;
+            }
+            ++ring[runpos];
+            if(op != VGMHEAD_OP_PSG){
+                ring[w] = decwritecmd.addr;
+                w = (w + 1) & (VGMHEAD_RINGSIZE-1);
+            }
+            ring[w] = decwritecmd.data;
+            w = (w + 1) & (VGMHEAD_RINGSIZE-1);
+        }else if(decwait){
+            ring[w] = VGMHEAD_OP_WAIT;
+            w = (w + 1) & (VGMHEAD_RINGSIZE-1);
+            ring[w] = decwait & 0xFF;
+            w = (w + 1) & (VGMHEAD_RINGSIZE-1);
+            ring[w] = (decwait >> 8) & 0xFF;
+            w = (w + 1) & (VGMHEAD_RINGSIZE-1);
+            //Publish everything up to the wait
+            runpos = 0xFFFF;
+            ringwrite = w;
+        }else{
+            //End of data
+            ring[w] = VGMHEAD_OP_END;
+            w = (w + 1) & (VGMHEAD_RINGSIZE-1);
+        }
+    }
+    ringwrite = w;
 }
 
 u8 VgmHead::getCommandLen(u8 type){
@@ -163,11 +269,12 @@ void VgmHead::fixPSGFrequency(ChipWriteCmd* writecmd, u32 psgmult, u8 psgfreq0to
     writecmd->data2 = (freq >> 4) & 0x3F;
 }
 
-void VgmHead::cmdNext(u32 vgm_time){
+void VgmHead::decodeNext(){
     u8 type, cmdlen;
-    iswait = iswrite = false;
+    decwait = 0;
+    decwrite = false;
     bool dontunbuffer;
-    while(!(iswait || iswrite)){
+    while(!(decwait || decwrite || decdone)){
         if(subbufferlen == 0){
             bufferNextCommand(); //Should never return false
         }
@@ -176,10 +283,10 @@ void VgmHead::cmdNext(u32 vgm_time){
         dontunbuffer = false;
         if(type == 0x50){
             //PSG write
-            iswrite = true;
-            writecmd.cmd = type;
-            writecmd.data = subbuffer[1];
-            if((writecmd.data & 0x80) && !(writecmd.data & 0x10) && (writecmd.data < 0xE0)){
+            decwrite = true;
+            decwritecmd.cmd = type;
+            decwritecmd.data = subbuffer[1];
+            if((decwritecmd.data & 0x80) && !(decwritecmd.data & 0x10) && (decwritecmd.data < 0xE0)){
                 //It's a main write, not attenuation, and not noise
                 u8 bufferpos, newtype;
                 bufferpos = subbufferlen;
@@ -187,12 +294,12 @@ void VgmHead::cmdNext(u32 vgm_time){
                     newtype = subbuffer[bufferpos];
                     if(newtype == type){
                         //Next command is another PSG write
-                        if((writecmd.data & 0x80)){
+                        if((decwritecmd.data & 0x80)){
                             //Second command is a frequency MSB write
-                            writecmd.data2 = subbuffer[bufferpos+1];
-                            fixPSGFrequency(&writecmd, psgmult, psgfreq0to1);
+                            decwritecmd.data2 = subbuffer[bufferpos+1];
+                            fixPSGFrequency(&decwritecmd, psgmult, psgfreq0to1);
                             //Reconstruct next command
-                            subbuffer[bufferpos+1] = writecmd.data2;
+                            subbuffer[bufferpos+1] = decwritecmd.data2;
                         }
                         //If it's another main write, don't modify anything, and stop
                         break;
@@ -202,11 +309,11 @@ void VgmHead::cmdNext(u32 vgm_time){
             }
         }else if((type & 0xFE) == 0x52){
             //OPN2 write
-            iswrite = true;
-            writecmd.cmd = type;
-            writecmd.addr = subbuffer[1];
-            writecmd.data = subbuffer[2];
-            if((writecmd.addr & 0xF4) == 0xA4){
+            decwrite = true;
+            decwritecmd.cmd = type;
+            decwritecmd.addr = subbuffer[1];
+            decwritecmd.data = subbuffer[2];
+            if((decwritecmd.addr & 0xF4) == 0xA4){
                 //Frequency MSB write, read to find frequency LSB write command
                 u8 bufferpos, newtype;
                 bufferpos = subbufferlen;
@@ -214,14 +321,14 @@ void VgmHead::cmdNext(u32 vgm_time){
                     newtype = subbuffer[bufferpos];
                     if(newtype == type){
                         //Next command is another OPN2 write to the same addrhi
-                        if((writecmd.addr & 0xFB) == (subbuffer[bufferpos+1] & 0xFB)){
+                        if((decwritecmd.addr & 0xFB) == (subbuffer[bufferpos+1] & 0xFB)){
                             //Second command is a frequency write to same channel
                             if(!(subbuffer[bufferpos+1] & 0x04)){
                                 //It's a frequency LSB write
-                                writecmd.data2 = subbuffer[bufferpos+2];
-                                fixOPN2Frequency(&writecmd, opn2mult);
+                                decwritecmd.data2 = subbuffer[bufferpos+2];
+                                fixOPN2Frequency(&decwritecmd, opn2mult);
                                 //Reconstruct next command
-                                subbuffer[bufferpos+2] = writecmd.data2;
+                                subbuffer[bufferpos+2] = decwritecmd.data2;
                             }
                             //If it's a frequency MSB command, don't modify anything, and stop
                             break;
@@ -232,10 +339,10 @@ void VgmHead::cmdNext(u32 vgm_time){
             }
         }else if(type >= 0x80 && type <= 0x8F){
             //OPN2 DAC write
-            iswrite = true;
-            writecmd.cmd = 0x52;
-            writecmd.addr = 0x2A;
-            writecmd.data = source->getBlockByte(srcblockaddr++);
+            decwrite = true;
+            decwritecmd.cmd = 0x52;
+            decwritecmd.addr = 0x2A;
+            decwritecmd.data = source->getBlockByte(srcblockaddr++);
             if(type != 0x80){
                 //Replace the command with the equivalent wait command
                 subbuffer[0] = type - 0x11;
@@ -243,20 +350,16 @@ void VgmHead::cmdNext(u32 vgm_time){
             }
         }else if(type >= 0x70 && type <= 0x7F){
             //Short wait
-            iswait = true;
-            ticks += type - 0x6F;
+            decwait = type - 0x6F;
         }else if(type == 0x61){
             //Long wait
-            iswait = true;
-            ticks += subbuffer[1] | ((u32)subbuffer[2] << 8);
+            decwait = subbuffer[1] | ((u32)subbuffer[2] << 8);
         }else if(type == 0x62){
             //60 Hz wait
-            iswait = true;
-            ticks += delay62;
+            decwait = delay62;
         }else if(type == 0x63){
             //50 Hz wait
-            iswait = true;
-            ticks += delay63;
+            decwait = delay63;
         }else if(type == 0x64){
             //Override wait lengths
             u8 tooverride = subbuffer[1];
@@ -270,15 +373,15 @@ void VgmHead::cmdNext(u32 vgm_time){
             //Nop [unofficial]
         }else if(type == 0x66){
             //End of data
-            //Behaves like endless stream of 65535-tick waits
-            isdone = true;
+            //Behaves like endless stream of 65535-tick waits, so stop here
+            decdone = true;
         }else if(type == 0x67){
             //Data block
             //Skip 0x66 in subbuffer[1]
             u32 a = subbuffer[2];
             if(a != 0){
                 //Format other than uncompressed YM2612 PCM not supported
-                isdone = true;
+                decdone = true;
             }else{
                 a = subbuffer[3] | ((u32)subbuffer[4] << 8)| ((u32)subbuffer[5] << 16) 
                     | ((u32)subbuffer[6] << 24);
@@ -15,6 +15,19 @@
 
 #include "vgmsourcestream.h"
 
+// Size of the ring of pre-decoded commands of each head, has to be a power of 2
+// The decoder runs in the background, the player only reads from the ring
+#ifndef VGMHEAD_RINGSIZE
+#define VGMHEAD_RINGSIZE 512
+#endif
+
+// Pre-decoded commands in the ring
+#define VGMHEAD_OP_OPN2_0 0x01 //Followed by number of writes n, n * (addr, data)
+#define VGMHEAD_OP_OPN2_1 0x02 //Followed by number of writes n, n * (addr, data)
+#define VGMHEAD_OP_PSG    0x03 //Followed by number of writes n, n * data
+#define VGMHEAD_OP_WAIT   0x04 //Followed by wait in samples (16 bit, LSB first)
+#define VGMHEAD_OP_END    0x05 //End of data
+
 union ChipWriteCmd {
     u32 all;
     struct {
@@ -32,15 +45,22 @@ public:
     
     void restart(u32 vgm_time);
     
+    // Decodes VGM commands into the ring, call this periodically from a task
+    void bg_fillBuffer();
+    
     void cmdNext(u32 vgm_time);
     inline bool cmdIsWait() {return iswait || isdone;}
-    inline s32 cmdGetWaitRemaining(u32 vgm_time) {return (isdone ? 65535 : ((s32)ticks - (s32)vgm_time));}
+    inline s32 cmdGetWaitRemaining(u32 vgm_time) {return (isdone ? 65535 : (starved ? (ringread == ringwrite) : ((s32)ticks - (s32)vgm_time)));}
     inline bool cmdIsChipWrite() {return iswrite && !isdone;}
     inline ChipWriteCmd cmdGetChipWrite() {return writecmd;}
     
     inline void setOPN2FreqMultiplier(u32 mult) {opn2mult = mult;} // Ratio of VGM to actual OPN2 clock, times 0x1000
     
+    inline void setBoard(u8 b) {board = b;} // Genesis board the head plays on
+    inline u8 getBoard() {return board;}
+    
     inline u32 getCurAddress() { return srcaddr; }
+    inline u32 getUnderruns() { return underruns; } // Number of times the player had to wait for the decoder
     
 private:
     static u8 getCommandLen(u8 type);
@@ -49,6 +69,7 @@ private:
     
     bool bufferNextCommand();
     void unBuffer(u8 len);
+    void decodeNext();
     
     VgmSourceStream* source;
     u32 srcaddr;
@@ -67,9 +88,23 @@ private:
     bool isdone;
     u32 delay62, delay63;
     
+    //Decoder state (background)
+    bool decwrite, decdone;
+    u32 decwait;
+    ChipWriteCmd decwritecmd;
+    
+    //Ring of pre-decoded commands, written by the decoder, read by the player
+    volatile u8* ring;
+    volatile u16 ringread, ringwrite;
+    u8 runcmd, runleft;
+    bool starved;
+    u32 underruns;
+    
     u32 opn2mult, psgmult;
     u8 psgfreq0to1;
     
+    u8 board;
+    
 };
 
 #endif /* _VGMHEAD_H */
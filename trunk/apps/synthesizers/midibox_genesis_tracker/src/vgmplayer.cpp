@@ -17,20 +17,144 @@
 
 #include "vgmplayer_ll.h"
 
-#define USE_GENESIS 0
-
 vgmp_chipdata chipdata[GENESIS_COUNT];
 
-// For this test software, there's only one head.
-VgmHead* vgmp_head;
+// All heads which are playing, as a min-heap ordered by the time they have to
+// be serviced next. The work callback only touches the heads which are due.
+static vgmp_headslot vgmp_heads[VGMP_MAXHEADS];
+static u8 vgmp_numheads;
+
+// Returns true if the time a is before the time b (wrap-around safe)
+static inline bool VgmPlayer_IsBefore(u32 a, u32 b){
+    return (s32)(a - b) < 0;
+}
+
+static void VgmPlayer_SiftUp(u8 pos){
+    vgmp_headslot slot = vgmp_heads[pos];
+    while(pos > 0){
+        u8 parent = (pos-1) >> 1;
+        if(!VgmPlayer_IsBefore(slot.duetime, vgmp_heads[parent].duetime)) break;
+        vgmp_heads[pos] = vgmp_heads[parent];
+        pos = parent;
+    }
+    vgmp_heads[pos] = slot;
+}
+
+static void VgmPlayer_SiftDown(u8 pos){
+    vgmp_headslot slot = vgmp_heads[pos];
+    u8 child;
+    while((child = 2*pos+1) < vgmp_numheads){
+        if(child+1 < vgmp_numheads && VgmPlayer_IsBefore(vgmp_heads[child+1].duetime, vgmp_heads[child].duetime)){
+            ++child;
+        }
+        if(!VgmPlayer_IsBefore(vgmp_heads[child].duetime, slot.duetime)) break;
+        vgmp_heads[pos] = vgmp_heads[child];
+        pos = child;
+    }
+    vgmp_heads[pos] = slot;
+}
 
-void VgmPlayer_AddHead(VgmHead* vgmh){
-    vgmp_head = vgmh;
-    //Start it!
-    vgmp_head->cmdNext(VgmPlayerLL_GetVGMTime());
+bool VgmPlayer_AddHead(VgmHead* vgmh){
+    if(vgmh->getBoard() >= GENESIS_COUNT) return false;
+    MIOS32_IRQ_Disable();
+    if(vgmp_numheads >= VGMP_MAXHEADS){
+        MIOS32_IRQ_Enable();
+        return false;
+    }
+    //Start it! Only reads the ring, so it's short enough for here
+    vgmh->cmdNext(VgmPlayerLL_GetVGMTime());
+    //Service it with the next callback
+    vgmp_heads[vgmp_numheads].duetime = VgmPlayerLL_GetHRTime();
+    vgmp_heads[vgmp_numheads].head = vgmh;
+    VgmPlayer_SiftUp(vgmp_numheads++);
+    MIOS32_IRQ_Enable();
+    return true;
 }
 void VgmPlayer_RemoveHead(VgmHead* vgmh){
-    vgmp_head = NULL;
+    u8 i;
+    MIOS32_IRQ_Disable();
+    for(i=0; i<vgmp_numheads; i++){
+        if(vgmp_heads[i].head == vgmh){
+            //Replace it with the last head, which can move up or down from here
+            if(i != --vgmp_numheads){
+                vgmp_heads[i] = vgmp_heads[vgmp_numheads];
+                VgmPlayer_SiftUp(i);
+                VgmPlayer_SiftDown(i);
+            }
+            break;
+        }
+    }
+    MIOS32_IRQ_Enable();
+}
+u8 VgmPlayer_GetNumHeads(){
+    return vgmp_numheads;
+}
+
+void VgmPlayer_Background(){
+    VgmHead* heads[VGMP_MAXHEADS];
+    u8 i, n;
+    //The callback reorders the heap, so take a copy of the heads
+    MIOS32_IRQ_Disable();
+    n = vgmp_numheads;
+    for(i=0; i<n; i++){
+        heads[i] = vgmp_heads[i].head;
+    }
+    MIOS32_IRQ_Enable();
+    for(i=0; i<n; i++){
+        heads[i]->bg_fillBuffer();
+    }
+}
+
+// Advances the head as far as possible at the current time: finished delays
+// are skipped, chip writes are done as long as the board isn't busy.
+// Returns the hr_time when the head has to be serviced again.
+static u32 VgmPlayer_ServiceHead(VgmHead* h, u32 hr_time, u32 vgm_time){
+    vgmp_chipdata* cd = &chipdata[h->getBoard()];
+    s32 s; u32 u;
+    ChipWriteCmd cmd;
+    while(1){
+        if(h->cmdIsWait()){
+            //Check for delay
+            s = h->cmdGetWaitRemaining(vgm_time);
+            if(s > 0){
+                return hr_time + (u32)s * VGMP_HRTICKSPERSAMPLE;
+            }
+            //Advance to next command
+            h->cmdNext(vgm_time);
+        }else if(h->cmdIsChipWrite()){
+            cmd = h->cmdGetChipWrite();
+            if(cmd.cmd == 0x50){
+                //PSG write
+                u = hr_time - cd->psg_lastwritetime;
+                if(u < VGMP_PSGBUSYDELAY){
+                    return cd->psg_lastwritetime + VGMP_PSGBUSYDELAY;
+                }
+                Genesis_PSGWrite(h->getBoard(), cmd.data);
+                h->cmdNext(vgm_time);
+                cd->psg_lastwritetime = hr_time;
+            }else if((cmd.cmd & 0xFE) == 0x52){
+                //OPN2 write
+                u = hr_time - cd->opn2_lastwritetime;
+                if(u < VGMP_OPN2BUSYDELAY){
+                    return cd->opn2_lastwritetime + VGMP_OPN2BUSYDELAY;
+                }
+                Genesis_OPN2Write(h->getBoard(), (cmd.cmd & 0x01), cmd.addr, cmd.data);
+                h->cmdNext(vgm_time);
+                //Don't delay after 0x2x commands
+                if(cmd.addr >= 0x20 && cmd.addr < 0x2F && cmd.addr != 0x28){
+                    cd->opn2_lastwritetime = hr_time - VGMP_OPN2BUSYDELAY;
+                }else{
+                    cd->opn2_lastwritetime = hr_time;
+                }
+            }else{
+                //Not a write to a Genesis chip, skip it
+                h->cmdNext(vgm_time);
+            }
+        }else{
+            //Not started, check again later
+            return hr_time + VGMP_MAXDELAY;
+        }
+    }
 }
 
 // Where all the work gets done.
@@ -45,84 +169,17 @@ u16 VgmPlayer_WorkCallback(u32 hr_time, u32 vgm_time){
     */
     u8 leds = MIOS32_BOARD_LED_Get();
     MIOS32_BOARD_LED_Set(0b1111, 0b0010);
-    VgmHead* h;
-    u32 minwait = 0xFFFFFFFF; s32 s; u32 u;
-    ChipWriteCmd cmd;
-    u8 wrotetochip;
-    //Scan all VGMs for delays
-    if(vgmp_head != NULL){
-        h = vgmp_head;
-        //Check for delay
-        if(h->cmdIsWait()){
-            s = h->cmdGetWaitRemaining(vgm_time);
-            if(s <= 0){
-                //Advance to next command
-                h->cmdNext(vgm_time);
-            }else{
-                u = s * VGMP_HRTICKSPERSAMPLE;
-                if(u < minwait){
-                    //Store it as the shortest remaining time
-                    minwait = u;
-                }
-            }
-        }
-    }
-    //Scan all VGMs for pending chip write commands
-    wrotetochip = 1;
-    while(wrotetochip){
-        wrotetochip = 0;
-        if(vgmp_head != NULL){
-            h = vgmp_head;
-            //Check for command
-            if(h->cmdIsChipWrite()){
-                cmd = h->cmdGetChipWrite();
-                if(cmd.cmd == 0x50){
-                    //PSG write
-                    u = hr_time - chipdata[USE_GENESIS].psg_lastwritetime;
-                    if(u < VGMP_PSGBUSYDELAY){
-                        u = VGMP_PSGBUSYDELAY - u;
-                        if(u < minwait){
-                            minwait = u;
-                        }
-                    }else{
-                        Genesis_PSGWrite(USE_GENESIS, cmd.data);
-                        h->cmdNext(vgm_time);
-                        chipdata[USE_GENESIS].psg_lastwritetime = hr_time;
-                        wrotetochip = 1;
-                    }
-                    /*
-                    if(Genesis_CheckPSGBusy(0)){
-                        if(VGMP_PSGBUSYDELAY < minwait){
-                            minwait = VGMP_PSGBUSYDELAY;
-                        }
-                    }else{
-                        Genesis_PSGWrite(0, cmd.data);
-                        h->cmdNext(vgm_time);
-                        wrotetochip = 1;
-                    }
-                    */
-                }else if((cmd.cmd & 0xFE) == 0x52){
-                    //OPN2 write
-                    u = hr_time - chipdata[USE_GENESIS].opn2_lastwritetime;
-                    if(u < VGMP_OPN2BUSYDELAY){
-                        u = VGMP_OPN2BUSYDELAY - u;
-                        if(u < minwait){
-                            minwait = u;
-                        }
-                    }else{
-                        Genesis_OPN2Write(USE_GENESIS, (cmd.cmd & 0x01), cmd.addr, cmd.data);
-                        h->cmdNext(vgm_time);
-                        //Don't delay after 0x2x commands
-                        if(cmd.addr >= 0x20 && cmd.addr < 0x2F && cmd.addr != 0x28){
-                            chipdata[USE_GENESIS].opn2_lastwritetime = hr_time - VGMP_OPN2BUSYDELAY;
-                        }else{
-                            chipdata[USE_GENESIS].opn2_lastwritetime = hr_time;
-                        }
-                        wrotetochip = 1;
-                    }
-                }
-            }
+    u32 minwait = 0xFFFFFFFF; s32 s;
+    //Service all heads which are due, in the order of their due time
+    while(vgmp_numheads){
+        s = vgmp_heads[0].duetime - hr_time;
+        if(s > 0){
+            //Store it as the shortest remaining time
+            minwait = s;
+            break;
         }
+        vgmp_heads[0].duetime = VgmPlayer_ServiceHead(vgmp_heads[0].head, hr_time, vgm_time);
+        VgmPlayer_SiftDown(0);
     }
     //Set up next delay
     if(minwait < 100){
@@ -138,9 +195,7 @@ u16 VgmPlayer_WorkCallback(u32 hr_time, u32 vgm_time){
 
 
 void VgmPlayer_Init(){
-    vgmp_head = NULL;
+    vgmp_numheads = 0;
     VgmPlayerLL_RegisterCallback(VgmPlayer_WorkCallback);
     VgmPlayerLL_Init();
 }
-
-
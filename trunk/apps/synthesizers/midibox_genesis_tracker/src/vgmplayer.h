@@ -17,17 +17,35 @@
 #include "vgmhead.h"
 
 
+// Maximum number of heads playing at the same time: one per tracker voice,
+// 6 FM + 4 PSG channels on up to 4 boards
+#ifndef VGMP_MAXHEADS
+#define VGMP_MAXHEADS 40
+#endif
+
 struct vgmp_chipdata {
     u32 opn2_lastwritetime;
     u32 psg_lastwritetime;
 };
 
+struct vgmp_headslot {
+    u32 duetime; //hr_time when the head has to be serviced next
+    VgmHead* head;
+};
+
 // Call at startup
 extern void VgmPlayer_Init();
 
-extern void VgmPlayer_AddHead(VgmHead* vgmh);
+// Heads play on the board selected with VgmHead::setBoard().
+// Returns false if the head can't be added (too many heads, invalid board).
+extern bool VgmPlayer_AddHead(VgmHead* vgmh);
 extern void VgmPlayer_RemoveHead(VgmHead* vgmh);
+extern u8 VgmPlayer_GetNumHeads();
+
+// Decodes the VGMs of all heads ahead of time, call this periodically from the
+// task which adds and removes the heads
+extern void VgmPlayer_Background();
 
-extern u16 VgmPlayer_WorkCallback(u16 hr_time, u16 vgm_time);
+extern u16 VgmPlayer_WorkCallback(u32 hr_time, u32 vgm_time);
 
 #endif /* _VGMPLAYER_H */
@@ -86,8 +86,9 @@ u8 VgmSourceStream::getByte(u32 addr){
 }
 
 void VgmSourceStream::bg_streamBuffer(){
+    //The stream is only read by the decoder of the VgmHead, which runs in the
+    //same task, so the player interrupt doesn't have to be blocked here
     if(wantbuffer == 1 || wantbuffer == 2){
-        MIOS32_IRQ_Disable();
         u8 leds = MIOS32_BOARD_LED_Get();
         MIOS32_BOARD_LED_Set(0b1111, 0b0001);
         DEBUGVAL = 1;
@@ -112,7 +113,6 @@ void VgmSourceStream::bg_streamBuffer(){
         FILE_ReadClose(&file);
         MIOS32_BOARD_LED_Set(0b1111, leds);
         DEBUGVAL = 0;
-        MIOS32_IRQ_Enable();
     }
 }
 
@@ -303,7 +303,7 @@ extern "C" void SID_TASK_Period1S(void)
     DEBUG_MSG("%d uS (max: %d uS)\n", acc_value / (1000000 / (2000/sid_se_speed_factor)), max_value);
 #endif
 #if 1
-  SID_PrintStatistics();
+  SID_PrintStatistics(1000);
 #endif
   MUTEX_MIDIOUT_GIVE;
 
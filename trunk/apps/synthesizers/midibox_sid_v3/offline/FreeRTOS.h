@@ -0,0 +1,10 @@
+// $Id$
+/*
+ * FreeRTOS stand-in for the offline renderer: the MIDI file parser
+ * includes the header, but doesn't use any RTOS function
+ */
+
+#ifndef _FREERTOS_H
+#define _FREERTOS_H
+
+#endif /* _FREERTOS_H */
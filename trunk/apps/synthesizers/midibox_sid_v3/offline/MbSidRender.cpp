@@ -0,0 +1,526 @@
+/* -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*- */
+// $Id$
+/*
+ * Offline Renderer for the MIDIbox SID V3 Sound Engines
+ *
+ * Feeds a .mid file or a list of timestamped MIDI events through
+ * MbSidEnvironment, clocks reSID as fast as the CPU allows and writes
+ * the result into a .wav file.
+ * See README.txt for details
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "MbSidEnvironment.h"
+#include "resid.h"
+
+extern "C" {
+#include <mid_parser.h>
+}
+
+
+// sampling method and SID frequency (see also juce/Source/PluginProcessor.cpp)
+#define RESID_SAMPLING_METHOD SAMPLE_INTERPOLATE
+#define RESID_FREQUENCY 1000000
+
+// number of SIDs which are rendered into the left and right channel
+#define RENDER_SID_NUM 2
+
+// max number of samples which are rendered per sound engine tick and channel
+#define RENDER_MAX_SAMPLES_PER_TICK 1024
+
+
+// these global variables are used by ReSID
+double mixer_value1;
+double mixer_value2;
+double mixer_value3;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static MbSidEnvironment mbSidEnvironment;
+static SID *reSID[RENDER_SID_NUM];
+static sid_regs_t sidRegsShadow[RENDER_SID_NUM];
+
+// only events of this channel are played (0: all channels)
+static u8 midiChannel;
+
+// timestamped events of an event list
+typedef struct {
+    u32 timestamp; // in mS
+    std::vector<u8> bytes;
+} render_event_t;
+
+static std::vector<render_event_t> eventList;
+
+// content of the .mid file
+static std::vector<u8> midFile;
+static u32 midFilePos;
+static float midFileBpm;
+
+// measured times (in seconds)
+static double engineTime;
+static double reSidTime;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Stand-ins for MIOS32 functions which aren't provided by mios32_wrapper_code.c
+/////////////////////////////////////////////////////////////////////////////
+extern "C" s32 MIOS32_MIDI_SendSysEx(mios32_midi_port_t port, u8 *stream, u32 count)
+{
+    return 0; // SysEx responses are discarded
+}
+
+extern "C" s32 MIOS32_DELAY_Wait_uS(u16 uS)
+{
+    return 0; // no delay required
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the current time in seconds
+/////////////////////////////////////////////////////////////////////////////
+static double timeGet(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1E9;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sends MIDI bytes to the sound engine
+/////////////////////////////////////////////////////////////////////////////
+static void midiSend(u8 *bytes, u32 len)
+{
+    if( !len )
+        return;
+
+    if( bytes[0] == 0xf0 || bytes[0] == 0xf7 || bytes[0] < 0x80 ) {
+        // SysEx (or continued SysEx)
+        for(u32 i=0; i<len; ++i)
+            mbSidEnvironment.midiReceiveSysEx(DEFAULT, bytes[i]);
+    } else if( bytes[0] >= 0xf8 ) {
+        mbSidEnvironment.midiReceiveRealTimeEvent(DEFAULT, bytes[0]);
+    } else if( bytes[0] < 0xf0 ) {
+        if( midiChannel && (bytes[0] & 0x0f) != (midiChannel-1) )
+            return; // channel filtered
+
+        mios32_midi_package_t p;
+        p.ALL = 0;
+        p.type = bytes[0] >> 4;
+        p.evnt0 = bytes[0] & 0xf0; // like the plugin: all channels are played by the first engine
+        p.evnt1 = (len >= 2) ? bytes[1] : 0x00;
+        p.evnt2 = (len >= 3) ? bytes[2] : 0x00;
+        mbSidEnvironment.midiReceive(DEFAULT, p);
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Event list: one event per line, same format like the MIDI input of the
+// MIOS32 host build:
+// <mS> [<port>] <hex bytes>
+/////////////////////////////////////////////////////////////////////////////
+static s32 eventListRead(const char *filename)
+{
+    FILE *f = fopen(filename, "r");
+    if( !f ) {
+        fprintf(stderr, "ERROR: can't open %s\n", filename);
+        return -1;
+    }
+
+    char line[1024];
+    u32 lineNum = 0;
+    while( fgets(line, sizeof(line), f) ) {
+        ++lineNum;
+
+        char *brkt;
+        char *word = strtok_r(line, " \t\r\n", &brkt);
+        if( !word || word[0] == '#' )
+            continue; // empty line or comment
+
+        render_event_t e;
+        char *next;
+        e.timestamp = strtoul(word, &next, 0);
+        if( next == word || *next ) {
+            fprintf(stderr, "ERROR: %s:%u: invalid timestamp '%s'\n", filename, lineNum, word);
+            fclose(f);
+            return -2;
+        }
+
+        while( (word=strtok_r(NULL, " \t\r\n", &brkt)) != NULL ) {
+            u32 value = strtoul(word, &next, 16);
+            if( next == word || *next || value > 0xff ) {
+                if( e.bytes.empty() )
+                    continue; // port name
+                fprintf(stderr, "ERROR: %s:%u: invalid byte '%s'\n", filename, lineNum, word);
+                fclose(f);
+                return -2;
+            }
+            e.bytes.push_back(value);
+        }
+
+        if( !eventList.empty() && e.timestamp < eventList.back().timestamp ) {
+            fprintf(stderr, "ERROR: %s:%u: timestamps have to be sorted\n", filename, lineNum);
+            fclose(f);
+            return -2;
+        }
+
+        eventList.push_back(e);
+    }
+
+    fclose(f);
+    return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Callbacks for the MIDI file parser
+/////////////////////////////////////////////////////////////////////////////
+static u32 midFileRead(void *buffer, u32 len)
+{
+    if( (midFilePos + len) > midFile.size() )
+        len = midFile.size() - midFilePos;
+
+    memcpy(buffer, &midFile[midFilePos], len);
+    midFilePos += len;
+
+    return len;
+}
+
+static s32 midFileEof(void)
+{
+    return (midFilePos >= midFile.size()) ? 1 : 0;
+}
+
+static s32 midFileSeek(u32 pos)
+{
+    if( pos >= midFile.size() )
+        return -1; // end of file reached
+
+    midFilePos = pos;
+    return 0; // no error
+}
+
+static s32 midFilePlayEvent(u8 track, mios32_midi_package_t midi_package, u32 tick)
+{
+    u8 bytes[3] = { midi_package.evnt0, midi_package.evnt1, midi_package.evnt2 };
+
+    if( midi_package.type == 0xf ) // SysEx and realtime events are sent as single bytes
+        midiSend(bytes, 1);
+    else
+        midiSend(bytes, 3);
+
+    return 0; // no error
+}
+
+static s32 midFilePlayMeta(u8 track, u8 meta, u32 len, u8 *buffer, u32 tick)
+{
+    if( meta == 0x51 && len == 3 ) { // Set Tempo
+        u32 tempo_us = (buffer[0] << 16) | (buffer[1] << 8) | buffer[2];
+        if( tempo_us ) {
+            midFileBpm = 60.0E6 / tempo_us;
+            mbSidEnvironment.bpmSet(midFileBpm);
+        }
+    }
+
+    return 0; // no error
+}
+
+static s32 midFileOpen(const char *filename)
+{
+    FILE *f = fopen(filename, "rb");
+    if( !f ) {
+        fprintf(stderr, "ERROR: can't open %s\n", filename);
+        return -1;
+    }
+
+    u8 buffer[4096];
+    size_t len;
+    while( (len=fread(buffer, 1, sizeof(buffer), f)) > 0 )
+        midFile.insert(midFile.end(), buffer, buffer + len);
+    fclose(f);
+
+    midFilePos = 0;
+    midFileBpm = 120.0;
+    mbSidEnvironment.bpmSet(midFileBpm);
+
+    MID_PARSER_Init(0);
+    MID_PARSER_InstallFileCallbacks((void *)&midFileRead, (void *)&midFileEof, (void *)&midFileSeek);
+    MID_PARSER_InstallEventCallbacks((void *)&midFilePlayEvent, (void *)&midFilePlayMeta);
+
+    if( MID_PARSER_Read() < 0 || !MID_PARSER_FileIsValid() ) {
+        fprintf(stderr, "ERROR: %s is not a valid MIDI file\n", filename);
+        return -2;
+    }
+
+    return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Transfers changed SID registers to reSID (like RESID_Update() of the plugin)
+/////////////////////////////////////////////////////////////////////////////
+static const u8 update_order[] = {
+   0,  1,  2,  3,  5,  6, // voice 1 w/o osc control register
+   7,  8,  9, 10, 12, 13, // voice 2 w/o osc control register
+  14, 15, 16, 17, 19, 20, // voice 3 w/o osc control register
+   4, 11, 18,             // voice 1/2/3 control registers
+  21, 22, 23, 24,         // remaining SID registers
+};
+
+static void reSidUpdate(bool force)
+{
+    for(int i=0; i<(int)sizeof(update_order); ++i) {
+        u8 reg = update_order[i];
+
+        for(int sid=0; sid<RENDER_SID_NUM; ++sid) {
+            u8 data;
+            if( (data=sid_regs[sid].ALL[reg]) != sidRegsShadow[sid].ALL[reg] || force ) {
+                sidRegsShadow[sid].ALL[reg] = data;
+                reSID[sid]->write(reg, data);
+            }
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// .wav file output (16bit PCM, stereo)
+/////////////////////////////////////////////////////////////////////////////
+static void wavWriteU32(FILE *f, u32 value)
+{
+    u8 b[4] = { (u8)value, (u8)(value >> 8), (u8)(value >> 16), (u8)(value >> 24) };
+    fwrite(b, 1, 4, f);
+}
+
+static void wavWriteU16(FILE *f, u16 value)
+{
+    u8 b[2] = { (u8)value, (u8)(value >> 8) };
+    fwrite(b, 1, 2, f);
+}
+
+static void wavWriteHeader(FILE *f, u32 sampleRate, u32 numFrames)
+{
+    u32 dataSize = numFrames * RENDER_SID_NUM * 2;
+
+    fseek(f, 0, SEEK_SET);
+    fwrite("RIFF", 1, 4, f);
+    wavWriteU32(f, 36 + dataSize);
+    fwrite("WAVEfmt ", 1, 8, f);
+    wavWriteU32(f, 16); // fmt chunk size
+    wavWriteU16(f, 1); // PCM
+    wavWriteU16(f, RENDER_SID_NUM);
+    wavWriteU32(f, sampleRate);
+    wavWriteU32(f, sampleRate * RENDER_SID_NUM * 2); // bytes per second
+    wavWriteU16(f, RENDER_SID_NUM * 2); // block align
+    wavWriteU16(f, 16); // bits per sample
+    fwrite("data", 1, 4, f);
+    wavWriteU32(f, dataSize);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Usage
+/////////////////////////////////////////////////////////////////////////////
+static void usage(const char *prgName)
+{
+    fprintf(stderr, "Usage: %s [options] <input> [<output.wav>]\n", prgName);
+    fprintf(stderr, "  <input>       .mid file, or a text file with timestamped MIDI events\n");
+    fprintf(stderr, "  <output.wav>  stereo output of both SIDs; if omitted, only the sound engine\n");
+    fprintf(stderr, "                is clocked (for CPU measurements w/o reSID)\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -p <patch>    load patch 1..128 of bank A before rendering\n");
+    fprintf(stderr, "  -c <channel>  only play events of the given MIDI channel 1..16\n");
+    fprintf(stderr, "  -l <seconds>  length of the rendering (default: end of input + release time)\n");
+    fprintf(stderr, "  -t <seconds>  release time after the last event (default: 2)\n");
+    fprintf(stderr, "  -r <rate>     sample rate (default: 44100)\n");
+    fprintf(stderr, "  -m <model>    SID model 6581 or 8580 (default: 8580)\n");
+    fprintf(stderr, "  -q            don't print the statistics\n");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+    int patch = -1;
+    double lengthSeconds = 0.0;
+    double releaseSeconds = 2.0;
+    u32 sampleRate = 44100;
+    chip_model model = MOS8580;
+    bool quiet = false;
+
+    int opt;
+    while( (opt=getopt(argc, argv, "p:c:l:t:r:m:q")) != -1 ) {
+        switch( opt ) {
+        case 'p': patch = atoi(optarg) - 1; break;
+        case 'c': midiChannel = atoi(optarg); break;
+        case 'l': lengthSeconds = atof(optarg); break;
+        case 't': releaseSeconds = atof(optarg); break;
+        case 'r': sampleRate = atoi(optarg); break;
+        case 'm': model = (atoi(optarg) == 6581) ? MOS6581 : MOS8580; break;
+        case 'q': quiet = true; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if( optind >= argc || (argc - optind) > 2 || patch < -1 || patch >= 128 || midiChannel > 16 || sampleRate < 8000 ) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char *inputName = argv[optind];
+    const char *outputName = ((argc - optind) >= 2) ? argv[optind+1] : NULL;
+
+    // read input
+    const char *ext = strrchr(inputName, '.');
+    bool isMidFile = ext && (strcasecmp(ext, ".mid") == 0 || strcasecmp(ext, ".midi") == 0);
+    if( isMidFile ) {
+        if( midFileOpen(inputName) < 0 )
+            return 1;
+    } else {
+        if( eventListRead(inputName) < 0 )
+            return 1;
+    }
+
+    // open output
+    FILE *wav = NULL;
+    if( outputName ) {
+        if( (wav=fopen(outputName, "wb")) == NULL ) {
+            fprintf(stderr, "ERROR: can't create %s\n", outputName);
+            return 1;
+        }
+        wavWriteHeader(wav, sampleRate, 0); // updated at the end
+    }
+
+    // initialize reSID
+    mixer_value1 = 1.0f;
+    mixer_value2 = 1.0f;
+    mixer_value3 = 1.0f;
+    for(int sid=0; sid<RENDER_SID_NUM; ++sid) {
+        reSID[sid] = new SID;
+        reSID[sid]->set_chip_model(model);
+        reSID[sid]->reset();
+        if( !reSID[sid]->set_sampling_parameters(RESID_FREQUENCY, RESID_SAMPLING_METHOD, sampleRate) ) {
+            fprintf(stderr, "ERROR: sample rate %u not supported by reSID\n", sampleRate);
+            return 1;
+        }
+    }
+    reSidUpdate(true);
+
+    // select patch
+    if( patch >= 0 )
+        mbSidEnvironment.bankLoad(0, 0, patch);
+
+    if( !quiet ) {
+        char patchName[17];
+        mbSidEnvironment.mbSid[0].mbSidPatch.nameGet(patchName);
+        fprintf(stderr, "[MBSID_RENDER] Patch: A%03d %s\n", (patch >= 0) ? (patch + 1) : 1, patchName);
+    }
+
+    // sound engine update period like in app.cpp
+    u32 tickPeriod_uS = 2000 / mbSidEnvironment.updateSpeedFactor;
+    u32 maxTicks = (u32)(lengthSeconds * 1E6 / tickPeriod_uS);
+    u32 releaseTicks = (u32)(releaseSeconds * 1E6 / tickPeriod_uS);
+
+    // rendering loop
+    static short sampleBuffer[RENDER_MAX_SAMPLES_PER_TICK * RENDER_SID_NUM];
+    u32 numTicks = 0;
+    u32 numFrames = 0;
+    u32 endTick = 0; // set once the input is finished
+    u32 eventIx = 0;
+    double midTick = 0.0;
+    u32 midNextTick = 0;
+    s32 ppqn = isMidFile ? MIDI_PARSER_PPQN_Get() : 0;
+    double startTime = timeGet();
+
+    engineTime = 0.0;
+    reSidTime = 0.0;
+    mbSidEnvironment.bpmRestart();
+
+    while( maxTicks ? (numTicks < maxTicks) : (!endTick || numTicks < endTick) ) {
+        u32 time_uS = numTicks * tickPeriod_uS;
+
+        double t0 = timeGet();
+
+        // play events
+        if( !endTick || maxTicks ) {
+            if( isMidFile ) {
+                midTick += (midFileBpm * ppqn * tickPeriod_uS) / 60.0E6;
+                if( (u32)midTick > midNextTick ) {
+                    if( MID_PARSER_FetchEvents(midNextTick, (u32)midTick - midNextTick) == 0 && !endTick )
+                        endTick = numTicks + releaseTicks;
+                    midNextTick = (u32)midTick;
+                }
+            } else {
+                while( eventIx < eventList.size() && (eventList[eventIx].timestamp * 1000) <= time_uS ) {
+                    midiSend(&eventList[eventIx].bytes[0], eventList[eventIx].bytes.size());
+                    ++eventIx;
+                }
+                if( eventIx >= eventList.size() && !endTick )
+                    endTick = numTicks + releaseTicks;
+            }
+        }
+
+        // update sound engine
+        mbSidEnvironment.tick();
+        ++numTicks;
+
+        double t1 = timeGet();
+        engineTime += t1 - t0;
+
+        // render samples
+        if( wav ) {
+            reSidUpdate(false);
+
+            int framesRendered = 0;
+            for(int sid=0; sid<RENDER_SID_NUM; ++sid) {
+                cycle_count delta_t = (RESID_FREQUENCY / 1000000.0) * tickPeriod_uS;
+                int n = 0;
+                while( delta_t && n < RENDER_MAX_SAMPLES_PER_TICK )
+                    n += reSID[sid]->clock(delta_t, &sampleBuffer[n * RENDER_SID_NUM + sid], RENDER_MAX_SAMPLES_PER_TICK - n, RENDER_SID_NUM);
+                framesRendered = n; // all SIDs are clocked with the same parameters
+            }
+
+            fwrite(sampleBuffer, sizeof(short), framesRendered * RENDER_SID_NUM, wav);
+            numFrames += framesRendered;
+
+            reSidTime += timeGet() - t1;
+        }
+    }
+
+    double totalTime = timeGet() - startTime;
+
+    if( wav ) {
+        wavWriteHeader(wav, sampleRate, numFrames);
+        fclose(wav);
+    }
+
+    for(int sid=0; sid<RENDER_SID_NUM; ++sid)
+        delete reSID[sid];
+
+    if( !quiet ) {
+        double audioSeconds = (numTicks * (double)tickPeriod_uS) / 1E6;
+        fprintf(stderr, "[MBSID_RENDER] %u engine ticks, %u samples, %.2f s audio\n", numTicks, numFrames, audioSeconds);
+        fprintf(stderr, "[MBSID_RENDER] sound engine: %8.3f s => %10.0f ticks/s\n", engineTime, engineTime ? (numTicks / engineTime) : 0.0);
+        if( wav )
+            fprintf(stderr, "[MBSID_RENDER] reSID:        %8.3f s => %10.0f samples/s\n", reSidTime, reSidTime ? (numFrames / reSidTime) : 0.0);
+        fprintf(stderr, "[MBSID_RENDER] total:        %8.3f s => %.1fx realtime\n", totalTime, totalTime ? (audioSeconds / totalTime) : 0.0);
+    }
+
+    return 0;
+}
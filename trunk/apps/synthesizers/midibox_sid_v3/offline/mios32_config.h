@@ -0,0 +1,47 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the offline renderer
+ *
+ * this file allows to disable (or re-configure) default functions of MIOS32
+ * available switches are listed in $MIOS32_PATH/modules/mios32/MIOS32_CONFIG.txt
+ *
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+#define MIOS32_FAMILY_EMULATION 1
+#define MIOS32_BOARD_STR   "OFFLINE"
+#define MIOS32_FAMILY_STR  "EMULATION"
+
+
+// The boot message which is print during startup and returned on a SysEx query
+//                                <------------------------>
+#define MIOS32_LCD_BOOT_MSG_LINE1 "MIDIbox SID Renderer    "
+#define MIOS32_LCD_BOOT_MSG_LINE2 "(C) 2014 T. Klose       "
+
+// function used to output debug messages (must be printf compatible!)
+#define DEBUG_MSG MIOS32_MIDI_SendDebugMessage
+
+
+// not supported by the offline renderer:
+#define MIOS32_DONT_USE_IRQ
+#define MIOS32_DONT_USE_AIN
+#define MIOS32_DONT_USE_MF
+#define MIOS32_DONT_USE_USB
+#define MIOS32_DONT_USE_USB_MIDI
+#define MIOS32_DONT_USE_IIC
+#define MIOS32_DONT_USE_IIC_MIDI
+#define MIOS32_DONT_USE_DELAY
+
+
+#define MIOS32_MIDI_DEFAULT_PORT UART0
+
+#define MIOS32_UART_NUM 4
+
+// maximum idle counter value to be expected
+#define MAX_IDLE_CTR 100
+
+#define SIDPHYS_DISABLED
+
+#endif /* _MIOS32_CONFIG_H */
@@ -78,6 +78,13 @@
 #define SAMPLE_BUFFER_SIZE 32  
 #define CHANNELS 2
 
+// 1: the synth engine renders each buffer half stage by stage (accumulators,
+//    oscillators, fx) with the patch flags checked once per block
+// 0: previous per-sample renderer, kept for benchmarking and bit-comparison
+#ifndef ENGINE_BLOCK_RENDER
+#define ENGINE_BLOCK_RENDER			1
+#endif
+
 #define ENVELOPE_RESOLUTION 		100 // divider for the envelope clock (48kHz/(X+1))
 #define LFO_RESOLUTION 				100  // divider for the lfo clock (48kHz/(X+1))
 
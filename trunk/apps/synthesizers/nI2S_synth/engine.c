@@ -23,6 +23,7 @@
 
 #include "defs.h"
 #include "engine.h"
+#include "envelope.h"
 #include "lfo.h"
 #include "filter.h"
 #include "drum.h"
@@ -676,6 +677,385 @@ void ENGINE_updateRoutingOutputs() {
 }
 */
 
+#if ENGINE_BLOCK_RENDER
+/////////////////////////////////////////////////////////////////////////////
+// Block renderer
+//
+// Each buffer half is rendered stage by stage: first the accumulators of
+// all samples, then each oscillator, the oscillator merge and the fx chain.
+// Patch flags and modulation values (route_outs are only updated once per
+// buffer) are checked/calculated once per block, and only the enabled
+// waveforms and fx are processed. The output is identical to the previous
+// per-sample renderer (ENGINE_BLOCK_RENDER 0).
+/////////////////////////////////////////////////////////////////////////////
+
+#define BLOCK_SIZE (SAMPLE_BUFFER_SIZE/CHANNELS)
+
+// the accumulators of both oscillators are processed in parallel:
+// osc 1 in the lower, osc 2 in the upper halfword
+#if defined(MIOS32_FAMILY_STM32F4xx)
+// Cortex-M4: dual 16bit add
+# define ENGINE_ADD16x2(a, b) __UADD16(a, b)
+#else
+# define ENGINE_ADD16x2(a, b) ((((a) + (b)) & 0x0000FFFF) | ((((a) & 0xFFFF0000) + ((b) & 0xFFFF0000)) & 0xFFFF0000))
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// calculates the oscillator (and sub oscillator) accumulators of a block
+/////////////////////////////////////////////////////////////////////////////
+static void ENGINE_renderAccumulators(u32 *phase, u32 *subPhase, u8 n) {
+	oscillator_t *o1 = &p.d.oscillators[0];
+	oscillator_t *o2 = &p.d.oscillators[1];
+	u32 ac, acc, subAcc, utout2;
+	s32 tout;
+	u8 i;
+
+	if (!p.d.engineFlags.syncOsc2 &&
+		(o1->portaMode == PORTA_NONE || o1->portaStart == o1->pitchedAccumValue) &&
+		(o2->portaMode == PORTA_NONE || o2->portaStart == o2->pitchedAccumValue)) {
+		// no sync and no running portamento: the increments are constant for the whole block
+		u32 inc, subInc;
+
+		// oscillator 1 with pitch mod
+		ac = o1->pitchedAccumValue;
+		tout = route_outs[RT_OSC1_PITCH].s16;
+		tout *= ac;
+		tout >>= 15;
+		ac += tout;
+		ac += o1->finetune;
+		inc = ac & 0xFFFF;
+		subInc = (ac >> 1) & 0xFFFF;
+
+		// oscillator 2 with pitch mod 2
+		ac = o2->pitchedAccumValue;
+		tout = route_outs[RT_OSC2_PITCH].s16;
+		tout *= ac;
+		tout /= 32768;
+		ac += tout;
+		ac += o2->finetune;
+		inc |= (ac & 0xFFFF) << 16;
+		subInc |= ((ac >> 1) & 0xFFFF) << 16;
+
+		acc = o1->accumulator | ((u32)o2->accumulator << 16);
+		subAcc = o1->subAccumulator | ((u32)o2->subAccumulator << 16);
+
+		for (i=0; i<n; i++) {
+			acc = ENGINE_ADD16x2(acc, inc);
+			subAcc = ENGINE_ADD16x2(subAcc, subInc);
+			phase[i] = acc;
+			subPhase[i] = subAcc;
+		}
+
+		o1->accumulator = acc;
+		o2->accumulator = acc >> 16;
+		o1->subAccumulator = subAcc;
+		o2->subAccumulator = subAcc >> 16;
+		return;
+	}
+
+	// sync or portamento: the increments change from sample to sample
+	for (i=0; i<n; i++) {
+		utout2 = o1->accumulator;
+		ac = o1->pitchedAccumValue;
+
+		// porta mode?
+		if (o1->portaMode != PORTA_NONE)
+		if (o1->portaStart != o1->pitchedAccumValue) {
+			ac = o1->portaStart + (o1->accumValue - o1->pitchedAccumValue);
+			o1->portaTick += o1->portaRate;
+			
+			if (o1->portaTick > 0xFFFFE) {
+				o1->portaTick = 0;
+				
+				// porta time up
+				if (o1->portaStart < o1->pitchedAccumValue)
+					o1->portaStart += 1;
+				else
+					o1->portaStart -= 1;
+			}
+		}
+
+		// pitch mod
+		tout = route_outs[RT_OSC1_PITCH].s16;
+		tout *= ac;
+		tout >>= 15;
+		ac += tout;
+
+		ac += o1->finetune;
+		o1->accumulator += ac;
+		ac >>= 1;
+		o1->subAccumulator += ac;
+		
+		// oscillator 2
+		if ((p.d.engineFlags.syncOsc2) && (o1->accumulator < utout2)) 
+			o2->accumulator = 0;
+		else {
+			utout2 = o2->pitchedAccumValue;
+			
+			// porta mode?
+			if (o2->portaMode != PORTA_NONE)
+			if (o2->portaStart != o2->pitchedAccumValue) {
+				utout2 = o2->portaStart  + (o2->accumValue - o2->pitchedAccumValue);
+				o2->portaTick += o2->portaRate;
+				
+				if (o2->portaTick >= 0xFFFF) {
+					o2->portaTick = 0;
+					
+					// porta time up
+					if (o2->portaStart < o2->pitchedAccumValue)
+						o2->portaStart += 1;
+					else
+						o2->portaStart -= 1;
+				}
+			}
+			
+			// pitch mod 2
+			tout = route_outs[RT_OSC2_PITCH].s16;
+			tout *= utout2;
+			tout /= 32768;
+			utout2 += tout;
+
+			utout2 += o2->finetune;
+			o2->accumulator += utout2;
+			utout2 >>= 1;
+			o2->subAccumulator += utout2;
+		}
+
+		phase[i] = o1->accumulator | ((u32)o2->accumulator << 16);
+		subPhase[i] = o1->subAccumulator | ((u32)o2->subAccumulator << 16);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// renders n samples of an oscillator (incl. sub oscillator and velocity)
+/////////////////////////////////////////////////////////////////////////////
+static void ENGINE_renderOscillator(u8 osc, u32 *phase, u32 *subPhase, s32 *out, u8 n) {
+	oscillator_t *o = &p.d.oscillators[osc];
+	u8 shift = osc ? 16 : 0;
+	waveform_t waveforms;
+	s32 acc32, subSample;
+	u16 acc;
+	u8 i;
+
+	// no waveforms... mute
+	waveforms.all = o->waveformCount ? o->waveforms.all : 0;
+
+	for (i=0; i<n; i++)
+		out[i] = 0;
+
+	// mix the selected waveforms
+	// fixme: mush em all together, missing mix blend and so on
+	if (waveforms.triangle) {
+		for (i=0; i<n; i++) {
+			acc = phase[i] >> shift;
+			if (acc < 32768) out[i] += (acc * 2) - 32768;
+			else 		  	 out[i] += 32767 - ((acc - 32768) * 2);
+		}
+	}
+
+	if (waveforms.saw) {
+		for (i=0; i<n; i++) {
+			acc = phase[i] >> shift;
+			out[i] += acc - 32768;
+		}
+	}
+
+	if (waveforms.ramp) {
+		for (i=0; i<n; i++) {
+			acc = phase[i] >> shift;
+			out[i] += (32768 - acc);
+		}
+	}
+
+	if (waveforms.sine) {
+		for (i=0; i<n; i++) {
+			acc = phase[i] >> shift;
+			out[i] += ssineTable512[(acc >> 7)];
+		}
+	}
+
+	if (waveforms.square) {
+		for (i=0; i<n; i++) {
+			acc = phase[i] >> shift;
+			out[i] += (acc > 32768) ? 32767 : -32768;
+		}
+	}
+
+	if (waveforms.pulse) {
+		u16 pulsewidth = o->pulsewidth;
+		for (i=0; i<n; i++) {
+			acc = phase[i] >> shift;
+			out[i] += (acc > pulsewidth) ? 32767 : -32768;
+		}
+	}
+
+	// white noise, "pink" noise is the same
+	if (waveforms.white_noise || waveforms.pink_noise) {
+		u8 both = waveforms.white_noise && waveforms.pink_noise;
+		for (i=0; i<n; i++) {
+			acc = phase[i] >> shift;
+			acc32 = sineTable512[acc >> 6] * acc - acc;
+			out[i] += acc32;
+			if (both)
+				out[i] += acc32;
+		}
+	}
+
+	// merge with sub osc (triangle) and set velocity
+	// fixme: vel curve
+	for (i=0; i<n; i++) {
+		acc = subPhase[i] >> shift;
+		if (acc < 32768) subSample = (acc * 2) - 32768;
+		else 		  	 subSample = 32767 - ((acc - 32768) * 2);
+
+		acc32 = out[i];
+		acc32 += (subSample * o->subOscVolume) / 65536;
+		acc32 /= 2;
+		acc32 *= o->velocity;
+		acc32 /= 128;
+		out[i] = acc32;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Fills the buffer with nicey sample sounds ;D
+/////////////////////////////////////////////////////////////////////////////
+void ENGINE_ReloadSampleBuffer(u32 state) {
+	// transfer new samples to the lower/upper sample buffer range
+	u8 i, n;
+	u16 out;
+	s32 tout, tout2;
+	u32 utout;
+	u32 *buffer = (u32	*)&sample_buffer[state ? (SAMPLE_BUFFER_SIZE/CHANNELS) : 0];
+	u32 phase[BLOCK_SIZE];			// accumulators of osc 1 (lower) and osc 2 (upper halfword)
+	u32 subPhase[BLOCK_SIZE];		// sub oscillator accumulators
+	s32 osc1[BLOCK_SIZE];			// oscillator outputs
+	s32 osc2[BLOCK_SIZE];
+	u8 rendered[BLOCK_SIZE];		// 0: sample is skipped due to downsampling
+
+	// debug: measure time it takes for 8 samples
+	// decrease counter
+	#ifdef ENGINE_VERBOSE_MAX
+	dead--;
+	MIOS32_STOPWATCH_Reset();
+	#endif 
+
+	// new one again
+	ENGINE_updateModPaths();
+
+	// tick the envelopes and the lfos
+	// they only change route_ins, which are taken over with the next ENGINE_updateModPaths()
+	for (i=0; i<BLOCK_SIZE; i++) {
+		envelopeTime++;
+		
+		if (envelopeTime > ENVELOPE_RESOLUTION) {
+			envelopeTime = 0;
+			ENV_tick();
+		}
+
+		lfoTime++;
+		
+		if (lfoTime > LFO_RESOLUTION) {
+			lfoTime = 0;
+			LFO_tick();
+		}
+	}
+
+	/* OSCILLATOR ACCUMULATORS *******************************************/
+	ENGINE_renderAccumulators(phase, subPhase, BLOCK_SIZE);
+
+	// downsampling ***********************************************************
+	// T_SAMPLERATE is right here
+	// the accumulators of the rendered samples are moved to the front
+	utout = p.d.voice.downsample;
+	utout *= route_outs[RT_DOWNSAMPLE].u16;
+	utout /= 65536;
+	utout >>= 15;
+
+	for (i=0, n=0; i<BLOCK_SIZE; i++) {
+		if (downsampled > utout)
+			downsampled = utout;
+		
+		if (utout != downsampled) {
+			rendered[i] = 0;
+			downsampled++;
+		} else {
+			rendered[i] = 1;
+			downsampled = 0;
+			phase[n] = phase[i];
+			subPhase[n] = subPhase[i];
+			n++;
+		}
+	}
+
+	if (n) {
+		/***************************************************************
+		 * calculate the oscillators                                   *
+		 ***************************************************************/
+		ENGINE_renderOscillator(0, phase, subPhase, osc1, n);
+		ENGINE_renderOscillator(1, phase, subPhase, osc2, n);
+
+		// merge the two oscillators into one stream
+		if (p.d.engineFlags.ringmod) {
+			for (i=0; i<n; i++) {
+				tout = osc1[i];
+				tout *= p.d.oscillators[0].volume;
+				tout >>= 14;
+				tout2 = osc2[i];
+				tout2 *= p.d.oscillators[1].volume;
+				tout2 >>= 14;
+
+				tout /= 4;
+				tout2 /= 4;
+				tout *= tout2;
+				tout /= 65536;
+				osc1[i] = (s16) tout;
+			}
+		} else {
+			for (i=0; i<n; i++) {
+				tout = osc1[i];
+				tout *= p.d.oscillators[0].volume;
+				tout >>= 14;
+				tout2 = osc2[i];
+				tout2 *= p.d.oscillators[1].volume;
+				tout2 >>= 14;
+
+				tout += tout2;
+				tout /= 8;
+				osc1[i] = (s16) tout;
+			}
+		}
+
+		// hand over merged samples to ENGINE_postProcessBlock for fx
+		ENGINE_postProcessBlock(osc1, n);
+	}
+
+	// write samples to output buffer, skipped samples repeat the last one
+	for (i=0, n=0; i<BLOCK_SIZE; i++) {
+		if (rendered[i])
+			p.d.voice.lastSample = osc1[n++];
+
+		out = p.d.voice.lastSample;
+		*buffer++ = out << 16 | out;
+	}
+
+	// debug: stop measuring time here
+	#ifdef ENGINE_VERBOSE_MAX
+	if (!dead) {
+		// send execution time via MIDI interface
+		u32 delay = MIOS32_STOPWATCH_ValueGet();
+		delay *= 1000;
+		delay /= 333;
+		MIOS32_MIDI_SendDebugMessage("%d.%d%%", delay/10, delay % 10);	
+
+		// reset timer to measure every 12000th iteration (0.5Hz)
+		dead = 12000;
+	}
+	#endif	  
+}
+
+#else
+
 /////////////////////////////////////////////////////////////////////////////
 // Fills the buffer with nicey sample sounds ;D
 /////////////////////////////////////////////////////////////////////////////
@@ -957,6 +1337,7 @@ void ENGINE_ReloadSampleBuffer(u32 state) {
 	}
 	#endif	  
 }
+#endif /* ENGINE_BLOCK_RENDER */
 
 // sets the waveform flags for an oscillator
 void ENGINE_setOscWaveform(u8 osc, u16 flags) {
@@ -1334,18 +1715,18 @@ s16 ENGINE_postProcess(s16 sample) {
 		uval /= 432;
 		// offset with base time
 		uval += 193;
-		tout2 = chorusBuffer[(chorusIndex - uval) & 0x1FFF];
+		tout2 = chorusBuffer[(chorusIndex - uval) & (CHORUS_BUFFER_SIZE - 1)];
 		tout += tout2;
 		tout /= 2;
  
 		// save to chorus buffer
-		chorusBuffer[chorusIndex & 0x1FFF] = tout;
+		chorusBuffer[chorusIndex & (CHORUS_BUFFER_SIZE - 1)] = tout;
 		chorusIndex++;
 	}
 
 	// add delay
 	if (p.d.engineFlags.delay) {
-	        tout2 = delayBuffer[(delayIndex - p.d.voice.delayTime) % DELAY_BUFFER_SIZE];
+	        tout2 = delayBuffer[(u16)(delayIndex - p.d.voice.delayTime) % DELAY_BUFFER_SIZE];
 		tout2 *= p.d.voice.delayFeedback;
 		tout2 /= 65536;
 		tout += tout2;
@@ -1372,6 +1753,144 @@ s16 ENGINE_postProcess(s16 sample) {
 	return tout;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// block variant of ENGINE_postProcess(): processes n samples in place, each
+// fx is only checked once per block
+/////////////////////////////////////////////////////////////////////////////
+void ENGINE_postProcessBlock(s32 *buffer, u8 n) {
+	u8 i;
+	u32 uval;
+	s32 tout, tout2;
+
+	if (p.d.engineFlags.overdrive) {
+		u32 drive = p.d.voice.overdrive;
+		drive *= route_outs[RT_OVERDRIVE].u16;  
+		drive /= 65536;										
+
+		drive *= drive;
+		drive /= 65536;
+		
+		// unity gain in 0..2048 range
+		if (drive < 2048)	
+			drive = 2048;
+
+		for (i=0; i<n; i++) {
+			tout = buffer[i];
+			tout *= drive;
+			tout /= 2048;
+
+			// clip
+			if (tout < -32768)
+				tout = -32768;
+			else
+			if (tout > 32767)
+				tout = 32767;
+
+			buffer[i] = tout;
+		}
+	} // drive
+
+	// filter
+	if (p.d.engineFlags.dcf && p.d.filter.filterType) {
+		uval = p.d.filter.cutoff; 					
+		uval *= route_outs[RT_FILTER_CUTOFF].u16; 
+		uval /= 65536;								
+		
+		FILTER_filterBlock(buffer, n, uval);
+	} // filter
+
+	// master volume
+	uval = p.d.voice.masterVolume;
+	uval *= route_outs[RT_VOLUME].u16;  
+	uval /= 65536;									
+	for (i=0; i<n; i++) {
+		tout = buffer[i];
+		tout *= uval;
+		tout /= 65536;
+		buffer[i] = tout;
+	}
+
+	// bitcrush and XOR (samples are in the 16bit range here, so that
+	// the full bitcrush pattern doesn't change anything)
+	if ((bcpattern != 0xFFFF) || p.d.voice.xor) {
+		for (i=0; i<n; i++) {
+			tout = buffer[i];
+			tout = ((tout + 32768) & bcpattern) - 32768;
+			tout ^= p.d.voice.xor;
+			buffer[i] = tout;
+		}
+	}
+
+	// add chorus
+	if (p.d.engineFlags.chorus) {
+		u32 feedback = sqrtTable[p.d.voice.chorusFeedback >> 7];
+
+		for (i=0; i<n; i++) {
+			// accumulate time shift
+			chorusAccum += p.d.voice.chorusTime;
+			// get sinewave
+			uval = sineTable512[chorusAccum >> 7];
+			// "log" 
+			uval *= feedback;
+			uval = sqrtTable[uval >> 23];
+			// get into desired timing range
+			uval /= 432;
+			// offset with base time
+			uval += 193;
+			tout2 = chorusBuffer[(chorusIndex - uval) & (CHORUS_BUFFER_SIZE - 1)];
+			tout = buffer[i];
+			tout += tout2;
+			tout /= 2;
+ 
+			// save to chorus buffer
+			chorusBuffer[chorusIndex & (CHORUS_BUFFER_SIZE - 1)] = tout;
+			chorusIndex++;
+			buffer[i] = tout;
+		}
+	}
+
+	// add delay
+	if (p.d.engineFlags.delay) {
+		for (i=0; i<n; i++) {
+			tout2 = delayBuffer[(u16)(delayIndex - p.d.voice.delayTime) % DELAY_BUFFER_SIZE];
+			tout2 *= p.d.voice.delayFeedback;
+			tout2 /= 65536;
+			tout = buffer[i];
+			tout += tout2;
+			tout /= 2; // fixme: this shouldn't be delay/2 but /(1+(delayFeeback/65536))
+
+			// save to delay buffer
+			if (delaysampled) {
+				delaysampled--;
+			} else {
+				delayBuffer[delayIndex % DELAY_BUFFER_SIZE] = tout;
+				delayIndex++;
+				delaysampled = p.d.voice.delayDownsample;
+			}
+			buffer[i] = tout;
+		}
+	}
+
+	// median with last sample and set volume
+	if (p.d.engineFlags.interpolate) {
+		s16 last = p.d.voice.lastSample;
+
+		for (i=0; i<n; i++) {
+			tout = (buffer[i] + last) / 2;
+			tout *= p.d.voice.masterVolume; 
+			tout /= 65536;
+			buffer[i] = last = tout;
+		}
+	} else {
+		for (i=0; i<n; i++) {
+			tout = buffer[i];
+			tout *= p.d.voice.masterVolume; 
+			tout /= 65536;
+			buffer[i] = (s16) tout;
+		}
+	}
+}
+
 void ENGINE_setDownsampling(u8 rate) {
 	p.d.voice.downsample = rate;
 }
@@ -44,6 +44,8 @@ void ENGINE_noteOn(u8 note, u8 vel, u8 steal);
 void ENGINE_setDelayTime(u16 time);
 void ENGINE_setDelayFeedback(u16 feedback);
 void ENGINE_setDelayDownsample(u8 downsample);
+void ENGINE_setChorusTime(u16 time);
+void ENGINE_setChorusFeedback(u16 feedback);
 
 void ENGINE_setOverdrive(u16 od);
 void ENGINE_setXOR(u16 xor);
@@ -55,6 +57,7 @@ void ENGINE_setSubOscVolume(u8 osc, u16 vol);
 void ENGINE_setOscPW(u8 osc, u16 pw);
 void ENGINE_setOscFinetune(u8 osc, s8 ft);
 
+u16 ENGINE_trigger(u8 trigger);
 void ENGINE_envelopeTick(void);
 void ENGINE_setEnvAttack(u8 env, u16 v);
 void ENGINE_setEnvDecay(u8 env, u16 v);
@@ -76,6 +79,7 @@ void ENGINE_setTriggerColumn(u8 row, u16 value);
 void ENGINE_setTempValue(u8 index, u16 value);
 
 s16 ENGINE_postProcess(s16 sample);
+void ENGINE_postProcessBlock(s32 *buffer, u8 n);
 
 /////////////////////////////////////////////////////////////////////////////
 // Temporary Function Prototypes
@@ -38,6 +38,7 @@ s16 FILTER_resonantLP(s16 in, u16 cutoff);
 s16 FILTER_simpleLP(s16 in, u16 cutoff);
 s16 FILTER_moogLP(s16 in, u16 resonance, u16 cutoff);
 s16 FILTER_svf(s16 in, u16 cutoff, u8 mode);
+void FILTER_svfBlock(s32 *buffer, u8 n, u16 cutoff);
 
 void FILTER_resonantLP_Init();
 void FILTER_svf_Init();
@@ -94,6 +95,34 @@ s16 FILTER_filter(s16 in, u16 cutoff) {
 	}
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// filters a block of n samples in place, the filter type is only checked
+// once per block
+/////////////////////////////////////////////////////////////////////////////
+void FILTER_filterBlock(s32 *buffer, u8 n, u16 cutoff) {
+	u8 i;
+
+	switch (p.d.filter.filterType) {
+		case FILTER_LP:
+			for (i=0; i<n; i++)
+				buffer[i] = FILTER_simpleLP(buffer[i], cutoff);
+			break;
+		case FILTER_RES_LP:
+			for (i=0; i<n; i++)
+				buffer[i] = (s16) ((s16) FILTER_resonantLP(buffer[i] + 32768, cutoff) - 32768);
+			break;
+		case FILTER_MOOG_LP:
+			for (i=0; i<n; i++)
+				buffer[i] = FILTER_moogLP(buffer[i], p.d.filter.resonance, cutoff);
+			break;
+		case FILTER_SVF_LOWPASS:
+		case FILTER_SVF_BANDPASS:
+		case FILTER_SVF_HIGHPASS:
+			FILTER_svfBlock(buffer, n, cutoff);
+			break;
+	}
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // simple resonant low pass filter
 /////////////////////////////////////////////////////////////////////////////
@@ -188,7 +217,7 @@ s16 FILTER_moogLP(s16 in, u16 resonance, u16 cutoff)
 	#define CUT_SCALE 65536
 	cutoff /= 3;
 	
-	s16 tan; // index for tanh lookup
+	u16 tan; // index for tanh lookup
 	s8 tanSign;
 
 	// offset to +- values
@@ -485,6 +514,45 @@ s16 FILTER_svf(s16 input, u16 cutoff, u8 mode) {
 	}
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// block variant of FILTER_svf(): only the selected output is summed up
+/////////////////////////////////////////////////////////////////////////////
+void FILTER_svfBlock(s32 *buffer, u8 n, u16 cutoff) {
+	s32 *tap;
+	s32 out, in;
+	u8 i;
+
+	svf_cutoff = (cutoff > 2047) ? cutoff : 2048;
+	f  = svf_cutoff / 4;
+
+	switch (p.d.filter.filterType) {
+		case FILTER_SVF_BANDPASS: tap = &bp1; break;
+		case FILTER_SVF_HIGHPASS: tap = &hp1; break;
+		default:                  tap = &lp1; break;
+	}
+
+	for (i=0; i<n; i++) {
+		in = (s16) buffer[i];
+
+		lp1 += (f * bp1) / 65535; 
+		hp1 = in - lp1 - bp1; 
+		bp1 += (f * hp1) / 65535; 
+		out = *tap;
+
+		lp1 += (f * bp1) / 65535; 
+		hp1 = in - lp1 - bp1; 
+		bp1 += (f * hp1) / 65535; 
+		out += *tap;
+
+		lp1 += (f * bp1) / 65535; 
+		hp1 = in - lp1 - bp1; 
+		bp1 += (f * hp1) / 65535; 
+		out += *tap;
+
+		buffer[i] = (s16) (out / 3);
+	}
+}
+
 void FILTER_svf_Init() {
 	// the math is way to complex (teehee) to be done everytime so we'll just
 	// guesstimate it
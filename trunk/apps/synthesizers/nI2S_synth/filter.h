@@ -23,6 +23,7 @@
 /////////////////////////////////////////////////////////////////////////////
 
 s16 FILTER_filter(s16 in, u16 cutoff);
+void FILTER_filterBlock(s32 *buffer, u8 n, u16 cutoff);
 
 void FILTER_setCutoff(u16 c);
 void FILTER_setResonance(u16 r);
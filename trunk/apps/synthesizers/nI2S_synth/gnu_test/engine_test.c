@@ -0,0 +1,213 @@
+// $Id$
+/*
+ * Host test and benchmark for the synth engine renderer
+ *
+ * Plays notes with different patch settings (waveforms, sync, portamento,
+ * ringmod, all filter types, fx...) through ENGINE_ReloadSampleBuffer() and
+ * prints a checksum of the rendered samples for each setting.
+ * The render time is printed to stderr.
+ *
+ * "make test" builds the test with the block renderer (ENGINE_BLOCK_RENDER 1)
+ * and with the previous per-sample renderer (ENGINE_BLOCK_RENDER 0), and
+ * compares the checksums.
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <gnu_test.h>
+
+#include "engine.h"
+#include "filter.h"
+#include "lfo.h"
+#include "envelope.h"
+
+#define NUM_BUFFERS      3000 // number of buffer halves per setting (16 samples each -> 1 second)
+#define NOTE_OFF_BUFFER  2000 // the note is released here
+
+// engine flags (see engineflags_t)
+#define F_INTERPOLATE (1 << 1)
+#define F_SYNC        (1 << 2)
+#define F_OVERDRIVE   (1 << 3)
+#define F_DCF         (1 << 6)
+#define F_RINGMOD     (1 << 7)
+#define F_DELAY       (1 << 8)
+#define F_CHORUS      (1 << 9)
+
+// trigger matrix columns (see trigger_col_t)
+#define T_ENV1_ATTACK  (1 << 2)
+#define T_ENV1_RELEASE (1 << 5)
+#define T_ENV2_ATTACK  (1 << 6)
+#define T_ENV2_RELEASE (1 << 9)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32 stand-ins
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_I2S_Start(u32 *buffer, u16 len, void *_callback) { return 0; }
+s32 MIOS32_I2S_Stop(void) { return 0; }
+s32 MIOS32_STOPWATCH_Init(u32 resolution) { return 0; }
+s32 MIOS32_STOPWATCH_Reset(void) { return 0; }
+u32 MIOS32_STOPWATCH_ValueGet(void) { return 0; }
+
+extern void ENGINE_ReloadSampleBuffer(u32 state);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// test settings
+/////////////////////////////////////////////////////////////////////////////
+typedef struct {
+  const char *name;
+  u16 flags;
+  u8  waveforms[2];
+  u8  porta;
+  u8  filter;
+  u16 overdrive;
+  u8  bitcrush;
+  u16 xor;
+  s16 pitchbend;
+} setting_t;
+
+static const setting_t settings[] = {
+  // name                 flags                                  waveforms   porta filter overdrive bitcrush xor   pitchbend
+  { "default patch",      0,                                     { 0x01, 0x02 }, 0, 0, 0,     0,  0x0000,     0 },
+  { "all waveforms",      0,                                     { 0xff, 0x55 }, 0, 0, 0,     0,  0x0000,     0 },
+  { "no waveforms",       0,                                     { 0x00, 0x00 }, 0, 0, 0,     0,  0x0000,     0 },
+  { "noise",              0,                                     { 0xc0, 0x40 }, 0, 0, 0,     0,  0x0000,     0 },
+  { "pitchbend",          0,                                     { 0x09, 0x12 }, 0, 0, 0,     0,  0x0000,  5000 },
+  { "sync",               F_SYNC,                                { 0x02, 0x22 }, 0, 0, 0,     0,  0x0000,     0 },
+  { "portamento",         0,                                     { 0x02, 0x04 }, 1, 0, 0,     0,  0x0000,     0 },
+  { "sync + portamento",  F_SYNC,                                { 0x10, 0x20 }, 1, 0, 0,     0,  0x0000, -3000 },
+  { "ringmod",            F_RINGMOD,                             { 0x08, 0x01 }, 0, 0, 0,     0,  0x0000,     0 },
+  { "overdrive",          F_OVERDRIVE,                           { 0x03, 0x08 }, 0, 0, 65535, 0,  0x0000,     0 },
+  { "simple LP",          F_DCF,                                 { 0x02, 0x10 }, 0, FILTER_LP,           0, 0, 0x0000, 0 },
+  { "resonant LP",        F_DCF,                                 { 0x02, 0x10 }, 0, FILTER_RES_LP,       0, 0, 0x0000, 0 },
+  { "moog LP",            F_DCF,                                 { 0x02, 0x10 }, 0, FILTER_MOOG_LP,      0, 0, 0x0000, 0 },
+  { "SVF lowpass",        F_DCF,                                 { 0x02, 0x10 }, 0, FILTER_SVF_LOWPASS,  0, 0, 0x0000, 0 },
+  { "SVF bandpass",       F_DCF,                                 { 0x02, 0x10 }, 0, FILTER_SVF_BANDPASS, 0, 0, 0x0000, 0 },
+  { "SVF highpass",       F_DCF,                                 { 0x02, 0x10 }, 0, FILTER_SVF_HIGHPASS, 0, 0, 0x0000, 0 },
+  { "bitcrush",           0,                                     { 0x01, 0x08 }, 0, 0, 0,     9,  0x0000,     0 },
+  { "xor",                0,                                     { 0x01, 0x08 }, 0, 0, 0,     0,  0x8421,     0 },
+  { "chorus",             F_CHORUS,                              { 0x02, 0x04 }, 0, 0, 0,     0,  0x0000,     0 },
+  { "delay",              F_DELAY,                               { 0x02, 0x04 }, 0, 0, 0,     0,  0x0000,     0 },
+  { "interpolate",        F_INTERPOLATE,                         { 0x20, 0x10 }, 0, 0, 0,     0,  0x0000,     0 },
+  { "everything",         F_INTERPOLATE | F_SYNC | F_OVERDRIVE | F_DCF | F_RINGMOD | F_DELAY | F_CHORUS,
+                                                                 { 0xff, 0xff }, 1, FILTER_MOOG_LP, 40000, 3, 0x0101, 1000 },
+};
+
+#define NUM_SETTINGS (sizeof(settings)/sizeof(setting_t))
+
+
+/////////////////////////////////////////////////////////////////////////////
+// renders a setting, returns the checksum of the output
+/////////////////////////////////////////////////////////////////////////////
+static uint32_t render(const setting_t *s, clock_t *render_time)
+{
+  int n, osc;
+  uint32_t hash = 2166136261u; // FNV-1a
+
+  // the layout of default_patch only matches the ARM target, therefore
+  // the patch is set up with the parameter functions
+  for(n=0; n<512; ++n)
+    p.all[n] = 0;
+  ENGINE_init();
+
+  // additional mod paths: env 1 -> volume, lfo 2 -> cutoff
+  routes[1].inputid[0] = RS_ENV1_OUT;
+  routes[1].depth[0] = 32767;
+  routes[1].outputid = RT_VOLUME;
+  routes[2].inputid[0] = RS_LFO2_OUT;
+  routes[2].depth[0] = 20000;
+  routes[2].outputid = RT_FILTER_CUTOFF;
+
+  ENGINE_setTriggerColumn(TRIGGER_NOTEON, T_ENV1_ATTACK | T_ENV2_ATTACK);
+  ENGINE_setTriggerColumn(TRIGGER_NOTEOFF, T_ENV1_RELEASE | T_ENV2_RELEASE);
+  for(n=0; n<2; ++n) {
+    ENV_setAttack(n, 2000);
+    ENV_setDecay(n, 3000);
+    ENV_setSustain(n, 40000);
+    ENV_setRelease(n, 4000);
+    LFO_setFreq(n, n ? 3000 : 1000);
+    LFO_setPW(n, 32768);
+    LFO_setWaveform(n, n ? 0x08 : 0x01);
+  }
+
+  ENGINE_setBitcrush(s->bitcrush);
+  ENGINE_setXOR(s->xor);
+  ENGINE_setEngineFlags(s->flags);
+  ENGINE_setOverdrive(s->overdrive);
+  ENGINE_setMasterVolume(60000);
+  ENGINE_setDelayTime(3000);
+  ENGINE_setDelayFeedback(40000);
+  ENGINE_setDelayDownsample(1);
+  ENGINE_setChorusTime(20000);
+  ENGINE_setChorusFeedback(30000);
+
+  FILTER_setFilter(s->filter);
+  FILTER_setCutoff(20000);
+  FILTER_setResonance(50000);
+
+  for(osc=0; osc<2; ++osc) {
+    ENGINE_setOscWaveform(osc, s->waveforms[osc]);
+    ENGINE_setOscVolume(osc, 50000);
+    ENGINE_setSubOscVolume(osc, osc ? 0 : 30000);
+    ENGINE_setOscPW(osc, 20000);
+    ENGINE_setOscFinetune(osc, osc ? 5 : -3);
+    ENGINE_setPortamentoMode(osc, s->porta ? PORTA_GLIDE : PORTA_NONE);
+    ENGINE_setPortamentoRate(osc, 20000);
+    ENGINE_setPitchbendUpRange(osc, 2);
+    ENGINE_setPitchbendDownRange(osc, 12);
+  }
+  ENGINE_setOscTranspose(1, 7);
+
+  ENGINE_noteOn(48, 100, NO_STEAL);
+  ENGINE_setPitchbend(2, s->pitchbend);
+
+  clock_t start = clock();
+  for(n=0; n<NUM_BUFFERS; ++n) {
+    int i;
+    u32 state = n & 1;
+
+    // legato note: portamento to the new pitch
+    if( n == NUM_BUFFERS/4 )
+      ENGINE_noteOn(60, 80, NO_STEAL);
+    if( n == NUM_BUFFERS/2 )
+      ENGINE_noteOff(60);
+    if( n == NOTE_OFF_BUFFER )
+      ENGINE_noteOff(48);
+
+    ENGINE_ReloadSampleBuffer(state);
+
+    for(i=0; i<SAMPLE_BUFFER_SIZE/CHANNELS; ++i) {
+      uint32_t value = (uint32_t)sample_buffer[(state ? (SAMPLE_BUFFER_SIZE/CHANNELS) : 0) + i];
+      int b;
+      for(b=0; b<4; ++b) {
+	hash ^= (value >> (8*b)) & 0xff;
+	hash *= 16777619u;
+      }
+    }
+  }
+  *render_time += clock() - start;
+
+  return hash;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  int i;
+  clock_t render_time = 0;
+
+  for(i=0; i<NUM_SETTINGS; ++i)
+    printf("%-20s %08x\n", settings[i].name, render(&settings[i], &render_time));
+
+  fprintf(stderr, "ENGINE_BLOCK_RENDER=%d: %d buffers rendered in %d ms\n",
+	  ENGINE_BLOCK_RENDER, (int)(NUM_SETTINGS*NUM_BUFFERS), (int)(render_time * 1000 / CLOCKS_PER_SEC));
+
+  return 0;
+}
@@ -133,7 +133,8 @@ const static u16 bcpatterns[15] = {
 	0xFFFF, 0xFFFE, 0xFFFC, 0xFFF8, 0xFFF0, 0xFFE0, 0xFFC0, 0xFF80, 0xFF00, 0xFE00, 0xFC00, 0xF800, 0xF000, 0xE000, 0xC000
 };
 	
-static s16 chorusBuffer[4096];
+#define CHORUS_BUFFER_SIZE 4096 // has to be a power of two
+static s16 chorusBuffer[CHORUS_BUFFER_SIZE];
 static s16 delayBuffer[DELAY_BUFFER_SIZE];
 
 #endif
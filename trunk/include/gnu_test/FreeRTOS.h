@@ -0,0 +1,18 @@
+// $Id$
+/*
+ * FreeRTOS stand-in for the host tests: the tests run in a single thread,
+ * only the heap functions and critical sections are provided
+ */
+
+#ifndef _FREERTOS_H
+#define _FREERTOS_H
+
+#include <stdlib.h>
+
+#define pvPortMalloc(size) malloc(size)
+#define vPortFree(ptr)     free(ptr)
+
+#define portENTER_CRITICAL()
+#define portEXIT_CRITICAL()
+
+#endif /* _FREERTOS_H */
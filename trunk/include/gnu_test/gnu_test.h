@@ -0,0 +1,63 @@
+// $Id$
+/*
+ * Common definitions for the host tests in the gnu_test directories
+ *
+ * This file should be included once by the main file of a test, after
+ * mios32.h. It provides:
+ *   - num_errors and CHECK(): failed checks are printed and counted
+ *   - GNU_TEST_Result(): prints PASSED or FAILED and returns the exit code
+ *   - stand-ins for MIOS32 functions which are called, but not checked by
+ *     most tests. A test which needs its own version defines the
+ *     GNU_TEST_OWN_* switch before this file is included.
+ *
+ * The make rules are located in $MIOS32_PATH/include/makefile/gnu_test.mk
+ */
+
+#ifndef _GNU_TEST_H
+#define _GNU_TEST_H
+
+#include <stdio.h>
+
+// number of error messages which are printed, further errors are only counted
+#ifndef GNU_TEST_MAX_ERROR_MSGS
+#define GNU_TEST_MAX_ERROR_MSGS 20
+#endif
+
+
+static u32 num_errors;
+
+#define CHECK(cond, ...) do { if( !(cond) ) { if( ++num_errors <= GNU_TEST_MAX_ERROR_MSGS ) { printf("ERROR: " __VA_ARGS__); printf("\n"); } } } while( 0 )
+
+static inline int GNU_TEST_Result(void)
+{
+  printf(num_errors ? "FAILED\n" : "PASSED\n");
+  return num_errors ? 1 : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32 stand-ins
+/////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef GNU_TEST_OWN_IRQ
+s32 MIOS32_IRQ_Disable(void) { return 0; }
+s32 MIOS32_IRQ_Enable(void) { return 0; }
+#endif
+
+#ifndef GNU_TEST_OWN_DELAY
+s32 MIOS32_DELAY_Wait_uS(u16 uS) { return 0; }
+#endif
+
+#ifndef GNU_TEST_OWN_DEBUG_MESSAGE
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...) { return 0; }
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GNU_TEST_H */
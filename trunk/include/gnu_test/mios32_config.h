@@ -0,0 +1,15 @@
+// $Id$
+/*
+ * Default MIOS32 configuration file for the host tests
+ *
+ * Used if neither the gnu_test directory nor the include paths of
+ * the tested module contain a mios32_config.h
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+// function used to output debug messages (must be printf compatible!)
+#define DEBUG_MSG MIOS32_MIDI_SendDebugMessage
+
+#endif /* _MIOS32_CONFIG_H */
@@ -0,0 +1,9 @@
+// $Id$
+/*
+ * FreeRTOS stand-in for the host tests, see FreeRTOS.h
+ */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#endif /* PORTMACRO_H */
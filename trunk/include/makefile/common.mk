@@ -31,16 +31,49 @@ export MIOS32_SHELL
 # The usage of arm-elf isn't recommented due to compatibility issues!!!
 MIOS32_GCC_PREFIX ?= arm-none-eabi
 
+ifeq ($(FAMILY),HOST)
+# native executable for the build machine (see $(MIOS32_PATH)/mios32/HOST/README.txt)
+CC      = gcc
+CPP     = g++
+OBJCOPY = objcopy
+OBJDUMP = objdump
+NM      = nm
+SIZE    = size
+else
 CC      = $(MIOS32_GCC_PREFIX)-gcc
 CPP     = $(MIOS32_GCC_PREFIX)-g++
 OBJCOPY = $(MIOS32_GCC_PREFIX)-objcopy
 OBJDUMP = $(MIOS32_GCC_PREFIX)-objdump
 NM      = $(MIOS32_GCC_PREFIX)-nm
 SIZE    = $(MIOS32_GCC_PREFIX)-size
+endif
 
 # where should the output files be located
+# (separate directory for the host build, so that the objects of both builds are not mixed)
+ifeq ($(FAMILY),HOST)
+PROJECT_OUT ?= $(PROJECT)_build_host
+else
 PROJECT_OUT ?= $(PROJECT)_build
+endif
+
+ifeq ($(FAMILY),HOST)
+# 32bit code by default, so that pointers fit into u32 like on the target
+# can be optionally overruled via environment variable (e.g. MIOS32_HOST_CFLAGS= for a 64bit build)
+MIOS32_HOST_CFLAGS ?= -m32
+CFLAGS  += $(MIOS32_HOST_CFLAGS)
+
+# like on the target: functions which are not referenced are removed, so that
+# unused hooks of modules don't have to be resolved
+CFLAGS  += -ffunction-sections -fdata-sections
 
+# variables which are defined in headers are merged like by the arm-none-eabi toolchain
+# (newer host compilers use -fno-common by default)
+CFLAGS  += -fcommon
+LDFLAGS += $(MIOS32_HOST_CFLAGS) -Wl,--gc-section -Xlinker -Map=$(PROJECT_OUT)/$(PROJECT).map -lstdc++ -lm -lrt
+
+# no thumb code
+THUMB_CFLAGS =
+else
 # default linker flags
 LDFLAGS += -T $(LD_FILE) -mthumb -u _start -Wl,--gc-section  -Xlinker -M -Xlinker -Map=$(PROJECT_OUT)/$(PROJECT).map  -nostartfiles -lstdc++
 
@@ -48,6 +81,9 @@ LDFLAGS += -T $(LD_FILE) -mthumb -u _start -Wl,--gc-section  -Xlinker -M -Xlinke
 # not compatible with other toolchains (users have to switch to new version, or disable the line below)
 LDFLAGS += --specs=nano.specs
 
+THUMB_CFLAGS = -mthumb
+endif
+
 # default assembler flags
 AFLAGS += $(A_DEFINES) $(A_INCLUDE) -Wa,-adhlns=$(<:.s=.lst)
 
@@ -105,7 +141,12 @@ DIST += $(MIOS32_PATH)/include/makefile/common.mk $(MIOS32_PATH)/include/c
 DIST += $(LD_FILE)
 
 # default rule
+ifeq ($(FAMILY),HOST)
+# the .elf file is the executable
+all: dirs $(PROJECT_OUT)/$(PROJECT).elf hostinfo
+else
 all: dirs cleanhex $(PROJECT).hex $(PROJECT_OUT)/$(PROJECT).bin $(PROJECT_OUT)/$(PROJECT).lss $(PROJECT_OUT)/$(PROJECT).sym projectinfo
+endif
 
 # define debug/release target for easier use in codeblocks
 debug: all
@@ -151,6 +192,14 @@ projectinfo:
 	$(SIZE) $(PROJECT_OUT)/$(PROJECT).elf
 	@grep -E '__ram_start|__ram_end' project_build/project.sym
 
+hostinfo:
+	@echo "-------------------------------------------------------------------------------"
+	@echo "Application successfully built for the host:"
+	@echo "Board:     $(BOARD)"
+	@echo "LCD:       $(LCD)"
+	@echo "Run:       ./$(PROJECT_OUT)/$(PROJECT).elf"
+	@echo "-------------------------------------------------------------------------------"
+
 # default rule for compiling .c programs
 # inspired from the "super makefile" published at http://gpwiki.org/index.php/Make
 # Rule for creating object file and .d file, the sed magic is to add
@@ -158,19 +207,19 @@ projectinfo:
 # outputs assume it will be in the same dir as the source file.
 $(PROJECT_OUT)/%.o: %.c
 	@echo Creating object file for $(notdir $<)
-	@$(CC) -Wp,-MMD,$(PROJECT_OUT)/$*.dd $(CFLAGS) -mthumb -c $< -o $@
+	@$(CC) -Wp,-MMD,$(PROJECT_OUT)/$*.dd $(CFLAGS) $(THUMB_CFLAGS) -c $< -o $@
 	@sed -e '1s/^\(.*\)$$/$(subst /,\/,$(dir $@))\1/' $(PROJECT_OUT)/$*.dd > $(PROJECT_OUT)/$*.d
 	@rm -f $(PROJECT_OUT)/$*.dd
 
 $(PROJECT_OUT)/%.o: %.cpp
 	@echo Creating object file for $(notdir $<)
-	@$(CC) -Wp,-MMD,$(PROJECT_OUT)/$*.dd $(CPPFLAGS) -mthumb -c $< -o $@
+	@$(CC) -Wp,-MMD,$(PROJECT_OUT)/$*.dd $(CPPFLAGS) $(THUMB_CFLAGS) -c $< -o $@
 	@sed -e '1s/^\(.*\)$$/$(subst /,\/,$(dir $@))\1/' $(PROJECT_OUT)/$*.dd > $(PROJECT_OUT)/$*.d
 	@rm -f $(PROJECT_OUT)/$*.dd
 
 $(PROJECT_OUT)/%.o: %.s
 	@echo Creating object file for $(notdir $<)
-	@$(CC) -Wp,-MMD,$(PROJECT_OUT)/$*.dd $(ASFLAGS) -mthumb -c $< -o $@
+	@$(CC) -Wp,-MMD,$(PROJECT_OUT)/$*.dd $(ASFLAGS) $(THUMB_CFLAGS) -c $< -o $@
 	@sed -e '1s/^\(.*\)$$/$(subst /,\/,$(dir $@))\1/' $(PROJECT_OUT)/$*.dd > $(PROJECT_OUT)/$*.d
 	@rm -f $(PROJECT_OUT)/$*.dd
 
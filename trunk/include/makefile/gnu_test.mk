@@ -0,0 +1,44 @@
+# $Id$
+#
+# Common make rules for the host tests in the gnu_test directories
+#
+# The makefile of a test sets:
+#   TARGETS       the test executables, and the rules to build them
+#                 with $(CC) $(CFLAGS) (or $(CXX) $(CFLAGS))
+#   CFLAGS        include paths and defines of the tested module (optional)
+#   TEST_TARGETS  the executables which are run by "make test" (default: TARGETS)
+#   TEST_CHECKS   targets which are made by "make test" after the TEST_TARGETS
+#                 have been run, e.g. to compare the output of build variants
+#   CLEAN_FILES   additional files which are removed by "make clean"
+#
+# Please keep the include statement at the end of the makefile.
+#
+
+# path to the MIOS32 trunk, relative to the test directory
+GNU_TEST_MIOS32_PATH := $(patsubst %/include/makefile/,%,$(dir $(lastword $(MAKEFILE_LIST))))
+
+CC  = gcc
+CXX = g++
+
+# same warnings like for the firmware (see common.mk)
+# the test directory comes first, and the stand-ins of include/gnu_test last,
+# so that a local mios32_config.h (or the one of the tested module) is preferred
+CFLAGS := -g -O2 -Wall -Wno-format -Wno-switch -Wno-strict-aliasing -DMIOS32_FAMILY_EMULATION -I . $(CFLAGS) \
+	  -I $(GNU_TEST_MIOS32_PATH)/include/mios32 -I $(GNU_TEST_MIOS32_PATH)/include/gnu_test
+
+TEST_TARGETS ?= $(TARGETS)
+
+.DEFAULT_GOAL := all
+.PHONY: all test test_run clean $(TEST_CHECKS)
+
+all: $(TARGETS)
+
+test: test_run $(TEST_CHECKS)
+
+test_run: all
+	@for t in $(TEST_TARGETS); do ./$$t || exit 1; done
+
+$(TEST_CHECKS): test_run
+
+clean:
+	rm -rf $(TARGETS) $(CLEAN_FILES)
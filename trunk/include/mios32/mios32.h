@@ -43,6 +43,8 @@ extern "C" {
 # include <mios32_datatypes.h>
 #elif defined(MIOS32_FAMILY_MIOSJUCE)
 # include <mios32_datatypes.h>
+#elif defined(MIOS32_FAMILY_HOST)
+# include <mios32_datatypes.h>
 #else
 # include <mios32_datatypes.h>
 # warning "Unsupported MIOS32_FAMILY selected!"
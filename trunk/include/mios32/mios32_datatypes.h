@@ -18,6 +18,40 @@
 // following check to ensure that typedefs won't be declared again from stm32f10x.h
 #if !defined(__STM32F10x_H) && !defined(__STM32F4xx_H)
 
+#if defined(MIOS32_FAMILY_HOST)
+// long is 64bit on most hosts, int is 32bit like on the target
+typedef signed int   s32;
+typedef signed short s16;
+typedef signed char  s8;
+
+typedef signed int   const sc32;  /* Read Only */
+typedef signed short const sc16;  /* Read Only */
+typedef signed char  const sc8;   /* Read Only */
+
+typedef volatile signed int   vs32;
+typedef volatile signed short vs16;
+typedef volatile signed char  vs8;
+
+typedef volatile signed int   const vsc32;  /* Read Only */
+typedef volatile signed short const vsc16;  /* Read Only */
+typedef volatile signed char  const vsc8;   /* Read Only */
+
+typedef unsigned int   u32;
+typedef unsigned short u16;
+typedef unsigned char  u8;
+
+typedef unsigned int   const uc32;  /* Read Only */
+typedef unsigned short const uc16;  /* Read Only */
+typedef unsigned char  const uc8;   /* Read Only */
+
+typedef volatile unsigned int   vu32;
+typedef volatile unsigned short vu16;
+typedef volatile unsigned char  vu8;
+
+typedef volatile unsigned int   const vuc32;  /* Read Only */
+typedef volatile unsigned short const vuc16;  /* Read Only */
+typedef volatile unsigned char  const vuc8;   /* Read Only */
+#else
 typedef signed long  s32;
 typedef signed short s16;
 typedef signed char  s8;
@@ -49,6 +83,7 @@ typedef volatile unsigned char  vu8;
 typedef volatile unsigned long  const vuc32;  /* Read Only */
 typedef volatile unsigned short const vuc16;  /* Read Only */
 typedef volatile unsigned char  const vuc8;   /* Read Only */
+#endif
 
 #define U8_MAX     ((u8)255)
 #define S8_MAX     ((s8)127)
@@ -212,6 +212,7 @@ extern s32 MIOS32_MIDI_RS_Reset(mios32_midi_port_t port);
 
 extern s32 MIOS32_MIDI_SendPackage_NonBlocking(mios32_midi_port_t port, mios32_midi_package_t package);
 extern s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t package);
+extern s32 MIOS32_MIDI_SendPackages(mios32_midi_port_t port, mios32_midi_package_t *packages, u32 num_packages);
 
 extern s32 MIOS32_MIDI_SendEvent(mios32_midi_port_t port, u8 evnt0, u8 evnt1, u8 evnt2);
 extern s32 MIOS32_MIDI_SendNoteOff(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 note, u8 vel);
@@ -264,6 +265,8 @@ extern s32 MIOS32_MIDI_DeviceIDSet(u8 device_id);
 extern u8  MIOS32_MIDI_DeviceIDGet(void);
 
 extern s32 MIOS32_MIDI_SysExCallback_Init(s32 (*callback_sysex)(mios32_midi_port_t port, u8 sysex_byte));
+extern s32 MIOS32_MIDI_SysExSpanCallback_Init(s32 (*callback_sysex_span)(mios32_midi_port_t port, u8 *span, u32 len));
+extern s32 MIOS32_MIDI_SysExStatusFind(u8 *span, u32 len);
 
 extern s32 MIOS32_MIDI_DebugCommandCallback_Init(s32 (*callback_debug_command)(mios32_midi_port_t port, char c));
 extern s32 MIOS32_MIDI_FilebrowserCommandCallback_Init(s32 (*callback_filebrowser_command)(mios32_midi_port_t port, char c));
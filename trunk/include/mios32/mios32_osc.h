@@ -48,6 +48,21 @@ typedef struct mios32_osc_search_tree_t {
 } mios32_osc_search_tree_t;
 
 
+// entry of a dispatch table compiled by MIOS32_OSC_CompileSearchTree()
+typedef struct {
+  u32 hash;           // hash of the complete path, e.g. "/sid1/osc/finetune"
+  u8  num_path_parts; // number of address parts, 0 if the entry is free
+  u8  node_index[MIOS32_OSC_MAX_PATH_PARTS]; // index of the matching node in each hierarchy level of the search tree
+} mios32_osc_dispatch_entry_t;
+
+typedef struct {
+  const mios32_osc_search_tree_t *search_tree; // the compiled search tree
+  mios32_osc_dispatch_entry_t    *entries;     // hash table (located in RAM)
+  u32                            size;         // number of entries (power of two), 0 if the search tree couldn't be compiled
+  u32                            num_paths;    // number of allocated entries
+} mios32_osc_dispatch_table_t;
+
+
 typedef struct {
   u32 seconds;
   u32 fraction;
@@ -104,6 +119,8 @@ extern mios32_midi_package_t MIOS32_OSC_GetMIDI(u8 *buffer);
 extern u8 *MIOS32_OSC_PutMIDI(u8 *buffer, mios32_midi_package_t p);
 
 extern s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *search_tree);
+extern s32 MIOS32_OSC_CompileSearchTree(mios32_osc_dispatch_table_t *table, mios32_osc_dispatch_entry_t *entries, u32 size, const mios32_osc_search_tree_t *search_tree);
+extern s32 MIOS32_OSC_ParsePacketCompiled(u8 *packet, u32 len, const mios32_osc_dispatch_table_t *table);
 
 extern s32 MIOS32_OSC_SendDebugMessage(mios32_osc_args_t *osc_args, u32 method_arg);
 
@@ -31,6 +31,12 @@
 #define MIOS32_SRIO_NUM_DOUT_PAGES 1
 #endif
 
+// number of words in mios32_srio_din_changed_map[]
+// each bit notifies that the appr. mios32_srio_din_changed[] entry is != 0
+// the MSB of the first word belongs to the first SR, so that the SRs can be
+// iterated in ascending order with CLZ
+#define MIOS32_SRIO_DIN_CHANGED_MAP_SIZE ((MIOS32_SRIO_NUM_SR+31)/32)
+
 // Which SPI peripheral should be used
 // allowed values: 0 and 1
 // (note: SPI0 will allocate DMA channel 2 and 3, SPI1 will allocate DMA channel 4 and 5)
@@ -96,6 +102,7 @@ extern volatile u8 mios32_srio_dout[MIOS32_SRIO_NUM_DOUT_PAGES][MIOS32_SRIO_NUM_
 extern volatile u8 mios32_srio_din[MIOS32_SRIO_NUM_SR];
 extern volatile u8 mios32_srio_din_buffer[MIOS32_SRIO_NUM_SR]; // only required for emulation
 extern volatile u8 mios32_srio_din_changed[MIOS32_SRIO_NUM_SR];
+extern volatile u32 mios32_srio_din_changed_map[MIOS32_SRIO_DIN_CHANGED_MAP_SIZE];
 
 // the current DOUT page
 #if MIOS32_SRIO_NUM_DOUT_PAGES > 1
@@ -86,6 +86,11 @@
 # define MIOS32_SYS_ADDR_BSL_INFO_BEGIN    0x08003f00
 #elif defined(MIOS32_FAMILY_LPC17xx)
 # define MIOS32_SYS_ADDR_BSL_INFO_BEGIN    0x00003f00
+#elif defined(MIOS32_FAMILY_HOST)
+// simulated info range in RAM, located in mios32/HOST/mios32_sys.c
+// it's erased (0xff) - no parameter is confirmed
+extern u8 mios32_sys_host_bsl_info[0x100];
+# define MIOS32_SYS_ADDR_BSL_INFO_BEGIN    ((size_t)&mios32_sys_host_bsl_info[0])
 #else
 // no warning or error for other families... just don't support these features
 #endif
@@ -40,6 +40,7 @@ extern s32 MIOS32_UART_MIDI_Periodic_mS(void);
 
 extern s32 MIOS32_UART_MIDI_PackageSend_NonBlocking(u8 uart_port, mios32_midi_package_t package);
 extern s32 MIOS32_UART_MIDI_PackageSend(u8 uart_port, mios32_midi_package_t package);
+extern s32 MIOS32_UART_MIDI_PackagesSend(u8 uart_port, mios32_midi_package_t *packages, u32 num_packages);
 extern s32 MIOS32_UART_MIDI_PackageReceive(u8 uart_port, mios32_midi_package_t *package);
 
 
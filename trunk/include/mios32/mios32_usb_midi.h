@@ -66,6 +66,7 @@ extern s32 MIOS32_USB_MIDI_CheckAvailable(u8 cable);
 
 extern s32 MIOS32_USB_MIDI_PackageSend_NonBlocking(mios32_midi_package_t package);
 extern s32 MIOS32_USB_MIDI_PackageSend(mios32_midi_package_t package);
+extern s32 MIOS32_USB_MIDI_PackagesSend(u8 cable, mios32_midi_package_t *packages, u32 num_packages);
 extern s32 MIOS32_USB_MIDI_PackageReceive(mios32_midi_package_t *package);
 
 extern s32 MIOS32_USB_MIDI_Periodic_mS(void);
@@ -0,0 +1,140 @@
+// $Id$
+//! \defgroup MIOS32_AIN
+//!
+//! AIN driver for MIOS32 host build
+//!
+//! There are no analog inputs on the host: all pins return 0, and the
+//! handler never reports a change.
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_AIN)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+#if MIOS32_AIN_CHANNEL_MASK
+static u16 ain_deadband;
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes AIN driver
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+#if !MIOS32_AIN_CHANNEL_MASK
+  return -1; // no analog input selected
+#else
+  ain_deadband = MIOS32_AIN_DEADBAND;
+
+  return 0; // no error
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Installs an optional "Service Prepare" callback function
+//! (never called on the host)
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_ServicePrepareCallback_Init(void *_service_prepare_callback)
+{
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns value of an AIN Pin
+//! \param[in] pin number
+//! \return AIN pin value - resolution depends on the selected MIOS32_AIN_OVERSAMPLING_RATE! (0 on the host)
+//! \return -1 if pin doesn't exist
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_PinGet(u32 pin)
+{
+#if !MIOS32_AIN_CHANNEL_MASK
+  return -1; // no analog input selected
+#else
+  return 0;
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the current deadband
+//! \return current deadband
+//! \return -1 if no analog input selected
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_DeadbandGet(void)
+{
+#if !MIOS32_AIN_CHANNEL_MASK
+  return -1; // no analog input selected
+#else
+  return ain_deadband;
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Changes the deadband
+//! \param[in] deadband the new deadband
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_DeadbandSet(u16 deadband)
+{
+#if !MIOS32_AIN_CHANNEL_MASK
+  return -1; // no analog input selected
+#else
+  ain_deadband = deadband;
+
+  return 0; // no error
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Checks for pin changes, and calls given callback function with following parameters on pin changes:
+//! \code
+//!   void AIN_NotifyChanged(u32 pin, u16 value)
+//! \endcode
+//! (pins never change on the host)
+//! \param[in] _callback pointer to callback function
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_Handler(void *_callback)
+{
+#if !MIOS32_AIN_CHANNEL_MASK
+  return -1; // no analog input selected
+#else
+  return 0; // no error
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Starts the ADC conversions
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_StartConversions(void)
+{
+  return 0; // no error
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_AIN */
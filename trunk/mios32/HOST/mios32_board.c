@@ -0,0 +1,333 @@
+// $Id$
+//! \defgroup MIOS32_BOARD
+//!
+//! Development Board specific functions for MIOS32 host build
+//!
+//! The J5/J10/J28 pins and LEDs are simulated by registers: outputs can be
+//! read back, inputs return 1 (like pins with enabled pull-up).
+//! There is no LCD port (J15) and no DAC on the host.
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_BOARD)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  u16 enable_mask;
+  u16 output_mask;
+  u16 value;
+} j_port_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u32 led_state;
+
+static j_port_t j5_port;
+static j_port_t j10_port;
+static j_port_t j28_port;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static s32 MIOS32_BOARD_PortPinInit(j_port_t *port, u8 num_pins, u8 pin, mios32_board_pin_mode_t mode);
+static s32 MIOS32_BOARD_PortSet(j_port_t *port, u16 value);
+static s32 MIOS32_BOARD_PortPinSet(j_port_t *port, u8 num_pins, u8 pin, u8 value);
+static s32 MIOS32_BOARD_PortGet(j_port_t *port);
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes MIOS32_BOARD driver
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  led_state = 0;
+  j5_port.enable_mask = j10_port.enable_mask = j28_port.enable_mask = 0;
+  j5_port.output_mask = j10_port.output_mask = j28_port.output_mask = 0;
+  j5_port.value = j10_port.value = j28_port.value = 0xffff;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes LEDs of the board
+//! \param[in] leds mask contains a flag for each LED which should be initialized
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_LED_Init(u32 leds)
+{
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Sets one or more LEDs to the given value(s)
+//! \param[in] leds mask contains a flag for each LED which should be changed
+//! \param[in] value contains the value
+//! \return < 0 if LEDs not available
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_LED_Set(u32 leds, u32 value)
+{
+  led_state = (led_state & ~leds) | (value & leds);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the status of all LEDs
+//! \return status of all LEDs
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_BOARD_LED_Get(void)
+{
+  return led_state;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! J5, J10 and J28 access functions, see the STM32F4xx variant for details.
+//! J5 and J28 provide 16 pins, J10 provides 16 pins (J10A: 0..7, J10B: 8..15)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J5_PinInit(u8 pin, mios32_board_pin_mode_t mode)
+{
+  return MIOS32_BOARD_PortPinInit(&j5_port, 16, pin, mode);
+}
+
+s32 MIOS32_BOARD_J5_Set(u16 value)
+{
+  return MIOS32_BOARD_PortSet(&j5_port, value);
+}
+
+s32 MIOS32_BOARD_J5_PinSet(u8 pin, u8 value)
+{
+  return MIOS32_BOARD_PortPinSet(&j5_port, 16, pin, value);
+}
+
+s32 MIOS32_BOARD_J5_Get(void)
+{
+  return MIOS32_BOARD_PortGet(&j5_port);
+}
+
+s32 MIOS32_BOARD_J5_PinGet(u8 pin)
+{
+  if( pin >= 16 )
+    return -1; // pin not supported
+
+  return (MIOS32_BOARD_PortGet(&j5_port) & (1 << pin)) ? 1 : 0;
+}
+
+
+s32 MIOS32_BOARD_J10_PinInit(u8 pin, mios32_board_pin_mode_t mode)
+{
+  return MIOS32_BOARD_PortPinInit(&j10_port, 16, pin, mode);
+}
+
+s32 MIOS32_BOARD_J10_Set(u16 value)
+{
+  return MIOS32_BOARD_PortSet(&j10_port, value);
+}
+
+s32 MIOS32_BOARD_J10_PinSet(u8 pin, u8 value)
+{
+  return MIOS32_BOARD_PortPinSet(&j10_port, 16, pin, value);
+}
+
+s32 MIOS32_BOARD_J10_Get(void)
+{
+  return MIOS32_BOARD_PortGet(&j10_port);
+}
+
+s32 MIOS32_BOARD_J10_PinGet(u8 pin)
+{
+  if( pin >= 16 )
+    return -1; // pin not supported
+
+  return (MIOS32_BOARD_PortGet(&j10_port) & (1 << pin)) ? 1 : 0;
+}
+
+s32 MIOS32_BOARD_J10A_Get(void)
+{
+  return MIOS32_BOARD_PortGet(&j10_port) & 0xff;
+}
+
+s32 MIOS32_BOARD_J10A_Set(u8 value)
+{
+  return MIOS32_BOARD_PortSet(&j10_port, (j10_port.value & 0xff00) | value);
+}
+
+s32 MIOS32_BOARD_J10B_Get(void)
+{
+  return MIOS32_BOARD_PortGet(&j10_port) >> 8;
+}
+
+s32 MIOS32_BOARD_J10B_Set(u8 value)
+{
+  return MIOS32_BOARD_PortSet(&j10_port, (j10_port.value & 0x00ff) | ((u16)value << 8));
+}
+
+
+s32 MIOS32_BOARD_J28_PinInit(u8 pin, mios32_board_pin_mode_t mode)
+{
+  return MIOS32_BOARD_PortPinInit(&j28_port, 16, pin, mode);
+}
+
+s32 MIOS32_BOARD_J28_Set(u16 value)
+{
+  return MIOS32_BOARD_PortSet(&j28_port, value);
+}
+
+s32 MIOS32_BOARD_J28_PinSet(u8 pin, u8 value)
+{
+  return MIOS32_BOARD_PortPinSet(&j28_port, 16, pin, value);
+}
+
+s32 MIOS32_BOARD_J28_Get(void)
+{
+  return MIOS32_BOARD_PortGet(&j28_port);
+}
+
+s32 MIOS32_BOARD_J28_PinGet(u8 pin)
+{
+  if( pin >= 16 )
+    return -1; // pin not supported
+
+  return (MIOS32_BOARD_PortGet(&j28_port) & (1 << pin)) ? 1 : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! J15 (LCD port) access functions
+//! \return -1: LCD port not available on the host
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J15_PortInit(u32 mode)
+{
+  return -1; // LCD port not available
+}
+
+s32 MIOS32_BOARD_J15_DataSet(u8 data)
+{
+  return -1; // LCD port not available
+}
+
+s32 MIOS32_BOARD_J15_SerDataShift(u8 data)
+{
+  return -1; // LCD port not available
+}
+
+s32 MIOS32_BOARD_J15_RS_Set(u8 rs)
+{
+  return -1; // LCD port not available
+}
+
+s32 MIOS32_BOARD_J15_RW_Set(u8 rw)
+{
+  return -1; // LCD port not available
+}
+
+s32 MIOS32_BOARD_J15_E_Set(u8 lcd, u8 e)
+{
+  return -1; // LCD port not available
+}
+
+s32 MIOS32_BOARD_J15_GetD7In(void)
+{
+  return -1; // LCD port not available
+}
+
+s32 MIOS32_BOARD_J15_D7InPullUpEnable(u8 enable)
+{
+  return -1; // LCD port not available
+}
+
+s32 MIOS32_BOARD_J15_PollUnbusy(u8 lcd, u32 time_out)
+{
+  return -1; // LCD port not available
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! DAC access functions
+//! \return -1: DAC not available on the host
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_DAC_PinInit(u8 chn, u8 enable)
+{
+  return -1; // DAC not available
+}
+
+s32 MIOS32_BOARD_DAC_PinSet(u8 chn, u16 value)
+{
+  return -1; // DAC not available
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Simulated ports
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_BOARD_PortPinInit(j_port_t *port, u8 num_pins, u8 pin, mios32_board_pin_mode_t mode)
+{
+  if( pin >= num_pins )
+    return -1; // pin not supported
+
+  if( mode == MIOS32_BOARD_PIN_MODE_IGNORE ) {
+    port->enable_mask &= ~(1 << pin);
+    return 0; // no error
+  }
+
+  port->enable_mask |= (1 << pin);
+  if( mode == MIOS32_BOARD_PIN_MODE_OUTPUT_PP || mode == MIOS32_BOARD_PIN_MODE_OUTPUT_OD )
+    port->output_mask |= (1 << pin);
+  else
+    port->output_mask &= ~(1 << pin);
+
+  return 0; // no error
+}
+
+static s32 MIOS32_BOARD_PortSet(j_port_t *port, u16 value)
+{
+  port->value = (port->value & ~port->output_mask) | (value & port->output_mask);
+
+  return 0; // no error
+}
+
+static s32 MIOS32_BOARD_PortPinSet(j_port_t *port, u8 num_pins, u8 pin, u8 value)
+{
+  if( pin >= num_pins )
+    return -1; // pin not supported
+
+  if( !(port->enable_mask & (1 << pin)) )
+    return -2; // pin disabled
+
+  return MIOS32_BOARD_PortSet(port, value ? (port->value | (1 << pin)) : (port->value & ~(1 << pin)));
+}
+
+static s32 MIOS32_BOARD_PortGet(j_port_t *port)
+{
+  // inputs are pulled up
+  return port->value | (~port->output_mask & 0xffff);
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_BOARD */
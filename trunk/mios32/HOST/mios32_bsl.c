@@ -0,0 +1,10 @@
+// $Id$
+//
+// No bootloader on the host
+//
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
@@ -0,0 +1,47 @@
+// $Id$
+//! \defgroup MIOS32_DELAY
+//!
+//! Delay functions for MIOS32 host build
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_DELAY)
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes the MIOS32_DELAY functions
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_DELAY_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Waits for a specific number of uS<BR>
+//! On the host the delay is skipped: the delays are used for hardware
+//! timings which don't exist in the simulation, and the simulated time
+//! doesn't advance while waiting anyhow.
+//! \param[in] uS delay (1..65535 microseconds)
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_DELAY_Wait_uS(u16 uS)
+{
+  return 0; // no error
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_DELAY */
@@ -0,0 +1,17 @@
+# $Id$
+# defines additional rules for MIOS32 family
+# (see $(MIOS32_PATH)/mios32/HOST/README.txt)
+
+# enhance include path
+C_INCLUDE +=	-I $(MIOS32_PATH)/mios32/$(FAMILY)
+
+
+# add modules to thumb sources
+THUMB_SOURCE += \
+	$(MIOS32_PATH)/mios32/$(FAMILY)/mios32_host.c
+
+
+THUMB_AS_SOURCE += 
+
+# directories and files that should be part of the distribution (release) package
+DIST += $(MIOS32_PATH)/mios32/$(FAMILY)
@@ -0,0 +1,369 @@
+// $Id$
+//! \defgroup MIOS32_HOST
+//!
+//! Simulated environment of the MIOS32 host build
+//!
+//! The host build runs MIOS32 applications as plain executables, e.g. for
+//! profiling with perf or valgrind. The environment is configured with
+//! following environment variables (see also README.txt):
+//! <UL>
+//!   <LI>MIOS32_HOST_RUN_MS: exit after the given number of simulated mS
+//!   <LI>MIOS32_HOST_MIDI_IN: file with timestamped MIDI input
+//!   <LI>MIOS32_HOST_MIDI_OUT: file into which all outgoing MIDI data is traced
+//!   <LI>MIOS32_HOST_LOOPBACK: list of ports which send their output back to the input
+//! </UL>
+//!
+//! The MIDI input and trace files use the same format, one event per line:
+//! \code
+//!   <mS> <port> <hex bytes>
+//!   1000 USB0 90 3c 7f
+//!   1100 UART0 80 3c 00
+//! \endcode
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <string.h>
+#include <time.h>
+
+#include "mios32_host.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+// simulated time since startup
+static u32 host_time_ms;
+
+// exit after this time (0: run endless)
+static u32 host_run_ms;
+
+// real time at startup
+static struct timespec host_start_time;
+
+// MIDI input
+static FILE *midi_in_file;
+static u32 midi_in_next_ms;
+static mios32_midi_port_t midi_in_next_port;
+static u8  midi_in_next_bytes[MIOS32_HOST_MIDI_IN_MAX_BYTES];
+static u32 midi_in_next_len;
+
+// MIDI output trace
+static FILE *midi_out_file;
+
+// ports which send their output back (bit 0..3: USB0..3, bit 4..7: UART0..3)
+static u8 loopback_ports;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static s32 MIOS32_HOST_PortParse(const char *str, mios32_midi_port_t *port);
+static const char *MIOS32_HOST_PortName(mios32_midi_port_t port);
+static s32 MIOS32_HOST_PortBit(mios32_midi_port_t port);
+static s32 MIOS32_HOST_MIDI_InNext(void);
+static s32 MIOS32_HOST_MIDI_InSend(mios32_midi_port_t port, u8 *bytes, u32 len);
+static void MIOS32_HOST_Exit(void);
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes the simulated environment
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+//! \note called from MIOS32_SYS_Init()
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_HOST_Init(u32 mode)
+{
+  char *env;
+
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  host_time_ms = 0;
+  clock_gettime(CLOCK_MONOTONIC, &host_start_time);
+
+  if( (env=getenv("MIOS32_HOST_RUN_MS")) != NULL )
+    host_run_ms = strtoul(env, NULL, 0);
+
+  if( (env=getenv("MIOS32_HOST_MIDI_IN")) != NULL ) {
+    if( (midi_in_file=fopen(env, "r")) == NULL ) {
+      fprintf(stderr, "[MIOS32_HOST] can't open MIDI input %s\n", env);
+      return -2; // file not found
+    }
+    MIOS32_HOST_MIDI_InNext();
+  }
+
+  if( (env=getenv("MIOS32_HOST_MIDI_OUT")) != NULL ) {
+    if( strcmp(env, "-") == 0 ) {
+      midi_out_file = stdout;
+    } else if( (midi_out_file=fopen(env, "w")) == NULL ) {
+      fprintf(stderr, "[MIOS32_HOST] can't create MIDI trace %s\n", env);
+      return -3; // file can't be created
+    }
+  }
+
+  if( (env=getenv("MIOS32_HOST_LOOPBACK")) != NULL ) {
+    char buffer[64];
+    char *brkt;
+    char *word;
+
+    strncpy(buffer, env, sizeof(buffer)-1);
+    buffer[sizeof(buffer)-1] = 0;
+    for(word=strtok_r(buffer, ", ", &brkt); word != NULL; word=strtok_r(NULL, ", ", &brkt)) {
+      mios32_midi_port_t port;
+      s32 bit;
+      if( MIOS32_HOST_PortParse(word, &port) < 0 || (bit=MIOS32_HOST_PortBit(port)) < 0 ) {
+	fprintf(stderr, "[MIOS32_HOST] invalid loopback port %s\n", word);
+	return -4; // invalid port
+      }
+      loopback_ports |= (1 << bit);
+    }
+  }
+
+  atexit(MIOS32_HOST_Exit);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Simulates the peripherals which are serviced by IRQs on the target.
+//! Has to be called each mS by the tick hook of the programming model.
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_HOST_Tick(void)
+{
+  ++host_time_ms;
+
+  // timer IRQs
+  MIOS32_TIMER_HostTick();
+
+  // MIDI input which is due
+  while( midi_in_file != NULL && midi_in_next_ms <= host_time_ms ) {
+    MIOS32_HOST_MIDI_InSend(midi_in_next_port, midi_in_next_bytes, midi_in_next_len);
+    MIOS32_HOST_MIDI_InNext();
+  }
+
+  if( host_run_ms && host_time_ms >= host_run_ms )
+    exit(0);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \return the simulated time since startup in mS
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_HOST_TimeGet(void)
+{
+  return host_time_ms;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \return 1 if the output of the given port should be sent back to its input
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_HOST_MIDI_LoopbackGet(mios32_midi_port_t port)
+{
+  s32 bit = MIOS32_HOST_PortBit(port);
+
+  return (bit >= 0 && (loopback_ports & (1 << bit))) ? 1 : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Traces outgoing MIDI data into the file selected with MIOS32_HOST_MIDI_OUT
+//! \param[in] port the MIDI port
+//! \param[in] bytes the sent bytes
+//! \param[in] len number of bytes
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_HOST_MIDI_Trace(mios32_midi_port_t port, u8 *bytes, u32 len)
+{
+  if( midi_out_file == NULL || !len )
+    return 0; // trace disabled
+
+  // IRQs disabled to prevent task switches while the file is accessed
+  MIOS32_IRQ_Disable();
+  fprintf(midi_out_file, "%u %s", host_time_ms, MIOS32_HOST_PortName(port));
+  int i;
+  for(i=0; i<len; ++i)
+    fprintf(midi_out_file, " %02x", bytes[i]);
+  fputc('\n', midi_out_file);
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Port names
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_HOST_PortParse(const char *str, mios32_midi_port_t *port)
+{
+  if( strncasecmp(str, "USB", 3) == 0 && str[3] >= '0' && str[3] <= '3' && !str[4] ) {
+    *port = USB0 + (str[3] - '0');
+    return 0;
+  }
+
+  if( strncasecmp(str, "UART", 4) == 0 && str[4] >= '0' && str[4] <= '3' && !str[5] ) {
+    *port = UART0 + (str[4] - '0');
+    return 0;
+  }
+
+  return -1; // invalid port
+}
+
+static const char *MIOS32_HOST_PortName(mios32_midi_port_t port)
+{
+  static const char names[8][6] = { "USB0", "USB1", "USB2", "USB3", "UART0", "UART1", "UART2", "UART3" };
+  s32 bit = MIOS32_HOST_PortBit(port);
+
+  return (bit >= 0) ? names[bit] : "???";
+}
+
+static s32 MIOS32_HOST_PortBit(mios32_midi_port_t port)
+{
+  if( (port & 0xf0) == USB0 && (port & 0x0f) < 4 )
+    return port & 0x0f;
+
+  if( (port & 0xf0) == UART0 && (port & 0x0f) < 4 )
+    return 4 + (port & 0x0f);
+
+  return -1; // not supported
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Reads the next MIDI input event
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_HOST_MIDI_InNext(void)
+{
+  char line[3*MIOS32_HOST_MIDI_IN_MAX_BYTES + 32];
+
+  while( fgets(line, sizeof(line), midi_in_file) != NULL ) {
+    char *brkt;
+    char *word;
+
+    // skip empty lines and comments
+    if( (word=strtok_r(line, " \t\r\n", &brkt)) == NULL || word[0] == '#' )
+      continue;
+    midi_in_next_ms = strtoul(word, NULL, 0);
+
+    if( (word=strtok_r(NULL, " \t\r\n", &brkt)) == NULL || MIOS32_HOST_PortParse(word, &midi_in_next_port) < 0 ) {
+      fprintf(stderr, "[MIOS32_HOST] invalid port in MIDI input at %u mS\n", midi_in_next_ms);
+      continue;
+    }
+
+    midi_in_next_len = 0;
+    while( (word=strtok_r(NULL, " \t\r\n", &brkt)) != NULL && midi_in_next_len < MIOS32_HOST_MIDI_IN_MAX_BYTES )
+      midi_in_next_bytes[midi_in_next_len++] = strtoul(word, NULL, 16);
+
+    return 0; // no error
+  }
+
+  fclose(midi_in_file);
+  midi_in_file = NULL;
+
+  return -1; // no more events
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Puts MIDI input into the receive buffer of a port
+// USB: the MIDI stream is converted into packages
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_HOST_MIDI_InSend(mios32_midi_port_t port, u8 *bytes, u32 len)
+{
+  int i;
+
+  if( (port & 0xf0) == UART0 ) {
+    for(i=0; i<len; ++i)
+      if( MIOS32_UART_RxBufferPut(port & 0x0f, bytes[i]) < 0 )
+	return -1; // buffer overrun
+    return 0; // no error
+  }
+
+  mios32_midi_package_t package;
+  for(i=0; i<len; ) {
+    u8 b = bytes[i];
+
+    package.ALL = 0;
+    package.cable = port & 0x0f;
+
+    if( b == 0xf0 ) {
+      // SysEx: up to 3 bytes per package, the last one contains F7
+      do {
+	u8 num = 0;
+	u8 ended = 0;
+	while( num < 3 && i < len && !ended ) {
+	  if( bytes[i] == 0xf7 )
+	    ended = 1;
+	  package.ALL |= bytes[i++] << (8*(num+1));
+	  ++num;
+	}
+	package.type = ended ? (0x5 + num - 1) : 0x4;
+	MIOS32_USB_MIDI_HostPackageReceived(package);
+	package.ALL = 0;
+	package.cable = port & 0x0f;
+	if( ended )
+	  break;
+      } while( i < len );
+    } else if( b >= 0xf8 ) {
+      // realtime
+      package.type = 0xf;
+      package.evnt0 = b;
+      ++i;
+      MIOS32_USB_MIDI_HostPackageReceived(package);
+    } else {
+      // channel voice and system common messages
+      u8 num;
+      if( b >= 0x80 && b <= 0xef ) {
+	package.type = b >> 4;
+	num = mios32_midi_pcktype_num_bytes[package.type];
+      } else if( b == 0xf2 ) {
+	package.type = 0x3;
+	num = 3;
+      } else if( b == 0xf1 || b == 0xf3 ) {
+	package.type = 0x2;
+	num = 2;
+      } else {
+	package.type = 0x5;
+	num = 1;
+      }
+
+      u8 pos;
+      for(pos=0; pos<num && i<len; ++pos)
+	package.ALL |= bytes[i++] << (8*(pos+1));
+      MIOS32_USB_MIDI_HostPackageReceived(package);
+    }
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Called on exit: prints the simulated and real time
+/////////////////////////////////////////////////////////////////////////////
+static void MIOS32_HOST_Exit(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  u32 real_ms = (now.tv_sec - host_start_time.tv_sec) * 1000 + (now.tv_nsec - host_start_time.tv_nsec) / 1000000;
+
+  if( midi_out_file != NULL && midi_out_file != stdout )
+    fclose(midi_out_file);
+
+  fflush(stdout);
+  fprintf(stderr, "[MIOS32_HOST] %u mS simulated in %u mS real time\n", host_time_ms, real_ms);
+}
+
+//! \}
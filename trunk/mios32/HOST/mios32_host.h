@@ -0,0 +1,41 @@
+// $Id$
+/*
+ * Header file for the simulated environment of the MIOS32 host build
+ */
+
+#ifndef _MIOS32_HOST_H
+#define _MIOS32_HOST_H
+
+/////////////////////////////////////////////////////////////////////////////
+// Global definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// max number of bytes of a MIDI input line (see README.txt)
+#ifndef MIOS32_HOST_MIDI_IN_MAX_BYTES
+#define MIOS32_HOST_MIDI_IN_MAX_BYTES 256
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+extern s32 MIOS32_HOST_Init(u32 mode);
+extern s32 MIOS32_HOST_Tick(void);
+extern u32 MIOS32_HOST_TimeGet(void);
+
+extern s32 MIOS32_HOST_MIDI_LoopbackGet(mios32_midi_port_t port);
+extern s32 MIOS32_HOST_MIDI_Trace(mios32_midi_port_t port, u8 *bytes, u32 len);
+
+// implemented in mios32_timer.c, called each mS
+extern s32 MIOS32_TIMER_HostTick(void);
+
+// implemented in mios32_usb_midi.c, puts a package into the receive buffer
+extern s32 MIOS32_USB_MIDI_HostPackageReceived(mios32_midi_package_t package);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Export global variables
+/////////////////////////////////////////////////////////////////////////////
+
+#endif /* _MIOS32_HOST_H */
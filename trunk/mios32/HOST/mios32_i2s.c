@@ -0,0 +1,56 @@
+// $Id$
+//! \defgroup MIOS32_I2S
+//!
+//! I2S Functions for MIOS32 host build
+//!
+//! Audio output is not supported on the host.
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+// this module can be optionally enabled in a local mios32_config.h file (included from mios32.h)
+#if defined(MIOS32_USE_I2S)
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes I2S interface
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_I2S_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  return -2; // no I2S on the host
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Starts DMA driven I2S transfers
+//! \return -1 (not supported on the host)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_I2S_Start(u32 *buffer, u16 len, void *_callback)
+{
+  return -1; // not supported
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Stops DMA driven I2S transfers
+//! \return < 0 if de-initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_I2S_Stop(void)
+{
+  return 0; // no error
+}
+
+//! \}
+
+#endif /* MIOS32_USE_I2S */
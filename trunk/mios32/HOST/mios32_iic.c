@@ -0,0 +1,184 @@
+// $Id$
+//! \defgroup MIOS32_IIC
+//!
+//! IIC driver for MIOS32 host build
+//!
+//! There are no IIC devices on the host, all transfers fail with
+//! MIOS32_IIC_ERROR_SLAVE_NOT_CONNECTED like on a bus without devices.
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_IIC)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static volatile u8 iic_semaphore[MIOS32_IIC_NUM];
+static volatile s32 transfer_error[MIOS32_IIC_NUM];
+static volatile s32 last_transfer_error[MIOS32_IIC_NUM];
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes IIC driver
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  u8 iic_port;
+  for(iic_port=0; iic_port<MIOS32_IIC_NUM; ++iic_port) {
+    iic_semaphore[iic_port] = 0;
+    transfer_error[iic_port] = 0;
+    last_transfer_error[iic_port] = 0;
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Semaphore handling: requests the IIC interface
+//! \param[in] iic_port the IIC port (0..MIOS32_IIC_NUM-1)
+//! \param[in] semaphore_type is either IIC_Blocking or IIC_Non_Blocking
+//! \return Non_Blocking: returns -1 to request a retry
+//! \return 0 if IIC interface free
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_TransferBegin(u8 iic_port, mios32_iic_semaphore_t semaphore_type)
+{
+  s32 status = -1;
+
+  if( iic_port >= MIOS32_IIC_NUM )
+    return MIOS32_IIC_ERROR_INVALID_PORT;
+
+  do {
+    MIOS32_IRQ_Disable();
+    if( !iic_semaphore[iic_port] ) {
+      iic_semaphore[iic_port] = 1;
+      status = 0;
+    }
+    MIOS32_IRQ_Enable();
+  } while( semaphore_type == IIC_Blocking && status != 0 );
+
+  // clear transfer errors of last transmission
+  last_transfer_error[iic_port] = 0;
+  transfer_error[iic_port] = 0;
+
+  return status;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Semaphore handling: releases the IIC interface for other tasks
+//! \param[in] iic_port the IIC port (0..MIOS32_IIC_NUM-1)
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_TransferFinished(u8 iic_port)
+{
+  if( iic_port >= MIOS32_IIC_NUM )
+    return MIOS32_IIC_ERROR_INVALID_PORT;
+
+  iic_semaphore[iic_port] = 0;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the last transfer error
+//! \param[in] iic_port the IIC port (0..MIOS32_IIC_NUM-1)
+//! \return last error status
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_LastErrorGet(u8 iic_port)
+{
+  if( iic_port >= MIOS32_IIC_NUM )
+    return MIOS32_IIC_ERROR_INVALID_PORT;
+
+  return last_transfer_error[iic_port];
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Checks if transfer is finished
+//! \param[in] iic_port the IIC port (0..MIOS32_IIC_NUM-1)
+//! \return 0 if no ongoing transfer
+//! \return < 0 if error during transfer
+//! \note Note that the semaphore will be released automatically after an error
+//! (MIOS32_IIC_TransferBegin() has to be called again)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_TransferCheck(u8 iic_port)
+{
+  if( iic_port >= MIOS32_IIC_NUM )
+    return MIOS32_IIC_ERROR_INVALID_PORT;
+
+  // error during transfer?
+  if( transfer_error[iic_port] ) {
+    // store error status for MIOS32_IIC_LastErrorGet() function
+    last_transfer_error[iic_port] = transfer_error[iic_port];
+    // clear current error status
+    transfer_error[iic_port] = 0;
+    // release semaphore for easier programming at user level
+    iic_semaphore[iic_port] = 0;
+    // and exit
+    return last_transfer_error[iic_port];
+  }
+
+  // no transfer
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Waits until transfer is finished
+//! \param[in] iic_port the IIC port (0..MIOS32_IIC_NUM-1)
+//! \return 0 if no ongoing transfer
+//! \return < 0 if error during transfer
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_TransferWait(u8 iic_port)
+{
+  // transfers are finished immediately on the host
+  return MIOS32_IIC_TransferCheck(iic_port);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Starts a new transfer.<BR>
+//! On the host no device acknowledges the address, the error is returned
+//! by the next MIOS32_IIC_TransferCheck() or MIOS32_IIC_TransferWait() call.
+//! \param[in] iic_port the IIC port (0..MIOS32_IIC_NUM-1)
+//! \param[in] transfer type
+//! \param[in] address of slave
+//! \param[in] *buffer pointer to transmit/receive buffer
+//! \param[in] len number of bytes which should be transmitted/received
+//! \return 0 no error
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_Transfer(u8 iic_port, mios32_iic_transfer_t transfer, u8 address, u8 *buffer, u16 len)
+{
+  if( iic_port >= MIOS32_IIC_NUM )
+    return MIOS32_IIC_ERROR_INVALID_PORT;
+
+  // wait until previous transfer finished
+  s32 error;
+  if( (error = MIOS32_IIC_TransferWait(iic_port)) )
+    return error + MIOS32_IIC_ERROR_PREV_OFFSET;
+
+  transfer_error[iic_port] = MIOS32_IIC_ERROR_SLAVE_NOT_CONNECTED;
+
+  return 0; // no error
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_IIC */
@@ -0,0 +1,100 @@
+// $Id$
+//! \defgroup MIOS32_IRQ
+//!
+//! System Specific IRQ Enable/Disable routines for MIOS32 host build
+//!
+//! There are no interrupts on the host, but disabling them also has to
+//! prevent the simulated tick (and therefore task switches).
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <FreeRTOS.h>
+#include <portmacro.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_IRQ)
+
+
+// the nesting counter ensures, that interrupts won't be enabled as long as
+// nested functions disable them
+static u32 nested_ctr;
+
+// stored mask before IRQ has been disabled (important for co-existence with vPortEnterCritical)
+static unsigned long prev_mask;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function disables all interrupts (nested)
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IRQ_Disable(void)
+{
+  unsigned long mask = portSET_INTERRUPT_MASK_FROM_ISR();
+
+  // store previous mask if nested level == 0
+  if( !nested_ctr )
+    prev_mask = mask;
+
+  ++nested_ctr;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function enables all interrupts (nested)
+//! \return < 0 on errors
+//! \return -1 on nesting errors (MIOS32_IRQ_Disable() hasn't been called before)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IRQ_Enable(void)
+{
+  // check for nesting error
+  if( nested_ctr == 0 )
+    return -1; // nesting error
+
+  // decrease nesting level
+  --nested_ctr;
+
+  // set back previous mask once nested level reached 0 again
+  if( nested_ctr == 0 ) {
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(prev_mask);
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function installs an interrupt service.
+//! \param[in] IRQn the interrupt number (ignored on the host)
+//! \param[in] priority the priority from 0..15
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IRQ_Install(u8 IRQn, u8 priority)
+{
+  if( priority >= 16 )
+    return -1; // invalid priority
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function deinstalls an interrupt service.
+//! \param[in] IRQn the interrupt number (ignored on the host)
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IRQ_DeInstall(u8 IRQn)
+{
+  return 0; // no error
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_IRQ */
@@ -0,0 +1,157 @@
+// $Id$
+//! \defgroup MIOS32_SPI
+//!
+//! Hardware Abstraction Layer for SPI ports of MIOS32 host build
+//!
+//! There are no SPI devices on the host: sent bytes are discarded, and
+//! all received bytes are 0xff (e.g. DIN pins read as "not pressed", no
+//! SD Card connected).
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <string.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_SPI)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+#define NUM_SPI 3
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u8 rc_pin_value[NUM_SPI];
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes SPI pins
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SPI_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  // RC pins are high by default
+  memset(rc_pin_value, 0xff, sizeof(rc_pin_value));
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! (Re-)initializes SPI IO Pins
+//! \param[in] spi SPI number (0, 1 or 2)
+//! \param[in] spi_pin_driver pin driver mode (ignored on the host)
+//! \return 0 if no error
+//! \return -1 if disabled SPI port selected
+//! \return -2 if unsupported SPI port selected
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SPI_IO_Init(u8 spi, mios32_spi_pin_driver_t spi_pin_driver)
+{
+  if( spi >= NUM_SPI )
+    return -2; // unsupported SPI port
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! (Re-)initializes SPI peripheral transfer mode
+//! \param[in] spi SPI number (0, 1 or 2)
+//! \param[in] spi_mode the SPI mode (ignored on the host)
+//! \param[in] spi_prescaler the prescaler (ignored on the host)
+//! \return 0 if no error
+//! \return -2 if unsupported SPI port selected
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SPI_TransferModeInit(u8 spi, mios32_spi_mode_t spi_mode, mios32_spi_prescaler_t spi_prescaler)
+{
+  if( spi >= NUM_SPI )
+    return -2; // unsupported SPI port
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Controls the RC (Register Clock alias Chip Select) pin of a SPI port
+//! \param[in] spi SPI number (0, 1 or 2)
+//! \param[in] rc_pin RCLK pin (0 or 1 for RCLK1 or RCLK2)
+//! \param[in] pin_value 0 or 1
+//! \return 0 if no error
+//! \return -2 if unsupported SPI port selected
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SPI_RC_PinSet(u8 spi, u8 rc_pin, u8 pin_value)
+{
+  if( spi >= NUM_SPI || rc_pin >= 2 )
+    return -2; // unsupported SPI port
+
+  if( pin_value )
+    rc_pin_value[spi] |= (1 << rc_pin);
+  else
+    rc_pin_value[spi] &= ~(1 << rc_pin);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Transfers a byte
+//! \param[in] spi SPI number (0, 1 or 2)
+//! \param[in] b the byte which should be transfered
+//! \return >= 0 if no error (received byte: always 0xff on the host)
+//! \return -2 if unsupported SPI port selected
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SPI_TransferByte(u8 spi, u8 b)
+{
+  if( spi >= NUM_SPI )
+    return -2; // unsupported SPI port
+
+  return 0xff;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Transfers a block of bytes.
+//! On the host the transfer is finished immediately, the callback (if
+//! not NULL) is executed before the function returns.
+//! \param[in] spi SPI number (0, 1 or 2)
+//! \param[in] send_buffer pointer to buffer which should be sent (ignored on the host)
+//! \param[in] receive_buffer pointer to buffer which should get the received values (filled with 0xff).<BR>
+//! If NULL, received bytes will be discarded.
+//! \param[in] len number of bytes which should be transfered
+//! \param[in] callback pointer to callback function which will be executed
+//! once the transfer is finished.
+//! \return >= 0 if no error during transfer
+//! \return -2 if unsupported SPI port selected
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SPI_TransferBlock(u8 spi, u8 *send_buffer, u8 *receive_buffer, u16 len, void *callback)
+{
+  if( spi >= NUM_SPI )
+    return -2; // unsupported SPI port
+
+  if( receive_buffer != NULL )
+    memset(receive_buffer, 0xff, len);
+
+  if( callback != NULL )
+    ((void (*)(void))callback)();
+
+  return 0; // no error
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_SPI */
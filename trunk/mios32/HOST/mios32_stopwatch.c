@@ -0,0 +1,83 @@
+// $Id$
+//! \defgroup MIOS32_STOPWATCH
+//!
+//! Stopwatch functions for MIOS32 host build
+//!
+//! In difference to the simulated time, the stopwatch measures the real
+//! CPU time of the host, so that it can be used for benchmarks.
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <time.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_STOPWATCH)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u32 stopwatch_resolution = 1;
+static struct timespec stopwatch_start;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes the stopwatch with the desired resolution:
+//! <UL>
+//!  <LI>1: 1 uS resolution, time measurement possible in the range of 0.001mS .. 65.535 mS
+//!  <LI>10: 10 uS resolution: 0.01 mS .. 655.35 mS
+//!  <LI>100: 100 uS resolution: 0.1 mS .. 6.5535 seconds
+//!  <LI>1000: 1 mS resolution: 1 mS .. 65.535 seconds
+//! <UL>
+//! The value range is the same like on the target (16bit counter).
+//! \param[in] resolution 1, 10, 100 or 1000
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_STOPWATCH_Init(u32 resolution)
+{
+  if( resolution < 1 )
+    return -1; // invalid resolution
+
+  stopwatch_resolution = resolution;
+
+  return MIOS32_STOPWATCH_Reset();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Resets the stopwatch
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_STOPWATCH_Reset(void)
+{
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &stopwatch_start);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns current value of stopwatch
+//! \return 1..65535: valid stopwatch value
+//! \return 0xffffffff: counter overrun
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_STOPWATCH_ValueGet(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+
+  unsigned long long us = (now.tv_sec - stopwatch_start.tv_sec) * 1000000ULL + (now.tv_nsec - stopwatch_start.tv_nsec) / 1000;
+  unsigned long long value = us / stopwatch_resolution;
+
+  return (value > 0xffff) ? 0xffffffff : (u32)value;
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_STOPWATCH */
@@ -0,0 +1,164 @@
+// $Id$
+//! \defgroup MIOS32_SYS
+//!
+//! System Initialisation for MIOS32 host build
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <string.h>
+
+#include "mios32_host.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global variables
+/////////////////////////////////////////////////////////////////////////////
+
+// simulated bootloader info range (see MIOS32_SYS_ADDR_BSL_INFO_BEGIN in mios32_sys.h)
+// erased like the flash of a core without programmed parameters
+u8 mios32_sys_host_bsl_info[0x100] = { [0 ... 0xff] = 0xff };
+
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_SYS)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+// simulated time at which the system time has been set, and the time which has been set
+static u32 time_set_ms;
+static mios32_sys_time_t time_set;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes the System for MIOS32:<BR>
+//! on the host this initializes the simulated environment, see \ref MIOS32_HOST
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SYS_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  if( MIOS32_HOST_Init(0) < 0 )
+    exit(1); // the environment is invalid, a run wouldn't be meaningful
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Shutdown MIOS32 and reset the microcontroller:<BR>
+//! on the host the program is terminated
+//! \return < 0 if reset failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SYS_Reset(void)
+{
+  exit(0);
+
+  return -1; // we will never reach this point
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the Chip ID of the core
+//! \return the chip ID (0 on the host)
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_SYS_ChipIDGet(void)
+{
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the Flash size of the core
+//! \return the Flash size in bytes (same like the STM32F407VG)
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_SYS_FlashSizeGet(void)
+{
+  return 1024*1024;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the (data) RAM size of the core
+//! \return the RAM size in bytes (same like the STM32F407VG)
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_SYS_RAMSizeGet(void)
+{
+  return 192*1024;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the serial number as a string
+//! \param[out] str pointer to a string which can store at least 32 digits + zero terminator!
+//! (24 digits returned on the host)
+//! \return < 0 if feature not supported
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SYS_SerialNumberGet(char *str)
+{
+  strcpy(str, "000000000000000000000000");
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Sets the System Time
+//!
+//! The system time is derived from the simulated time, accordingly it
+//! runs as fast as the simulation.
+//! \param[in] t the time in seconds + fraction
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SYS_TimeSet(mios32_sys_time_t t)
+{
+  MIOS32_IRQ_Disable();
+  time_set_ms = MIOS32_HOST_TimeGet();
+  time_set = t;
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the System Time
+//! \return the time in seconds + fraction
+/////////////////////////////////////////////////////////////////////////////
+mios32_sys_time_t MIOS32_SYS_TimeGet(void)
+{
+  MIOS32_IRQ_Disable();
+  u32 ms = time_set.fraction_ms + (MIOS32_HOST_TimeGet() - time_set_ms);
+  mios32_sys_time_t t = {
+    .seconds = time_set.seconds + ms / 1000,
+    .fraction_ms = ms % 1000
+  };
+  MIOS32_IRQ_Enable();
+
+  return t;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Installs a DMA callback function
+//! \return -1 (no DMA on the host)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SYS_DMA_CallbackSet(u8 dma, u8 chn, void *callback)
+{
+  return -1; // function not implemented for this MIOS32_PROCESSOR
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_SYS */
@@ -0,0 +1,138 @@
+// $Id$
+//! \defgroup MIOS32_TIMER
+//!
+//! Timer functions for MIOS32 host build
+//!
+//! The timers are simulated: MIOS32_TIMER_HostTick() is called by
+//! \ref MIOS32_HOST each simulated mS and calls the timer callbacks as
+//! often as their periods elapsed within this mS.
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include "mios32_host.h"
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_TIMER)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+#define NUM_TIMERS 3
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static void (*timer_callback[NUM_TIMERS])(void);
+static u32 timer_period[NUM_TIMERS];
+static u32 timer_elapsed[NUM_TIMERS];
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initialize a timer
+//! \param[in] timer (0..2)
+//! \param[in] period in uS accuracy (1..65536)
+//! \param[in] _irq_handler (function name)
+//! \param[in] irq_priority (ignored on the host)
+//! \return 0 if initialisation passed
+//! \return -1 if invalid timer number
+//! \return -2 if invalid period
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_TIMER_Init(u8 timer, u32 period, void (*_irq_handler)(void), u8 irq_priority)
+{
+  // check if valid timer
+  if( timer >= NUM_TIMERS )
+    return -1; // invalid timer selected
+
+  // check if valid period
+  if( period < 1 || period >= 65537 )
+    return -2;
+
+  MIOS32_IRQ_Disable();
+  timer_callback[timer] = _irq_handler;
+  timer_period[timer] = period;
+  timer_elapsed[timer] = 0;
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Re-Initialize a timer with given period
+//! \param[in] timer (0..2)
+//! \param[in] period in uS accuracy (1..65536)
+//! \return 0 if initialisation passed
+//! \return if invalid timer number
+//! \return -2 if invalid period
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_TIMER_ReInit(u8 timer, u32 period)
+{
+  // check if valid timer
+  if( timer >= NUM_TIMERS )
+    return -1; // invalid timer selected
+
+  // check if valid period
+  if( period < 1 || period >= 65537 )
+    return -2;
+
+  MIOS32_IRQ_Disable();
+  timer_period[timer] = period;
+  if( timer_elapsed[timer] >= period )
+    timer_elapsed[timer] = 0;
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! De-Initialize a timer
+//! \param[in] timer (0..2)
+//! \return 0 if timer has been disabled
+//! \return -1 if invalid timer number
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_TIMER_DeInit(u8 timer)
+{
+  // check if valid timer
+  if( timer >= NUM_TIMERS )
+    return -1; // invalid timer selected
+
+  MIOS32_IRQ_Disable();
+  timer_callback[timer] = NULL;
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Replaces the timer interrupts: called each simulated mS
+//! \note don't call it directly from application
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_TIMER_HostTick(void)
+{
+  u8 timer;
+
+  for(timer=0; timer<NUM_TIMERS; ++timer) {
+    if( timer_callback[timer] != NULL ) {
+      for(timer_elapsed[timer] += 1000; timer_elapsed[timer] >= timer_period[timer]; timer_elapsed[timer] -= timer_period[timer])
+	timer_callback[timer]();
+    }
+  }
+
+  return 0; // no error
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_TIMER */
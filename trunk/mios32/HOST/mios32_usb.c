@@ -0,0 +1,82 @@
+// $Id$
+//! \defgroup MIOS32_USB
+//!
+//! USB driver for MIOS32 host build
+//!
+//! There is no USB device on the host, the USB MIDI ports are simulated
+//! by \ref MIOS32_USB_MIDI, they are always connected.
+//!
+//! Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_USB)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u8 usb_is_initialized;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes USB interface
+//! \param[in] mode currently only mode 0..2 supported (no difference on the host)
+//! \return < 0 if initialisation failed
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_Init(u32 mode)
+{
+  // currently only mode 0..2 supported
+  if( mode >= 3 )
+    return -1; // unsupported mode
+
+  usb_is_initialized = 1;
+
+#ifndef MIOS32_DONT_USE_USB_MIDI
+  MIOS32_USB_MIDI_ChangeConnectionState(1);
+#endif
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Allows to query, if the USB interface has already been initialized.<BR>
+//! \return 1 if USB already initialized, 0 if not initialized
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_IsInitialized(void)
+{
+  return usb_is_initialized;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \returns != 0 if a single USB port has been forced
+//! (there is no bootloader config section on the host)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_ForceSingleUSB(void)
+{
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \returns != 0 if device mode is enforced
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_ForceDeviceMode(void)
+{
+  return 1;
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_USB */
@@ -0,0 +1,231 @@
+// $Id$
+//! \defgroup MIOS32_USB_MIDI
+//!
+//! USB MIDI layer for MIOS32 host build
+//!
+//! There is no USB on the host: outgoing packages are written into the
+//! MIDI trace and sent back to the receive buffer if loopback is enabled
+//! for the port, incoming packages are injected by \ref MIOS32_HOST
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include "mios32_host.h"
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_USB_MIDI)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+// Rx buffer
+static u32 rx_buffer[MIOS32_USB_MIDI_RX_BUFFER_SIZE];
+static volatile u16 rx_buffer_tail;
+static volatile u16 rx_buffer_head;
+static volatile u16 rx_buffer_size;
+
+// transfer possible?
+static u8 transfer_possible = 0;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static void MIOS32_USB_MIDI_Transmit(mios32_midi_package_t package);
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes USB MIDI layer
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function is called by MIOS32_USB_Init() on the host
+//! \param[in] connected status (1 if connected)
+//! \return < 0 on errors
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_ChangeConnectionState(u8 connected)
+{
+  rx_buffer_tail = rx_buffer_head = rx_buffer_size = 0;
+  transfer_possible = connected ? 1 : 0;
+
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function returns the connection status of the USB MIDI interface
+//! \param[in] cable number
+//! \return 1: interface available
+//! \return 0: interface not available
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_CheckAvailable(u8 cable)
+{
+  if( cable >= MIOS32_USB_MIDI_NUM_PORTS )
+    return 0;
+
+  return transfer_possible ? 1 : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function sends a MIDI package.
+//! On the host the package is transmitted immediately.
+//! \param[in] package MIDI package
+//! \return 0: no error
+//! \return -1: USB not connected
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_PackageSend_NonBlocking(mios32_midi_package_t package)
+{
+  // device available?
+  if( !transfer_possible )
+    return -1;
+
+  MIOS32_USB_MIDI_Transmit(package);
+
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function sends a MIDI package (blocking function)
+//! \param[in] package MIDI package
+//! \return 0: no error
+//! \return -1: USB not connected
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_PackageSend(mios32_midi_package_t package)
+{
+  return MIOS32_USB_MIDI_PackageSend_NonBlocking(package);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function sends multiple MIDI packages (blocking function)
+//! \param[in] cable USB cable number, will be inserted into the packages
+//! \param[in] packages pointer to the MIDI packages
+//! \param[in] num_packages number of packages
+//! \return 0: no error
+//! \return -1: USB not connected
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_PackagesSend(u8 cable, mios32_midi_package_t *packages, u32 num_packages)
+{
+  // device available?
+  if( !transfer_possible )
+    return -1;
+
+  u32 i;
+  for(i=0; i<num_packages; ++i) {
+    mios32_midi_package_t package = packages[i];
+    package.cable = cable;
+    MIOS32_USB_MIDI_Transmit(package);
+  }
+
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function checks for a new package
+//! \param[out] package pointer to MIDI package (received package will be put into the given variable)
+//! \return -1 if no package in buffer
+//! \return >= 0: number of packages which are still in the buffer
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_PackageReceive(mios32_midi_package_t *package)
+{
+  // package received?
+  if( !rx_buffer_size )
+    return -1;
+
+  // get package - this operation should be atomic!
+  MIOS32_IRQ_Disable();
+  package->ALL = rx_buffer[rx_buffer_tail];
+  if( ++rx_buffer_tail >= MIOS32_USB_MIDI_RX_BUFFER_SIZE )
+    rx_buffer_tail = 0;
+  --rx_buffer_size;
+  MIOS32_IRQ_Enable();
+
+  return rx_buffer_size;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function should be called periodically each mS to handle timeout
+//! and expire counters.
+//! Nothing to do on the host.
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_Periodic_mS(void)
+{
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Puts a package into the receive buffer, it replaces the OUT endpoint
+//! of the target.
+//! \param[in] package MIDI package
+//! \return 0: no error
+//! \return -1: USB not connected
+//! \return -2: buffer full, package has been dropped
+//! \note only used by \ref MIOS32_HOST and the loopback
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_HostPackageReceived(mios32_midi_package_t package)
+{
+  if( !transfer_possible )
+    return -1;
+
+  if( rx_buffer_size >= MIOS32_USB_MIDI_RX_BUFFER_SIZE )
+    return -2; // buffer full
+
+  // this operation should be atomic!
+  MIOS32_IRQ_Disable();
+  rx_buffer[rx_buffer_head] = package.ALL;
+  if( ++rx_buffer_head >= MIOS32_USB_MIDI_RX_BUFFER_SIZE )
+    rx_buffer_head = 0;
+  ++rx_buffer_size;
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Replaces the IN endpoint of the target: traces and loops back a package
+/////////////////////////////////////////////////////////////////////////////
+static void MIOS32_USB_MIDI_Transmit(mios32_midi_package_t package)
+{
+  mios32_midi_port_t port = USB0 + package.cable;
+  u8 bytes[3] = { package.evnt0, package.evnt1, package.evnt2 };
+  u8 len = mios32_midi_pcktype_num_bytes[package.type];
+
+  MIOS32_HOST_MIDI_Trace(port, bytes, len);
+
+  if( MIOS32_HOST_MIDI_LoopbackGet(port) )
+    MIOS32_USB_MIDI_HostPackageReceived(package);
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_USB_MIDI */
@@ -218,6 +218,65 @@ s32 MIOS32_USB_MIDI_PackageSend(mios32_midi_package_t package)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! This function puts multiple MIDI packages into the Tx buffer.
+//! The packages are copied within one atomic section per free buffer range
+//! instead of locking the buffer for each package.
+//! (blocking function)
+//! \param[in] cable USB cable number, will be inserted into the packages
+//! \param[in] packages pointer to the MIDI packages
+//! \param[in] num_packages number of packages
+//! \return 0: no error
+//! \return -1: USB not connected
+//! \return -2: buffer still full after timeout
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_PackagesSend(u8 cable, mios32_midi_package_t *packages, u32 num_packages)
+{
+  static u16 timeout_ctr = 0;
+  // same timeout handling like for MIOS32_USB_MIDI_PackageSend()
+
+  while( num_packages ) {
+    // device available?
+    if( !transfer_possible )
+      return -1;
+
+    // the buffer is only emptied by the USB handler meanwhile, so that
+    // the free space can't get smaller until the packages are copied
+    u32 num = (MIOS32_USB_MIDI_TX_BUFFER_SIZE-1) - tx_buffer_size;
+    if( !num ) {
+      // buffer full: call USB handler, so that we are able to get the buffer free again
+      MIOS32_USB_MIDI_TxBufferHandler(MIOS32_USB_MIDI_DATA_IN_EP);
+
+      if( timeout_ctr >= 10000 )
+	return -2;
+      ++timeout_ctr;
+      continue;
+    }
+
+    if( num > num_packages )
+      num = num_packages;
+    num_packages -= num;
+
+    // put packages into buffer - this operation should be atomic!
+    MIOS32_IRQ_Disable();
+    tx_buffer_size += num;
+    for(; num; --num, ++packages) {
+      mios32_midi_package_t package = *packages;
+      package.cable = cable;
+      tx_buffer[tx_buffer_head++] = package.ALL;
+      if( tx_buffer_head >= MIOS32_USB_MIDI_TX_BUFFER_SIZE )
+	tx_buffer_head = 0;
+    }
+    MIOS32_IRQ_Enable();
+
+    timeout_ctr = 0;
+  }
+
+  return 0; // no error
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! This function checks for a new package
 //! \param[out] package pointer to MIDI package (received package will be put into the given variable)
@@ -62,6 +62,16 @@ s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t packa
 	return 1;
 }
 
+s32 MIOS32_MIDI_SendPackages(mios32_midi_port_t port, mios32_midi_package_t *packages, u32 num_packages)
+{
+	u32 i;
+	for (i = 0; i < num_packages; ++i) {
+		MIOS32_MIDI_SendPackage(port, packages[i]);
+	}
+
+	return 0;
+}
+
 s32 MIOS32_MIDI_SendNoteOff(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 note, u8 vel)
 {
 	return JUCE_MIDI_SendNoteOff((int) port, (char) chn, (char) note, (char) vel);
@@ -42,6 +42,9 @@ s32 MIOS32_DIN_Init(u32 mode)
     mios32_srio_din_changed[i] = 0;
   }
 
+  for(i=0; i<MIOS32_SRIO_DIN_CHANGED_MAP_SIZE; ++i)
+    mios32_srio_din_changed_map[i] = 0;
+
   return 0;
 }
 
@@ -121,7 +124,8 @@ u8 MIOS32_DIN_SRChangedGetAndClear(u32 sr, u8 mask)
   // get and clear changed flags - must be atomic!
   MIOS32_IRQ_Disable();
   changed = mios32_srio_din_changed[sr] & mask;
-  mios32_srio_din_changed[sr] &= ~mask;
+  if( !(mios32_srio_din_changed[sr] &= ~mask) )
+    mios32_srio_din_changed_map[sr / 32] &= ~(0x80000000 >> (sr % 32));
   MIOS32_IRQ_Enable();
 
   return changed;
@@ -133,6 +137,10 @@ u8 MIOS32_DIN_SRChangedGetAndClear(u32 sr, u8 mask)
 //! \code
 //!   void DIN_NotifyToggle(u32 pin, u32 value)
 //! \endcode
+//!
+//! Only the SRs which are marked in mios32_srio_din_changed_map[] are checked.
+//! The change flags of these SRs are taken and cleared within a single
+//! atomic section before the callback function is called.
 //! \param[in] _callback pointer to callback function
 //! \return < 0 on errors
 /////////////////////////////////////////////////////////////////////////////
@@ -140,9 +148,12 @@ s32 MIOS32_DIN_Handler(void *_callback)
 {
   s32 sr;
   s32 sr_pin;
+  s32 w;
   u8 changed;
   void (*callback)(u32 pin, u32 value) = _callback;
   u8 num_sr = MIOS32_SRIO_ScanNumGet();
+  u32 changed_map[MIOS32_SRIO_DIN_CHANGED_MAP_SIZE];
+  u8 changed_sr[MIOS32_SRIO_NUM_SR];
 
   // no SRIOs?
 #if MIOS32_SRIO_NUM_SR == 0
@@ -156,25 +167,46 @@ s32 MIOS32_DIN_Handler(void *_callback)
   if( _callback == NULL )
     return -1;
 
-  // check all shift registers for DIN pin changes
-  for(sr=0; sr<num_sr; ++sr) {
-    
-    // check if there are pin changes (mask all pins)
-    changed = MIOS32_DIN_SRChangedGetAndClear(sr, 0xff);
-
-    // any pin change at this SR?
-    if( !changed )
-      continue;
-
-    // check all 8 pins of the SR
-    for(sr_pin=0; sr_pin<8; ++sr_pin)
-      if( changed & (1 << sr_pin) ) {
-	// call the notification function
-	callback(8*sr+sr_pin, (mios32_srio_din[sr] & (1 << sr_pin)) ? 1 : 0);
-
-	// start debouncing (if enabled in SRIO driver)
-	MIOS32_SRIO_DebounceStart();
-      }
+  // get and clear changed flags of all SRs which are marked in the map - must be atomic!
+  MIOS32_IRQ_Disable();
+  for(w=0; w<MIOS32_SRIO_DIN_CHANGED_MAP_SIZE; ++w) {
+    u32 pending = mios32_srio_din_changed_map[w];
+    changed_map[w] = pending;
+    mios32_srio_din_changed_map[w] = 0;
+
+    while( pending ) {
+      u32 bit = __builtin_clz(pending); // single CLZ instruction on Cortex-M3/M4
+      pending &= ~(0x80000000 >> bit);
+      sr = 32*w + bit;
+      changed_sr[sr] = mios32_srio_din_changed[sr];
+      mios32_srio_din_changed[sr] = 0;
+    }
+  }
+  MIOS32_IRQ_Enable();
+
+  // check the taken shift registers for DIN pin changes (in ascending order)
+  for(w=0; w<MIOS32_SRIO_DIN_CHANGED_MAP_SIZE; ++w) {
+    u32 pending = changed_map[w];
+
+    while( pending ) {
+      u32 bit = __builtin_clz(pending);
+      pending &= ~(0x80000000 >> bit);
+      sr = 32*w + bit;
+
+      // any pin change at this SR? (ignore SRs which are not scanned anymore)
+      if( sr >= num_sr || !(changed = changed_sr[sr]) )
+	continue;
+
+      // check all 8 pins of the SR
+      for(sr_pin=0; sr_pin<8; ++sr_pin)
+	if( changed & (1 << sr_pin) ) {
+	  // call the notification function
+	  callback(8*sr+sr_pin, (mios32_srio_din[sr] & (1 << sr_pin)) ? 1 : 0);
+
+	  // start debouncing (if enabled in SRIO driver)
+	  MIOS32_SRIO_DebounceStart();
+	}
+    }
   }
 
   return 0;
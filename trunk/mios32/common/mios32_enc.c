@@ -59,6 +59,35 @@ mios32_enc_config_t enc_config[MIOS32_ENC_NUM_MAX];
 
 enc_state_t enc_state[MIOS32_ENC_NUM_MAX];
 
+// encoders which are connected to the same SR are chained, so that only the
+// encoders of SRs with pin changes have to be checked
+#if MIOS32_ENC_NUM_MAX > 255
+# error "MIOS32_ENC_NUM_MAX must not exceed 255"
+#endif
+#define ENC_NONE 0xff // terminates the chain (encoder numbers are 0..254)
+
+static u8 enc_sr_first[MIOS32_SRIO_NUM_SR];
+static u8 enc_sr_next[MIOS32_ENC_NUM_MAX];
+static u8 enc_sr_mask[MIOS32_SRIO_NUM_SR]; // pins which are assigned to encoders
+
+// one bit per encoder, MSB of the first word is encoder #0
+#define ENC_MAP_SIZE ((MIOS32_ENC_NUM_MAX+31)/32)
+
+// encoders which have to be serviced on each update (accelerator running,
+// new state not processed yet, or state controlled by application)
+static u32 enc_active_map[ENC_MAP_SIZE];
+
+// encoders with incrementer != 0
+static volatile u32 enc_incrementer_map[ENC_MAP_SIZE];
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static void MIOS32_ENC_MapUpdate(void);
+static void MIOS32_ENC_ChainUpdate(u8 sr, u8 encoder, u8 insert);
+
 
 /////////////////////////////////////////////////////////////////////////////
 //! Initializes encoder driver
@@ -87,10 +116,100 @@ s32 MIOS32_ENC_Init(u32 mode)
     enc_state[i].predivider = 0;
   }
 
+  for(i=0; i<ENC_MAP_SIZE; ++i)
+    enc_incrementer_map[i] = 0;
+
+  MIOS32_ENC_MapUpdate();
+
   return 0; // no error
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Rebuilds the SR chains and the active map from the encoder configuration
+// IRQs have to be disabled by the caller
+/////////////////////////////////////////////////////////////////////////////
+static void MIOS32_ENC_MapUpdate(void)
+{
+  s32 i;
+
+  for(i=0; i<MIOS32_SRIO_NUM_SR; ++i) {
+    enc_sr_first[i] = ENC_NONE;
+    enc_sr_mask[i] = 0;
+  }
+
+  for(i=0; i<ENC_MAP_SIZE; ++i)
+    enc_active_map[i] = 0;
+
+  // chained in descending order, so that the encoders of a SR are serviced in ascending order
+  for(i=MIOS32_ENC_NUM_MAX-1; i>=0; --i) {
+    mios32_enc_config_t *enc_config_ptr = &enc_config[i];
+
+    if( enc_config_ptr->cfg.type == DISABLED )
+      continue;
+
+    // all configured encoders are serviced at least once
+    enc_active_map[i / 32] |= 0x80000000 >> (i % 32);
+
+    if( enc_config_ptr->cfg.sr != 0 && enc_config_ptr->cfg.sr <= MIOS32_SRIO_NUM_SR ) {
+      u8 sr = enc_config_ptr->cfg.sr-1;
+      enc_sr_next[i] = enc_sr_first[sr];
+      enc_sr_first[sr] = i;
+      enc_sr_mask[sr] |= 3 << (enc_config_ptr->cfg.pos & 6);
+    }
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Removes an encoder from the chain of a SR, or inserts it in ascending order,
+// and updates the pins of the SR which are assigned to encoders
+// IRQs have to be disabled by the caller
+/////////////////////////////////////////////////////////////////////////////
+static void MIOS32_ENC_ChainUpdate(u8 sr, u8 encoder, u8 insert)
+{
+  u8 *link = &enc_sr_first[sr];
+  u8 enc;
+  u8 mask = 0;
+
+  while( *link != ENC_NONE && *link < encoder )
+    link = &enc_sr_next[*link];
+
+  if( insert ) {
+    enc_sr_next[encoder] = *link;
+    *link = encoder;
+  } else if( *link == encoder ) {
+    *link = enc_sr_next[encoder];
+  }
+
+  for(enc=enc_sr_first[sr]; enc != ENC_NONE; enc=enc_sr_next[enc])
+    mask |= 3 << (enc_config[enc].cfg.pos & 6);
+  enc_sr_mask[sr] = mask;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the first encoder >= enc which is marked in the given map
+// Returns ENC_NONE if there is no further encoder
+/////////////////////////////////////////////////////////////////////////////
+static inline u8 MIOS32_ENC_MapNext(u32 *map, u32 enc)
+{
+  u32 w = enc / 32;
+
+  if( w >= ENC_MAP_SIZE )
+    return ENC_NONE;
+
+  u32 pending = map[w] & (0xffffffff >> (enc % 32));
+  while( !pending ) {
+    if( ++w >= ENC_MAP_SIZE )
+      return ENC_NONE;
+    pending = map[w];
+  }
+
+  return 32*w + __builtin_clz(pending); // single CLZ instruction on Cortex-M3/M4
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Configures Encoder
 //! \param[in] encoder encoder number (0..MIOS32_ENC_NUM_MAX-1)
@@ -111,8 +230,23 @@ s32 MIOS32_ENC_ConfigSet(u32 encoder, mios32_enc_config_t config)
   if( encoder >= MIOS32_ENC_NUM_MAX )
     return -1; // invalid number
 
-  // take over new configuration
-  enc_config[encoder] = config;
+  mios32_enc_config_t *enc_config_ptr = &enc_config[encoder];
+
+  // take over new configuration, only the chains of the old and new SR are updated
+  MIOS32_IRQ_Disable();
+  if( enc_config_ptr->cfg.type != DISABLED && enc_config_ptr->cfg.sr != 0 && enc_config_ptr->cfg.sr <= MIOS32_SRIO_NUM_SR )
+    MIOS32_ENC_ChainUpdate(enc_config_ptr->cfg.sr-1, encoder, 0);
+
+  *enc_config_ptr = config;
+
+  if( config.cfg.type != DISABLED ) {
+    // service the encoder at least once
+    enc_active_map[encoder / 32] |= 0x80000000 >> (encoder % 32);
+
+    if( config.cfg.sr != 0 && config.cfg.sr <= MIOS32_SRIO_NUM_SR )
+      MIOS32_ENC_ChainUpdate(config.cfg.sr-1, encoder, 1);
+  }
+  MIOS32_IRQ_Enable();
 
   return 0; // no error
 }
@@ -187,20 +321,75 @@ s32 MIOS32_ENC_StateGet(u32 encoder)
 
 /////////////////////////////////////////////////////////////////////////////
 //! This function has to be called after a SRIO scan to update encoder states
+//!
+//! Only encoders which are connected to SRs with pin changes (see
+//! mios32_srio_din_changed_map[]), and encoders which are still active
+//! (accelerator running, or state controlled by application) are serviced.
 //! \return < 0 on errors
 /////////////////////////////////////////////////////////////////////////////
 s32 MIOS32_ENC_UpdateStates(void)
 {
   u8 enc;
+  s32 w;
+  u32 updated_map[ENC_MAP_SIZE];
+  u32 service_map[ENC_MAP_SIZE];
+
+  for(w=0; w<ENC_MAP_SIZE; ++w)
+    updated_map[w] = 0;
+
+  // take over encoder states of SRs with pin changes, and clear changed flags,
+  // so that the changes won't be propagated to DIN handler - must be atomic!
+  // (encoders with SR == 0 are controlled from application, e.g. by scanning GPIOs)
+  MIOS32_IRQ_Disable();
+  for(w=0; w<MIOS32_SRIO_DIN_CHANGED_MAP_SIZE; ++w) {
+    u32 pending = mios32_srio_din_changed_map[w];
+
+    while( pending ) {
+      u32 bit = __builtin_clz(pending);
+      pending &= ~(0x80000000 >> bit);
+      u32 sr = 32*w + bit;
+
+      u8 changed = mios32_srio_din_changed[sr] & enc_sr_mask[sr];
+      if( !changed )
+	continue;
+
+      if( !(mios32_srio_din_changed[sr] &= ~changed) )
+	mios32_srio_din_changed_map[w] &= ~(0x80000000 >> bit);
+
+      for(enc=enc_sr_first[sr]; enc != ENC_NONE; enc=enc_sr_next[enc]) {
+	u8 pos = enc_config[enc].cfg.pos;
+	u8 pos_normalized = pos & 6; // (0, 2, 4 or 6)
+	u8 changed_mask = 3 << pos_normalized;
 
-  // check all encoders
-  // Note: scanning of 64 encoders takes ca. 30 uS @ 72 MHz :-)
-  for(enc=0; enc<MIOS32_ENC_NUM_MAX; ++enc) {
+	if( changed & changed_mask ) {
+	  changed &= ~changed_mask; // only taken by the first encoder which is assigned to these pins
+
+	  u8 state = (mios32_srio_din[sr] >> pos_normalized) & 3;
+	  if( pos & 1 ) { // swap pins?
+	    state = ((state << 1) & 2) | (state >> 1);
+	  }
+	  enc_state[enc].last12 = enc_state[enc].act12;
+	  enc_state[enc].act12 = state;
+	  updated_map[enc / 32] |= 0x80000000 >> (enc % 32);
+	}
+      }
+    }
+  }
+  MIOS32_IRQ_Enable();
+
+  for(w=0; w<ENC_MAP_SIZE; ++w)
+    service_map[w] = enc_active_map[w] | updated_map[w];
+
+  // service active and updated encoders
+  for(enc=MIOS32_ENC_MapNext(service_map, 0); enc != ENC_NONE; enc=MIOS32_ENC_MapNext(service_map, enc+1)) {
     mios32_enc_config_t *enc_config_ptr = &enc_config[enc];
+    u32 enc_mask = 0x80000000 >> (enc % 32);
 
     // skip if encoder not configured
-    if( enc_config_ptr->cfg.type == DISABLED )
+    if( enc_config_ptr->cfg.type == DISABLED ) {
+      enc_active_map[enc / 32] &= ~enc_mask;
       continue;
+    }
 
     enc_state_t *enc_state_ptr = &enc_state[enc];
 
@@ -208,23 +397,9 @@ s32 MIOS32_ENC_UpdateStates(void)
     if( enc_state_ptr->accelerator )
       --enc_state_ptr->accelerator;
 
-    // take over encoder state from SRIO handler if SR != 0
-    // (if SR configured with 0 we expect that the state is controlled from application, e.g. by scanning GPIOs)
-    if( enc_config_ptr->cfg.sr != 0 ) {
-      // check if encoder state has been changed, and clear changed flags, so that the changes won't be propagated to DIN handler
-      u8 sr = enc_config_ptr->cfg.sr-1;
-      u8 pos = enc_config_ptr->cfg.pos;
-      u8 pos_normalized = pos & 6; // (0, 2, 4 or 6)
-      u8 changed_mask = 3 << pos_normalized; // note: by checking mios32_srio_din_changed[sr] directly, we speed up the scanning of unmoved encoders by factor 3!
+    // no new state from SRIO handler: previous state has been processed
+    if( enc_config_ptr->cfg.sr != 0 && !(updated_map[enc / 32] & enc_mask) )
       enc_state_ptr->last12 = enc_state_ptr->act12;
-      if( (mios32_srio_din_changed[sr] & changed_mask) && MIOS32_DIN_SRChangedGetAndClear(sr, changed_mask) ) {
-	u8 state = (mios32_srio_din[sr] >> pos_normalized) & 3;
-	if( pos & 1 ) { // swap pins?
-	  state = ((state << 1) & 2) | (state >> 1);
-	}
-	enc_state_ptr->act12 = state;
-      }
-    }
 
     // new encoder state?
     if( enc_state_ptr->last12 != enc_state_ptr->act12 ) {
@@ -356,6 +531,16 @@ s32 MIOS32_ENC_UpdateStates(void)
 	}
       }
     }
+
+    // notify new increments to MIOS32_ENC_Handler
+    if( enc_state_ptr->incrementer )
+      enc_incrementer_map[enc / 32] |= enc_mask;
+
+    // keep encoder active as long as it has to be serviced on each update
+    if( enc_config_ptr->cfg.sr == 0 || enc_state_ptr->accelerator || enc_state_ptr->last12 != enc_state_ptr->act12 )
+      enc_active_map[enc / 32] |= enc_mask;
+    else
+      enc_active_map[enc / 32] &= ~enc_mask;
   }
   return 0; // no error
 }
@@ -373,15 +558,25 @@ s32 MIOS32_ENC_UpdateStates(void)
 s32 MIOS32_ENC_Handler(void *_callback)
 {
   u8 enc;
+  s32 w;
   s32 incrementer;
   void (*callback)(u32 pin, u32 value) = _callback;
+  u32 incrementer_map[ENC_MAP_SIZE];
 
   // no callback function?
   if( _callback == NULL )
     return -1;
 
-  // check all encoders
-  for(enc=0; enc<MIOS32_ENC_NUM_MAX; ++enc) {
+  // get and clear the encoders which have been moved - must be atomic!
+  MIOS32_IRQ_Disable();
+  for(w=0; w<ENC_MAP_SIZE; ++w) {
+    incrementer_map[w] = enc_incrementer_map[w];
+    enc_incrementer_map[w] = 0;
+  }
+  MIOS32_IRQ_Enable();
+
+  // check the moved encoders
+  for(enc=MIOS32_ENC_MapNext(incrementer_map, 0); enc != ENC_NONE; enc=MIOS32_ENC_MapNext(incrementer_map, enc+1)) {
 
     // following check/modify operation must be atomic
     MIOS32_IRQ_Disable();
@@ -138,6 +138,7 @@ static mios32_midi_port_t debug_port   = MIOS32_MIDI_DEBUG_PORT;
 static s32 (*direct_rx_callback_func)(mios32_midi_port_t port, u8 midi_byte);
 static s32 (*direct_tx_callback_func)(mios32_midi_port_t port, mios32_midi_package_t package);
 static s32 (*sysex_callback_func)(mios32_midi_port_t port, u8 sysex_byte);
+static s32 (*sysex_span_callback_func)(mios32_midi_port_t port, u8 *span, u32 len);
 static s32 (*timeout_callback_func)(mios32_midi_port_t port);
 static s32 (*debug_command_callback_func)(mios32_midi_port_t port, char c);
 static s32 (*filebrowser_command_callback_func)(mios32_midi_port_t port, char c);
@@ -170,6 +171,8 @@ static sysex_timeout_ctr_flags_t sysex_timeout_ctr_flags;
 // Local prototypes
 /////////////////////////////////////////////////////////////////////////////
 
+static s32 MIOS32_MIDI_SYSEX_Forward(mios32_midi_port_t port, mios32_midi_package_t package, u8 *span, u32 len, void (*callback_package)(mios32_midi_port_t port, mios32_midi_package_t midi_package));
+static s32 MIOS32_MIDI_SYSEX_ParserSpan(mios32_midi_port_t port, u8 *span, u32 len);
 static s32 MIOS32_MIDI_SYSEX_Parser(mios32_midi_port_t port, u8 midi_in);
 static s32 MIOS32_MIDI_SYSEX_CmdFinished(void);
 static s32 MIOS32_MIDI_SYSEX_Cmd(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_t cmd_state, u8 midi_in);
@@ -202,6 +205,7 @@ s32 MIOS32_MIDI_Init(u32 mode)
   direct_rx_callback_func = NULL;
   direct_tx_callback_func = NULL;
   sysex_callback_func = NULL;
+  sysex_span_callback_func = NULL;
   timeout_callback_func = NULL;
   debug_command_callback_func = NULL;
   filebrowser_command_callback_func = NULL;
@@ -561,6 +565,65 @@ s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t packa
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Sends multiple packages over given port
+//!
+//! Intended for bursts (e.g. all events of a sequencer step, or a dump):
+//! the port is resolved once, and USB and UART packages are copied into the
+//! Tx buffer within one atomic section per Tx buffer chunk instead of locking
+//! the buffer for each package.
+//! Packages to the remaining ports are sent individually via
+//! MIOS32_MIDI_SendPackage().
+//!
+//! If a Tx Callback function is installed, the packages are forwarded
+//! individually via MIOS32_MIDI_SendPackage(), so that they can still be
+//! filtered/monitored/routed.
+//! (blocking function)
+//! \param[in] port MIDI port (DEFAULT, USB0..USB7, UART0..UART3, IIC0..IIC7, SPIM0..SPIM7)
+//! \param[in] packages pointer to the MIDI packages
+//! \param[in] num_packages number of packages
+//! \return -1 if port not available
+//! \return 0 on success
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_SendPackages(mios32_midi_port_t port, mios32_midi_package_t *packages, u32 num_packages)
+{
+  // if default/debug port: select mapped port
+  if( !(port & 0xf0) ) {
+    port = (port == MIDI_DEBUG) ? debug_port : default_port;
+  }
+
+  // Tx callback has to see each package
+  if( direct_tx_callback_func == NULL ) {
+    // branch depending on selected port
+    switch( port & 0xf0 ) {
+      case USB0://..15
+#if !defined(MIOS32_DONT_USE_USB) && !defined(MIOS32_DONT_USE_USB_MIDI)
+	return MIOS32_USB_MIDI_PackagesSend(port & 0xf, packages, num_packages);
+#else
+	return -1; // USB has been disabled
+#endif
+
+      case UART0://..15
+#if !defined(MIOS32_DONT_USE_UART) && !defined(MIOS32_DONT_USE_UART_MIDI)
+	return MIOS32_UART_MIDI_PackagesSend(port & 0xf, packages, num_packages);
+#else
+	return -1; // UART_MIDI has been disabled
+#endif
+    }
+  }
+
+  // other ports: send packages individually
+  u32 i;
+  for(i=0; i<num_packages; ++i) {
+    s32 status;
+    if( (status=MIOS32_MIDI_SendPackage(port, packages[i])) < 0 )
+      return status;
+  }
+
+  return 0; // no error
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Sends a MIDI Event
 //! This function is provided for a more comfortable use model
@@ -763,6 +826,15 @@ s32 MIOS32_MIDI_SendDebugStringHeader(mios32_midi_port_t port, char command, cha
 #ifdef MIOS32_MIDI_DISABLE_DEBUG_MESSAGE
   // for bootloader to save memory
   return -1;
+#elif defined(MIOS32_FAMILY_HOST)
+  // no MIOS Terminal on the host: debug strings are printed to stdout
+  // IRQs disabled to prevent task switches while stdout is accessed
+  if( first_byte ) {
+    MIOS32_IRQ_Disable();
+    fputc(first_byte, stdout);
+    MIOS32_IRQ_Enable();
+  }
+  return 0; // no error
 #else
   s32 status = 0;
   mios32_midi_package_t package;
@@ -809,6 +881,11 @@ s32 MIOS32_MIDI_SendDebugStringBody(mios32_midi_port_t port, char *str, u32 len)
 #ifdef MIOS32_MIDI_DISABLE_DEBUG_MESSAGE
   // for bootloader to save memory
   return -1;
+#elif defined(MIOS32_FAMILY_HOST)
+  MIOS32_IRQ_Disable();
+  fwrite(str, 1, strnlen(str, len), stdout);
+  MIOS32_IRQ_Enable();
+  return 0; // no error
 #else
   s32 status = 0;
   mios32_midi_package_t package;
@@ -862,6 +939,8 @@ s32 MIOS32_MIDI_SendDebugStringFooter(mios32_midi_port_t port)
 #ifdef MIOS32_MIDI_DISABLE_DEBUG_MESSAGE
   // for bootloader to save memory
   return -1;
+#elif defined(MIOS32_FAMILY_HOST)
+  return 0; // nothing to terminate
 #else
   s32 status = 0;
   mios32_midi_package_t package;
@@ -1096,7 +1175,6 @@ s32 MIOS32_MIDI_ReceivePackage(mios32_midi_port_t port, mios32_midi_package_t pa
       }
     }
 
-    u8 filter_sysex = 0;
     switch( package.type ) {
     case 0x0: // reserved, ignore
     case 0x1: // cable events, ignore
@@ -1117,26 +1195,10 @@ s32 MIOS32_MIDI_ReceivePackage(mios32_midi_port_t port, mios32_midi_package_t pa
 	break;
       }
 
-      MIOS32_MIDI_SYSEX_Parser(port, package.evnt0); // -> forward to MIOS32 SysEx Parser
-      if( package.type != 0x0f ) {
-	MIOS32_MIDI_SYSEX_Parser(port, package.evnt1); // -> forward to MIOS32 SysEx Parser
-	MIOS32_MIDI_SYSEX_Parser(port, package.evnt2); // -> forward to MIOS32 SysEx Parser
-      }
-
-#if !MIOS32_MIDI_BSL_ENHANCEMENTS // to save some memory
-      if( !sysex_state.general.MY_SYSEX ) { // don't forward to application if we receive a MIOS32 command
-	if( sysex_callback_func != NULL ) {
-	  filter_sysex |= sysex_callback_func(port, package.evnt0); // -> forwarded as SysEx
-	  if( package.type != 0x0f ) {
-	    filter_sysex |= sysex_callback_func(port, package.evnt1); // -> forwarded as SysEx
-	    filter_sysex |= sysex_callback_func(port, package.evnt2); // -> forwarded as SysEx
-	  }
-	}
-
-	if( callback_package != NULL && !filter_sysex )
-	  callback_package(port, package);
+      {
+	u8 span[3] = { package.evnt0, package.evnt1, package.evnt2 };
+	MIOS32_MIDI_SYSEX_Forward(port, package, span, (package.type == 0x0f) ? 1 : 3, callback_package);
       }
-#endif
       break;
 
     case 0x5:   // Single-byte System Common Message or SysEx ends with following single byte. 
@@ -1150,55 +1212,13 @@ s32 MIOS32_MIDI_ReceivePackage(mios32_midi_port_t port, mios32_midi_package_t pa
     case 0x6:   // SysEx ends with following two bytes.
     case 0x7: { // SysEx ends with following three bytes.
       u8 num_bytes = package.type - 0x5 + 1;
-      u8 current_byte = 0;
-
-      if( num_bytes >= 1 ) {
-	current_byte = package.evnt0;
-	MIOS32_MIDI_SYSEX_Parser(port, current_byte); // -> forward to MIOS32 SysEx Parser
+      u8 span[3] = { package.evnt0, package.evnt1, package.evnt2 };
 
-#if !MIOS32_MIDI_BSL_ENHANCEMENTS // to save some memory
-	if( !sysex_state.general.MY_SYSEX ) { // don't forward to application if we receive a MIOS32 command
-	  if( sysex_callback_func != NULL )
-	    filter_sysex |= sysex_callback_func(port, current_byte); // -> forwarded as SysEx
-	}
-#endif
-      }
-
-      if( num_bytes >= 2 ) {
-	current_byte = package.evnt1;
-	MIOS32_MIDI_SYSEX_Parser(port, current_byte); // -> forward to MIOS32 SysEx Parser
-
-#if !MIOS32_MIDI_BSL_ENHANCEMENTS // to save some memory
-	if( !sysex_state.general.MY_SYSEX ) { // don't forward to application if we receive a MIOS32 command
-	  if( sysex_callback_func != NULL )
-	    filter_sysex |= sysex_callback_func(port, current_byte); // -> forwarded as SysEx
-	}
-#endif
-      }
-
-      if( num_bytes >= 3 ) {
-	current_byte = package.evnt2;
-	MIOS32_MIDI_SYSEX_Parser(port, current_byte); // -> forward to MIOS32 SysEx Parser
-
-#if !MIOS32_MIDI_BSL_ENHANCEMENTS // to save some memory
-	if( !sysex_state.general.MY_SYSEX ) { // don't forward to application if we receive a MIOS32 command
-	  if( sysex_callback_func != NULL )
-	    filter_sysex |= sysex_callback_func(port, current_byte); // -> forwarded as SysEx
-	}
-#endif
-      }
+      MIOS32_MIDI_SYSEX_Forward(port, package, span, num_bytes, callback_package);
 
       // reset timeout protection if required
-      if( current_byte == 0xf7 )
+      if( span[num_bytes-1] == 0xf7 )
 	sysex_timeout_ctr_flags.ALL = 0;
-
-#if !MIOS32_MIDI_BSL_ENHANCEMENTS // to save some memory
-      if( !sysex_state.general.MY_SYSEX ) { // don't forward to application if we receive a MIOS32 command
-	// forward as package if not filtered
-	if( callback_package != NULL && !filter_sysex )
-	  callback_package(port, package);
-      }	  
-#endif  
     } break;
     }	      
   }
@@ -1651,6 +1671,140 @@ s32 MIOS32_MIDI_SysExCallback_Init(s32 (*callback_sysex)(mios32_midi_port_t port
   return 0; // no error
 }
 
+
+/////////////////////////////////////////////////////////////////////////////
+//! Installs an optional SysEx span callback which is called by
+//! MIOS32_MIDI_Receive_Handler() with all SysEx bytes of a received package
+//! at once.
+//!
+//! Compared to MIOS32_MIDI_SysExCallback_Init() the callback is only called
+//! once per package instead of once per byte, which saves a lot of calls
+//! when large dumps are received. The span is only valid during the call.
+//!
+//! Both callbacks can be installed at the same time, in this case the span
+//! callback is called first, and the byte-wise callback for each byte of
+//! the span afterwards.
+//!
+//! Realtime events are handled like described for MIOS32_MIDI_SysExCallback_Init()
+//!
+//! MIOS32_MIDI_SysExStatusFind() allows to copy the data bytes of the span
+//! up to the next F7 (or any other status byte) without checking them byte by byte.
+//!
+//! \param[in] *callback_sysex_span pointer to callback function:<BR>
+//! \code
+//!    s32 callback_sysex_span(mios32_midi_port_t port, u8 *span, u32 len)
+//!    {
+//!       //
+//!       // .. parse span[0]..span[len-1]
+//!       //
+//!     
+//!       return 1; // don't forward package to APP_MIDI_NotifyPackage()
+//!    }
+//! \endcode
+//! If the function returns 0, SysEx bytes will be forwarded to APP_MIDI_NotifyPackage() as well.
+//! With return value != 0, APP_MIDI_NotifyPackage() won't get the already processed package.
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_SysExSpanCallback_Init(s32 (*callback_sysex_span)(mios32_midi_port_t port, u8 *span, u32 len))
+{
+  sysex_span_callback_func = callback_sysex_span;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Searches for the next status byte (typically F7) in a SysEx span.
+//!
+//! Since SysEx data bytes never have bit 7 set, four bytes are checked
+//! at once.
+//! \param[in] span pointer to the SysEx bytes
+//! \param[in] len number of bytes
+//! \return position of the first byte >= 0x80
+//! \return len if the span only contains data bytes
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_SysExStatusFind(u8 *span, u32 len)
+{
+  u8 *ptr = span;
+  u8 *end = span + len;
+
+  // byte-wise until the pointer is word aligned
+  for(; ptr < end && ((size_t)ptr & 3); ++ptr)
+    if( *ptr & 0x80 )
+      return ptr - span;
+
+  // four bytes at once
+  for(; (end - ptr) >= 4; ptr += 4)
+    if( *(u32 *)ptr & 0x80808080 )
+      break;
+
+  // remaining bytes
+  for(; ptr < end; ++ptr)
+    if( *ptr & 0x80 )
+      return ptr - span;
+
+  return len;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This function forwards the SysEx bytes of a received package to the
+// MIOS32 SysEx parser, and to the SysEx callbacks of the application
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_MIDI_SYSEX_Forward(mios32_midi_port_t port, mios32_midi_package_t package, u8 *span, u32 len, void (*callback_package)(mios32_midi_port_t port, mios32_midi_package_t midi_package))
+{
+  // -> forward to MIOS32 SysEx Parser
+  // returns the position of the first byte which doesn't belong to a MIOS32 command
+  s32 app_pos = MIOS32_MIDI_SYSEX_ParserSpan(port, span, len);
+
+#if !MIOS32_MIDI_BSL_ENHANCEMENTS // to save some memory
+  if( !sysex_state.general.MY_SYSEX ) { // don't forward to application if we receive a MIOS32 command
+    u8 filter_sysex = 0;
+
+    if( sysex_span_callback_func != NULL )
+      filter_sysex |= sysex_span_callback_func(port, span + app_pos, len - app_pos); // -> forwarded as SysEx
+
+    if( sysex_callback_func != NULL ) {
+      u32 i;
+      for(i=app_pos; i<len; ++i)
+	filter_sysex |= sysex_callback_func(port, span[i]); // -> forwarded as SysEx
+    }
+
+    // forward as package if not filtered
+    if( callback_package != NULL && !filter_sysex )
+      callback_package(port, package);
+  }
+#endif
+
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// This function parses a span of incoming sysex bytes for MIOS32 commands
+// Returns the position of the first byte which doesn't belong to a MIOS32
+// command anymore (e.g. the F7 which terminates the command)
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_MIDI_SYSEX_ParserSpan(mios32_midi_port_t port, u8 *span, u32 len)
+{
+  s32 app_pos = 0;
+  u32 i;
+
+  for(i=0; i<len; ++i) {
+    u8 midi_in = span[i];
+
+    // as long as no header is received, all bytes until the next F0 can be skipped
+    if( !sysex_state.general.CTR && !sysex_state.general.MY_SYSEX && midi_in != 0xf0 )
+      continue;
+
+    u8 my_sysex = sysex_state.general.MY_SYSEX;
+    MIOS32_MIDI_SYSEX_Parser(port, midi_in);
+    if( my_sysex && !sysex_state.general.MY_SYSEX )
+      app_pos = i;
+  }
+
+  return app_pos;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // This function parses an incoming sysex stream for MIOS32 commands
 /////////////////////////////////////////////////////////////////////////////
@@ -79,6 +79,14 @@
 //!   <LI>pointer to arguments (have to be fetched with MIOS32_OSC_Get*() functions)
 //! </UL>
 //!
+//! Servers which receive OSC messages at a high rate can compile the search tree
+//! into a hash table with MIOS32_OSC_CompileSearchTree() and parse the packets with
+//! MIOS32_OSC_ParsePacketCompiled() instead. Paths without wildcards are dispatched
+//! with a single hash lookup then, instead of comparing the path with the address
+//! parts of all nodes. Paths with wildcards, and nodes with wildcards in their address
+//! are still handled by scanning the search tree, so that both functions call the
+//! same methods with the same arguments.
+//!
 //! An example for a search tree construction and OSC method handling can be found
 //! under $MIOS32_PATH/apps/examples/ethernet/osc
 //!
@@ -144,12 +152,25 @@
 #if !defined(MIOS32_DONT_USE_OSC)
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// FNV-1a hash over the path (incl. '/' separators) for the dispatch table
+#define OSC_HASH_INIT       2166136261u
+#define OSC_HASH_ADD(h, c)  (((h) ^ (u8)(c)) * 16777619u)
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local prototypes
 /////////////////////////////////////////////////////////////////////////////
 
-static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree);
+static s32 MIOS32_OSC_Parse(u8 *packet, u32 len, const mios32_osc_search_tree_t *search_tree, const mios32_osc_dispatch_table_t *table);
+static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree, const mios32_osc_dispatch_table_t *table);
 static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *search_tree);
+static s32 MIOS32_OSC_SearchTable(char *path, mios32_osc_args_t *osc_args, const mios32_osc_dispatch_table_t *table);
+static u8 MIOS32_OSC_MatchPart(char *path, const char *address, size_t *sep_pos);
+static s32 MIOS32_OSC_CompileNodes(mios32_osc_dispatch_table_t *table, const mios32_osc_search_tree_t *search_tree, u8 depth, u32 hash, u8 *node_index);
 
 static size_t my_strnlen(char *str, size_t max_len);
 
@@ -488,6 +509,101 @@ u8 *MIOS32_OSC_PutMIDI(u8 *buffer, mios32_midi_package_t p)
 //! returns -4 if MIOS32_OSC_MAX_PATH_PARTS has been exceeded
 /////////////////////////////////////////////////////////////////////////////
 s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *search_tree)
+{
+  return MIOS32_OSC_Parse(packet, len, search_tree, NULL);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Compiles a search tree into a hash table which is used by
+//! MIOS32_OSC_ParsePacketCompiled() to dispatch incoming paths without
+//! scanning the tree.
+//!
+//! An entry is allocated for each address path which consists of address
+//! parts without wildcards, and which can only be matched by a single node
+//! in each hierarchy level. Paths to methods get an entry, and the paths to
+//! the intermediate nodes as well, so that messages with wildcards or with
+//! unknown address parts only have to scan the remaining part of the tree.
+//!
+//! Not more than 3/4 of the entries will be allocated,
+//! so that lookups don't have to probe too many entries.
+//! The table has to be compiled again if the search tree is changed.
+//!
+//! Usage Example:
+//! \code
+//! static mios32_osc_dispatch_entry_t osc_dispatch_entries[256];
+//! static mios32_osc_dispatch_table_t osc_dispatch_table;
+//!
+//!   // during initialisation:
+//!   MIOS32_OSC_CompileSearchTree(&osc_dispatch_table, osc_dispatch_entries, 256, parse_root);
+//!
+//!   // for each received packet:
+//!   MIOS32_OSC_ParsePacketCompiled(packet, len, &osc_dispatch_table);
+//! \endcode
+//! \param[out] table the dispatch table which should be initialized
+//! \param[in] entries array of table entries (located in RAM)
+//! \param[in] size number of entries, has to be a power of two
+//! \param[in] search_tree the search tree which should be compiled
+//! \return number of allocated entries
+//! \return -1 if size is not a power of two
+//! \return -2 if the table is too small for the search tree
+//! (the packets will be parsed by searching the tree in both error cases)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_OSC_CompileSearchTree(mios32_osc_dispatch_table_t *table, mios32_osc_dispatch_entry_t *entries, u32 size, const mios32_osc_search_tree_t *search_tree)
+{
+  u8 node_index[MIOS32_OSC_MAX_PATH_PARTS];
+  u32 i;
+
+  table->search_tree = search_tree;
+  table->entries = entries;
+  table->size = 0; // table can't be used until it has been compiled
+  table->num_paths = 0;
+
+  if( size == 0 || (size & (size-1)) )
+    return -1; // size is not a power of two
+
+  for(i=0; i<size; ++i)
+    entries[i].num_path_parts = 0;
+
+  table->size = size;
+  s32 status = MIOS32_OSC_CompileNodes(table, search_tree, 0, OSC_HASH_INIT, node_index);
+  if( status < 0 ) {
+    table->size = 0;
+    table->num_paths = 0;
+    return status;
+  }
+
+  return table->num_paths;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Parses an incoming OSC packet and calls OSC methods of a search tree
+//! which has been compiled with MIOS32_OSC_CompileSearchTree()
+//!
+//! Calls the same methods like MIOS32_OSC_ParsePacket(), but paths without
+//! wildcards are found with a hash lookup in the dispatch table.
+//! \param[in] packet pointer to OSC packet
+//! \param[in] len length of packet
+//! \param[in] table the compiled search tree
+//! \return 0 if packet has been parsed w/o errors
+//! \return -1 if packet format invalid
+//! \return -2 if the packet contains an OSC element with invalid format
+//! \return -3 if the packet contains an OSC element with an unsupported format
+//! returns -4 if MIOS32_OSC_MAX_PATH_PARTS has been exceeded
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_OSC_ParsePacketCompiled(u8 *packet, u32 len, const mios32_osc_dispatch_table_t *table)
+{
+  return MIOS32_OSC_Parse(packet, len, table->search_tree, table->size ? table : NULL);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// parses a packet, the dispatch table is optional (NULL: search the tree)
+// returns the same values like MIOS32_OSC_ParsePacket()
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_OSC_Parse(u8 *packet, u32 len, const mios32_osc_search_tree_t *search_tree, const mios32_osc_dispatch_table_t *table)
 {
   // store osc arguments (and more...) into osc_args variable
   mios32_osc_args_t osc_args;
@@ -517,7 +633,7 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
 
       // parse element if size > 0
       if( elem_size ) {
-	s32 status = MIOS32_OSC_SearchElement((u8 *)(packet+pos), elem_size, &osc_args, search_tree);
+	s32 status = MIOS32_OSC_SearchElement((u8 *)(packet+pos), elem_size, &osc_args, search_tree, table);
 	if( status < 0 )
 	  return status;
       }
@@ -531,7 +647,7 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
     osc_args.timetag.seconds = 0;
     osc_args.timetag.fraction = 1;
 
-    s32 status = MIOS32_OSC_SearchElement(packet, len, &osc_args, search_tree);
+    s32 status = MIOS32_OSC_SearchElement(packet, len, &osc_args, search_tree, table);
     if( status < 0 )
       return status;
   }
@@ -547,7 +663,7 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
 // returns -3 if element contains an unsupported format
 // returns -4 if MIOS32_OSC_MAX_PATH_PARTS has been exceeded
 /////////////////////////////////////////////////////////////////////////////
-static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree)
+static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree, const mios32_osc_dispatch_table_t *table)
 {
   // exit immediately if element is empty
   if( !len )
@@ -676,6 +792,8 @@ static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_
 
   // finally parse for elements which are matching the OSC address
   osc_args->num_path_parts = 0;
+  if( table != NULL )
+    return MIOS32_OSC_SearchTable((char *)&path[1], osc_args, table);
   return MIOS32_OSC_SearchPath((char *)&path[1], osc_args, 0x00000000, search_tree);
 }
 
@@ -692,38 +810,9 @@ static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 me
 
   while( search_tree->address != NULL ) {
     // compare OSC address with name of tree item
-    u8 match = 1;
-    u8 wildcard = 0;
-
-    char *str1 = path;
-    char *str2 = (char *)search_tree->address;
-    size_t sep_pos = 0;
-
-    while( *str1 != 0 && *str1 != '/' ) {
-      if( *str1 == '*' || *str2 == '*' ) {
-	// '*' wildcard: continue to end of address part
-	while( *str1 != 0 && *str1 != '/' ) {
-	  ++sep_pos;
-	  ++str1;
-	}
-	wildcard = 1;
-	break;
-      } else {
-	// no wildcard: check for matching characters
-	++sep_pos;
-	if( *str2 == 0 || (*str2 != *str1 && *str1 != '?' && *str2 != '?') ) {
-	  match = 0;
-	  break;
-	}
-	++str1;
-	++str2;
-      }
-    }
-    
-    if( !wildcard && *str2 != 0 ) // we haven't parsed the complete string
-      match = 0;
+    size_t sep_pos;
 
-    if( match ) {
+    if( MIOS32_OSC_MatchPart(path, search_tree->address, &sep_pos) ) {
       // store number of path parts in local variable, since content of osc_args is changed recursively
       // we don't want to copy the whole structure to save (a lot of...) memory
       u8 num_path_parts = osc_args->num_path_parts;
@@ -756,6 +845,214 @@ static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 me
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// compares the first address part of path with the address of a tree item
+// returns 1 on a match, and the length of the address part in sep_pos
+/////////////////////////////////////////////////////////////////////////////
+static u8 MIOS32_OSC_MatchPart(char *path, const char *address, size_t *sep_pos)
+{
+  u8 match = 1;
+  u8 wildcard = 0;
+
+  char *str1 = path;
+  char *str2 = (char *)address;
+  size_t pos = 0;
+
+  while( *str1 != 0 && *str1 != '/' ) {
+    if( *str1 == '*' || *str2 == '*' ) {
+      // '*' wildcard: continue to end of address part
+      while( *str1 != 0 && *str1 != '/' ) {
+	++pos;
+	++str1;
+      }
+      wildcard = 1;
+      break;
+    } else {
+      // no wildcard: check for matching characters
+      ++pos;
+      if( *str2 == 0 || (*str2 != *str1 && *str1 != '?' && *str2 != '?') ) {
+	match = 0;
+	break;
+      }
+      ++str1;
+      ++str2;
+    }
+  }
+    
+  if( !wildcard && *str2 != 0 ) // we haven't parsed the complete string
+    match = 0;
+
+  *sep_pos = pos;
+  return match;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// searches the path in a compiled dispatch table
+// The longest leading part of the path which doesn't contain wildcards is
+// looked up, and the remaining address parts are searched in the tree.
+// Paths which aren't part of the table are searched in the complete tree.
+// returns -4 if MIOS32_OSC_MAX_PATH_PARTS has been exceeded
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_OSC_SearchTable(char *path, mios32_osc_args_t *osc_args, const mios32_osc_dispatch_table_t *table)
+{
+  u32 part_hash[MIOS32_OSC_MAX_PATH_PARTS];
+  char *part_end[MIOS32_OSC_MAX_PATH_PARTS];
+  u8 num_parts = 0;
+  u32 hash = OSC_HASH_INIT;
+  char *str = path;
+
+  // hash the path up to the end of each address part, stop at the first part with a wildcard
+  while( num_parts < MIOS32_OSC_MAX_PATH_PARTS ) {
+    char *part = str;
+    u32 next_hash = OSC_HASH_ADD(hash, '/');
+
+    while( *str != 0 && *str != '/' && *str != '*' && *str != '?' ) {
+      next_hash = OSC_HASH_ADD(next_hash, *str);
+      ++str;
+    }
+
+    if( str == part || (*str != 0 && *str != '/') )
+      break; // empty address part or wildcard
+
+    hash = next_hash;
+    part_hash[num_parts] = hash;
+    part_end[num_parts] = str;
+    ++num_parts;
+
+    if( *str == 0 )
+      break;
+    ++str;
+  }
+
+  // look up the longest path first
+  u32 mask = table->size - 1;
+  for(; num_parts > 0; --num_parts) {
+    u32 pos = part_hash[num_parts-1] & mask;
+    mios32_osc_dispatch_entry_t *entry;
+
+    for(entry=&table->entries[pos]; entry->num_path_parts; pos=(pos+1) & mask, entry=&table->entries[pos]) {
+      if( entry->hash != part_hash[num_parts-1] || entry->num_path_parts != num_parts )
+	continue;
+
+      // compare the address parts, since different paths could have the same hash
+      const mios32_osc_search_tree_t *search_tree = table->search_tree;
+      const mios32_osc_search_tree_t *node = NULL;
+      u32 method_arg = 0;
+      char *part = path;
+      u8 i;
+
+      for(i=0; i<num_parts; ++i) {
+	char *str1 = part;
+	const char *str2;
+
+	node = &search_tree[entry->node_index[i]];
+	str2 = node->address;
+	while( str1 != part_end[i] && *str1 == *str2 ) {
+	  ++str1;
+	  ++str2;
+	}
+	if( str1 != part_end[i] || *str2 != 0 )
+	  break;
+
+	osc_args->path_part[i] = node->address;
+	method_arg |= node->method_arg;
+	search_tree = node->next;
+	part = str1 + 1;
+      }
+
+      if( i < num_parts )
+	continue; // hash collision
+
+      // found: call the method, or search the remaining path in the next hierarchy level
+      s32 status = 0;
+      osc_args->num_path_parts = num_parts;
+      if( node->osc_method ) {
+	s32 (*osc_method)(mios32_osc_args_t *osc_args, u32 method_arg) = node->osc_method;
+	osc_method(osc_args, method_arg);
+      } else {
+	status = MIOS32_OSC_SearchPath(part_end[num_parts-1] + 1, osc_args, method_arg, node->next);
+      }
+      osc_args->num_path_parts = 0;
+
+      return status;
+    }
+  }
+
+  // not found: search in the complete tree
+  return MIOS32_OSC_SearchPath(path, osc_args, 0x00000000, table->search_tree);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// allocates dispatch table entries for the nodes of a hierarchy level which
+// can be addressed without wildcards, and continues with the next level
+// returns -2 if the table is too small
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_OSC_CompileNodes(mios32_osc_dispatch_table_t *table, const mios32_osc_search_tree_t *search_tree, u8 depth, u32 hash, u8 *node_index)
+{
+  const mios32_osc_search_tree_t *node;
+  u32 index;
+
+  // node_index is 8bit: the remaining nodes of (very) large levels are searched in the tree
+  for(node=search_tree, index=0; node->address != NULL && index < 256; ++node, ++index) {
+    // only address parts without wildcards can be compiled
+    const char *str = node->address;
+    if( *str == 0 )
+      continue;
+    while( *str != 0 && *str != '*' && *str != '?' && *str != '/' )
+      ++str;
+    if( *str != 0 )
+      continue;
+
+    // skip the node if its address part is matched by another node as well (e.g. "note" and "n*"),
+    // since the methods of all matching nodes have to be called
+    const mios32_osc_search_tree_t *other;
+    for(other=search_tree; other->address != NULL; ++other) {
+      size_t sep_pos;
+      if( other != node && MIOS32_OSC_MatchPart((char *)node->address, other->address, &sep_pos) )
+	break;
+    }
+    if( other->address != NULL )
+      continue;
+
+    u32 node_hash = OSC_HASH_ADD(hash, '/');
+    for(str=node->address; *str != 0; ++str)
+      node_hash = OSC_HASH_ADD(node_hash, *str);
+    node_index[depth] = index;
+
+    if( node->osc_method || node->next ) {
+      // keep 1/4 of the table free, so that lookups don't have to probe too many entries
+      if( table->num_paths >= (table->size - table->size/4) )
+	return -2; // table too small
+
+      u32 mask = table->size - 1;
+      u32 pos = node_hash & mask;
+      while( table->entries[pos].num_path_parts )
+	pos = (pos + 1) & mask;
+
+      mios32_osc_dispatch_entry_t *entry = &table->entries[pos];
+      entry->hash = node_hash;
+      entry->num_path_parts = depth + 1;
+      memcpy(entry->node_index, node_index, depth + 1);
+      ++table->num_paths;
+    }
+
+    // methods are called regardless of the remaining path, therefore only nodes without method are continued
+    if( !node->osc_method && node->next && (depth+1) < MIOS32_OSC_MAX_PATH_PARTS ) {
+      s32 status = MIOS32_OSC_CompileNodes(table, node->next, depth + 1, node_hash, node_index);
+      if( status < 0 )
+	return status;
+    }
+  }
+
+  return 0; // no error
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Sends the argument list of a method to the debug terminal.
 //!
@@ -18,6 +18,10 @@
 //!
 //! MIOS32_SDCARD_SectorRead/SectorWrite allow to read/write a 512 byte sector.
 //!
+//! MIOS32_SDCARD_SectorsRead reads consecutive sectors with a single
+//! READ_MULTIPLE_BLOCK command, which saves the command and access latency
+//! for each additional sector (used for streaming, e.g. audio samples)
+//!
 //! If such an access returns an error, it can be assumed that the SD Card has
 //! been disconnected during the transfer.
 //!
@@ -99,9 +103,15 @@
 #define SDCMD_SEND_STATUS		(0x40+13)
 #define SDCMD_SEND_STATUS_CRC	0xaf
 
+#define SDCMD_STOP_TRANSMISSION	(0x40+12)
+#define SDCMD_STOP_TRANSMISSION_CRC 0xff
+
 #define SDCMD_READ_SINGLE_BLOCK	(0x40+17)
 #define SDCMD_READ_SINGLE_BLOCK_CRC 0xff
 
+#define SDCMD_READ_MULTIPLE_BLOCK	(0x40+18)
+#define SDCMD_READ_MULTIPLE_BLOCK_CRC 0xff
+
 #define SDCMD_SET_BLOCKLEN		(0x40+16)
 #define SDCMD_SET_BLOCKLEN_CRC 	0xff
 
@@ -367,6 +377,10 @@ s32 MIOS32_SDCARD_SendSDCCmd(u8 cmd, u32 addr, u8 crc)
 
   u8 timeout = 0;
 
+  // skip the stuff byte which follows the STOP_TRANSMISSION command
+  if( cmd == SDCMD_STOP_TRANSMISSION )
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+
   if( cmd == SDCMD_SEND_STATUS ) {
 
   // one dummy read
@@ -486,6 +500,94 @@ error:
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Reads consecutive 512 byte sectors with a single READ_MULTIPLE_BLOCK
+//! command (CMD18). The transmission is terminated with STOP_TRANSMISSION
+//! (CMD12) after the last sector.
+//! \param[in] sector 32bit sector of the first block
+//! \param[in] *buffer pointer to num_sectors*512 byte buffer
+//! \param[in] num_sectors number of sectors which should be read
+//! \return 0 if all sectors have been successfully read
+//! \return -error if error occured during read operation (see MIOS32_SDCARD_SectorRead)
+//! \return -256 if timeout during command has been sent
+//! \return -257 if timeout while waiting for start token
+//! \return -258 if timeout while waiting for the end of STOP_TRANSMISSION
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SDCARD_SectorsRead(u32 sector, u8 *buffer, u32 num_sectors)
+{
+  s32 status = 0;
+  int i;
+
+  if( num_sectors == 0 )
+    return 0; // nothing to do
+  if( num_sectors == 1 )
+    return MIOS32_SDCARD_SectorRead(sector, buffer);
+
+  if (!(CardType & CT_BLOCK)) 
+	sector *= 512;
+
+  MIOS32_SDCARD_MUTEX_TAKE;
+
+  // init SPI port for fast frequency access (ca. 18 MBit/s)
+  // this is required for the case that the SPI port is shared with other devices
+  MIOS32_SPI_TransferModeInit(MIOS32_SDCARD_SPI, MIOS32_SPI_MODE_CLK1_PHASE1, MIOS32_SDCARD_SPI_PRESCALER);
+
+  if( (status=MIOS32_SDCARD_SendSDCCmd(SDCMD_READ_MULTIPLE_BLOCK, sector, SDCMD_READ_MULTIPLE_BLOCK_CRC)) ) {
+    status=(status < 0) ? -256 : status; // return timeout indicator or error flags
+    goto error;
+  }
+
+  while( num_sectors-- ) {
+    // wait for start token of the data block
+    for(i=0; i<65536; ++i) { // TODO: check if sufficient
+      u8 ret = MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+      if( ret != 0xff )
+	break;
+    }
+    if( i == 65536 ) {
+      status= -257;
+      break; // send STOP_TRANSMISSION anyhow
+    }
+
+    // read 512 bytes via DMA
+    MIOS32_SPI_TransferBlock(MIOS32_SDCARD_SPI, NULL, buffer, 512, NULL);
+    buffer += 512;
+
+    // read (and ignore) CRC
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+  }
+
+  // terminate the transmission
+  if( MIOS32_SDCARD_SendSDCCmd(SDCMD_STOP_TRANSMISSION, 0, SDCMD_STOP_TRANSMISSION_CRC) < 0 ) {
+    if( status == 0 )
+      status= -256;
+    goto error;
+  }
+
+  // wait until card isn't busy anymore
+  for(i=0; i<65536; ++i) { // TODO: check if sufficient
+    u8 ret = MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+    if( ret != 0x00 )
+      break;
+  }
+  if( i == 65536 && status == 0 )
+    status= -258;
+
+  // required for clocking (see spec)
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+
+error:
+  // deactivate chip select
+  MIOS32_SPI_RC_PinSet(MIOS32_SDCARD_SPI, MIOS32_SDCARD_SPI_RC_PIN, 1); // spi, rc_pin, pin_value
+
+  // Send dummy byte once deactivated to drop cards DO
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+  MIOS32_SDCARD_MUTEX_GIVE;
+  return status; 
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Writes 512 bytes into selected sector
 //! \param[in] sector 32bit sector
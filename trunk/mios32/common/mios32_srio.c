@@ -49,6 +49,10 @@ volatile u8 mios32_srio_din_buffer[MIOS32_SRIO_NUM_SR];
 // change notification flags
 volatile u8 mios32_srio_din_changed[MIOS32_SRIO_NUM_SR];
 
+// one bit per SR which has change notification flags, so that the DIN and ENC
+// handlers don't need to check each SR
+volatile u32 mios32_srio_din_changed_map[MIOS32_SRIO_DIN_CHANGED_MAP_SIZE];
+
 // the current DOUT page
 #if MIOS32_SRIO_NUM_DOUT_PAGES > 1
 u8 mios32_srio_dout_page_ctr;
@@ -118,6 +122,9 @@ s32 MIOS32_SRIO_Init(u32 mode)
     mios32_srio_din_changed[i] = 0;   // no change
   }
 
+  for(i=0; i<MIOS32_SRIO_DIN_CHANGED_MAP_SIZE; ++i)
+    mios32_srio_din_changed_map[i] = 0;
+
   // initial debounce time (debouncing disabled)
   debounce_time = 0;
   debounce_ctr = 0;
@@ -350,7 +357,11 @@ static void MIOS32_SRIO_DMA_Callback(void)
   // copy/or buffered DIN values/changed flags
   int i;
   for(i=0; i<num_sr; ++i) {
-    mios32_srio_din_changed[i] |= mios32_srio_din[i] ^ mios32_srio_din_buffer[i];
+    u8 changed = mios32_srio_din[i] ^ mios32_srio_din_buffer[i];
+    if( changed ) {
+      mios32_srio_din_changed[i] |= changed;
+      mios32_srio_din_changed_map[i / 32] |= 0x80000000 >> (i % 32);
+    }
     mios32_srio_din[i] = mios32_srio_din_buffer[i];
   }
 
@@ -374,6 +385,9 @@ static void MIOS32_SRIO_DMA_Callback(void)
       mios32_srio_din[i] ^= mios32_srio_din_changed[i];
       mios32_srio_din_changed[i] = 0;
     }
+
+    for(i=0; i<MIOS32_SRIO_DIN_CHANGED_MAP_SIZE; ++i)
+      mios32_srio_din_changed_map[i] = 0;
   }
 
   // next transfer has to be started with MIOS32_SRIO_ScanStart
@@ -247,28 +247,19 @@ s32 MIOS32_UART_MIDI_Periodic_mS(void)
 }
 
 
+#if MIOS32_UART_NUM
 /////////////////////////////////////////////////////////////////////////////
-//! This function sends a new MIDI package to the selected UART_MIDI port
-//! \param[in] uart_port UART_MIDI module number (0..2)
-//! \param[in] package MIDI package
-//! \return 0: no error
-//! \return -1: UART_MIDI device not available
-//! \return -2: UART_MIDI buffer is full
-//!             caller should retry until buffer is free again
-//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+// Converts a MIDI package into a byte stream with optional running status
+// optimisation, the bytes are written into the given buffer (3 bytes max)
+// Returns the number of bytes
 /////////////////////////////////////////////////////////////////////////////
-s32 MIOS32_UART_MIDI_PackageSend_NonBlocking(u8 uart_port, mios32_midi_package_t package)
+static u8 MIOS32_UART_MIDI_PackageEncode(u8 uart_port, mios32_midi_package_t package, u8 *buffer)
 {
-#if MIOS32_UART_NUM == 0
-  return -1; // all UARTs explicitely disabled
-#else
-  // exit if UART port not available
-  if( !MIOS32_UART_MIDI_CheckAvailable(uart_port) )
-    return -1;
-
   u8 len = mios32_midi_pcktype_num_bytes[package.cin];
   if( len ) {
-    u8 buffer[3] = {package.evnt0, package.evnt1, package.evnt2};
+    buffer[0] = package.evnt0;
+    buffer[1] = package.evnt1;
+    buffer[2] = package.evnt2;
 
     if( rs_expire_ctr[uart_port] > 1000 ) {
       // the current RS is expired each second to ensure that a status byte will be sent
@@ -301,14 +292,40 @@ s32 MIOS32_UART_MIDI_PackageSend_NonBlocking(u8 uart_port, mios32_midi_package_t
     // only realtime events won't touch it (according to MIDI spec)
     if( package.evnt0 < 0xf8 )
       rs_last[uart_port] = package.evnt0;
+  }
+
+  return len;
+}
+#endif
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! This function sends a new MIDI package to the selected UART_MIDI port
+//! \param[in] uart_port UART_MIDI module number (0..2)
+//! \param[in] package MIDI package
+//! \return 0: no error
+//! \return -1: UART_MIDI device not available
+//! \return -2: UART_MIDI buffer is full
+//!             caller should retry until buffer is free again
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_MIDI_PackageSend_NonBlocking(u8 uart_port, mios32_midi_package_t package)
+{
+#if MIOS32_UART_NUM == 0
+  return -1; // all UARTs explicitely disabled
+#else
+  // exit if UART port not available
+  if( !MIOS32_UART_MIDI_CheckAvailable(uart_port) )
+    return -1;
+
+  u8 buffer[3];
+  u8 len = MIOS32_UART_MIDI_PackageEncode(uart_port, package, buffer);
+  if( len ) {
     switch( MIOS32_UART_TxBufferPutMore(uart_port, buffer, len) ) {
       case  0: return  0; // transfer successfull
       case -2: return -2; // buffer full, request retry
       default: return -1; // UART error
     }
-
   } else {
     return 0; // no bytes to send -> no error
   }
@@ -334,6 +351,49 @@ s32 MIOS32_UART_MIDI_PackageSend(u8 uart_port, mios32_midi_package_t package)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! This function sends multiple MIDI packages to the selected UART_MIDI port
+//! (blocking function)
+//!
+//! The packages are converted into a byte stream which is copied into the
+//! Tx buffer in chunks, so that the buffer is locked once per chunk instead
+//! of once per package.
+//! \param[in] uart_port UART_MIDI module number (0..2)
+//! \param[in] packages pointer to the MIDI packages
+//! \param[in] num_packages number of packages
+//! \return 0: no error
+//! \return -1: UART_MIDI device not available
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_MIDI_PackagesSend(u8 uart_port, mios32_midi_package_t *packages, u32 num_packages)
+{
+#if MIOS32_UART_NUM == 0
+  return -1; // all UARTs explicitely disabled
+#else
+  // exit if UART port not available
+  if( !MIOS32_UART_MIDI_CheckAvailable(uart_port) )
+    return -1;
+
+  // MIOS32_UART_TxBufferPutMore can only copy chunks which are smaller than the Tx buffer
+  u8 buffer[MIOS32_UART_TX_BUFFER_SIZE/2];
+  u32 len = 0;
+  u32 i;
+  mios32_midi_package_t *p = packages;
+  for(i=0; i<num_packages; ++i, ++p) {
+    len += MIOS32_UART_MIDI_PackageEncode(uart_port, *p, &buffer[len]);
+
+    if( len && (len > (sizeof(buffer)-3) || i == (num_packages-1)) ) {
+      if( MIOS32_UART_TxBufferPutMore(uart_port, buffer, len) < 0 )
+	return -1; // UART error
+      len = 0;
+    }
+  }
+
+  return 0; // no error
+#endif
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! This function checks for a new package
 //! \param[in] uart_port UART_MIDI module number (0..2)
@@ -47,8 +47,12 @@ THUMB_SOURCE += \
 	$(MIOS32_PATH)/mios32/$(FAMILY)/mios32_usb_midi.c \
 	$(MIOS32_PATH)/mios32/$(FAMILY)/mios32_usb_com.c \
 	$(MIOS32_PATH)/mios32/$(FAMILY)/mios32_uart.c \
-	$(MIOS32_PATH)/mios32/$(FAMILY)/mios32_iic.c \
-	$(MIOS32_PATH)/mios32/common/printf-stdarg.c
+	$(MIOS32_PATH)/mios32/$(FAMILY)/mios32_iic.c
+
+# on the host, the printf functions are provided by the C library
+ifneq ($(FAMILY),HOST)
+THUMB_SOURCE += $(MIOS32_PATH)/mios32/common/printf-stdarg.c
+endif
 
 
 # MEMO: the gcc linker is clever enough to exclude functions from the final memory image
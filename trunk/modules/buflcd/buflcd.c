@@ -49,6 +49,23 @@
 #include "buflcd.h"
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local defines
+/////////////////////////////////////////////////////////////////////////////
+
+// characters of a run are taken from the buffer in chunks of this size
+// (each chunk is taken with a single atomic operation)
+#define UPDATE_CHUNK_SIZE 40
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static void BUFLCD_LinesDirtySet(void);
+static void BUFLCD_UpdateRuns(u32 bufpos, u32 len, u32 x, int phys_y, u8 font_code);
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
@@ -74,6 +91,192 @@ static u8 glcd_font_handling;
 static u8 lcd_current_font;
 #endif
 
+// one flag per line, set whenever a character of the line has been changed
+// (a byte per line, so that it can be set without disabling IRQs)
+static u8 lcd_line_dirty[BUFLCD_MAX_LINES];
+
+// device and font which have been selected during BUFLCD_Update()
+static int update_device;
+#if BUFLCD_SUPPORT_GLCD_FONTS
+static u8 *update_font;
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// marks all lines as changed, so that they will be scanned with the next update
+/////////////////////////////////////////////////////////////////////////////
+static void BUFLCD_LinesDirtySet(void)
+{
+  int i;
+  for(i=0; i<BUFLCD_MAX_LINES; ++i)
+    lcd_line_dirty[i] = 1;
+}
+
+
+#if BUFLCD_SUPPORT_GLCD_FONTS
+/////////////////////////////////////////////////////////////////////////////
+// returns the GLCD font which belongs to the font code in the buffer
+// returns NULL if the font code is unknown (no character will be print)
+/////////////////////////////////////////////////////////////////////////////
+static u8 *BUFLCD_FontGet(u8 font_code)
+{
+  switch( font_code ) {
+  case 'n': return (u8 *)GLCD_FONT_NORMAL;
+  case 'i': return (u8 *)GLCD_FONT_NORMAL_INV;
+  case 'b': return (u8 *)GLCD_FONT_BIG;
+  case 's': return (u8 *)GLCD_FONT_SMALL;
+  case 't': return (u8 *)GLCD_FONT_TINY;
+  case 'k': return (u8 *)GLCD_FONT_KNOB_ICONS;
+  case 'h': return (u8 *)GLCD_FONT_METER_ICONS_H;
+  case 'v': return (u8 *)GLCD_FONT_METER_ICONS_V;
+  }
+
+  return NULL;
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// sets the cursor to the begin of a run
+/////////////////////////////////////////////////////////////////////////////
+static void BUFLCD_UpdateCursor(int device, u16 column, u16 line, u8 *glcd_font)
+{
+#if BUFLCD_SUPPORT_GLCD_FONTS
+  if( glcd_font_handling && glcd_font ) {
+    if( glcd_font[MIOS32_LCD_FONT_HEIGHT_IX] != 1*8 ) {
+      // temporary use pseudo-font to ensure that Y is handled equaly for all fonts
+      u8 pseudo_font[4];
+      // just to ensure...
+#if MIOS32_LCD_FONT_WIDTH_IX != 0 || MIOS32_LCD_FONT_HEIGHT_IX != 1 || MIOS32_LCD_FONT_X0_IX != 2 || MIOS32_LCD_FONT_OFFSET_IX != 3
+# error "Please adapt this part for new LCD Font parameter positions!"
+#endif
+      pseudo_font[MIOS32_LCD_FONT_WIDTH_IX] = glcd_font[MIOS32_LCD_FONT_WIDTH_IX];
+      pseudo_font[MIOS32_LCD_FONT_HEIGHT_IX] = 1*8; // forced!
+      pseudo_font[MIOS32_LCD_FONT_X0_IX] = glcd_font[MIOS32_LCD_FONT_X0_IX];
+      pseudo_font[MIOS32_LCD_FONT_OFFSET_IX] = glcd_font[MIOS32_LCD_FONT_OFFSET_IX];
+      MIOS32_LCD_FontInit((u8 *)&pseudo_font);
+      update_font = NULL;
+    } else if( update_font != glcd_font ) {
+      // the font can be used directly
+      MIOS32_LCD_FontInit(glcd_font);
+      update_font = glcd_font;
+    }
+  }
+#endif
+
+  if( device != update_device ) {
+    MIOS32_LCD_DeviceSet(device);
+    update_device = device;
+  }
+
+  MIOS32_LCD_CursorSet(column, line);
+
+#if BUFLCD_SUPPORT_GLCD_FONTS
+  if( glcd_font_handling && glcd_font && update_font != glcd_font ) {
+    // switch back to original font
+    MIOS32_LCD_FontInit(glcd_font);
+    update_font = glcd_font;
+  }
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// transfers all changed characters of a line, starting at the given position
+// If GLCD fonts are handled, only characters with the given font code are
+// transfered.
+// Contiguous characters are sent as run with a single cursor set, runs end
+// at the border of a device.
+/////////////////////////////////////////////////////////////////////////////
+static void BUFLCD_UpdateRuns(u32 bufpos, u32 len, u32 x, int phys_y, u8 font_code)
+{
+  u8 *ptr = (u8 *)&lcd_buffer[bufpos];
+#if BUFLCD_SUPPORT_GLCD_FONTS
+  u8 *font_ptr = (u8 *)&lcd_buffer[bufpos + (BUFLCD_BUFFER_SIZE/2)];
+  u8 *glcd_font = glcd_font_handling ? BUFLCD_FontGet(font_code) : NULL;
+#else
+  u8 *glcd_font = NULL;
+#endif
+
+  // device of the first column (the device number is incremented at each device border)
+  int device_base = buflcd_device_num_x * (phys_y / buflcd_device_height) -
+    ((buflcd_offset_x + buflcd_device_width - 1) / buflcd_device_width);
+
+  while( x < len ) {
+#if BUFLCD_SUPPORT_GLCD_FONTS
+# define CHAR_CHANGED(pos) ((!(ptr[pos] & 0x80) || (glcd_font_handling && !(font_ptr[pos] & 0x80))) && \
+                            (!glcd_font_handling || (font_ptr[pos] & 0x7f) == font_code))
+#else
+# define CHAR_CHANGED(pos) (!(ptr[pos] & 0x80))
+#endif
+
+    if( !CHAR_CHANGED(x) ) {
+      ++x;
+      continue;
+    }
+
+    // search for the end of the run
+    int phys_x = buflcd_offset_x + x;
+    u32 run_end = x + (buflcd_device_width - (phys_x % buflcd_device_width));
+    if( run_end > len )
+      run_end = len;
+    {
+      u32 end;
+      for(end=x+1; end<run_end && CHAR_CHANGED(end); ++end);
+      run_end = end;
+    }
+#undef CHAR_CHANGED
+
+    u8 cursor_set = 0;
+    while( x < run_end ) {
+      u8 chars[UPDATE_CHUNK_SIZE];
+      u32 num = run_end - x;
+      if( num > UPDATE_CHUNK_SIZE )
+	num = UPDATE_CHUNK_SIZE;
+
+      // take the characters and flag them as transfered with a single atomic operation
+      u32 i;
+      MIOS32_IRQ_Disable();
+      for(i=0; i<num; ++i) {
+#if BUFLCD_SUPPORT_GLCD_FONTS
+	if( glcd_font_handling ) {
+	  if( (font_ptr[x+i] & 0x7f) != font_code )
+	    break; // font has been changed meanwhile: character will be print with the next update
+	  font_ptr[x+i] |= 0x80;
+	}
+#endif
+	chars[i] = ptr[x+i] & 0x7f;
+	ptr[x+i] |= 0x80;
+      }
+      MIOS32_IRQ_Enable();
+
+      if( i ) {
+#if BUFLCD_SUPPORT_GLCD_FONTS
+	if( !glcd_font_handling || glcd_font )
+#endif
+	{
+	  if( !cursor_set ) {
+	    cursor_set = 1;
+	    BUFLCD_UpdateCursor(device_base + (phys_x / buflcd_device_width),
+				phys_x % buflcd_device_width, phys_y % buflcd_device_height,
+				glcd_font);
+	  }
+
+	  u32 j;
+	  for(j=0; j<i; ++j)
+	    MIOS32_LCD_PrintChar(chars[j]);
+	}
+
+	x += i;
+      }
+
+      if( i < num )
+	break; // run has been interrupted
+    }
+  }
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Display Initialisation
 /////////////////////////////////////////////////////////////////////////////
@@ -107,6 +310,8 @@ s32 BUFLCD_Init(u32 mode)
   buflcd_offset_x = 0;
   buflcd_offset_y = 0;
 
+  BUFLCD_LinesDirtySet();
+
   if( !mode )
     BUFLCD_Clear();
 
@@ -137,6 +342,7 @@ s32 BUFLCD_MaxBufferGet(void)
 s32 BUFLCD_DeviceNumXSet(u8 num_x)
 {
   buflcd_device_num_x = num_x;
+  BUFLCD_LinesDirtySet(); // buffer has to be scanned again
   return 0; // no error
 }
 
@@ -155,6 +361,7 @@ s32 BUFLCD_DeviceNumXGet(void)
 s32 BUFLCD_DeviceNumYSet(u8 num_y)
 {
   buflcd_device_num_y = num_y;
+  BUFLCD_LinesDirtySet(); // buffer has to be scanned again
   return 0; // no error
 }
 
@@ -173,6 +380,7 @@ s32 BUFLCD_DeviceNumYGet(void)
 s32 BUFLCD_DeviceWidthSet(u8 width)
 {
   buflcd_device_width = width;
+  BUFLCD_LinesDirtySet(); // buffer has to be scanned again
   return 0; // no error
 }
 
@@ -191,6 +399,7 @@ s32 BUFLCD_DeviceWidthGet(void)
 s32 BUFLCD_DeviceHeightSet(u8 height)
 {
   buflcd_device_height = height;
+  BUFLCD_LinesDirtySet(); // buffer has to be scanned again
   return 0; // no error
 }
 
@@ -222,6 +431,7 @@ s32 BUFLCD_DeviceFontHandlingEnabled(void)
 s32 BUFLCD_OffsetXSet(u8 offset)
 {
   buflcd_offset_x = offset;
+  BUFLCD_LinesDirtySet(); // buffer has to be scanned again
   return 0; // no error
 }
 
@@ -240,6 +450,7 @@ s32 BUFLCD_OffsetXGet(void)
 s32 BUFLCD_OffsetYSet(u8 offset)
 {
   buflcd_offset_y = offset;
+  BUFLCD_LinesDirtySet(); // buffer has to be scanned again
   return 0; // no error
 }
 
@@ -302,6 +513,8 @@ s32 BUFLCD_Clear(void)
   lcd_cursor_x = 0;
   lcd_cursor_y = 0;
 
+  BUFLCD_LinesDirtySet();
+
   return 0; // no error
 }
 
@@ -337,24 +550,35 @@ s32 BUFLCD_FontInit(u8 *font)
 /////////////////////////////////////////////////////////////////////////////
 s32 BUFLCD_PrintChar(char c)
 {
-  u32 bufpos = lcd_cursor_y * buflcd_device_num_x * buflcd_device_width + lcd_cursor_x;
+  u32 line_width = buflcd_device_num_x * buflcd_device_width;
+  u32 bufpos = lcd_cursor_y * line_width + lcd_cursor_x;
   if( bufpos >= BUFLCD_MaxBufferGet() )
     return -1; // invalid line
 
+  u8 changed = 0;
   u8 *ptr = &lcd_buffer[bufpos];
-  if( (*ptr & 0x7f) != c )
+  if( (*ptr & 0x7f) != c ) {
     *ptr = c;
+    changed = 1;
+  }
 
 #if BUFLCD_SUPPORT_GLCD_FONTS
   if( glcd_font_handling ) {
     u8 *font_ptr = &lcd_buffer[bufpos + (BUFLCD_BUFFER_SIZE/2)];
-    if( *font_ptr != lcd_current_font ) {
-      *font_ptr = lcd_current_font;
-      *ptr &= 0x7f; // new font: ensure that character will be updated
+    if( (*font_ptr & 0x7f) != lcd_current_font ) {
+      *font_ptr = lcd_current_font; // new font: ensure that character will be updated
+      changed = 1;
     }
   }
 #endif
 
+  if( changed ) {
+    // the cursor could be outside the line
+    u32 line = (lcd_cursor_x < line_width) ? lcd_cursor_y : (bufpos / line_width);
+    if( line < BUFLCD_MAX_LINES )
+      lcd_line_dirty[line] = 1;
+  }
+
   ++lcd_cursor_x;
 
   return 0; // no error
@@ -375,107 +599,69 @@ s32 BUFLCD_CursorSet(u16 column, u16 line)
 
 /////////////////////////////////////////////////////////////////////////////
 //! transfers the buffer to LCDs
+//!
+//! Only lines which have been changed since the last update are scanned.
+//! Contiguous changed characters (with the same font) are sent with a single
+//! cursor set, and if GLCD fonts are used, the characters of a line are
+//! print sorted by font, so that fonts are only switched once per line.
 //! \param[in] force if != 0, it is ensured that the whole screen will be refreshed, regardless
 //! if characters have changed or not
 /////////////////////////////////////////////////////////////////////////////
 s32 BUFLCD_Update(u8 force)
 {
-  int next_x = -1;
-  int next_y = -1;
-  int x, y;
+  int y;
+
+  update_device = -1;
+#if BUFLCD_SUPPORT_GLCD_FONTS
+  update_font = NULL;
+#endif
 
   u32 bufpos_len = BUFLCD_MaxBufferGet();
+  u32 line_width = buflcd_device_num_x * buflcd_device_width;
   int phys_y = buflcd_offset_y;
   for(y=0; y<buflcd_device_num_y*buflcd_device_height; ++y, ++phys_y) {
-    u32 bufpos = y * buflcd_device_num_x * buflcd_device_width;
+    u32 bufpos = y * line_width;
     if( bufpos >= bufpos_len )
       break;
 
-    u8 *ptr = (u8 *)&lcd_buffer[bufpos];
-#if BUFLCD_SUPPORT_GLCD_FONTS
-    u8 *font_ptr = (u8 *)&lcd_buffer[bufpos + (BUFLCD_BUFFER_SIZE/2)];
-#endif
-    int phys_x = buflcd_offset_x;
-    int device = (buflcd_device_num_x * (phys_y / buflcd_device_height)) - 1;
-    for(x=0; x<(buflcd_device_num_x * buflcd_device_width) && bufpos < bufpos_len; ++x, ++phys_x, ++bufpos) {
-      if( (phys_x % buflcd_device_width) == 0 )
-	++device;
-
-      if( force || !(*ptr & 0x80)
-#if BUFLCD_SUPPORT_GLCD_FONTS
-	  || (glcd_font_handling && !(*font_ptr & 0x80))
-#endif
-	  ) {
-#if BUFLCD_SUPPORT_GLCD_FONTS
-	u8 *glcd_font = NULL;
-	if( glcd_font_handling ) {
-	  switch( *font_ptr & 0x7f ) {
-	  case 'n': glcd_font = (u8 *)GLCD_FONT_NORMAL; break;
-	  case 'i': glcd_font = (u8 *)GLCD_FONT_NORMAL_INV; break;
-	  case 'b': glcd_font = (u8 *)GLCD_FONT_BIG; break;
-	  case 's': glcd_font = (u8 *)GLCD_FONT_SMALL; break;
-	  case 't': glcd_font = (u8 *)GLCD_FONT_TINY; break;
-	  case 'k': glcd_font = (u8 *)GLCD_FONT_KNOB_ICONS; break;
-	  case 'h': glcd_font = (u8 *)GLCD_FONT_METER_ICONS_H; break;
-	  case 'v': glcd_font = (u8 *)GLCD_FONT_METER_ICONS_V; break;
-	  default:
-	    glcd_font = NULL; // no character will be print
-	  }
+    if( y < BUFLCD_MAX_LINES ) {
+      if( !force && !lcd_line_dirty[y] )
+	continue; // no change in this line
 
-	  MIOS32_LCD_FontInit(glcd_font);
-	}
-#endif
+      // cleared before the characters are taken, changes which are done
+      // in between will be transfered with the next update
+      lcd_line_dirty[y] = 0;
+    }
 
-	if( x != next_x || y != next_y ) {
-#if BUFLCD_SUPPORT_GLCD_FONTS
-	  if( glcd_font_handling && glcd_font ) {
-	    // temporary use pseudo-font to ensure that Y is handled equaly for all fonts
-	    u8 pseudo_font[4];
-	    // just to ensure...
-#if MIOS32_LCD_FONT_WIDTH_IX != 0 || MIOS32_LCD_FONT_HEIGHT_IX != 1 || MIOS32_LCD_FONT_X0_IX != 2 || MIOS32_LCD_FONT_OFFSET_IX != 3
-# error "Please adapt this part for new LCD Font parameter positions!"
-#endif
-	    pseudo_font[MIOS32_LCD_FONT_WIDTH_IX] = glcd_font[MIOS32_LCD_FONT_WIDTH_IX];
-	    pseudo_font[MIOS32_LCD_FONT_HEIGHT_IX] = 1*8; // forced!
-	    pseudo_font[MIOS32_LCD_FONT_X0_IX] = glcd_font[MIOS32_LCD_FONT_X0_IX];
-	    pseudo_font[MIOS32_LCD_FONT_OFFSET_IX] = glcd_font[MIOS32_LCD_FONT_OFFSET_IX];
-	    MIOS32_LCD_FontInit((u8 *)&pseudo_font);
-	  }
-#endif
-	  MIOS32_LCD_DeviceSet(device);
-	  MIOS32_LCD_CursorSet(phys_x % buflcd_device_width, phys_y % buflcd_device_height);
-#if BUFLCD_SUPPORT_GLCD_FONTS
-	  if( glcd_font_handling ) {
-	    // switch back to original font
-	    MIOS32_LCD_FontInit(glcd_font);
-	  }
-#endif
-	}
+    u32 len = line_width;
+    if( len > (bufpos_len - bufpos) )
+      len = bufpos_len - bufpos;
 
-#if BUFLCD_SUPPORT_GLCD_FONTS
-	if( !glcd_font_handling || glcd_font )
-#endif
-	  MIOS32_LCD_PrintChar(*ptr & 0x7f);
+    u8 *ptr = (u8 *)&lcd_buffer[bufpos];
+    int x;
+
+    if( force ) {
+      // refresh all characters of this line
+      MIOS32_IRQ_Disable(); // must be atomic
+      for(x=0; x<len; ++x)
+	ptr[x] &= 0x7f;
+      MIOS32_IRQ_Enable();
+    }
 
-	MIOS32_IRQ_Disable(); // must be atomic
-	*ptr |= 0x80;
 #if BUFLCD_SUPPORT_GLCD_FONTS
-	*font_ptr |= 0x80;
-#endif
-	MIOS32_IRQ_Enable();
-
-	next_y = y;
-	next_x = x+1;
-
-	// for multiple LCDs: ensure that cursor is set when we reach the next partition
-	if( (next_x % buflcd_device_width) == 0 )
-	  next_x = -1;
+    if( glcd_font_handling ) {
+      // characters are print sorted by font (in the order of their first appearance),
+      // after a run all characters of the font have been transfered
+      u8 *font_ptr = (u8 *)&lcd_buffer[bufpos + (BUFLCD_BUFFER_SIZE/2)];
+      for(x=0; x<len; ++x) {
+	if( !(ptr[x] & 0x80) || !(font_ptr[x] & 0x80) )
+	  BUFLCD_UpdateRuns(bufpos, len, x, phys_y, font_ptr[x] & 0x7f);
       }
-      ++ptr;
-#if BUFLCD_SUPPORT_GLCD_FONTS
-      ++font_ptr;
-#endif
+      continue;
     }
+#endif
+
+    BUFLCD_UpdateRuns(bufpos, len, 0, phys_y, 0);
   }
 
   return 0; // no error
@@ -40,6 +40,13 @@ extern "C" {
 # define BUFLCD_SUPPORT_GLCD_FONTS   0
 #endif
 
+// number of lines which are flagged when characters have been changed
+// BUFLCD_Update() only scans flagged lines, lines above this number are
+// always scanned
+#ifndef BUFLCD_MAX_LINES
+# define BUFLCD_MAX_LINES           64
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -0,0 +1,366 @@
+// $Id$
+/*
+ * Host test for the buffered LCD driver
+ *
+ * Prints typical screens (MBNG/MBLC like: labels, values, knob and meter
+ * icons) into the buffer, and counts the LCD accesses of BUFLCD_Update():
+ *   - MIOS32_LCD_CursorSet and MIOS32_LCD_PrintChar (bus transfers)
+ *   - MIOS32_LCD_DeviceSet and MIOS32_LCD_FontInit
+ *   - MIOS32_IRQ_Disable
+ * The accesses are compared with the previous per-character update
+ * algorithm (calculated for the same changed characters).
+ *
+ * Each update is checked against an emulated screen, which is written
+ * by the MIOS32_LCD stand-ins.
+ *
+ * Build and run with and without GLCD font support with "make test"
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GNU_TEST_OWN_IRQ
+#include <gnu_test.h>
+
+#if BUFLCD_SUPPORT_GLCD_FONTS
+#include <glcd_font.h>
+#endif
+
+#include "buflcd.h"
+
+#define MAX_DEVICES 8
+#define MAX_LINES   16
+#define MAX_COLUMNS 64
+
+typedef struct {
+  u32 cursor_set;
+  u32 print_char;
+  u32 device_set;
+  u32 font_init;
+  u32 irq_disable;
+} counters_t;
+
+static counters_t counters;
+
+typedef struct {
+  char c;
+  u8 *font;
+} screen_char_t;
+
+static screen_char_t screen[MAX_DEVICES][MAX_LINES][MAX_COLUMNS];
+
+static u8 is_glcd;
+static u8 current_device;
+static u16 current_column;
+static u16 current_line;
+static u8 *current_font;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// stand-ins for MIOS32 functions used by buflcd.c
+/////////////////////////////////////////////////////////////////////////////
+mios32_lcd_parameters_t mios32_lcd_parameters;
+
+s32 MIOS32_LCD_TypeIsGLCD(void) { return is_glcd; }
+
+s32 MIOS32_IRQ_Disable(void) { ++counters.irq_disable; return 0; }
+s32 MIOS32_IRQ_Enable(void) { return 0; }
+
+s32 MIOS32_LCD_DeviceSet(u8 device)
+{
+  ++counters.device_set;
+  current_device = device;
+  return 0;
+}
+
+s32 MIOS32_LCD_CursorSet(u16 column, u16 line)
+{
+  ++counters.cursor_set;
+  current_column = column;
+  current_line = line;
+#if BUFLCD_SUPPORT_GLCD_FONTS
+  if( is_glcd && current_font && current_font[MIOS32_LCD_FONT_HEIGHT_IX] != 1*8 ) {
+    if( ++num_errors < 10 )
+      printf("ERROR: cursor set with font height %d\n", current_font[MIOS32_LCD_FONT_HEIGHT_IX]);
+  }
+#endif
+  return 0;
+}
+
+s32 MIOS32_LCD_FontInit(u8 *font)
+{
+  ++counters.font_init;
+  current_font = font;
+  return 0;
+}
+
+s32 MIOS32_LCD_PrintChar(char c)
+{
+  ++counters.print_char;
+  if( current_device >= MAX_DEVICES || current_line >= MAX_LINES || current_column >= MAX_COLUMNS ) {
+    if( ++num_errors < 10 )
+      printf("ERROR: character print at invalid position %d:%d:%d\n", current_device, current_column, current_line);
+  } else {
+    screen_char_t *s = &screen[current_device][current_line][current_column];
+    s->c = c;
+    s->font = current_font;
+  }
+  ++current_column;
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// helper functions
+/////////////////////////////////////////////////////////////////////////////
+
+#if BUFLCD_SUPPORT_GLCD_FONTS
+static u8 *font_get(u8 font_code)
+{
+  switch( font_code ) {
+  case 'n': return (u8 *)GLCD_FONT_NORMAL;
+  case 'i': return (u8 *)GLCD_FONT_NORMAL_INV;
+  case 'b': return (u8 *)GLCD_FONT_BIG;
+  case 's': return (u8 *)GLCD_FONT_SMALL;
+  case 't': return (u8 *)GLCD_FONT_TINY;
+  case 'k': return (u8 *)GLCD_FONT_KNOB_ICONS;
+  case 'h': return (u8 *)GLCD_FONT_METER_ICONS_H;
+  case 'v': return (u8 *)GLCD_FONT_METER_ICONS_V;
+  }
+  return NULL;
+}
+#endif
+
+// the display buffer isn't accessible from outside, therefore the
+// expected content is stored in a shadow buffer
+static char expected_char[MAX_LINES][MAX_DEVICES*MAX_COLUMNS];
+static u8 expected_font[MAX_LINES][MAX_DEVICES*MAX_COLUMNS];
+static u8 expected_dirty[MAX_LINES][MAX_DEVICES*MAX_COLUMNS];
+
+static void print_at(int x, int y, u8 font_code, const char *str)
+{
+#if BUFLCD_SUPPORT_GLCD_FONTS
+  BUFLCD_FontInit(font_get(font_code));
+#else
+  font_code = 'n';
+#endif
+  BUFLCD_CursorSet(x, y);
+  for(; *str; ++str, ++x) {
+    BUFLCD_PrintChar(*str);
+    if( expected_char[y][x] != *str || (BUFLCD_DeviceFontHandlingEnabled() && expected_font[y][x] != font_code) )
+      expected_dirty[y][x] = 1;
+    expected_char[y][x] = *str;
+    expected_font[y][x] = font_code;
+  }
+}
+
+static int line_width(void)
+{
+  return BUFLCD_DeviceNumXGet() * BUFLCD_DeviceWidthGet();
+}
+
+static int num_lines(void)
+{
+  return BUFLCD_DeviceNumYGet() * BUFLCD_DeviceHeightGet();
+}
+
+// counts the LCD accesses of the previous (per-character) BUFLCD_Update() for the changed characters
+static void reference_count(counters_t *ref, u8 force)
+{
+  int width = BUFLCD_DeviceWidthGet();
+  int font_handling = BUFLCD_DeviceFontHandlingEnabled();
+  int x, y;
+
+  memset(ref, 0, sizeof(counters_t));
+  int next_x = -1;
+  int next_y = -1;
+  for(y=0; y<num_lines(); ++y) {
+    for(x=0; x<line_width(); ++x) {
+      if( !force && !expected_dirty[y][x] )
+	continue;
+
+      u8 font_valid = 1;
+      if( font_handling ) {
+	++ref->font_init;
+#if BUFLCD_SUPPORT_GLCD_FONTS
+	font_valid = font_get(expected_font[y][x]) != NULL;
+#endif
+      }
+
+      if( x != next_x || y != next_y ) {
+	if( font_handling && font_valid )
+	  ref->font_init += 2;
+	++ref->device_set;
+	++ref->cursor_set;
+      }
+
+      if( font_valid )
+	++ref->print_char;
+      ++ref->irq_disable;
+
+      next_y = y;
+      next_x = x + 1;
+      if( (next_x % width) == 0 )
+	next_x = -1;
+    }
+  }
+}
+
+static void check_screen(const char *name)
+{
+  int width = BUFLCD_DeviceWidthGet();
+  int height = BUFLCD_DeviceHeightGet();
+  int x, y;
+
+  for(y=0; y<num_lines(); ++y) {
+    for(x=0; x<line_width(); ++x) {
+      int device = BUFLCD_DeviceNumXGet() * (y / height) + (x / width);
+      screen_char_t *s = &screen[device][y % height][x % width];
+      u8 *font = NULL;
+#if BUFLCD_SUPPORT_GLCD_FONTS
+      if( BUFLCD_DeviceFontHandlingEnabled() )
+	font = font_get(expected_font[y][x]);
+#endif
+      if( s->c != expected_char[y][x] || (BUFLCD_DeviceFontHandlingEnabled() && s->font != font) ) {
+	if( ++num_errors < 10 )
+	  printf("ERROR: %s: unexpected character '%c' at %d:%d, expected '%c'\n", name, s->c, x, y, expected_char[y][x]);
+      }
+    }
+  }
+}
+
+static void update(const char *name, u8 force)
+{
+  counters_t ref;
+  reference_count(&ref, force);
+
+  memset(&counters, 0, sizeof(counters_t));
+  BUFLCD_Update(force);
+  memset(expected_dirty, 0, sizeof(expected_dirty));
+
+  check_screen(name);
+
+  printf("  %-22s cursor %4u (%4u)  chars %4u (%4u)  device %4u (%4u)  font %4u (%4u)  irq %4u (%4u)\n",
+	 name,
+	 counters.cursor_set, ref.cursor_set,
+	 counters.print_char, ref.print_char,
+	 counters.device_set, ref.device_set,
+	 counters.font_init, ref.font_init,
+	 counters.irq_disable, ref.irq_disable);
+}
+
+static void init(u8 glcd, u8 num_x, u8 num_y, u16 width, u16 height)
+{
+  is_glcd = glcd;
+  mios32_lcd_parameters.lcd_type = glcd ? MIOS32_LCD_TYPE_GLCD_SSD1306 : MIOS32_LCD_TYPE_CLCD;
+  mios32_lcd_parameters.num_x = num_x;
+  mios32_lcd_parameters.num_y = num_y;
+  mios32_lcd_parameters.width = width;
+  mios32_lcd_parameters.height = height;
+
+  memset(screen, 0, sizeof(screen));
+  memset(expected_char, ' ', sizeof(expected_char));
+  memset(expected_font, 'n', sizeof(expected_font));
+  memset(expected_dirty, 1, sizeof(expected_dirty));
+
+  BUFLCD_Init(0);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// screens
+/////////////////////////////////////////////////////////////////////////////
+
+// two 2x40 CLCDs, combined to 2x80 (e.g. MBLC host messages)
+static void clcd_screens(void)
+{
+  int i;
+
+  printf("2x80 CLCD (two 2x40 devices)\n");
+  init(0, 2, 1, 40, 2);
+  update("initial", 0);
+
+  print_at(0, 0, 'n', "Track 1  Track 2  Track 3  Track 4  Track 5  Track 6  Track 7  Track 8  Master ");
+  print_at(0, 1, 'n', "  0.0dB   -3.2dB  -12.0dB    0.0dB   -6.5dB   -1.0dB  -24.0dB    0.0dB    0.0dB");
+  update("page", 0);
+  update("no change", 0);
+
+  print_at(0, 0, 'n', "Track 1  Track 2  Track 3  Track 4  Track 5  Track 6  Track 7  Track 8  Master ");
+  update("same page again", 0);
+
+  print_at(9, 1, 'n', " -3.4dB");
+  update("value change", 0);
+
+  for(i=0; i<8; ++i)
+    print_at(9*i + 7, 1, 'n', (i & 1) ? "\x03" : "\x05");
+  update("meters", 0);
+
+  update("force", 1);
+}
+
+
+#if BUFLCD_SUPPORT_GLCD_FONTS
+// four 128x64 GLCDs (2x2 devices, 21x8 characters each), MBNG like screen
+static void glcd_screens(void)
+{
+  char str[64];
+  int i;
+
+  printf("4 GLCDs 128x64 (42x16 characters, font handling enabled)\n");
+  init(1, 2, 2, 128, 64);
+  update("initial", 0);
+
+  print_at(0, 0, 'i', "  Bank 1 - Mixer                          ");
+  for(i=0; i<8; ++i) {
+    print_at(5*i, 2, 'n', "Vol");
+    sprintf(str, "%3d", 10*i);
+    print_at(5*i/2, 3, 'b', str); // big font: 16 pixels per character
+    print_at(5*i/5, 6, 'k', "\x01"); // knob icon: 28 pixels per character
+    print_at(5*i, 9, 'n', "Pan");
+    print_at(5*i/5, 10, 'h', "\x05");
+  }
+  print_at(0, 15, 's', "Page 1/4  Patch: default.ngc");
+  update("page", 0);
+  update("no change", 0);
+
+  print_at(0, 0, 'i', "  Bank 1 - Mixer                          ");
+  for(i=0; i<8; ++i)
+    print_at(5*i, 2, 'n', "Vol");
+  update("same page again", 0);
+
+  print_at(5*3/2, 3, 'b', " 31");
+  print_at(3, 6, 'k', "\x02");
+  update("value change", 0);
+
+  for(i=0; i<8; ++i)
+    print_at(i, 10, 'h', (i & 1) ? "\x03" : "\x07");
+  update("meters", 0);
+
+  print_at(0, 0, 'i', "  Bank 2 - Sends                          ");
+  for(i=0; i<8; ++i) {
+    print_at(5*i, 2, 'n', "FX A");
+    print_at(5*i, 9, 'n', "FX B");
+  }
+  update("page switch", 0);
+
+  update("force", 1);
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  printf("BUFLCD_SUPPORT_GLCD_FONTS=%d, access counters of BUFLCD_Update() (previous algorithm in brackets)\n", BUFLCD_SUPPORT_GLCD_FONTS);
+
+  clcd_screens();
+#if BUFLCD_SUPPORT_GLCD_FONTS
+  glcd_screens();
+#endif
+
+  return GNU_TEST_Result();
+}
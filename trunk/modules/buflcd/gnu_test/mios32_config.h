@@ -0,0 +1,14 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host test
+ *
+ * BUFLCD_SUPPORT_GLCD_FONTS is passed by the makefile
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+// four 128x64 GLCDs (21x8 characters each) with font buffer
+#define BUFLCD_BUFFER_SIZE (2*4*21*8)
+
+#endif /* _MIOS32_CONFIG_H */
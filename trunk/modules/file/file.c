@@ -47,6 +47,8 @@
 # include <FreeRTOS.h>
 # include <portmacro.h>
 # include <task.h>
+#else
+# include <unistd.h> // unlink()
 #endif
 
 
@@ -80,6 +82,7 @@ u8 file_copy_percentage;
 /////////////////////////////////////////////////////////////////////////////
 
 static s32 FILE_MountFS(void);
+static s32 FILE_BrowserSendBinBlocks(void);
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -116,6 +119,17 @@ static u8 tmp_buffer[TMP_BUFFER_SIZE];
 static u32 browser_write_file_size;
 static u32 browser_write_file_pos;
 
+// for binary read operations of FILE_BrowserHandler
+#if FILE_BROWSER_BIN_BLOCK_SIZE > 256 || FILE_BROWSER_BIN_BLOCK_SIZE > (TMP_BUFFER_SIZE/2)
+# error "FILE_BROWSER_BIN_BLOCK_SIZE too large, max. 256 supported"
+#endif
+static file_t browser_read_file;
+static u8 browser_read_file_valid;
+static mios32_midi_port_t browser_read_port;
+static u32 browser_read_file_size;
+static u32 browser_read_send_pos; // next block which will be sent
+static u32 browser_read_ack_pos; // all bytes below this position have been received
+
 static s32 (*browser_upload_callback_func)(char *filename);
 
 
@@ -131,6 +145,7 @@ s32 FILE_Init(u32 mode)
   volume_free_bytes = 0;
 
   browser_upload_callback_func = NULL;
+  browser_read_file_valid = 0;
 
   // init SDCard access
   s32 error = MIOS32_SDCARD_Init(0);
@@ -1538,6 +1553,91 @@ s32 FILE_BrowserHandler(mios32_midi_port_t port, char *command)
 
 	FILE_ReadClose(&file);
       }
+    } else if( strcmp(parameter, "readbin") == 0 ) {
+      // binary read: the file content is sent in 7bit packed blocks with CRC (see FILE_BrowserSendBinBlocks())
+      // up to FILE_BROWSER_BIN_WINDOW blocks are sent without acknowledge, MIOS Studio requests
+      // the next blocks with "readack <position>", and a retransmission with "readretry <position>"
+      command_taken = 1;
+      status |= MIOS32_MIDI_SendDebugStringHeader(port, 0x41, (u8)'R');
+
+      browser_read_file_valid = 0;
+
+      if( !volume_available ) {
+	status |= MIOS32_MIDI_SendDebugStringBody(port, "!", 1); // SD Card not mounted
+      } else {
+	char *filepath = brkt;
+
+	if( FILE_ReadOpen(&browser_read_file, filepath) < 0 ) {
+	  status |= MIOS32_MIDI_SendDebugStringBody(port, "-", 1); // can't access file
+	} else {
+	  char str[20];
+	  browser_read_file_size = FILE_ReadGetCurrentSize();
+	  FILE_ReadClose(&browser_read_file);
+
+	  sprintf(str, "%d", browser_read_file_size);
+	  status |= MIOS32_MIDI_SendDebugStringBody(port, str, strlen(str));
+	  status |= MIOS32_MIDI_SendDebugStringFooter(port);
+	  send_footer = 0; // done
+
+	  if( browser_read_file_size ) {
+	    browser_read_file_valid = 1;
+	    browser_read_port = port;
+	    browser_read_send_pos = 0;
+	    browser_read_ack_pos = 0;
+
+	    DEBUG_MSG("[FILE] Binary download of %d bytes started.", browser_read_file_size);
+	    status |= FILE_BrowserSendBinBlocks();
+	  }
+	}
+      }
+    } else if( strcmp(parameter, "readack") == 0 || strcmp(parameter, "readretry") == 0 ) {
+      command_taken = 1;
+      u8 retry = parameter[4] == 'r';
+
+      u32 pos = 0;
+      u8 parameters_valid = 1;
+      if( !(parameter = strtok_r(NULL, separators, &brkt)) ) {
+	parameters_valid = 0;
+      } else {
+	char *next;
+	pos = strtol(parameter, &next, 16);
+	if( parameter == next )
+	  parameters_valid = 0;
+      }
+
+      if( !browser_read_file_valid || !parameters_valid || pos > browser_read_send_pos ) {
+	status |= MIOS32_MIDI_SendDebugStringHeader(port, 0x41, (u8)'R');
+	status |= MIOS32_MIDI_SendDebugStringBody(port, "~", 1); // no read operation in progress or invalid position
+      } else {
+	send_footer = 0; // only binary blocks are sent
+
+	if( pos >= browser_read_file_size ) {
+	  browser_read_file_valid = 0;
+	  DEBUG_MSG("[FILE] Binary download of %d bytes finished.", browser_read_file_size);
+	} else {
+	  if( pos > browser_read_ack_pos ) {
+	    // send status message to MIOS terminal for the case that MIOS Studio has been started
+	    // while read operation in progress
+	    if( (pos / (320*32)) != (browser_read_ack_pos / (320*32)) ) {
+	      DEBUG_MSG("[FILE] Binary download of %d bytes in progress (%d%%)", browser_read_file_size, (int)((100.0*(float)pos)/(float)browser_read_file_size));
+	    }
+	    browser_read_ack_pos = pos;
+	  }
+
+	  if( retry ) {
+	    // go back to the requested position
+	    browser_read_ack_pos = pos;
+	    browser_read_send_pos = pos;
+	  }
+
+	  if( (status |= FILE_BrowserSendBinBlocks()) < 0 ) {
+	    browser_read_file_valid = 0;
+	    status |= MIOS32_MIDI_SendDebugStringHeader(port, 0x41, (u8)'R');
+	    status |= MIOS32_MIDI_SendDebugStringBody(port, "-", 1); // can't access file anymore
+	    status |= MIOS32_MIDI_SendDebugStringFooter(port);
+	  }
+	}
+      }
     } else if( strcmp(parameter, "write") == 0 ) {
       command_taken = 1;
       status |= MIOS32_MIDI_SendDebugStringHeader(port, 0x41, (u8)'W');
@@ -1675,6 +1775,111 @@ s32 FILE_BrowserHandler(mios32_midi_port_t port, char *command)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// CRC-16-CCITT (polynomial 0x1021, initial value 0xffff) of binary blocks
+/////////////////////////////////////////////////////////////////////////////
+static u16 FILE_BrowserCRC16(u8 *buffer, u32 len)
+{
+  u16 crc = 0xffff;
+
+  while( len-- ) {
+    crc ^= (u16)*buffer++ << 8;
+
+    int i;
+    for(i=0; i<8; ++i)
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+  }
+
+  return crc;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sends the blocks of a binary read operation until the window is full.
+// Block format:
+//   F0 00 00 7E 32 <device-id> 0D 42
+//   <position: 4 bytes, 7bit each, LSB first>
+//   <length: 2 bytes, 7bit each, LSB first>
+//   <CRC16 of the unpacked payload: 3 bytes, 7bit each, LSB first>
+//   <payload: each group of 7 bytes is preceded by a byte with their MSBs (bit 0 -> first byte)>
+//   F7
+/////////////////////////////////////////////////////////////////////////////
+static s32 FILE_BrowserSendBinBlocks(void)
+{
+  s32 status = 0;
+  u32 window_end = browser_read_ack_pos + FILE_BROWSER_BIN_WINDOW * FILE_BROWSER_BIN_BLOCK_SIZE;
+
+  if( browser_read_send_pos >= window_end || browser_read_send_pos >= browser_read_file_size )
+    return 0; // window full or all blocks sent
+
+  if( FILE_ReadReOpen(&browser_read_file) < 0 )
+    return FILE_ERR_OPEN_READ;
+
+  if( (status=FILE_ReadSeek(browser_read_send_pos)) < 0 ) {
+    FILE_ReadClose(&browser_read_file);
+    return status;
+  }
+
+  while( browser_read_send_pos < window_end && browser_read_send_pos < browser_read_file_size ) {
+    u32 pos = browser_read_send_pos;
+    u32 len = browser_read_file_size - pos;
+    if( len > FILE_BROWSER_BIN_BLOCK_SIZE )
+      len = FILE_BROWSER_BIN_BLOCK_SIZE;
+
+    // the payload is read into the upper half of tmp_buffer, and packed into the lower half
+    // (the write pointer never overtakes the read pointer)
+    u8 *payload = (u8 *)&tmp_buffer[TMP_BUFFER_SIZE - FILE_BROWSER_BIN_BLOCK_SIZE];
+    if( (status=FILE_ReadBuffer(payload, len)) < 0 )
+      break;
+
+    u16 crc = FILE_BrowserCRC16(payload, len);
+
+    u8 *msg = (u8 *)&tmp_buffer[0];
+    int i;
+    for(i=0; i<sizeof(mios32_midi_sysex_header); ++i)
+      *msg++ = mios32_midi_sysex_header[i];
+    *msg++ = MIOS32_MIDI_DeviceIDGet();
+    *msg++ = MIOS32_MIDI_SYSEX_DEBUG;
+    *msg++ = 0x42; // binary data for filebrowser
+    *msg++ = (pos >>  0) & 0x7f;
+    *msg++ = (pos >>  7) & 0x7f;
+    *msg++ = (pos >> 14) & 0x7f;
+    *msg++ = (pos >> 21) & 0x7f;
+    *msg++ = (len >>  0) & 0x7f;
+    *msg++ = (len >>  7) & 0x7f;
+    *msg++ = (crc >>  0) & 0x7f;
+    *msg++ = (crc >>  7) & 0x7f;
+    *msg++ = (crc >> 14) & 0x7f;
+
+    for(i=0; i<len; i+=7) {
+      u8 group[7];
+      u8 msbs = 0;
+      int j;
+      int group_len = ((len - i) < 7) ? (len - i) : 7;
+      for(j=0; j<group_len; ++j) {
+	group[j] = payload[i+j];
+	if( group[j] & 0x80 )
+	  msbs |= (1 << j);
+      }
+
+      *msg++ = msbs;
+      for(j=0; j<group_len; ++j)
+	*msg++ = group[j] & 0x7f;
+    }
+    *msg++ = 0xf7;
+
+    if( (status=MIOS32_MIDI_SendSysEx(browser_read_port, tmp_buffer, (u32)(msg - tmp_buffer))) < 0 )
+      break;
+
+    browser_read_send_pos += len;
+  }
+
+  FILE_ReadClose(&browser_read_file);
+
+  return status;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Installs the Browser Upload callback function which is executed whenever
 //! a file upload starts, and when it has been successfully finished.
@@ -22,6 +22,17 @@ extern "C" {
 // Global definitions
 /////////////////////////////////////////////////////////////////////////////
 
+// binary file transfer of FILE_BrowserHandler() ("readbin" command):
+// number of payload bytes per SysEx block (max. 256)
+#ifndef FILE_BROWSER_BIN_BLOCK_SIZE
+#define FILE_BROWSER_BIN_BLOCK_SIZE 256
+#endif
+
+// number of blocks which are sent without acknowledge from MIOS Studio
+#ifndef FILE_BROWSER_BIN_WINDOW
+#define FILE_BROWSER_BIN_WINDOW 8
+#endif
+
 // error codes
 // NOTE: FILE_SendErrorMessage() should be extended whenever new codes have been added!
 
@@ -0,0 +1,479 @@
+// $Id$
+/*
+ * Loopback test for the filebrowser protocol of FILE_BrowserHandler
+ *
+ * A file is stored on a RAM disk and downloaded with the text ("read")
+ * and the binary ("readbin") mode.  The client side decodes the SysEx
+ * messages like MIOS Studio does, and checks the received data.
+ * The binary mode is additionally tested with a dropped and a corrupted
+ * block, which have to be recovered with "readretry".
+ *
+ * Measured:
+ *   - SysEx bytes sent by the core and by the client per payload byte
+ *   - CPU time spent in FILE_BrowserHandler (host CPU!)
+ * Modeled (not measured!) from the SysEx byte count:
+ *   - effective bytes/s over a MIDI UART (31250 baud, 10 bits per byte)
+ *   - effective bytes/s over USB MIDI, assuming 16 packets (= 48 SysEx bytes)
+ *     per 1 mS frame
+ *
+ * Build and run with "make test"
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+#define GNU_TEST_OWN_DEBUG_MESSAGE
+#include <gnu_test.h>
+
+#include <ff.h>
+#include "file.h"
+
+#define DISK_SECTORS   16384 // 8 MB
+#define TEST_FILE      "/TEST.BIN"
+#define TEST_FILE_SIZE 100000
+
+#define MAX_MESSAGES   8192
+#define MAX_COMMANDS   64
+
+static u8 *disk;
+
+typedef struct {
+  u32 len;
+  u8 *data;
+} message_t;
+
+// core -> client
+static message_t downlink[MAX_MESSAGES];
+static u32 downlink_head, downlink_tail;
+static u8 *current_msg;
+static u32 current_msg_len;
+
+// client -> core
+static char uplink[MAX_COMMANDS][100];
+static u32 uplink_head, uplink_tail;
+
+static u32 down_bytes;
+static u32 down_usb_packets;
+static u32 up_bytes;
+static u32 up_usb_packets;
+
+static u8 verbose;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// stand-ins for MIOS32 functions used by file.c and diskio.c
+/////////////////////////////////////////////////////////////////////////////
+const u8 mios32_midi_sysex_header[5] = { 0xf0, 0x00, 0x00, 0x7e, 0x32 };
+
+u8 MIOS32_MIDI_DeviceIDGet(void) { return 0x00; }
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  if( verbose ) {
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    printf("\n");
+  }
+  return 0;
+}
+
+s32 MIOS32_MIDI_SendDebugHexDump(const u8 *src, u32 len)
+{
+  return 0;
+}
+
+static void downlink_push(void)
+{
+  if( downlink_head - downlink_tail >= MAX_MESSAGES ) {
+    printf("ERROR: downlink overrun\n");
+    exit(1);
+  }
+
+  message_t *m = &downlink[downlink_head++ % MAX_MESSAGES];
+  m->len = current_msg_len;
+  m->data = current_msg;
+  current_msg = NULL;
+
+  down_bytes += m->len;
+  down_usb_packets += (m->len + 2) / 3;
+}
+
+s32 MIOS32_MIDI_SendSysEx(mios32_midi_port_t port, u8 *stream, u32 count)
+{
+  current_msg = malloc(count);
+  memcpy(current_msg, stream, count);
+  current_msg_len = count;
+  downlink_push();
+  return 0;
+}
+
+s32 MIOS32_MIDI_SendDebugStringHeader(mios32_midi_port_t port, char command, char first_byte)
+{
+  current_msg = malloc(1024);
+  memcpy(current_msg, mios32_midi_sysex_header, 5);
+  current_msg[5] = MIOS32_MIDI_DeviceIDGet();
+  current_msg[6] = MIOS32_MIDI_SYSEX_DEBUG;
+  current_msg[7] = command;
+  current_msg_len = 8;
+  if( first_byte )
+    current_msg[current_msg_len++] = first_byte;
+  return 0;
+}
+
+s32 MIOS32_MIDI_SendDebugStringBody(mios32_midi_port_t port, char *str, u32 len)
+{
+  len = strnlen(str, len);
+  memcpy(&current_msg[current_msg_len], str, len);
+  current_msg_len += len;
+  return 0;
+}
+
+s32 MIOS32_MIDI_SendDebugStringFooter(mios32_midi_port_t port)
+{
+  current_msg[current_msg_len++] = 0xf7;
+  downlink_push();
+  return 0;
+}
+
+// the SD Card is a RAM disk
+s32 MIOS32_SDCARD_Init(u32 mode) { return 0; }
+s32 MIOS32_SDCARD_CheckAvailable(u8 was_available) { return 1; }
+
+s32 MIOS32_SDCARD_SectorRead(u32 sector, u8 *buffer)
+{
+  if( sector >= DISK_SECTORS )
+    return -1;
+  memcpy(buffer, &disk[sector*512], 512);
+  return 0;
+}
+
+s32 MIOS32_SDCARD_SectorWrite(u32 sector, u8 *buffer)
+{
+  if( sector >= DISK_SECTORS )
+    return -1;
+  memcpy(&disk[sector*512], buffer, 512);
+  return 0;
+}
+
+s32 MIOS32_SDCARD_CIDRead(mios32_sdcard_cid_t *cid)
+{
+  memset(cid, 0, sizeof(mios32_sdcard_cid_t));
+  return 0;
+}
+
+s32 MIOS32_SDCARD_CSDRead(mios32_sdcard_csd_t *csd)
+{
+  memset(csd, 0, sizeof(mios32_sdcard_csd_t));
+  csd->CSDStruct = 1; // SD V2
+  csd->DeviceSize = (DISK_SECTORS >> 10) - 1;
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// client side (decoder like in MIOS Studio)
+/////////////////////////////////////////////////////////////////////////////
+typedef struct {
+  u8  binary;
+  u8  done;
+  u8  error;
+  u32 size;
+  u32 received;
+  u32 pos;
+  u32 retry_pos;
+  u8 *data;
+  u32 num_retries;
+  u32 num_duplicates;
+  u32 num_corrupted;
+} client_t;
+
+static client_t client;
+
+static void client_send(const char *format, ...)
+{
+  if( uplink_head - uplink_tail >= MAX_COMMANDS ) {
+    printf("ERROR: uplink overrun\n");
+    exit(1);
+  }
+
+  va_list args;
+  va_start(args, format);
+  vsnprintf(uplink[uplink_head++ % MAX_COMMANDS], 100, format, args);
+  va_end(args);
+
+  // F0 00 00 7E 32 <device-id> 0D 01 <command> '\n' F7
+  u32 len = 8 + strlen(uplink[(uplink_head-1) % MAX_COMMANDS]) + 2;
+  up_bytes += len;
+  up_usb_packets += (len + 2) / 3;
+}
+
+static void client_retry(void)
+{
+  // only once per missing position
+  if( client.retry_pos != client.pos ) {
+    client.retry_pos = client.pos;
+    ++client.num_retries;
+    client_send("readretry %X", client.pos);
+  }
+}
+
+static void client_receive_string(char *str)
+{
+  switch( str[0] ) {
+  case 'R':
+    if( str[1] == '!' || str[1] == '-' || str[1] == '~' ) {
+      printf("ERROR: read failed with '%s'\n", str);
+      client.error = 1;
+    } else {
+      client.size = atoi(&str[1]);
+      client.data = calloc(client.size + 1, 1);
+      client.received = 0;
+      client.pos = 0;
+      client.retry_pos = 0;
+      if( !client.size )
+	client.done = 1;
+    }
+    break;
+
+  case 'r': {
+    char addr_str[9];
+    memcpy(addr_str, &str[1], 8);
+    addr_str[8] = 0;
+    u32 address = strtoul(addr_str, NULL, 16);
+    char *payload = &str[10];
+    int i;
+    for(i=0; payload[i] && payload[i+1]; i+=2) {
+      char byte_str[3] = { payload[i], payload[i+1], 0 };
+      if( (address + i/2) >= client.size ) {
+	printf("ERROR: received invalid payload\n");
+	client.error = 1;
+	return;
+      }
+      client.data[address + i/2] = strtoul(byte_str, NULL, 16);
+    }
+    client.received += i/2;
+    if( client.received >= client.size )
+      client.done = 1;
+  } break;
+
+  default:
+    printf("ERROR: unexpected response '%s'\n", str);
+    client.error = 1;
+  }
+}
+
+static void client_receive_block(u8 *data, u32 len)
+{
+  u32 address = data[0] | (data[1] << 7) | (data[2] << 14) | (data[3] << 21);
+  u32 length = data[4] | (data[5] << 7);
+  u16 crc = data[6] | (data[7] << 7) | (data[8] << 14);
+
+  u8 payload[256];
+  u32 payload_len = 0;
+  u32 i = 9;
+  while( i < len && data[i] < 0x80 ) {
+    u8 msbs = data[i++];
+    int j;
+    for(j=0; j<7 && i < len && data[i] < 0x80; ++j, ++i) {
+      if( payload_len >= sizeof(payload) ) {
+	client_retry();
+	return;
+      }
+      payload[payload_len++] = data[i] | ((msbs & (1 << j)) ? 0x80 : 0x00);
+    }
+  }
+
+  u16 payload_crc = 0xffff;
+  for(i=0; i<payload_len; ++i) {
+    payload_crc ^= (u16)payload[i] << 8;
+    int bit;
+    for(bit=0; bit<8; ++bit)
+      payload_crc = (payload_crc & 0x8000) ? ((payload_crc << 1) ^ 0x1021) : (payload_crc << 1);
+  }
+
+  if( payload_len != length || payload_crc != crc || (address + length) > client.size ) {
+    ++client.num_corrupted;
+    client_retry();
+  } else if( address < client.pos ) {
+    ++client.num_duplicates;
+  } else if( address > client.pos ) {
+    client_retry();
+  } else {
+    memcpy(&client.data[address], payload, length);
+    client.pos += length;
+    client.received = client.pos;
+    client_send("readack %X", client.pos);
+    if( client.pos >= client.size )
+      client.done = 1;
+  }
+}
+
+static void client_receive(u8 *msg, u32 len)
+{
+  if( len < 9 || memcmp(msg, mios32_midi_sysex_header, 5) != 0 || msg[6] != MIOS32_MIDI_SYSEX_DEBUG || msg[len-1] != 0xf7 ) {
+    printf("ERROR: invalid SysEx message\n");
+    client.error = 1;
+    return;
+  }
+
+  if( msg[7] == 0x41 ) {
+    char str[1024];
+    memcpy(str, &msg[8], len - 9);
+    str[len - 9] = 0;
+    client_receive_string(str);
+  } else if( msg[7] == 0x42 && client.binary ) {
+    client_receive_block(&msg[8], len - 8);
+  } else {
+    printf("ERROR: unexpected SysEx message type 0x%02x\n", msg[7]);
+    client.error = 1;
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// runs a download
+// drop_block/corrupt_block: number of the binary block which should be
+// dropped/corrupted on the way to the client (0: none)
+/////////////////////////////////////////////////////////////////////////////
+static int run_download(const char *name, u8 binary, u32 drop_block, u32 corrupt_block, u8 *expected)
+{
+  memset(&client, 0, sizeof(client_t));
+  client.binary = binary;
+  down_bytes = down_usb_packets = up_bytes = up_usb_packets = 0;
+
+  clock_t handler_clocks = 0;
+  u32 num_blocks = 0;
+  u32 num_timeouts = 0;
+
+  client_send(binary ? "readbin %s" : "read %s", TEST_FILE);
+
+  while( !client.done && !client.error ) {
+    while( uplink_tail != uplink_head ) {
+      char command[100];
+      strcpy(command, uplink[uplink_tail++ % MAX_COMMANDS]);
+      clock_t t = clock();
+      FILE_BrowserHandler(DEFAULT, command);
+      handler_clocks += clock() - t;
+    }
+
+    if( downlink_tail != downlink_head ) {
+      message_t *m = &downlink[downlink_tail++ % MAX_MESSAGES];
+
+      u8 deliver = 1;
+      if( m->data[7] == 0x42 ) {
+	++num_blocks;
+	if( num_blocks == drop_block )
+	  deliver = 0;
+	else if( num_blocks == corrupt_block )
+	  m->data[m->len / 2] ^= 0x01;
+      }
+
+      if( deliver )
+	client_receive(m->data, m->len);
+      free(m->data);
+    } else if( uplink_tail == uplink_head && !client.done ) {
+      // timeout: request the missing blocks again
+      if( !binary || ++num_timeouts > 3 ) {
+	printf("ERROR: no response from core\n");
+	client.error = 1;
+      } else {
+	client.retry_pos = client.pos + 1; // force retry
+	client_retry();
+      }
+    }
+  }
+
+  // send remaining commands (e.g. final acknowledge)
+  while( uplink_tail != uplink_head ) {
+    char command[100];
+    strcpy(command, uplink[uplink_tail++ % MAX_COMMANDS]);
+    FILE_BrowserHandler(DEFAULT, command);
+  }
+  if( downlink_tail != downlink_head ) {
+    printf("ERROR: unexpected messages after download\n");
+    client.error = 1;
+  }
+
+  if( !client.error && memcmp(client.data, expected, TEST_FILE_SIZE) != 0 ) {
+    printf("ERROR: received data doesn't match\n");
+    client.error = 1;
+  }
+
+  float handler_s = (float)handler_clocks / CLOCKS_PER_SEC;
+  // full duplex: the direction with more traffic limits the transfer
+  u32 link_bytes = (down_bytes > up_bytes) ? down_bytes : up_bytes;
+  u32 link_packets = (down_usb_packets > up_usb_packets) ? down_usb_packets : up_usb_packets;
+  float uart_s = (float)link_bytes * 10.0 / 31250.0;
+  float usb_s = (float)link_packets / 16000.0;
+
+  printf("%-20s %s: %u bytes, %u retries, %u corrupted, %u duplicates\n",
+	 name, client.error ? "FAILED" : "ok", client.size, client.num_retries, client.num_corrupted, client.num_duplicates);
+  printf("  wire bytes: core->client %u (%.2f per payload byte), client->core %u\n",
+	 down_bytes, (float)down_bytes / TEST_FILE_SIZE, up_bytes);
+  printf("  handler CPU time: %.3f s (%.0f bytes/s)\n",
+	 handler_s, handler_s > 0 ? TEST_FILE_SIZE / handler_s : 0);
+  printf("  modeled UART 31250 baud: %.1f s (%.0f bytes/s), modeled USB MIDI: %.2f s (%.0f bytes/s)\n",
+	 uart_s, TEST_FILE_SIZE / uart_s, usb_s, TEST_FILE_SIZE / usb_s);
+
+  free(client.data);
+
+  return client.error ? -1 : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  int i;
+
+  verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+  // format the RAM disk and store the test file
+  disk = calloc(DISK_SECTORS, 512);
+
+  u8 *test_data = malloc(TEST_FILE_SIZE);
+  srand(1);
+  for(i=0; i<TEST_FILE_SIZE; ++i)
+    test_data[i] = rand();
+
+  {
+    FATFS fatfs;
+    FIL fil;
+    UINT written;
+    f_mount(0, &fatfs);
+    if( f_mkfs(0, 0, 0) != FR_OK ||
+	f_open(&fil, TEST_FILE, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK ||
+	f_write(&fil, test_data, TEST_FILE_SIZE, &written) != FR_OK ||
+	written != TEST_FILE_SIZE ||
+	f_close(&fil) != FR_OK ) {
+      printf("ERROR: failed to create test file\n");
+      return 1;
+    }
+    f_mount(0, NULL);
+  }
+
+  FILE_Init(0);
+  if( FILE_CheckSDCard() < 0 || !FILE_VolumeAvailable() ) {
+    printf("ERROR: failed to mount RAM disk\n");
+    return 1;
+  }
+
+  printf("Downloading %s with %d bytes (block size: %d, window: %d blocks)\n",
+	 TEST_FILE, TEST_FILE_SIZE, FILE_BROWSER_BIN_BLOCK_SIZE, FILE_BROWSER_BIN_WINDOW);
+
+  num_errors += run_download("text", 0, 0, 0, test_data) < 0;
+  num_errors += run_download("binary", 1, 0, 0, test_data) < 0;
+  num_errors += run_download("binary (dropped)", 1, 5, 0, test_data) < 0;
+  num_errors += run_download("binary (corrupted)", 1, 0, 7, test_data) < 0;
+  num_errors += run_download("binary (both)", 1, 3, 20, test_data) < 0;
+
+  return GNU_TEST_Result();
+}
@@ -34,6 +34,15 @@ u32 timeout_counter;
 //Short wait for glue logic
 #define GENESIS_SHORTWAIT { timeout_counter = 0; while(++timeout_counter <= (GENESIS_SHORTWAITTIME >> 2)); }
 
+#if GENESIS_WRITE_FIFO_SIZE
+//Write FIFO entries: bits 7:0 data, 15:8 address, 17:16 type (OPN2 addrhi or PSG)
+#define GENESIS_FIFO_PSG 2
+#define GENESIS_FIFO_MASK (GENESIS_WRITE_FIFO_SIZE - 1)
+//Maximum number of writes per board and timer tick (only writes without busy
+//time can follow each other)
+#define GENESIS_FIFO_MAX_WRITES 4
+#endif
+
 /////////////////////////////////////////////////////////////////////////////
 // Global variables
 /////////////////////////////////////////////////////////////////////////////
@@ -44,6 +53,23 @@ genesis_t genesis[GENESIS_COUNT];
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
 
+#if GENESIS_WRITE_FIFO_SIZE
+//The indices are free running, entries are written by Genesis_OPN2Write() and
+//Genesis_PSGWrite() and removed by the timer interrupt
+typedef struct {
+    u32 entry[GENESIS_WRITE_FIFO_SIZE];
+    volatile u16 rd;
+    volatile u16 wr;
+    u16 floor;              //Entries before this index can't be combined anymore
+    volatile u8 opn2_busy;  //Remaining busy time in us
+    volatile u8 psg_busy;
+    u16 slot[2][256];       //Index of the last queued write to each OPN2 register
+} genesis_fifo_t;
+
+static genesis_fifo_t genesis_fifo[GENESIS_COUNT];
+#endif
+
+static genesis_fifo_stats_t genesis_fifo_stats;
 
 /////////////////////////////////////////////////////////////////////////////
 // Lookup tables
@@ -65,7 +91,173 @@ static const u8 OPN2Ch3Regs[8] = {
 // Functions
 /////////////////////////////////////////////////////////////////////////////
 
+static void Genesis_OPN2BusWrite(u8 board, u8 addrhi, u8 address, u8 data){
+#if defined(MIOS32_FAMILY_EMULATION)
+    GENESISEMU_OPN2Write(board, addrhi, address, data);
+#else
+    MIOS32_IRQ_Disable(); //Turn off interrupts
+    GPIOE->MODER &= 0x0000FFFF; //Set data pins to inputs (in case not already)
+    u32 porte = GPIOE->ODR;
+    porte &= 0xFFFF000B; //Mask out the things we will set
+    u32 a = address;
+    a <<= 2; //Make room for board number
+    a |= board;
+    a <<= 2; //A2 = 0 for OPN2 write, A1 = addrhi
+    a |= addrhi;
+    a <<= 4; //Move over into place, A0 = 0 for address write
+    porte |= a; //Write to our temp copy
+    GPIOE->ODR = porte; //Write address bits and data
+    GPIOE->MODER |= 0x55550000; //Set data pins to outputs
+    GENESIS_SHORTWAIT;
+    GPIOC->ODR &= 0xFFFF5FFF; //Write /CS and /WR low
+    GENESIS_OPN2_WRITEWAIT; //Wait for 1 OPN2 internal cycle
+    GPIOC->ODR |= 0x0000A000; //Write /CS and /WR high
+    porte &= 0xFFFF00FF; //Get rid of address value
+    porte |= ((u32)data << 8); //Put in data value
+    porte |= 4; //A0 = 1 for data write
+    GPIOE->ODR = porte; //Write address bits and data
+    GENESIS_SHORTWAIT;
+    GPIOC->ODR &= 0xFFFF5FFF; //Write /CS and /WR low
+    GENESIS_OPN2_WRITEWAIT; //Wait for 1 OPN2 internal cycle
+    GPIOC->ODR |= 0x0000A000; //Write /CS and /WR high
+    GPIOE->MODER &= 0x0000FFFF; //Set data pins to inputs
+    MIOS32_IRQ_Enable(); //Turn on interrupts
+#endif
+}
+
+static void Genesis_PSGBusWrite(u8 board, u8 data){
+#if defined(MIOS32_FAMILY_EMULATION)
+    GENESISEMU_PSGWrite(board, data);
+#else
+    MIOS32_IRQ_Disable(); //Turn off interrupts
+    GPIOE->MODER &= 0x0000FFFF; //Set data pins to inputs (in case not already)
+    u32 porte = GPIOE->ODR;
+    porte &= 0xFFFF000B; //Mask out the things we will set
+    u32 a = data;
+    a <<= 2; //Make room for board number
+    a |= board;
+    a <<= 6; //Move into place
+    a |= 0x20; //A2 = 1 for PSG write, A1 = 0 for PSG not output bits, A0 = -
+    porte |= a; //Write to our temp copy
+    GPIOE->ODR = porte; //Write address bits and data
+    GPIOE->MODER |= 0x55550000; //Set data pins to outputs
+    GENESIS_SHORTWAIT;
+    GPIOC->ODR &= 0xFFFFDFFF; //Write /CS low
+    GENESIS_SHORTWAIT;
+    GPIOC->ODR &= 0xFFFF7FFF; //Write /WR low
+    GENESIS_PSG_WRITEWAIT; //Wait for the glue logic to catch up
+    GPIOC->ODR |= 0x00008000; //Write /WR high first to avoid race condition
+    GENESIS_SHORTWAIT;
+    GPIOC->ODR |= 0x00002000; //Now write /CS high to turn off bus drivers
+    GPIOE->MODER &= 0x0000FFFF; //Set data pins to inputs
+    MIOS32_IRQ_Enable(); //Turn on interrupts
+#endif
+}
+
+#if GENESIS_WRITE_FIFO_SIZE
+//Busy time after an OPN2 write. The global registers except key on don't need
+//one (same as in the VGM player).
+static u8 Genesis_OPN2BusyTime(u8 addrhi, u8 address){
+    if(!addrhi && address >= 0x20 && address < 0x2F && address != 0x28) return 0;
+    return GENESIS_OPN2_BUSY_US;
+}
+
+//Writes which must not be combined and must not be passed by a combined write:
+//timer control, key on, DAC data, and the frequency MSB latches (the latched
+//value only gets applied by the following LSB write)
+static u8 Genesis_OPN2IsBarrier(u8 addrhi, u8 address){
+    if(!addrhi && (address == 0x27 || address == 0x28 || address == 0x2A)) return 1;
+    return (address >= 0xA4 && address <= 0xA7) || (address >= 0xAC && address <= 0xAF);
+}
+
+//Writes the oldest queued write of a board to the bus. If the chip is still
+//busy, returns 0, or waits for it if sync is set. Entries are only removed
+//with interrupts disabled, so that no writer can combine into an entry which
+//is just being written.
+static u8 Genesis_FifoWriteNext(u8 board, u8 sync){
+    genesis_fifo_t *f = &genesis_fifo[board];
+    MIOS32_IRQ_Disable();
+    if(f->rd == f->wr){
+        MIOS32_IRQ_Enable();
+        return 0;
+    }
+    u32 entry = f->entry[f->rd & GENESIS_FIFO_MASK];
+    u8 type = (entry >> 16);
+    volatile u8 *busy = (type == GENESIS_FIFO_PSG) ? &f->psg_busy : &f->opn2_busy;
+    if(*busy){
+        if(!sync){
+            MIOS32_IRQ_Enable();
+            return 0;
+        }
+        MIOS32_DELAY_Wait_uS(*busy);
+    }
+    if(type == GENESIS_FIFO_PSG){
+        Genesis_PSGBusWrite(board, (u8)entry);
+        *busy = GENESIS_PSG_BUSY_US;
+    }else{
+        Genesis_OPN2BusWrite(board, type, (u8)(entry >> 8), (u8)entry);
+        *busy = Genesis_OPN2BusyTime(type, (u8)(entry >> 8));
+    }
+    //Not aligned to the timer, so the next tick counts less than a period
+    if(sync && *busy) *busy += GENESIS_WRITE_FIFO_PERIOD_US;
+    f->rd++;
+    genesis_fifo_stats.bus_writes++;
+    MIOS32_IRQ_Enable();
+    return 1;
+}
+
+//Appends an entry; if the FIFO is full, the oldest entry is written first.
+//Has to be called with interrupts disabled.
+static void Genesis_FifoPush(u8 board, u32 entry){
+    genesis_fifo_t *f = &genesis_fifo[board];
+    if((u16)(f->wr - f->rd) >= GENESIS_WRITE_FIFO_SIZE){
+        genesis_fifo_stats.overflows++;
+        Genesis_FifoWriteNext(board, 1);
+    }
+    f->entry[f->wr & GENESIS_FIFO_MASK] = entry;
+    f->wr++;
+    u16 level = f->wr - f->rd;
+    if(level > genesis_fifo_stats.max_level) genesis_fifo_stats.max_level = level;
+}
+
+static void Genesis_FifoOPN2Push(u8 board, u8 addrhi, u8 address, u8 data){
+    genesis_fifo_t *f = &genesis_fifo[board];
+    u32 entry = ((u32)addrhi << 16) | ((u32)address << 8) | data;
+    MIOS32_IRQ_Disable();
+    genesis_fifo_stats.writes++;
+    //Keep the combine limit within the queued entries
+    if((u16)(f->wr - f->floor) > (u16)(f->wr - f->rd)) f->floor = f->rd;
+    if(Genesis_OPN2IsBarrier(addrhi, address)){
+        Genesis_FifoPush(board, entry);
+        f->floor = f->wr;
+    }else{
+        //Still queued after the last barrier? The slot index may be stale,
+        //so also compare the type and register.
+        u16 s = f->slot[addrhi][address];
+        u32 *e = &f->entry[s & GENESIS_FIFO_MASK];
+        if((u16)(s - f->floor) < (u16)(f->wr - f->floor) && (*e & 0x3FF00) == (entry & 0x3FF00)){
+            *e = entry;
+            genesis_fifo_stats.combined++;
+        }else{
+            Genesis_FifoPush(board, entry);
+            f->slot[addrhi][address] = f->wr - 1;
+        }
+    }
+    MIOS32_IRQ_Enable();
+}
+
+//PSG writes are never combined, since the data bytes depend on the latched
+//register
+static void Genesis_FifoPSGPush(u8 board, u8 data){
+    MIOS32_IRQ_Disable();
+    genesis_fifo_stats.writes++;
+    Genesis_FifoPush(board, ((u32)GENESIS_FIFO_PSG << 16) | data);
+    MIOS32_IRQ_Enable();
+}
+#endif
+
 void Genesis_Init(){
+#if !defined(MIOS32_FAMILY_EMULATION)
     //========Set up GPIO (General Purpose Input/Output)
     /*
     MBHP_Genesis:J10    CORE_STM32F4    STM32F4
@@ -102,6 +294,10 @@ void Genesis_Init(){
     GPIOC->OTYPER &= 0xFFFF1FFF;    //Set all to push-pull
     GPIOC->OSPEEDR |= 0xFC000000;   //GOTTA GO FAST
     GPIOC->PUPDR &= 0x03FFFFFF;     //Turn off all pull-ups
+#endif
+#if GENESIS_WRITE_FIFO_SIZE
+    MIOS32_TIMER_Init(GENESIS_WRITE_FIFO_TIMER, GENESIS_WRITE_FIFO_PERIOD_US, Genesis_WriteFifoService, MIOS32_IRQ_PRIO_MID);
+#endif
     //Reset all (also resets internal chip state)
     u8 i;
     for(i=0; i<GENESIS_COUNT; i++){
@@ -157,34 +353,13 @@ void Genesis_OPN2Write(u8 board, u8 addrhi, u8 address, u8 data){
             genesis[board].opn2.chan[chan].ALL[reg] = data;
         }
     }//else { not a register; }
-    //Perform chip write
-    MIOS32_IRQ_Disable(); //Turn off interrupts
-    GPIOE->MODER &= 0x0000FFFF; //Set data pins to inputs (in case not already)
-    u32 porte = GPIOE->ODR;
-    porte &= 0xFFFF000B; //Mask out the things we will set
-    u32 a = address;
-    a <<= 2; //Make room for board number
-    a |= board;
-    a <<= 2; //A2 = 0 for OPN2 write, A1 = addrhi
-    a |= addrhi;
-    a <<= 4; //Move over into place, A0 = 0 for address write
-    porte |= a; //Write to our temp copy
-    GPIOE->ODR = porte; //Write address bits and data
-    GPIOE->MODER |= 0x55550000; //Set data pins to outputs
-    GENESIS_SHORTWAIT;
-    GPIOC->ODR &= 0xFFFF5FFF; //Write /CS and /WR low
-    GENESIS_OPN2_WRITEWAIT; //Wait for 1 OPN2 internal cycle
-    GPIOC->ODR |= 0x0000A000; //Write /CS and /WR high
-    porte &= 0xFFFF00FF; //Get rid of address value
-    porte |= ((u32)data << 8); //Put in data value
-    porte |= 4; //A0 = 1 for data write
-    GPIOE->ODR = porte; //Write address bits and data
-    GENESIS_SHORTWAIT;
-    GPIOC->ODR &= 0xFFFF5FFF; //Write /CS and /WR low
-    GENESIS_OPN2_WRITEWAIT; //Wait for 1 OPN2 internal cycle
-    GPIOC->ODR |= 0x0000A000; //Write /CS and /WR high
-    GPIOE->MODER &= 0x0000FFFF; //Set data pins to inputs
-    MIOS32_IRQ_Enable(); //Turn on interrupts
+#if GENESIS_WRITE_FIFO_SIZE
+    Genesis_FifoOPN2Push(board, addrhi, address, data);
+#else
+    genesis_fifo_stats.writes++;
+    genesis_fifo_stats.bus_writes++;
+    Genesis_OPN2BusWrite(board, addrhi, address, data);
+#endif
 }
 
 void Genesis_PSGWrite(u8 board, u8 data){
@@ -217,39 +392,27 @@ void Genesis_PSGWrite(u8 board, u8 data){
             genesis[board].psg.square[voice].freq = (genesis[board].psg.square[voice].freq & 0x000F) | ((u16)(data & 0x3F) << 4);
         }
     }
-    //Perform chip write
-    MIOS32_IRQ_Disable(); //Turn off interrupts
-    GPIOE->MODER &= 0x0000FFFF; //Set data pins to inputs (in case not already)
-    u32 porte = GPIOE->ODR;
-    porte &= 0xFFFF000B; //Mask out the things we will set
-    u32 a = data;
-    a <<= 2; //Make room for board number
-    a |= board;
-    a <<= 6; //Move into place
-    a |= 0x20; //A2 = 1 for PSG write, A1 = 0 for PSG not output bits, A0 = -
-    porte |= a; //Write to our temp copy
-    GPIOE->ODR = porte; //Write address bits and data
-    GPIOE->MODER |= 0x55550000; //Set data pins to outputs
-    GENESIS_SHORTWAIT;
-    GPIOC->ODR &= 0xFFFFDFFF; //Write /CS low
-    GENESIS_SHORTWAIT;
-    GPIOC->ODR &= 0xFFFF7FFF; //Write /WR low
-    GENESIS_PSG_WRITEWAIT; //Wait for the glue logic to catch up
-    GPIOC->ODR |= 0x00008000; //Write /WR high first to avoid race condition
-    GENESIS_SHORTWAIT;
-    GPIOC->ODR |= 0x00002000; //Now write /CS high to turn off bus drivers
-    GPIOE->MODER &= 0x0000FFFF; //Set data pins to inputs
-    MIOS32_IRQ_Enable(); //Turn on interrupts
+#if GENESIS_WRITE_FIFO_SIZE
+    Genesis_FifoPSGPush(board, data);
+#else
+    genesis_fifo_stats.writes++;
+    genesis_fifo_stats.bus_writes++;
+    Genesis_PSGBusWrite(board, data);
+#endif
 }
 
 u8 Genesis_CheckOPN2Busy(u8 board){
     board &= 0x03;
+    Genesis_WriteFifoFlush(board);
     if(genesis[board].opn2.test_readdat){
         //Switch back to read status mode
         genesis[board].opn2.test_readdat = 0;
-        Genesis_OPN2Write(board, 0, 0x21, genesis[board].opn2.testreg21);
+        Genesis_OPN2BusWrite(board, 0, 0x21, genesis[board].opn2.testreg21);
         //Don't wait for busy
     }
+#if defined(MIOS32_FAMILY_EMULATION)
+    return 0;
+#else
     MIOS32_IRQ_Disable(); //Turn off interrupts
     GPIOE->MODER &= 0x0000FFFF; //Set data pins to inputs (in case not already)
     u32 porte = GPIOE->ODR;
@@ -265,10 +428,15 @@ u8 Genesis_CheckOPN2Busy(u8 board){
     GPIOC->ODR |= 0x00006000; //Write /CS and /RD high
     MIOS32_IRQ_Enable(); //Turn on interrupts
     return ((res & 0x80) > 0);
+#endif
 }
 
 u8 Genesis_CheckPSGBusy(u8 board){
     board &= 0x03;
+    Genesis_WriteFifoFlush(board);
+#if defined(MIOS32_FAMILY_EMULATION)
+    return 0;
+#else
     MIOS32_IRQ_Disable(); //Turn off interrupts
     GPIOE->MODER &= 0x0000FFFF; //Set data pins to inputs (in case not already)
     u32 porte = GPIOE->ODR;
@@ -285,10 +453,13 @@ u8 Genesis_CheckPSGBusy(u8 board){
     GPIOC->ODR |= 0x00006000; //Write /CS and /RD high
     MIOS32_IRQ_Enable(); //Turn on interrupts
     return !(genesis[board].board.psg_ready);
+#endif
 }
 
 void Genesis_WriteBoardBits(u8 board){
     board &= 0x03;
+    Genesis_WriteFifoFlush(board);
+#if !defined(MIOS32_FAMILY_EMULATION)
     MIOS32_IRQ_Disable(); //Turn off interrupts
     GPIOE->MODER &= 0x0000FFFF; //Set data pins to inputs (in case not already)
     u32 porte = GPIOE->ODR;
@@ -311,10 +482,20 @@ void Genesis_WriteBoardBits(u8 board){
     GPIOC->ODR |= 0x00002000; //Now write /CS high to turn off bus drivers
     GPIOE->MODER &= 0x0000FFFF; //Set data pins to inputs
     MIOS32_IRQ_Enable(); //Turn on interrupts
+#endif
 }
 
 void Genesis_Reset(u8 board){
     board &= 0x03;
+#if GENESIS_WRITE_FIFO_SIZE
+    //Queued writes would be lost by the reset anyway
+    MIOS32_IRQ_Disable();
+    genesis_fifo[board].rd = genesis_fifo[board].wr;
+    genesis_fifo[board].floor = genesis_fifo[board].wr;
+    genesis_fifo[board].opn2_busy = 0;
+    genesis_fifo[board].psg_busy = 0;
+    MIOS32_IRQ_Enable();
+#endif
     //Clear internal state
     u8 i;
     for(i=0; i<154; i++){
@@ -345,7 +526,40 @@ void Genesis_Reset(u8 board){
     Genesis_PSGWrite(board, 0b11111111); MIOS32_DELAY_Wait_uS(20);
 }
 
+void Genesis_WriteFifoService(){
+#if GENESIS_WRITE_FIFO_SIZE
+    u8 board, n;
+    for(board=0; board<GENESIS_COUNT; board++){
+        genesis_fifo_t *f = &genesis_fifo[board];
+        f->opn2_busy = (f->opn2_busy > GENESIS_WRITE_FIFO_PERIOD_US) ? (f->opn2_busy - GENESIS_WRITE_FIFO_PERIOD_US) : 0;
+        f->psg_busy = (f->psg_busy > GENESIS_WRITE_FIFO_PERIOD_US) ? (f->psg_busy - GENESIS_WRITE_FIFO_PERIOD_US) : 0;
+        if(f->rd == f->wr) continue;
+        for(n=0; n<GENESIS_FIFO_MAX_WRITES; n++){
+            if(!Genesis_FifoWriteNext(board, 0)) break;
+        }
+    }
+#endif
+}
 
+void Genesis_WriteFifoFlush(u8 board){
+#if GENESIS_WRITE_FIFO_SIZE
+    board &= 0x03;
+    while(Genesis_FifoWriteNext(board, 1));
+#endif
+}
 
+void Genesis_WriteFifoStatsGet(genesis_fifo_stats_t *stats){
+    MIOS32_IRQ_Disable();
+    *stats = genesis_fifo_stats;
+    MIOS32_IRQ_Enable();
+}
 
-
+void Genesis_WriteFifoStatsClear(){
+    MIOS32_IRQ_Disable();
+    genesis_fifo_stats.writes = 0;
+    genesis_fifo_stats.bus_writes = 0;
+    genesis_fifo_stats.combined = 0;
+    genesis_fifo_stats.overflows = 0;
+    genesis_fifo_stats.max_level = 0;
+    MIOS32_IRQ_Enable();
+}
@@ -25,7 +25,7 @@ extern "C" {
 // Global definitions
 /////////////////////////////////////////////////////////////////////////////
 
-#if !defined(MIOS32_BOARD_STM32F4DISCOVERY) && !defined(MIOS32_BOARD_MBHP_CORE_STM32F4)
+#if !defined(MIOS32_BOARD_STM32F4DISCOVERY) && !defined(MIOS32_BOARD_MBHP_CORE_STM32F4) && !defined(MIOS32_FAMILY_EMULATION)
 #error "MBHP_Genesis module only supported for STM32F4 MCU!"
 #endif
 
@@ -54,6 +54,45 @@ OPN2 Timeout Test Results
 #define GENESIS_RESETTIMEOUTUS 1000
 #endif
 
+/*
+Write FIFO
+If GENESIS_WRITE_FIFO_SIZE is not 0, Genesis_OPN2Write() and Genesis_PSGWrite()
+only update the chip state and put the write into a FIFO of this size (power of
+2) per board. The FIFOs are drained by a MIOS32_TIMER interrupt, which keeps
+the chips' busy times. A write to an OPN2 register which is still waiting in
+the FIFO replaces the queued value (see Readme.txt).
+0: writes go to the bus immediately, timing is done by the application
+*/
+#ifndef GENESIS_WRITE_FIFO_SIZE
+#define GENESIS_WRITE_FIFO_SIZE 0
+#endif
+
+#ifndef GENESIS_WRITE_FIFO_TIMER
+#define GENESIS_WRITE_FIFO_TIMER 2
+#endif
+
+#ifndef GENESIS_WRITE_FIFO_PERIOD_US
+#define GENESIS_WRITE_FIFO_PERIOD_US 10
+#endif
+
+//Busy times used by the write FIFO, same as VGMP_OPN2BUSYDELAY and
+//VGMP_PSGBUSYDELAY of the MIDIbox Genesis Tracker
+#ifndef GENESIS_OPN2_BUSY_US
+#define GENESIS_OPN2_BUSY_US 50
+#endif
+
+#ifndef GENESIS_PSG_BUSY_US
+#define GENESIS_PSG_BUSY_US 16
+#endif
+
+#if GENESIS_WRITE_FIFO_SIZE & (GENESIS_WRITE_FIFO_SIZE - 1) || GENESIS_WRITE_FIFO_SIZE > 1024
+#error "GENESIS_WRITE_FIFO_SIZE has to be 0 or a power of 2 up to 1024"
+#endif
+
+#if GENESIS_OPN2_BUSY_US + GENESIS_WRITE_FIFO_PERIOD_US > 255 || GENESIS_PSG_BUSY_US + GENESIS_WRITE_FIFO_PERIOD_US > 255
+#error "GENESIS_*_BUSY_US + GENESIS_WRITE_FIFO_PERIOD_US have to be below 256"
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -409,6 +448,14 @@ typedef union {
     };
 } genesis_t;
 
+typedef struct {
+    u32 writes;     //Calls of Genesis_OPN2Write() and Genesis_PSGWrite()
+    u32 bus_writes; //Writes done on the bus
+    u32 combined;   //Writes which replaced a queued write to the same register
+    u32 overflows;  //Writes which had to wait for a full FIFO
+    u16 max_level;  //Highest number of queued writes of a board
+} genesis_fifo_stats_t;
+
 //Sample use cases of these data structures:
 //u8 is_ssg_toggle = genesis[3].opn2.chan[4].op[0].ssg_toggle;
 //u16 psg_freq = genesis[2].psg.square[1].freq;
@@ -449,6 +496,23 @@ extern void Genesis_Reset(u8 board);
 // after e.g. changing filter capacitor settings.
 extern void Genesis_WriteBoardBits(u8 board);
 
+// Drains the write FIFOs, called periodically by the MIOS32_TIMER.
+extern void Genesis_WriteFifoService(void);
+
+// Waits until all queued writes of a board have been done. Interrupts are
+// disabled for up to one busy time per write.
+extern void Genesis_WriteFifoFlush(u8 board);
+
+// Write FIFO statistics.
+extern void Genesis_WriteFifoStatsGet(genesis_fifo_stats_t *stats);
+extern void Genesis_WriteFifoStatsClear(void);
+
+#if defined(MIOS32_FAMILY_EMULATION)
+// Bus writes are forwarded to these functions, they have to be provided by the emulation
+extern void GENESISEMU_OPN2Write(u8 board, u8 addrhi, u8 address, u8 data);
+extern void GENESISEMU_PSGWrite(u8 board, u8 data);
+#endif
+
 
 
 #ifdef __cplusplus
@@ -0,0 +1,404 @@
+// $Id$
+/*
+ * Host test for the Genesis write FIFO
+ *
+ * Bus writes are captured by GENESISEMU_OPN2Write()/GENESISEMU_PSGWrite()
+ * into a simulated bus with one OPN2 register file per board. The timer
+ * interrupt is simulated by calling Genesis_WriteFifoService() each
+ * GENESIS_WRITE_FIFO_PERIOD_US of simulated time, MIOS32_DELAY_Wait_uS()
+ * advances the simulated time. The test checks that:
+ *   - genesis[board] is updated before the write reaches the bus
+ *   - no bus write is done while the chip is still busy
+ *   - barrier writes (key on, DAC, frequency latches...) reach the bus in
+ *     order, with exactly the register state which was written before them
+ *   - PSG writes reach the bus unchanged and in order
+ *   - the register files match all writes at the end, and the statistics
+ *     add up
+ *   - writers only do bus writes when the FIFO is full
+ * The time during which the writers disable interrupts is printed to stderr.
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define GNU_TEST_OWN_IRQ
+#define GNU_TEST_OWN_DELAY
+#include <gnu_test.h>
+
+#include "genesis.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// simulated time and interrupts
+/////////////////////////////////////////////////////////////////////////////
+#define CTX_WRITER 0
+#define CTX_TIMER  1
+#define CTX_FLUSH  2
+
+static u32 sim_us;
+static int ctx;
+static void (*timer_callback)(void);
+
+static int irq_nested;
+static uint64_t irq_start_ns;
+static uint64_t irq_off_ns[3];
+static uint64_t irq_off_max_ns[3];
+static u32 irq_off_sections[3];
+
+static uint64_t now_ns(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+
+s32 MIOS32_IRQ_Disable(void)
+{
+  if( !irq_nested++ )
+    irq_start_ns = now_ns();
+  return 0;
+}
+
+s32 MIOS32_IRQ_Enable(void)
+{
+  if( !--irq_nested ) {
+    uint64_t ns = now_ns() - irq_start_ns;
+    irq_off_ns[ctx] += ns;
+    if( ns > irq_off_max_ns[ctx] )
+      irq_off_max_ns[ctx] = ns;
+    ++irq_off_sections[ctx];
+  }
+  return 0;
+}
+
+s32 MIOS32_DELAY_Wait_uS(u16 uS)
+{
+  sim_us += uS;
+  return 0;
+}
+
+s32 MIOS32_TIMER_Init(u8 timer, u32 period, void (*_irq_handler)(void), u8 irq_priority)
+{
+  CHECK(period == GENESIS_WRITE_FIFO_PERIOD_US, "timer period %u", (unsigned)period);
+  timer_callback = _irq_handler;
+  return 0;
+}
+
+static void tick(void)
+{
+  int prev_ctx = ctx;
+  sim_us += GENESIS_WRITE_FIFO_PERIOD_US;
+  ctx = CTX_TIMER;
+  timer_callback();
+  ctx = prev_ctx;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// simulated bus and reference model
+/////////////////////////////////////////////////////////////////////////////
+#define MAX_EXPECTED 100000
+
+typedef struct {
+  u8  addrhi;
+  u8  address;
+  u8  data;
+  u32 hash; // register state before the barrier
+} barrier_t;
+
+typedef struct {
+  // bus side
+  u8  regs[512];
+  u32 opn2_free_us;
+  u32 psg_free_us;
+  // model side
+  u8  model[512];
+  barrier_t *barriers;
+  u32 num_barriers;
+  u32 next_barrier;
+  u8  *psg;
+  u32 num_psg;
+  u32 next_psg;
+  u32 reset_psg;
+} sim_board_t;
+
+static sim_board_t sim[GENESIS_COUNT];
+static u32 writer_bus_writes;
+static int model_enabled; // the PSG reset writes of Genesis_Init() aren't part of the model
+
+static u32 hash_regs(const u8 *regs)
+{
+  u32 hash = 2166136261u; // FNV-1a
+  int i;
+  for(i=0; i<512; ++i) {
+    hash ^= regs[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// same as in the driver: frequency latches and key on/timer/DAC writes
+static int is_barrier(u8 addrhi, u8 address)
+{
+  if( !addrhi && (address == 0x27 || address == 0x28 || address == 0x2a) )
+    return 1;
+  return (address >= 0xa4 && address <= 0xa7) || (address >= 0xac && address <= 0xaf);
+}
+
+void GENESISEMU_OPN2Write(u8 board, u8 addrhi, u8 address, u8 data)
+{
+  sim_board_t *b = &sim[board];
+
+  CHECK(irq_nested, "OPN2 bus write with interrupts enabled");
+  CHECK(sim_us >= b->opn2_free_us, "board %d: OPN2 write %d:%02x at %u us, busy until %u us",
+	board, addrhi, address, (unsigned)sim_us, (unsigned)b->opn2_free_us);
+  if( ctx == CTX_WRITER )
+    ++writer_bus_writes;
+
+  if( is_barrier(addrhi, address) ) {
+    if( b->next_barrier >= b->num_barriers ) {
+      CHECK(0, "board %d: unexpected barrier %d:%02x", board, addrhi, address);
+    } else {
+      barrier_t *e = &b->barriers[b->next_barrier++];
+      CHECK(e->addrhi == addrhi && e->address == address && e->data == data,
+	    "board %d: barrier %u is %d:%02x=%02x, expected %d:%02x=%02x", board, (unsigned)b->next_barrier-1,
+	    addrhi, address, data, e->addrhi, e->address, e->data);
+      CHECK(e->hash == hash_regs(b->regs), "board %d: register state differs at barrier %u", board, (unsigned)b->next_barrier-1);
+    }
+  }
+
+  b->regs[addrhi*256 + address] = data;
+  b->opn2_free_us = sim_us + ((!addrhi && address >= 0x20 && address < 0x2f && address != 0x28) ? 0 : GENESIS_OPN2_BUSY_US);
+}
+
+void GENESISEMU_PSGWrite(u8 board, u8 data)
+{
+  sim_board_t *b = &sim[board];
+
+  CHECK(irq_nested, "PSG bus write with interrupts enabled");
+  CHECK(sim_us >= b->psg_free_us, "board %d: PSG write at %u us, busy until %u us",
+	board, (unsigned)sim_us, (unsigned)b->psg_free_us);
+  if( ctx == CTX_WRITER )
+    ++writer_bus_writes;
+
+  if( !model_enabled ) {
+    ++b->reset_psg;
+  } else if( b->next_psg >= b->num_psg ) {
+    CHECK(0, "board %d: unexpected PSG write %02x", board, data);
+  } else {
+    CHECK(b->psg[b->next_psg] == data, "board %d: PSG write %u is %02x, expected %02x",
+	  board, (unsigned)b->next_psg, data, b->psg[b->next_psg]);
+    ++b->next_psg;
+  }
+
+  b->psg_free_us = sim_us + GENESIS_PSG_BUSY_US;
+}
+
+static void opn2_write(u8 board, u8 addrhi, u8 address, u8 data)
+{
+  sim_board_t *b = &sim[board];
+
+  if( is_barrier(addrhi, address) && b->num_barriers < MAX_EXPECTED ) {
+    barrier_t *e = &b->barriers[b->num_barriers++];
+    e->addrhi = addrhi;
+    e->address = address;
+    e->data = data;
+    e->hash = hash_regs(b->model);
+  }
+  b->model[addrhi*256 + address] = data;
+
+  Genesis_OPN2Write(board, addrhi, address, data);
+
+  // the chip state is updated immediately
+  if( address >= 0xb0 && address <= 0xb2 )
+    CHECK(genesis[board].opn2.chan[addrhi*3 + (address & 3)].ALL[2] == data,
+	  "board %d: chip state of %d:%02x not updated", board, addrhi, address);
+}
+
+static void psg_write(u8 board, u8 data)
+{
+  sim_board_t *b = &sim[board];
+
+  if( b->num_psg < MAX_EXPECTED )
+    b->psg[b->num_psg++] = data;
+
+  Genesis_PSGWrite(board, data);
+
+  if( (data & 0x90) == 0x90 )
+    CHECK(genesis[board].psg.voice[(data >> 5) & 3].atten == (data & 0x0f),
+	  "board %d: PSG attenuation not updated", board);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// workload
+/////////////////////////////////////////////////////////////////////////////
+static u32 rnd_state = 12345;
+
+static u32 rnd(u32 range)
+{
+  rnd_state = rnd_state * 1103515245 + 12345;
+  return (rnd_state >> 16) % range;
+}
+
+// one random register write like done by a synth engine or VGM file
+static void random_write(u8 board)
+{
+  u8 addrhi = rnd(2);
+  u8 chan = rnd(3);
+
+  switch( rnd(10) ) {
+  case 0: // key on/off
+    opn2_write(board, 0, 0x28, (rnd(16) << 4) | (addrhi << 2) | chan);
+    break;
+  case 1: // frequency: MSB latch, then LSB
+    opn2_write(board, addrhi, 0xa4 + chan, rnd(64));
+    opn2_write(board, addrhi, 0xa0 + chan, rnd(256));
+    break;
+  case 2: // DAC
+    opn2_write(board, 0, 0x2a, rnd(256));
+    break;
+  case 3: // global registers
+    opn2_write(board, 0, 0x22 + rnd(2)*9, rnd(256));
+    break;
+  case 4: // algorithm/feedback, panning
+    opn2_write(board, addrhi, 0xb0 + rnd(2)*4 + chan, rnd(256));
+    break;
+  case 5: // PSG attenuation
+    psg_write(board, 0x90 | (rnd(4) << 5) | rnd(16));
+    break;
+  case 6: // PSG frequency
+    psg_write(board, 0x80 | (rnd(3) << 5) | rnd(16));
+    psg_write(board, rnd(64));
+    break;
+  default: // operator registers
+    opn2_write(board, addrhi, 0x30 + rnd(7)*16 + rnd(2)*8 + rnd(2)*4 + chan, rnd(256));
+  }
+}
+
+static void drain(void)
+{
+  int i, board;
+  for(i=0; i<10000; ++i)
+    tick();
+  ctx = CTX_FLUSH;
+  for(board=0; board<GENESIS_COUNT; ++board)
+    Genesis_WriteFifoFlush(board);
+  ctx = CTX_WRITER;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  int i, board;
+  genesis_fifo_stats_t stats;
+
+  for(board=0; board<GENESIS_COUNT; ++board) {
+    sim[board].barriers = calloc(MAX_EXPECTED, sizeof(barrier_t));
+    sim[board].psg = calloc(MAX_EXPECTED, 1);
+  }
+
+  ctx = CTX_FLUSH;
+  Genesis_Init();
+  CHECK(timer_callback != NULL, "timer not initialized");
+  // the first queued entry is a PSG write, an OPN2 write to 0:00 must not replace it
+  opn2_write(0, 0, 0x00, 0x55);
+  for(board=0; board<GENESIS_COUNT; ++board) {
+    Genesis_WriteFifoFlush(board);
+    CHECK(sim[board].reset_psg == 11, "board %d: %u PSG reset writes", board, (unsigned)sim[board].reset_psg);
+  }
+  CHECK(sim[0].regs[0x00] == 0x55, "OPN2 write to 0:00 missing");
+  model_enabled = 1;
+  ctx = CTX_WRITER;
+  Genesis_WriteFifoStatsClear();
+  for(i=0; i<3; ++i)
+    irq_off_ns[i] = irq_off_max_ns[i] = irq_off_sections[i] = 0;
+
+  // 1: random writes below the bus capacity, with a burst (patch change) now and then
+  for(i=0; i<200000; ++i) {
+    if( !rnd(16) )
+      random_write(rnd(GENESIS_COUNT));
+    if( (i % 5000) == 0 ) {
+      int n;
+      board = rnd(GENESIS_COUNT);
+      for(n=0; n<20; ++n)
+	random_write(board);
+    }
+    tick();
+  }
+  Genesis_WriteFifoStatsGet(&stats);
+  CHECK(stats.overflows == 0, "%u overflows below the bus capacity", (unsigned)stats.overflows);
+  CHECK(writer_bus_writes == 0, "%u bus writes by the writer", (unsigned)writer_bus_writes);
+
+  // 2: volume/panning sweeps which are faster than the bus, they have to be combined
+  for(i=0; i<20000; ++i) {
+    for(board=0; board<GENESIS_COUNT; ++board) {
+      opn2_write(board, i & 1, 0x40 + (i % 3), i & 0x7f);
+      opn2_write(board, 0, 0xb4, i & 0xc0);
+      if( (i % 64) == 0 )
+	opn2_write(board, 0, 0x28, 0xf0 | (i % 3));
+    }
+    tick();
+  }
+  Genesis_WriteFifoStatsGet(&stats);
+  CHECK(stats.combined > 0, "no writes combined");
+  CHECK(stats.overflows == 0, "%u overflows with combined writes", (unsigned)stats.overflows);
+  CHECK(writer_bus_writes == 0, "%u bus writes by the writer", (unsigned)writer_bus_writes);
+
+  // 3: Genesis_CheckOPN2Busy() flushes the FIFO of the board
+  for(i=0; i<30; ++i)
+    random_write(1);
+  ctx = CTX_FLUSH;
+  Genesis_CheckOPN2Busy(1);
+  ctx = CTX_WRITER;
+  CHECK(memcmp(sim[1].regs, sim[1].model, 512) == 0, "registers differ after Genesis_CheckOPN2Busy()");
+  CHECK(sim[1].next_psg == sim[1].num_psg, "PSG writes missing after Genesis_CheckOPN2Busy()");
+
+  // 4: bursts which don't fit into the FIFO: the oldest entries are written by the writer
+  for(i=0; i<1000; ++i) {
+    random_write(2);
+    random_write(3);
+  }
+  Genesis_WriteFifoStatsGet(&stats);
+  CHECK(stats.overflows > 0, "no overflows");
+  CHECK(writer_bus_writes == stats.overflows, "%u bus writes by the writer, but %u overflows",
+	(unsigned)writer_bus_writes, (unsigned)stats.overflows);
+
+  // everything has to arrive
+  drain();
+  for(board=0; board<GENESIS_COUNT; ++board) {
+    sim_board_t *b = &sim[board];
+    CHECK(memcmp(b->regs, b->model, 512) == 0, "board %d: final registers differ", board);
+    CHECK(b->next_barrier == b->num_barriers, "board %d: %u of %u barriers written",
+	  board, (unsigned)b->next_barrier, (unsigned)b->num_barriers);
+    CHECK(b->next_psg == b->num_psg, "board %d: %u of %u PSG writes done",
+	  board, (unsigned)b->next_psg, (unsigned)b->num_psg);
+  }
+
+  Genesis_WriteFifoStatsGet(&stats);
+  CHECK(stats.writes == stats.bus_writes + stats.combined, "statistics: %u writes, %u bus writes, %u combined",
+	(unsigned)stats.writes, (unsigned)stats.bus_writes, (unsigned)stats.combined);
+  CHECK(stats.max_level <= GENESIS_WRITE_FIFO_SIZE, "max. level %u", stats.max_level);
+  CHECK(irq_nested == 0, "interrupts still disabled");
+
+  fprintf(stderr, "%u writes, %u bus writes, %u combined, %u overflows, max. level %u\n",
+	  (unsigned)stats.writes, (unsigned)stats.bus_writes, (unsigned)stats.combined,
+	  (unsigned)stats.overflows, stats.max_level);
+  fprintf(stderr, "interrupts disabled by writers: %u sections, avg %u ns, max %u ns (host, includes the overflow writes)\n",
+	  (unsigned)irq_off_sections[CTX_WRITER],
+	  (unsigned)(irq_off_ns[CTX_WRITER] / (irq_off_sections[CTX_WRITER] ? irq_off_sections[CTX_WRITER] : 1)),
+	  (unsigned)irq_off_max_ns[CTX_WRITER]);
+  fprintf(stderr, "interrupts disabled by the timer: %u sections, avg %u ns, max %u ns (host, includes the simulated bus)\n",
+	  (unsigned)irq_off_sections[CTX_TIMER],
+	  (unsigned)(irq_off_ns[CTX_TIMER] / (irq_off_sections[CTX_TIMER] ? irq_off_sections[CTX_TIMER] : 1)),
+	  (unsigned)irq_off_max_ns[CTX_TIMER]);
+
+  return GNU_TEST_Result();
+}
@@ -0,0 +1,12 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host test
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+#define GENESIS_COUNT 4
+#define GENESIS_WRITE_FIFO_SIZE 64
+
+#endif /* _MIOS32_CONFIG_H */
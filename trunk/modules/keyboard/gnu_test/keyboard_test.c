@@ -0,0 +1,446 @@
+// $Id$
+/*
+ * Host test for the keyboard handler
+ *
+ * Replays scan traces of key strokes (break and make contact timings,
+ * optionally with bouncing make contacts) through an emulated 8x16 matrix:
+ *   - the SRIO scan latches the DIN values of the row which has been
+ *     selected by the previous KEYBOARD_SRIO_ServicePrepare() call
+ *   - KEYBOARD_Periodic_1mS() is called after 1 mS worth of scans
+ *
+ * The received MIDI notes are compared against the velocities which are
+ * expected from the scan numbers at which the contacts were seen.
+ *
+ * With a small event queue (keyboard_test_q8) only the overrun handling
+ * is checked: all notes have to be switched off again.
+ *
+ * Build and run with "make test"
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gnu_test.h>
+
+#include "keyboard.h"
+
+#define SCAN_PERIOD_US   20 // one row per scan
+#define SCANS_PER_MS     (1000 / SCAN_PERIOD_US)
+#define NUM_ROWS         8
+#define NUM_KEYS         64
+#define NOTE_OFFSET      36
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Scan traces
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  u8  key;
+  u32 t_break;          // break contact pressed (uS)
+  u32 t_make;           // make contact pressed
+  u32 t_make_release;   // make contact released
+  u32 t_break_release;  // break contact released
+  u32 bounce_us;        // make contact bounces (20 uS period) for the given time
+} stroke_t;
+
+#if KEYBOARD_EVENT_QUEUE_SIZE >= 64
+// single keys with different speeds, chords, overlapping keys
+static const stroke_t trace_velocity[] = {
+  {  0,   1000,   2200,  50000,  52000, 0 },
+  {  9,  60000,  61000, 100000, 101000, 0 },
+  { 17,  60000,  68000, 120000, 125000, 0 },
+  { 25, 130000, 130400, 150000, 150300, 0 },
+  { 33, 130050, 131000, 151000, 152000, 0 },
+  { 40, 130100, 133500, 160000, 163000, 0 },
+  { 63, 130150, 145000, 170000, 178000, 0 },
+  {  5, 200000, 200800, 300000, 301000, 0 },
+  {  5, 310000, 325000, 400000, 402000, 0 },
+  { 31, 250000, 251000, 260000, 261000, 0 },
+  { 32, 250000, 255000, 270000, 271000, 0 },
+};
+
+// make contacts are bouncing
+static const stroke_t trace_bounce[] = {
+  {  2,   1000,   3000,  50000,  52000, 200 },
+  { 12,  60000,  62000,  90000,  91000, 500 },
+  { 44,  60100,  66000,  95000,  97000, 100 },
+  { 50, 100000, 100300, 140000, 140500, 300 },
+};
+#endif
+
+// a lot of keys at the same time
+static stroke_t trace_chords[NUM_KEYS];
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Matrix emulation
+/////////////////////////////////////////////////////////////////////////////
+
+static const stroke_t *trace;
+static int trace_len;
+static u32 now_us;
+
+static int selected_row = 0xff; // written by DOUT_SRSet, becomes active after scan
+static int active_row = 0xff;
+static u8  din_sr[2];
+
+static int key_column(int key) { return ((key >= 32) ? 8 : 0) + (key % 8); }
+static int key_make_row(int key) { return 2*((key % 32) / 8); }
+
+// 1 if contact is pressed
+static int contact_pressed(const stroke_t *s, int break_contact, u32 t)
+{
+  if( break_contact )
+    return t >= s->t_break && t < s->t_break_release;
+
+  if( t < s->t_make || t >= s->t_make_release )
+    return 0;
+
+  if( t < (s->t_make + s->bounce_us) )
+    return (((t - s->t_make) / 20) % 2) == 0;
+
+  return 1;
+}
+
+// first scan number at which a contact has been seen pressed/released
+static u16 seen_break[sizeof(trace_chords)/sizeof(stroke_t)];
+static u16 seen_make[sizeof(trace_chords)/sizeof(stroke_t)];
+static u16 seen_make_release[sizeof(trace_chords)/sizeof(stroke_t)];
+static u16 seen_break_release[sizeof(trace_chords)/sizeof(stroke_t)];
+static u16 scan_ctr;
+
+static void scan_row(void)
+{
+  u16 value = 0xffff;
+  int i;
+
+  if( active_row < NUM_ROWS ) {
+    for(i=0; i<trace_len; ++i) {
+      const stroke_t *s = &trace[i];
+      int break_contact = active_row & 1;
+
+      if( active_row != (key_make_row(s->key) + break_contact) )
+	continue;
+
+      if( contact_pressed(s, break_contact, now_us) ) {
+	value &= ~(1 << key_column(s->key));
+
+	if( break_contact ) {
+	  if( !seen_break[i] ) seen_break[i] = scan_ctr;
+	} else {
+	  if( !seen_make[i] ) seen_make[i] = scan_ctr;
+	}
+      } else {
+	if( break_contact ) {
+	  if( seen_break[i] && !seen_break_release[i] && now_us >= s->t_break_release ) seen_break_release[i] = scan_ctr;
+	} else {
+	  if( seen_make[i] && !seen_make_release[i] && now_us >= s->t_make_release ) seen_make_release[i] = scan_ctr;
+	}
+      }
+    }
+  }
+
+  din_sr[0] = value & 0xff;
+  din_sr[1] = value >> 8;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIDI
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  u8 note;
+  u8 velocity;
+  u8 off;
+} midi_note_t;
+
+#define MAX_MIDI_NOTES 1000
+static midi_note_t midi_notes[MAX_MIDI_NOTES];
+static int num_midi_notes;
+
+static void midi_log(mios32_midi_port_t port, u8 note, u8 velocity, u8 off)
+{
+  if( port != USB0 ) // the same notes are sent to all configured ports
+    return;
+
+  if( num_midi_notes < MAX_MIDI_NOTES ) {
+    midi_note_t *n = &midi_notes[num_midi_notes++];
+    n->note = note;
+    n->velocity = velocity;
+    n->off = off;
+  }
+}
+
+s32 MIOS32_MIDI_SendNoteOn(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 note, u8 vel)
+{
+  midi_log(port, note, vel, vel == 0);
+  return 0;
+}
+
+s32 MIOS32_MIDI_SendNoteOff(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 note, u8 vel)
+{
+  midi_log(port, note, vel, 1);
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32 stand-ins
+/////////////////////////////////////////////////////////////////////////////
+
+s32 MIOS32_TIMESTAMP_Get(void) { return now_us / 1000; }
+u8 MIOS32_SRIO_ScanNumGet(void) { return MIOS32_SRIO_NUM_SR; }
+
+s32 MIOS32_DOUT_SRSet(u32 sr, u8 value)
+{
+  if( sr == 0 ) {
+    int row;
+    for(row=0; row<8; ++row)
+      if( !(value & (1 << row)) )
+	selected_row = row;
+  }
+  return 0;
+}
+
+s32 MIOS32_DIN_SRGet(u32 sr)
+{
+  return (sr < 2) ? din_sr[sr] : 0xff;
+}
+
+u8 MIOS32_DIN_SRChangedGetAndClear(u32 sr, u8 mask)
+{
+  return 0;
+}
+
+s32 MIOS32_MIDI_SendCC(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 cc, u8 val) { return 0; }
+s32 MIOS32_MIDI_SendPitchBend(mios32_midi_port_t port, mios32_midi_chn_t chn, u16 val) { return 0; }
+s32 MIOS32_MIDI_SendAftertouch(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 val) { return 0; }
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Replays a trace
+/////////////////////////////////////////////////////////////////////////////
+static void replay(const stroke_t *_trace, int _trace_len, u32 duration_us, int periodic_ms)
+{
+  trace = _trace;
+  trace_len = _trace_len;
+  memset(seen_break, 0, sizeof(seen_break));
+  memset(seen_make, 0, sizeof(seen_make));
+  memset(seen_make_release, 0, sizeof(seen_make_release));
+  memset(seen_break_release, 0, sizeof(seen_break_release));
+  num_midi_notes = 0;
+
+  KEYBOARD_Init(1); // runtime variables
+  selected_row = active_row = 0xff;
+  scan_ctr = 0;
+
+  // like APP_SRIO_ServiceFinish() of MIDIbox KB: the next scan is started immediately
+  KEYBOARD_SRIO_ServicePrepare();
+  ++scan_ctr;
+
+  int scans = 0;
+  for(now_us=0; now_us<duration_us; now_us += SCAN_PERIOD_US) {
+    scan_row();
+    active_row = selected_row; // DOUT latched at the end of the scan
+
+    KEYBOARD_SRIO_ServiceFinish();
+    KEYBOARD_SRIO_ServicePrepare();
+    if( !++scan_ctr ) // same like the timestamp of the keyboard driver
+      ++scan_ctr;
+
+    if( ++scans >= periodic_ms * SCANS_PER_MS ) {
+      scans = 0;
+      KEYBOARD_Periodic_1mS();
+    }
+  }
+
+  KEYBOARD_Periodic_1mS();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Checks
+/////////////////////////////////////////////////////////////////////////////
+
+#if KEYBOARD_EVENT_QUEUE_SIZE >= 64
+static int expected_velocity(u16 delay, u16 delay_slowest, u16 delay_fastest)
+{
+  int velocity = 127;
+
+  if( delay > delay_fastest ) {
+    velocity = 127 - (((delay - delay_fastest) * 127) / (delay_slowest - delay_fastest));
+    if( velocity < 1 )
+      velocity = 1;
+    if( velocity > 127 )
+      velocity = 127;
+  }
+
+  return velocity;
+}
+
+static int find_note(int from, u8 note, u8 off)
+{
+  int i;
+  for(i=from; i<num_midi_notes; ++i)
+    if( midi_notes[i].note == note && midi_notes[i].off == off )
+      return i;
+  return -1;
+}
+
+// checks that each stroke has played one note with the expected velocity
+static void check_strokes(const char *name, const stroke_t *_trace, int _trace_len, u8 release_velocity)
+{
+  keyboard_config_t *kc = &keyboard_config[0];
+  u32 errors = 0;
+  int used[MAX_MIDI_NOTES];
+  int i;
+
+  memset(used, 0, sizeof(used));
+
+  for(i=0; i<_trace_len; ++i) {
+    const stroke_t *s = &_trace[i];
+    u8 note = s->key + NOTE_OFFSET;
+
+    int on = -1;
+    do {
+      on = find_note(on+1, note, 0);
+    } while( on >= 0 && used[on] );
+
+    if( on < 0 ) {
+      printf("ERROR: %s: no note on for key %d\n", name, s->key);
+      ++errors;
+      continue;
+    }
+    used[on] = 1;
+
+    u16 delay = seen_make[i] - seen_break[i];
+    int velocity = expected_velocity(delay, kc->delay_slowest, kc->delay_fastest);
+    if( midi_notes[on].velocity != velocity ) {
+      printf("ERROR: %s: key %d delay=%d scans: velocity %d, expected %d\n", name, s->key, delay, midi_notes[on].velocity, velocity);
+      ++errors;
+    }
+
+    int off = on;
+    do {
+      off = find_note(off+1, note, 1);
+    } while( off >= 0 && used[off] );
+
+    if( off < 0 ) {
+      printf("ERROR: %s: no note off for key %d\n", name, s->key);
+      ++errors;
+      continue;
+    }
+    used[off] = 1;
+
+    if( release_velocity ) {
+      delay = seen_break_release[i] - seen_make_release[i];
+      velocity = expected_velocity(delay, kc->delay_slowest_release, kc->delay_fastest_release);
+      if( velocity == 127 )
+	velocity = 0; // sent as Note On with velocity 0
+      if( midi_notes[off].velocity != velocity ) {
+	printf("ERROR: %s: key %d release delay=%d scans: velocity %d, expected %d\n", name, s->key, delay, midi_notes[off].velocity, velocity);
+	++errors;
+      }
+    }
+  }
+
+  for(i=0; i<num_midi_notes; ++i) {
+    if( !used[i] ) {
+      printf("ERROR: %s: unexpected note %s %d\n", name, midi_notes[i].off ? "off" : "on", midi_notes[i].note);
+      ++errors;
+    }
+  }
+
+  printf("  %-28s %3d notes  %s\n", name, num_midi_notes, errors ? "FAILED" : "ok");
+  num_errors += errors;
+}
+#else
+// checks that all played notes have been switched off again
+static void check_balanced(const char *name)
+{
+  int active[128];
+  int i, ons = 0;
+  u32 errors = 0;
+
+  memset(active, 0, sizeof(active));
+  for(i=0; i<num_midi_notes; ++i) {
+    if( midi_notes[i].off ) {
+      if( active[midi_notes[i].note] )
+	--active[midi_notes[i].note];
+    } else {
+      ++active[midi_notes[i].note];
+      ++ons;
+    }
+  }
+
+  for(i=0; i<128; ++i) {
+    if( active[i] ) {
+      printf("ERROR: %s: note %d hasn't been switched off\n", name, i);
+      ++errors;
+    }
+  }
+
+  if( !ons ) {
+    printf("ERROR: %s: no notes played\n", name);
+    ++errors;
+  }
+
+  printf("  %-28s %3d notes  %s\n", name, num_midi_notes, errors ? "FAILED" : "ok");
+  num_errors += errors;
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  keyboard_config_t *kc = &keyboard_config[0];
+  int i;
+
+  printf("KEYBOARD_EVENT_QUEUE_SIZE=%d, %d uS per scan\n", KEYBOARD_EVENT_QUEUE_SIZE, SCAN_PERIOD_US);
+
+  KEYBOARD_Init(0);
+  kc->verbose_level = 0;
+  kc->note_offset = NOTE_OFFSET;
+
+  for(i=0; i<NUM_KEYS; ++i) {
+    stroke_t *s = &trace_chords[i];
+    s->key = i;
+    s->t_break = 1000 + (i % 8) * 100;
+    s->t_make = s->t_break + 1500 + i * 170;
+    s->t_make_release = 80000 + (i % 5) * 300;
+    s->t_break_release = s->t_make_release + 2000 + i * 90;
+    s->bounce_us = 0;
+  }
+
+#if KEYBOARD_EVENT_QUEUE_SIZE >= 64
+  replay(trace_velocity, sizeof(trace_velocity)/sizeof(stroke_t), 500000, 1);
+  check_strokes("velocity", trace_velocity, sizeof(trace_velocity)/sizeof(stroke_t), 0);
+
+  replay(trace_chords, NUM_KEYS, 150000, 1);
+  check_strokes("64 keys chord", trace_chords, NUM_KEYS, 0);
+
+  kc->make_debounced = 1;
+  replay(trace_bounce, sizeof(trace_bounce)/sizeof(stroke_t), 200000, 1);
+  check_strokes("bouncing make contacts", trace_bounce, sizeof(trace_bounce)/sizeof(stroke_t), 0);
+  kc->make_debounced = 0;
+
+  kc->scan_release_velocity = 1;
+  kc->delay_fastest_release = 50;
+  replay(trace_velocity, sizeof(trace_velocity)/sizeof(stroke_t), 500000, 1);
+  check_strokes("release velocity", trace_velocity, sizeof(trace_velocity)/sizeof(stroke_t), 1);
+  kc->scan_release_velocity = 0;
+#else
+  // task is only called each 10 mS: events get lost
+  replay(trace_chords, NUM_KEYS, 150000, 10);
+  check_balanced("queue overrun");
+#endif
+
+  return GNU_TEST_Result();
+}
@@ -0,0 +1,13 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host test
+ *
+ * KEYBOARD_EVENT_QUEUE_SIZE is passed by the makefile
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+#define MIOS32_SRIO_NUM_SR 4
+
+#endif /* _MIOS32_CONFIG_H */
@@ -51,6 +51,15 @@ keyboard_config_t keyboard_config[KEYBOARD_NUM];
 // Local structures
 /////////////////////////////////////////////////////////////////////////////
 
+// contact event: changed pins of a row, recorded after the row has been scanned
+typedef struct {
+  u16 value;     // new row value
+  u16 changed;   // changed pins
+  u16 timestamp; // scan timestamp
+  u8  kb;
+  u8  row;
+} keyboard_event_t;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
@@ -58,13 +67,20 @@ keyboard_config_t keyboard_config[KEYBOARD_NUM];
 
 static u8 connected_keyboards_num;
 
-static u16 din_value[KEYBOARD_NUM][MATRIX_NUM_ROWS];
-static u16 din_value_changed[KEYBOARD_NUM][MATRIX_NUM_ROWS];
+static u16 din_value[KEYBOARD_NUM][MATRIX_NUM_ROWS]; // scanned values (SRIO handler)
+static u16 din_state[KEYBOARD_NUM][MATRIX_NUM_ROWS]; // values of processed events (KEYBOARD_Periodic_1mS)
 
 // for velocity
 static u16 timestamp;
 static u16 din_activated_timestamp[KEYBOARD_NUM][KEYBOARD_NUM_PINS];
 
+// contact events in scan order
+// lock-free: head is only written by KEYBOARD_SRIO_ServiceFinish(), tail only by KEYBOARD_Periodic_1mS()
+static keyboard_event_t event_queue[KEYBOARD_EVENT_QUEUE_SIZE];
+static volatile u16 event_queue_head;
+static volatile u16 event_queue_tail;
+static volatile u8  event_queue_overrun; // no new events until KEYBOARD_Periodic_1mS() has taken over the scanned values
+
 #if (KEYBOARD_NUM_PINS % 8)
 # error "KEYBOARD_NUM_PINS must be dividable by 8!"
 #endif
@@ -105,6 +121,12 @@ s32 KEYBOARD_Init(u32 mode)
   ain_cali_mode_pin = 0;
 #endif
 
+  MIOS32_IRQ_Disable();
+  event_queue_head = 0;
+  event_queue_tail = 0;
+  event_queue_overrun = 0;
+  MIOS32_IRQ_Enable();
+
   int kb;
   keyboard_config_t *kc = (keyboard_config_t *)&keyboard_config[0];
   for(kb=0; kb<KEYBOARD_NUM; ++kb, ++kc) {
@@ -197,7 +219,7 @@ s32 KEYBOARD_Init(u32 mode)
     u16 inversion = kc->din_inverted ? 0xffff : 0x0000;
     for(row=0; row<MATRIX_NUM_ROWS; ++row) {
       din_value[kb][row] = 0xffff ^ inversion; // default state: buttons depressed
-      din_value_changed[kb][row] = 0x0000;
+      din_state[kb][row] = din_value[kb][row];
     }
 
     // initialize timestamps
@@ -348,54 +370,30 @@ void KEYBOARD_SRIO_ServiceFinish(void)
     u16 changed = sr_value ^ din_value[kb][prev_row];
 
     if( changed ) {
-      // add them to existing notifications
-      din_value_changed[kb][prev_row] |= changed;
-
       // store new value
       din_value[kb][prev_row] = sr_value;
 
-      // number of pins per row depends on assigned DINs:
-      int pins_per_row = kc->din_sr2 ? 16 : 8;
-      u8 sr_pin;
-      u16 mask = 0x01;
-      u16 *ts_ptr = (u16 *)&din_activated_timestamp[kb][prev_row * MATRIX_NUM_ROWS];
-
-      /*-----------------02.03.2013 13:31-----------------
-       * key on velocity only : 40,4 us over all 16 scanlines -> 2,53 us/row
-       * --------------------------------------------------*/
-      if ( !kc->scan_release_velocity ) {
-	// store timestamp for changed pin on 1->0 transition
-    	for(sr_pin=0; sr_pin<pins_per_row; ++sr_pin, mask <<= 1, ++ts_ptr) {
-	  if( (changed & mask) && !(sr_value & mask) && !(*ts_ptr)) {
-	    *ts_ptr = timestamp;
-//	    DEBUG_MSG("Scanned TS: pin %d & row %d = %d \n", sr_pin, prev_row, *ts_ptr);
-	  }
-      	}
-      }
-      /* --------------------------------------------------*/
-
-      /*-----------------02.03.2013 13:39-----------------
-       * key on/off velocity : 48,9 us over all 16 scanlines -> 3,06 us/row
-       * --------------------------------------------------*/
-      else {
-	// get related contact row: MKx = BRx - 1; BRx = MK + 1;
-	u8  rel_row = prev_row + ((prev_row & 1) ? (-1) : 1);
-	u16 rel_changed = din_value_changed[kb][rel_row];
-	u16 rel_sr_value = din_value[kb][rel_row];
-      	// check Make and Break Pins
-      	for(sr_pin=0; sr_pin<pins_per_row; ++sr_pin, mask <<= 1, ++ts_ptr) {
-	  // update timestamp only if timestamp is 0 (untouched or previously processed)
-	  //               AND     if Break pin changes and related Make pin remains released (1) without change
-	  //                    OR if Make pin changes and related Break pin remains pressed (0) without change
-	  if( (changed & mask) && !(rel_changed & mask) && !(*ts_ptr) &&
-	      (( (prev_row & 1) &&  (rel_sr_value & mask))||
-	       (!(prev_row & 1) && !(rel_sr_value & mask))  )   		) {
-	    *ts_ptr = timestamp;
-//	    DEBUG_MSG("Scanned TS: pin %d & row %d [%s %s] = %d \n", sr_pin, prev_row, sr_value & mask ? "released" : "pressed", prev_row & 1 ? "BR" : "MK", *ts_ptr);
-	  }
+      // record the event, velocity and debouncing will be processed in KEYBOARD_Periodic_1mS()
+      if( !event_queue_overrun ) {
+	u16 head = event_queue_head;
+	u16 next_head = head + 1;
+	if( next_head >= KEYBOARD_EVENT_QUEUE_SIZE )
+	  next_head = 0;
+
+	if( next_head == event_queue_tail ) {
+	  // queue full: KEYBOARD_Periodic_1mS() will take over the scanned values
+	  event_queue_overrun = 1;
+	} else {
+	  keyboard_event_t *e = &event_queue[head];
+	  e->value = sr_value;
+	  e->changed = changed;
+	  e->timestamp = timestamp;
+	  e->kb = kb;
+	  e->row = prev_row;
+
+	  event_queue_head = next_head; // event is valid now
 	}
       }
-/* --------------------------------------------------*/
     }
   }
 }
@@ -413,7 +411,7 @@ static void KEYBOARD_NotifyToggle(u8 kb, u8 row, u8 column, u8 depressed)
     DEBUG_MSG("---\n");
     int i;
     for(i=0; i<MATRIX_NUM_ROWS; ++i) {
-      int v = ~din_value[kb][i];
+      int v = ~din_state[kb][i];
       DEBUG_MSG("DOUT SR%d.%d:  %c%c%c%c%c%c%c%c  %c%c%c%c%c%c%c%c\n",
 		(i / 8)+1,
 		7 - (i % 8),
@@ -529,9 +527,7 @@ static void KEYBOARD_NotifyToggle(u8 kb, u8 row, u8 column, u8 depressed)
 	if( depressed ) {
 	  if( kc->make_debounced ) {
 	    // for debouncing we have to play Note Off when Break is released, because make is bouncing
-	    MIOS32_IRQ_Disable();
 	    *ts_break_ptr = 0;
-	    MIOS32_IRQ_Enable();
 
 	    if( kc->verbose_level >= 2 )
 	      DEBUG_MSG("DEPRESSED note=%s\n", KEYBOARD_GetNoteName(note_number, note_str));
@@ -543,10 +539,8 @@ static void KEYBOARD_NotifyToggle(u8 kb, u8 row, u8 column, u8 depressed)
 #endif
 	  }
 
-	  MIOS32_IRQ_Disable();
 	  *ts_make_ptr = 0;
 	  *ts_break_ptr = 0;
-          MIOS32_IRQ_Enable();
 	}
 
 	if( !kc->break_is_make )
@@ -583,16 +577,13 @@ static void KEYBOARD_NotifyToggle(u8 kb, u8 row, u8 column, u8 depressed)
     // release velocity processing
     if( kc->scan_release_velocity ) {
       // break contact released (0->1) (not bouncing yet) and make contact remains depressed (1) ?
-      if( break_contact && *ts_make_ptr &&
-          !(din_value_changed[kb][row_make] & key16_mask) && (din_value[kb][row_make] & key16_mask) ) {
+      if( break_contact && *ts_make_ptr && (din_state[kb][row_make] & key16_mask) ) {
 	if( kc->verbose_level >= 2 )
 	  DEBUG_MSG("RELEASED note=%s\n", KEYBOARD_GetNoteName(note_number, note_str));
 	// and the delta delay (IMPORTANT: delay variable needs same resolution like timestamps to handle overrun correctly!)
-        MIOS32_IRQ_Disable();
 	u16 delay = *ts_break_ptr - *ts_make_ptr;
 	*ts_make_ptr = 0;
 	*ts_break_ptr = 0;
-        MIOS32_IRQ_Enable();
 
 	u16 delay_fastest = ( black_key && kc->delay_fastest_release_black_keys ) ? kc->delay_fastest_release_black_keys
 										  : kc->delay_fastest_release;
@@ -626,9 +617,7 @@ static void KEYBOARD_NotifyToggle(u8 kb, u8 row, u8 column, u8 depressed)
       if( !kc->scan_velocity || !(*ts_make_ptr) ) {
 	if( !kc->make_debounced ) {
 	  // (if debouncing mode is activated, the note off is played with depressed break)
-	  MIOS32_IRQ_Disable();
 	  *ts_break_ptr = 0;
-	  MIOS32_IRQ_Enable();
 
 	  if( kc->verbose_level >= 2 )
 	    DEBUG_MSG("RELEASED note=%s\n", KEYBOARD_GetNoteName(note_number, note_str));
@@ -647,14 +636,11 @@ static void KEYBOARD_NotifyToggle(u8 kb, u8 row, u8 column, u8 depressed)
 
     if( !kc->scan_velocity ||
         // or make contact reached (1->0) (not bouncing yet) and break contact remains pressed (0) ?
-	(note_trigger_contact && *ts_break_ptr &&
-	 !(din_value_changed[kb][row_break] & key16_mask) && !(din_value[kb][row_break] & key16_mask)) ) {
+	(note_trigger_contact && *ts_break_ptr && !(din_state[kb][row_break] & key16_mask)) ) {
       // and the delta delay (IMPORTANT: delay variable needs same resolution like timestamps to handle overrun correctly!)
-      MIOS32_IRQ_Disable();
       u16 delay = *ts_make_ptr - *ts_break_ptr;
       *ts_break_ptr = 0;
       *ts_make_ptr = 0;
-      MIOS32_IRQ_Enable();
 
       if( kc->break_is_make ) {
 	if( kc->verbose_level >= 2 )
@@ -693,34 +679,95 @@ static void KEYBOARD_NotifyToggle(u8 kb, u8 row, u8 column, u8 depressed)
 
 
 /////////////////////////////////////////////////////////////////////////////
-//! This function should be called periodically (each mS) to check for pin changes
+//! processes the pin changes of a scanned row
+/////////////////////////////////////////////////////////////////////////////
+static void KEYBOARD_ProcessEvent(u8 kb, u8 row, u16 value, u16 changed, u16 ts)
+{
+  keyboard_config_t *kc = (keyboard_config_t *)&keyboard_config[kb];
+
+  // number of pins per row depends on assigned DINs:
+  int pins_per_row = kc->din_sr2 ? 16 : 8;
+  u8 sr_pin;
+  u16 mask = 0x01;
+  u16 *ts_ptr = (u16 *)&din_activated_timestamp[kb][row * MATRIX_NUM_ROWS];
+
+  if ( !kc->scan_release_velocity ) {
+    // store timestamp for changed pin on 1->0 transition
+    for(sr_pin=0; sr_pin<pins_per_row; ++sr_pin, mask <<= 1, ++ts_ptr) {
+      if( (changed & mask) && !(value & mask) && !(*ts_ptr)) {
+	*ts_ptr = ts;
+      }
+    }
+  } else {
+    // get related contact row: MKx = BRx - 1; BRx = MK + 1;
+    u8  rel_row = row + ((row & 1) ? (-1) : 1);
+    u16 rel_value = din_state[kb][rel_row];
+    // check Make and Break Pins
+    for(sr_pin=0; sr_pin<pins_per_row; ++sr_pin, mask <<= 1, ++ts_ptr) {
+      // update timestamp only if timestamp is 0 (untouched or previously processed)
+      //               AND     if Break pin changes and related Make pin is released (1)
+      //                    OR if Make pin changes and related Break pin is pressed (0)
+      // (since events are processed in scan order, the related pin has the state of the scan time)
+      if( (changed & mask) && !(*ts_ptr) &&
+	  (( (row & 1) &&  (rel_value & mask)) ||
+	   (!(row & 1) && !(rel_value & mask))) ) {
+	*ts_ptr = ts;
+      }
+    }
+  }
+
+  // take over new value
+  din_state[kb][row] = value;
+
+  // check the 16 captured pins of the two SRs
+  mask = 0x01;
+  for(sr_pin=0; sr_pin<pins_per_row; ++sr_pin, mask <<= 1)
+    if( changed & mask )
+      KEYBOARD_NotifyToggle(kb, row, sr_pin, (value & mask) ? 1 : 0);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function should be called periodically (each mS) to process the
+//! contact events which have been recorded by KEYBOARD_SRIO_ServiceFinish()
 /////////////////////////////////////////////////////////////////////////////
 void KEYBOARD_Periodic_1mS(void)
 {
-  int kb;
-  keyboard_config_t *kc = (keyboard_config_t *)&keyboard_config[0];
-  for(kb=0; kb<connected_keyboards_num; ++kb, ++kc) {
-    // number of pins per row depends on assigned DINs:
-    int pins_per_row = kc->din_sr2 ? 16 : 8;
+  // process events in scan order
+  while( event_queue_tail != event_queue_head ) {
+    u16 tail = event_queue_tail;
+    keyboard_event_t *e = &event_queue[tail];
 
-    int row;
-    for(row=0; row<kc->num_rows; ++row) {
-      // check if there are pin changes - must be atomic!
-      MIOS32_IRQ_Disable();
-      u16 changed = din_value_changed[kb][row];
-      din_value_changed[kb][row] = 0;
-      MIOS32_IRQ_Enable();
-
-      // any pin change at this SR?
-      if( !changed )
-	continue;
-
-      // check the 16 captured pins of the two SRs
-      int sr_pin;
-      u16 mask = 0x01;
-      for(sr_pin=0; sr_pin<pins_per_row; ++sr_pin, mask <<= 1)
-	if( changed & mask )
-	  KEYBOARD_NotifyToggle(kb, row, sr_pin, (din_value[kb][row] & mask) ? 1 : 0);
+    KEYBOARD_ProcessEvent(e->kb, e->row, e->value, e->changed, e->timestamp);
+
+    if( ++tail >= KEYBOARD_EVENT_QUEUE_SIZE )
+      tail = 0;
+    event_queue_tail = tail; // event can be overwritten now
+  }
+
+  // events have been dropped: continue with the scanned values
+  if( event_queue_overrun ) {
+    u16 value[KEYBOARD_NUM][MATRIX_NUM_ROWS];
+    u16 ts;
+    int kb, row;
+
+    // the SRIO handler doesn't record new events until the flag is cleared - must be atomic!
+    MIOS32_IRQ_Disable();
+    memcpy(value, din_value, sizeof(value));
+    ts = timestamp;
+    event_queue_overrun = 0;
+    MIOS32_IRQ_Enable();
+
+    if( keyboard_config[0].verbose_level >= 1 )
+      DEBUG_MSG("WARNING: keyboard event queue overrun, increase KEYBOARD_EVENT_QUEUE_SIZE!\n");
+
+    keyboard_config_t *kc = (keyboard_config_t *)&keyboard_config[0];
+    for(kb=0; kb<connected_keyboards_num; ++kb, ++kc) {
+      for(row=0; row<kc->num_rows; ++row) {
+	u16 changed = value[kb][row] ^ din_state[kb][row];
+	if( changed )
+	  KEYBOARD_ProcessEvent(kb, row, value[kb][row], changed, ts);
+      }
     }
   }
 }
@@ -60,6 +60,12 @@
 #define KEYBOARD_MAX_KEYS 128
 #endif
 
+// number of contact events which can be recorded by KEYBOARD_SRIO_ServiceFinish()
+// until they are processed by KEYBOARD_Periodic_1mS() (8 bytes per event)
+#ifndef KEYBOARD_EVENT_QUEUE_SIZE
+#define KEYBOARD_EVENT_QUEUE_SIZE 128
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
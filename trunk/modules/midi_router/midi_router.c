@@ -28,6 +28,7 @@
 #include <seq_midi_out.h>
 #endif
 
+
 /////////////////////////////////////////////////////////////////////////////
 // local defines
 /////////////////////////////////////////////////////////////////////////////
@@ -35,6 +36,35 @@
 // SysEx buffer for each input (exclusive Default)
 #define NUM_SYSEX_BUFFERS     (MIDI_PORT_NUM_IN_PORTS-1)
 
+#if MIDI_ROUTER_USE_TABLE
+// source ports of the routing table: USB0..7, UART0..7, IIC0..7, OSC0..7 (see MIDI_ROUTER_PortIxGet)
+// all other ports share the last entry
+#define NUM_TABLE_SRC_PORTS   32
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// local types
+/////////////////////////////////////////////////////////////////////////////
+
+#if MIDI_ROUTER_USE_TABLE
+typedef struct {
+  u32 dst_port_mask; // for Realtime/SysEx events which are only forwarded once per destination port
+  u16 src_chn_mask;  // bit n set: channel n+1 is forwarded
+  u8  src_port;
+  u8  dst_port;
+  u8  dst_chn;       // 0 == keep channel, 1..16: specific destination channel
+  u8  osc_loop;      // OSC->OSC: only SysEx is forwarded
+} midi_router_route_t;
+
+// the routes of source port ix are located at route[begin[ix]]..route[begin[ix+1]-1]
+typedef struct {
+  u8  begin[NUM_TABLE_SRC_PORTS+2];
+  u16 chn_mask[NUM_TABLE_SRC_PORTS+1]; // all channels which are forwarded from a source port
+  midi_router_route_t route[MIDI_ROUTER_NUM_NODES];
+} midi_router_table_t;
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // global variables
@@ -69,6 +99,22 @@ u32 midi_router_mclk_out;
 static u8 sysex_buffer[NUM_SYSEX_BUFFERS][MIDI_ROUTER_SYSEX_BUFFER_SIZE];
 static u32 sysex_buffer_len[NUM_SYSEX_BUFFERS];
 
+#if MIDI_ROUTER_USE_TABLE
+// routing tables: the active one is only accessed with MUTEX_MIDIOUT (or IRQs disabled),
+// the other one is rebuilt in background and swapped in once it's complete
+static midi_router_table_t route_table[2];
+static midi_router_table_t *route_table_active = &route_table[0];
+static volatile u8 route_valid;
+static u8 route_update_running;
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static s32 MIDI_ROUTER_SysExBufferAdd(mios32_midi_port_t port, int sysex_in, u8 midi_in);
+
 
 /////////////////////////////////////////////////////////////////////////////
 // This function initializes the MIDI router
@@ -88,6 +134,22 @@ s32 MIDI_ROUTER_Init(u32 mode)
   for(i=0; i<NUM_SYSEX_BUFFERS; ++i)
     sysex_buffer_len[i] = 0;
 
+  MIDI_ROUTER_NodesChanged();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Has to be called whenever midi_router_node[] has been changed
+// (by the terminal, UI or configuration files)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIDI_ROUTER_NodesChanged(void)
+{
+#if MIDI_ROUTER_USE_TABLE
+  route_valid = 0; // table will be rebuilt with the next received package
+#endif
+
   return 0; // no error
 }
 
@@ -106,6 +168,119 @@ static inline u32 MIDI_ROUTER_PortMaskGet(mios32_midi_port_t port)
 }
 
 
+#if MIDI_ROUTER_USE_TABLE
+/////////////////////////////////////////////////////////////////////////////
+// Returns the routing table index of a source port
+// 0..31 for USB0..7, UART0..7, IIC0..7, OSC0..7, 32 for all other ports
+/////////////////////////////////////////////////////////////////////////////
+static inline u32 MIDI_ROUTER_PortIxGet(mios32_midi_port_t port)
+{
+  u8 port_ix = port & 0xf;
+  if( port >= USB0 && port <= OSC7 && port_ix <= 7 ) {
+    return (((port-USB0) & 0x30) >> 1) | port_ix;
+  }
+
+  return NUM_TABLE_SRC_PORTS;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compiles midi_router_node[] into the routing table
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIDI_ROUTER_TableUpdate(void)
+{
+  // the table could be rebuilt by multiple tasks: only one of them will do this,
+  // the others continue with the current table
+  MIOS32_IRQ_Disable();
+  if( route_update_running ) {
+    MIOS32_IRQ_Enable();
+    return 0; // no error
+  }
+  route_update_running = 1;
+  route_valid = 1; // cleared again if nodes are changed while the table is built
+  MIOS32_IRQ_Enable();
+
+  // the inactive table isn't accessed by the router functions
+  midi_router_table_t *t = (route_table_active == &route_table[0]) ? &route_table[1] : &route_table[0];
+
+  // count the routes of each source port
+  u8 num_routes[NUM_TABLE_SRC_PORTS+1];
+  memset(num_routes, 0, sizeof(num_routes));
+  memset(t->chn_mask, 0, sizeof(t->chn_mask));
+
+  int node;
+  midi_router_node_entry_t *n = (midi_router_node_entry_t *)&midi_router_node[0];
+  for(node=0; node<MIDI_ROUTER_NUM_NODES; ++node, ++n) {
+    if( n->src_chn && n->dst_chn )
+      ++num_routes[MIDI_ROUTER_PortIxGet(n->src_port)];
+  }
+
+  int ix;
+  u8 begin = 0;
+  for(ix=0; ix<=NUM_TABLE_SRC_PORTS; ++ix) {
+    t->begin[ix] = begin;
+    begin += num_routes[ix];
+    num_routes[ix] = t->begin[ix]; // now used as insert position
+  }
+  t->begin[NUM_TABLE_SRC_PORTS+1] = begin;
+
+  // nodes are added in the same order like in midi_router_node[]
+  n = (midi_router_node_entry_t *)&midi_router_node[0];
+  for(node=0; node<MIDI_ROUTER_NUM_NODES; ++node, ++n) {
+    if( n->src_chn && n->dst_chn ) {
+      ix = MIDI_ROUTER_PortIxGet(n->src_port);
+      midi_router_route_t *r = &t->route[num_routes[ix]++];
+      r->dst_port_mask = MIDI_ROUTER_PortMaskGet(n->dst_port);
+      r->src_chn_mask = (n->src_chn > 16) ? 0xffff : (1 << (n->src_chn-1));
+      r->src_port = n->src_port;
+      r->dst_port = n->dst_port;
+      r->dst_chn = (n->dst_chn > 16) ? 0 : n->dst_chn;
+
+      // forwarding OSC to OSC will very likely result into a stack overflow (or feedback loop) -> avoid this!
+      r->osc_loop = ((n->src_port & 0xf0) == OSC0) && ((n->dst_port & 0xf0) == OSC0);
+
+      if( !r->osc_loop )
+	t->chn_mask[ix] |= r->src_chn_mask;
+    }
+  }
+
+  // swap in the new table
+  MUTEX_MIDIOUT_TAKE;
+  route_table_active = t;
+  MUTEX_MIDIOUT_GIVE;
+
+  route_update_running = 0;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Rebuilds the routing table if MIDI_ROUTER_NodesChanged() has been called
+/////////////////////////////////////////////////////////////////////////////
+static inline void MIDI_ROUTER_TableCheck(void)
+{
+  if( !route_valid )
+    MIDI_ROUTER_TableUpdate();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the channels which are forwarded from a source port
+// Can be called without MUTEX_MIDIOUT: the active table is never written,
+// and it can't be swapped and rebuilt while IRQs are disabled
+/////////////////////////////////////////////////////////////////////////////
+static inline u16 MIDI_ROUTER_TableChnMaskGet(u32 ix)
+{
+  MIOS32_IRQ_Disable();
+  u16 chn_mask = route_table_active->chn_mask[ix];
+  MIOS32_IRQ_Enable();
+
+  return chn_mask;
+}
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Receives a MIDI package from APP_NotifyReceivedEvent (-> app.c)
 /////////////////////////////////////////////////////////////////////////////
@@ -117,6 +292,51 @@ s32 MIDI_ROUTER_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_pack
       (midi_package.cin >= 0x4 && midi_package.cin <= 0x7)) )
     return 0; // no error
 
+#if MIDI_ROUTER_USE_TABLE
+  MIDI_ROUTER_TableCheck();
+
+  u32 ix = MIDI_ROUTER_PortIxGet(port);
+  u16 port_chn_mask = MIDI_ROUTER_TableChnMaskGet(ix);
+  if( !port_chn_mask )
+    return 0; // nothing routed from this port (SysEx is handled separately)
+
+  if( midi_package.event >= NoteOff && midi_package.event <= PitchBend ) {
+    u16 chn_mask = 1 << midi_package.chn;
+    if( !(port_chn_mask & chn_mask) )
+      return 0; // channel not routed
+
+    MUTEX_MIDIOUT_TAKE;
+    midi_router_table_t *t = route_table_active;
+    midi_router_route_t *r = &t->route[t->begin[ix]];
+    midi_router_route_t *r_end = &t->route[t->begin[ix+1]];
+    for(; r < r_end; ++r) {
+      if( (r->src_chn_mask & chn_mask) && !r->osc_loop && r->src_port == port ) {
+	mios32_midi_package_t fwd_package = midi_package;
+	if( r->dst_chn )
+	  fwd_package.chn = (r->dst_chn-1);
+	MIOS32_MIDI_SendPackage(r->dst_port, fwd_package);
+      }
+    }
+    MUTEX_MIDIOUT_GIVE;
+  } else {
+    // Realtime events: ensure that they are only forwarded once
+    u32 fwd_done = 0;
+    MUTEX_MIDIOUT_TAKE;
+    midi_router_table_t *t = route_table_active;
+    midi_router_route_t *r = &t->route[t->begin[ix]];
+    midi_router_route_t *r_end = &t->route[t->begin[ix+1]];
+    for(; r < r_end; ++r) {
+      if( !r->osc_loop && r->src_port == port ) {
+	u32 mask = r->dst_port_mask;
+	if( !mask || !(fwd_done & mask) ) {
+	  fwd_done |= mask;
+	  MIOS32_MIDI_SendPackage(r->dst_port, midi_package);
+	}
+      }
+    }
+    MUTEX_MIDIOUT_GIVE;
+  }
+#else
   u32 sysex_dst_fwd_done = 0;
   int node;
   midi_router_node_entry_t *n = (midi_router_node_entry_t *)&midi_router_node[0];
@@ -149,6 +369,7 @@ s32 MIDI_ROUTER_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_pack
       }
     }
   }
+#endif
 
   return 0; // no error
 }
@@ -157,6 +378,15 @@ s32 MIDI_ROUTER_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_pack
 // Receives a SysEx byte from APP_SYSEX_Parser (-> app.c)
 /////////////////////////////////////////////////////////////////////////////
 s32 MIDI_ROUTER_ReceiveSysEx(mios32_midi_port_t port, u8 midi_in)
+{
+  return MIDI_ROUTER_ReceiveSysExSpan(port, &midi_in, 1);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Receives multiple SysEx bytes, e.g. from a callback which has been
+// installed with MIOS32_MIDI_SysExSpanCallback_Init()
+/////////////////////////////////////////////////////////////////////////////
+s32 MIDI_ROUTER_ReceiveSysExSpan(mios32_midi_port_t port, u8 *span, u32 len)
 {
   // determine SysEx buffer
   int sysex_in = MIDI_PORT_InIxGet(port);
@@ -171,6 +401,35 @@ s32 MIDI_ROUTER_ReceiveSysEx(mios32_midi_port_t port, u8 midi_in)
   if( sysex_in >= NUM_SYSEX_BUFFERS )
     return -2; // error in sysex assignments
 
+  while( len ) {
+    // copy data bytes up to the next status byte at once as long as the buffer isn't full
+    u32 buffer_len = sysex_buffer_len[sysex_in];
+    if( buffer_len < (MIDI_ROUTER_SYSEX_BUFFER_SIZE-1) ) {
+      u32 max_len = (MIDI_ROUTER_SYSEX_BUFFER_SIZE-1) - buffer_len;
+      u32 num_bytes = MIOS32_MIDI_SysExStatusFind(span, (len < max_len) ? len : max_len);
+      if( num_bytes ) {
+	memcpy(&sysex_buffer[sysex_in][buffer_len], span, num_bytes);
+	sysex_buffer_len[sysex_in] += num_bytes;
+	span += num_bytes;
+	len -= num_bytes;
+	continue;
+      }
+    }
+
+    // status byte or buffer full
+    MIDI_ROUTER_SysExBufferAdd(port, sysex_in, *span);
+    ++span;
+    --len;
+  }
+
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Adds a SysEx byte to the buffer of the given input, and forwards the buffer
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIDI_ROUTER_SysExBufferAdd(mios32_midi_port_t port, int sysex_in, u8 midi_in)
+{
   // store value into buffer, send when:
   //   o 0xf7 (end of stream) has been received
   //   o 0xf0 (start of stream) has been received although buffer isn't empty
@@ -182,6 +441,32 @@ s32 MIDI_ROUTER_ReceiveSysEx(mios32_midi_port_t port, u8 midi_in)
     if( midi_in == 0xf7 && buffer_len < MIDI_ROUTER_SYSEX_BUFFER_SIZE ) // note: we always have a free byte for F7
       sysex_buffer[sysex_in][sysex_buffer_len[sysex_in]++] = midi_in;
 
+#if MIDI_ROUTER_USE_TABLE
+    MIDI_ROUTER_TableCheck();
+
+    // SysEx, only forwarded once per destination port
+    u32 sysex_dst_fwd_done = 0;
+    u32 ix = MIDI_ROUTER_PortIxGet(port);
+    MUTEX_MIDIOUT_TAKE;
+    midi_router_table_t *t = route_table_active;
+    midi_router_route_t *r = &t->route[t->begin[ix]];
+    midi_router_route_t *r_end = &t->route[t->begin[ix+1]];
+    for(; r < r_end; ++r) {
+      if( r->src_port == port ) {
+	u32 mask = r->dst_port_mask;
+	if( !mask || !(sysex_dst_fwd_done & mask) ) {
+	  sysex_dst_fwd_done |= mask;
+
+	  mios32_midi_port_t port = r->dst_port;
+	  if( (port & 0xf0) == OSC0 )
+	    OSC_CLIENT_SendSysEx(port & 0x0f, sysex_buffer[sysex_in], sysex_buffer_len[sysex_in]);
+	  else
+	    MIOS32_MIDI_SendSysEx(port, sysex_buffer[sysex_in], sysex_buffer_len[sysex_in]);
+	}
+      }
+    }
+    MUTEX_MIDIOUT_GIVE;
+#else
     u32 sysex_dst_fwd_done = 0;
     int node;
     midi_router_node_entry_t *n = (midi_router_node_entry_t *)&midi_router_node[0];
@@ -202,6 +487,7 @@ s32 MIDI_ROUTER_ReceiveSysEx(mios32_midi_port_t port, u8 midi_in)
 	}
       }
     }
+#endif
 
     // empty buffer
     sysex_buffer_len[sysex_in] = 0;
@@ -545,6 +831,7 @@ s32 MIDI_ROUTER_TerminalParseLine(char *input, void *_output_function)
 	n->src_chn = src_chn;
 	n->dst_port = dst_port;
 	n->dst_chn = dst_chn;
+	MIDI_ROUTER_NodesChanged();
 
 	out("Changed Node %d to SRC:%s %s  DST:%s %s",
 	    node+1,
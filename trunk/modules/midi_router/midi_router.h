@@ -27,6 +27,16 @@ extern "C" {
 #define MIDI_ROUTER_NUM_NODES  16
 #endif
 
+// routing method:
+// 0: all nodes are checked for each received package, MUTEX_MIDIOUT is taken for each destination
+// 1: nodes are compiled into a routing table, which is rebuilt after MIDI_ROUTER_NodesChanged() has been called.
+//    Only the nodes of the source port are checked, and all destinations are served with a single MUTEX_MIDIOUT_TAKE
+//    Only enable this in mios32_config.h if the application calls MIDI_ROUTER_NodesChanged() after each
+//    write to midi_router_node[], otherwise the old routes will still be used!
+#ifndef MIDI_ROUTER_USE_TABLE
+#define MIDI_ROUTER_USE_TABLE 0
+#endif
+
 // size of SysEx buffers
 // if longer SysEx strings are received, they will be forwarded directly
 // in this case, multiple strings concurrently sent to the same port won't be merged correctly anymore.
@@ -57,9 +67,11 @@ typedef struct {
 /////////////////////////////////////////////////////////////////////////////
 
 extern s32 MIDI_ROUTER_Init(u32 mode);
+extern s32 MIDI_ROUTER_NodesChanged(void);
 
 extern s32 MIDI_ROUTER_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_package);
 extern s32 MIDI_ROUTER_ReceiveSysEx(mios32_midi_port_t port, u8 midi_in);
+extern s32 MIDI_ROUTER_ReceiveSysExSpan(mios32_midi_port_t port, u8 *span, u32 len);
 
 extern s32 MIDI_ROUTER_MIDIClockInGet(mios32_midi_port_t port);
 extern s32 MIDI_ROUTER_MIDIClockInSet(mios32_midi_port_t port, u8 enable);
@@ -44,8 +44,35 @@ typedef struct {
   u32  chunk_end;
   u32  tick;
   u8   running_status;
+#if MID_PARSER_TRACK_CACHE_SIZE
+  u32  cache_file_pos; // file position of cache[0]
+  u16  cache_len;      // number of valid bytes in cache
+  u8   cache[MID_PARSER_TRACK_CACHE_SIZE];
+#endif
 } midi_track_t;
 
+#if MID_PARSER_SEEK_INDEX_SIZE
+// controllers which are chased by MID_PARSER_SeekTick()
+// the order is relevant, e.g. bank select has to be sent before program change
+#define CHASE_PROGRAM_CHANGE 0x80
+#define CHASE_PITCHBEND_LSB  0x81
+#define CHASE_PITCHBEND_MSB  0x82
+#define CHASE_NUM            12
+#define CHASE_NOT_SET        0xff
+
+typedef struct {
+  u32  file_pos:24;
+  u32  running_status:8;
+  u32  tick;
+} midi_track_pos_t;
+
+typedef struct {
+  u32  tick;
+  midi_track_pos_t track[MID_PARSER_MAX_TRACKS];
+  u8   chase_value[16][CHASE_NUM];
+} midi_seek_point_t;
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local prototypes
@@ -54,6 +81,16 @@ typedef struct {
 static u32 MID_PARSER_ReadWord(u8 len);
 static u32 MID_PARSER_ReadVarLen(u32 *pos);
 
+static u8  MID_PARSER_TrackReadByte(midi_track_t *mt);
+static u32 MID_PARSER_TrackRead(midi_track_t *mt, u8 *buffer, u32 len);
+static s32 MID_PARSER_TrackSkip(midi_track_t *mt, u32 len);
+static u32 MID_PARSER_TrackReadVarLen(midi_track_t *mt);
+
+#if MID_PARSER_SEEK_INDEX_SIZE
+static s32 MID_PARSER_SeekIndexBuild(void);
+static s32 MID_PARSER_ChaseEvent(u8 track, mios32_midi_package_t midi_package, u32 tick);
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
@@ -69,6 +106,22 @@ static midi_track_t midi_tracks[MID_PARSER_MAX_TRACKS];
 
 static u8 meta_buffer[MID_PARSER_META_BUFFER_SIZE];
 
+#if MID_PARSER_SEEK_INDEX_SIZE
+static const u8 chase_event[CHASE_NUM] = {
+  0, 32, CHASE_PROGRAM_CHANGE, // Bank Select MSB/LSB, Program Change
+  1, 7, 10, 11, 64, 91, 93,    // ModWheel, Volume, Pan, Expression, Sustain, Reverb, Chorus
+  CHASE_PITCHBEND_LSB, CHASE_PITCHBEND_MSB,
+};
+
+static u8  seek_index_num;
+static u32 seek_index_interval;
+static midi_seek_point_t seek_index[MID_PARSER_SEEK_INDEX_SIZE];
+
+// chased values at the current parser position, and the ticks at which they have been set
+static u8  chase_value[16][CHASE_NUM];
+static u32 chase_tick[16][CHASE_NUM];
+#endif
+
 // callback functions
 static u32 (*mid_parser_read_callback)(void *buffer, u32 len);
 static s32 (*mid_parser_eof_callback)(void);
@@ -201,6 +254,9 @@ s32 MID_PARSER_Read(void)
 	mt->chunk_end = file_pos + chunk_len - 1;
 	mt->tick = delta;
 	mt->running_status = 0x80;
+#if MID_PARSER_TRACK_CACHE_SIZE
+	mt->cache_len = 0; // invalidate cache
+#endif
 	++midi_tracks_num;
 
 #if DEBUG_VERBOSE_LEVEL >= 1
@@ -242,6 +298,10 @@ s32 MID_PARSER_Read(void)
 
   file_valid = 1;
 
+#if MID_PARSER_SEEK_INDEX_SIZE
+  MID_PARSER_SeekIndexBuild();
+#endif
+
   return 0; // no error
 }
 
@@ -301,15 +361,16 @@ s32 MID_PARSER_FetchEvents(u32 tick_offset, u32 num_ticks)
       if( mt->tick >= (tick_offset + num_ticks) )
 	break;
 
+#if !MID_PARSER_TRACK_CACHE_SIZE
       // set file pos
       mid_parser_seek_callback(mt->file_pos);
+#endif
 
       // get event
-      u8 event;
-      mt->file_pos += mid_parser_read_callback(&event, 1);
+      u8 event = MID_PARSER_TrackReadByte(mt);
 
       if( event == 0xf0 ) { // SysEx event
-	u32 length = (u32)MID_PARSER_ReadVarLen(&mt->file_pos);
+	u32 length = MID_PARSER_TrackReadVarLen(mt);
 #if DEBUG_VERBOSE_LEVEL >= 3
 	DEBUG_MSG("[MID_PARSER:%d:%u] SysEx event with %u bytes\n\r", track, mt->tick, length);
 #endif
@@ -326,14 +387,12 @@ s32 MID_PARSER_FetchEvents(u32 tick_offset, u32 num_ticks)
 	// remaining bytes
 	int i;
 	for(i=0; i<length; ++i) {
-	  u8 evnt0;
-	  mt->file_pos += mid_parser_read_callback(&evnt0, 1);
-	  midi_package.evnt0 = evnt0;
+	  midi_package.evnt0 = MID_PARSER_TrackReadByte(mt);
 	  if( mid_parser_playevent_callback != NULL )
 	    mid_parser_playevent_callback(track, midi_package, mt->tick);
 	}
       } else if( event == 0xf7 ) { // "Escaped" event (allows to send any MIDI data)
-	u32 length = (u32)MID_PARSER_ReadVarLen(&mt->file_pos);
+	u32 length = MID_PARSER_TrackReadVarLen(mt);
 #if DEBUG_VERBOSE_LEVEL >= 3
 	DEBUG_MSG("[MID_PARSER:%d:%u] Escaped event with %u bytes\n\r", track, mt->tick, length);
 #endif
@@ -341,16 +400,13 @@ s32 MID_PARSER_FetchEvents(u32 tick_offset, u32 num_ticks)
 	midi_package.type = 0xf; // single bytes will be transmitted
 	int i;
 	for(i=0; i<length; ++i) {
-	  u8 evnt0;
-	  mt->file_pos += mid_parser_read_callback(&evnt0, 1);
-	  midi_package.evnt0 = evnt0;
+	  midi_package.evnt0 = MID_PARSER_TrackReadByte(mt);
 	  if( mid_parser_playevent_callback != NULL )
 	    mid_parser_playevent_callback(track, midi_package, mt->tick);
 	}
       } else if( event == 0xff ) { // Meta Event
-	u8 meta;
-	mt->file_pos += mid_parser_read_callback(&meta, 1);
-	u32 length = (u32)MID_PARSER_ReadVarLen(&mt->file_pos);
+	u8 meta = MID_PARSER_TrackReadByte(mt);
+	u32 length = MID_PARSER_TrackReadVarLen(mt);
 
 	if( mid_parser_playmeta_callback != NULL ) {
 	  u32 buflen = length;
@@ -367,14 +423,11 @@ s32 MID_PARSER_FetchEvents(u32 tick_offset, u32 num_ticks)
 
 	  if( buflen ) {
 	    // copy bytes into buffer
-	    mt->file_pos += mid_parser_read_callback(meta_buffer, buflen);
+	    MID_PARSER_TrackRead(mt, meta_buffer, buflen);
 
 	    if( length > buflen ) {
-	      // no free memory: dummy reads
-	      int i;
-	      u8 dummy;
-	      for(i=buflen; i<length; ++i)
-		mt->file_pos += mid_parser_read_callback(&dummy, 1);
+	      // no free memory: skip remaining bytes
+	      MID_PARSER_TrackSkip(mt, length - buflen);
 	    }
 	  }
 
@@ -382,6 +435,8 @@ s32 MID_PARSER_FetchEvents(u32 tick_offset, u32 num_ticks)
 	  
 	  // -> forward to callback function
 	  mid_parser_playmeta_callback(track, meta, buflen, meta_buffer, mt->tick);
+	} else {
+	  MID_PARSER_TrackSkip(mt, length);
 	}
       } else { // common MIDI event
 	mios32_midi_package_t midi_package;
@@ -389,9 +444,7 @@ s32 MID_PARSER_FetchEvents(u32 tick_offset, u32 num_ticks)
 	if( event & 0x80 ) {
 	  mt->running_status = event;
 	  midi_package.evnt0 = event;
-	  u8 evnt1;
-	  mt->file_pos += mid_parser_read_callback(&evnt1, 1);
-	  midi_package.evnt1 = evnt1;
+	  midi_package.evnt1 = MID_PARSER_TrackReadByte(mt);
 	} else {
 	  midi_package.evnt0 = mt->running_status;
 	  midi_package.evnt1 = event;
@@ -405,9 +458,7 @@ s32 MID_PARSER_FetchEvents(u32 tick_offset, u32 num_ticks)
 	  case CC:
 	  case PitchBend:
 	  {
-	    u8 evnt2;
-	    mt->file_pos += mid_parser_read_callback(&evnt2, 1);
-	    midi_package.evnt2 = evnt2;
+	    midi_package.evnt2 = MID_PARSER_TrackReadByte(mt);
 
 	    if( mid_parser_playevent_callback != NULL )
 	      mid_parser_playevent_callback(track, midi_package, mt->tick);
@@ -434,7 +485,7 @@ s32 MID_PARSER_FetchEvents(u32 tick_offset, u32 num_ticks)
 
       // get delta length to next event if end of track hasn't been reached yet
       if( mt->file_pos < mt->chunk_end ) {
-	u32 delta = (u32)MID_PARSER_ReadVarLen(&mt->file_pos);
+	u32 delta = MID_PARSER_TrackReadVarLen(mt);
 	mt->tick += delta;
       }
     }
@@ -486,6 +537,122 @@ static u32 MID_PARSER_ReadVarLen(u32 *pos)
 }
 
 
+#if MID_PARSER_TRACK_CACHE_SIZE
+/////////////////////////////////////////////////////////////////////////////
+// Help function: refills the read-ahead cache of a track from the current
+// file position up to the end of the track chunk
+// returns < 0 on read errors
+/////////////////////////////////////////////////////////////////////////////
+static s32 MID_PARSER_TrackCacheFill(midi_track_t *mt)
+{
+  u32 len = MID_PARSER_TRACK_CACHE_SIZE;
+  if( mt->file_pos > mt->chunk_end )
+    len = 1; // corrupted track: take the byte behind the chunk like without cache
+  else if( (mt->chunk_end + 1 - mt->file_pos) < len )
+    len = mt->chunk_end + 1 - mt->file_pos;
+
+  mid_parser_seek_callback(mt->file_pos);
+  u32 num_read = mid_parser_read_callback(mt->cache, len);
+
+  mt->cache_file_pos = mt->file_pos;
+  mt->cache_len = (num_read <= len) ? num_read : 0; // read callbacks could return a (negative) error code
+
+  return mt->cache_len ? 0 : -1;
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// Help function: reads a byte from the current track position
+/////////////////////////////////////////////////////////////////////////////
+static u8 MID_PARSER_TrackReadByte(midi_track_t *mt)
+{
+#if MID_PARSER_TRACK_CACHE_SIZE
+  // note: also covers file_pos < cache_file_pos due to the unsigned subtraction
+  u32 offset = mt->file_pos - mt->cache_file_pos;
+  if( offset >= mt->cache_len ) {
+    if( MID_PARSER_TrackCacheFill(mt) < 0 ) {
+      mt->file_pos = mt->chunk_end; // read error: stop track
+      return 0;
+    }
+    offset = 0;
+  }
+
+  ++mt->file_pos;
+  return mt->cache[offset];
+#else
+  u8 byte = 0;
+  mt->file_pos += mid_parser_read_callback(&byte, 1);
+  return byte;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Help function: reads a number of bytes from the current track position
+// returns the number of read bytes
+/////////////////////////////////////////////////////////////////////////////
+static u32 MID_PARSER_TrackRead(midi_track_t *mt, u8 *buffer, u32 len)
+{
+#if MID_PARSER_TRACK_CACHE_SIZE
+  u32 num_read = 0;
+  while( num_read < len ) {
+    u32 offset = mt->file_pos - mt->cache_file_pos;
+    if( offset >= mt->cache_len ) {
+      if( MID_PARSER_TrackCacheFill(mt) < 0 ) {
+	mt->file_pos = mt->chunk_end; // read error: stop track
+	break;
+      }
+      offset = 0;
+    }
+
+    u32 num_bytes = mt->cache_len - offset;
+    if( num_bytes > (len - num_read) )
+      num_bytes = len - num_read;
+    memcpy(buffer + num_read, &mt->cache[offset], num_bytes);
+    num_read += num_bytes;
+    mt->file_pos += num_bytes;
+  }
+
+  return num_read;
+#else
+  u32 num_read = mid_parser_read_callback(buffer, len);
+  mt->file_pos += num_read;
+  return num_read;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Help function: skips a number of bytes
+/////////////////////////////////////////////////////////////////////////////
+static s32 MID_PARSER_TrackSkip(midi_track_t *mt, u32 len)
+{
+  mt->file_pos += len;
+#if !MID_PARSER_TRACK_CACHE_SIZE
+  mid_parser_seek_callback(mt->file_pos);
+#endif
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Help function: reads a variable-length number from the current track position
+/////////////////////////////////////////////////////////////////////////////
+static u32 MID_PARSER_TrackReadVarLen(midi_track_t *mt)
+{
+  u32 value;
+  u8 c;
+
+  if( (value = (c = MID_PARSER_TrackReadByte(mt))) & 0x80 ) {
+    value &= 0x7f;
+
+    do {
+      c = MID_PARSER_TrackReadByte(mt);
+      value = (value << 7) | (c & 0x7f);
+    } while( c & 0x80 );
+  }
+
+  return value;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Restarts a song w/o reading the .mid file chunks again (saves time)
 /////////////////////////////////////////////////////////////////////////////
@@ -503,3 +670,228 @@ s32 MID_PARSER_RestartSong(void)
   return 0; // no error
 }
 
+
+/////////////////////////////////////////////////////////////////////////////
+// Sets the song position to the given tick without playing the events
+// which are located before this tick.
+// If chase is set, the last Bank Select, Program Change, Pitch Bend and
+// some common CCs are played at the new position (only with seek index)
+/////////////////////////////////////////////////////////////////////////////
+s32 MID_PARSER_SeekTick(u32 tick, u8 chase)
+{
+  if( mid_parser_read_callback == NULL ||
+      mid_parser_eof_callback == NULL ||
+      mid_parser_seek_callback == NULL )
+    return -1; // missing callback functions
+
+  if( file_valid == 0 )
+    return 0; // nothing to do
+
+  s32 (*playevent_callback)(u8 track, mios32_midi_package_t midi_package, u32 tick) = mid_parser_playevent_callback;
+  s32 (*playmeta_callback)(u8 track, u8 meta, u32 len, u8 *buffer, u32 tick) = mid_parser_playmeta_callback;
+
+#if MID_PARSER_SEEK_INDEX_SIZE
+  // search for the last checkpoint before the new position
+  u32 start_tick = 0;
+  int i;
+  for(i=seek_index_num-1; i>=0 && seek_index[i].tick > tick; --i);
+
+  if( i < 0 ) {
+    MID_PARSER_RestartSong();
+    memset(chase_value, CHASE_NOT_SET, sizeof(chase_value));
+  } else {
+    midi_seek_point_t *sp = &seek_index[i];
+    start_tick = sp->tick;
+
+    u8 track;
+    midi_track_t *mt = &midi_tracks[0];
+    midi_track_pos_t *tp = &sp->track[0];
+    for(track=0; track<midi_tracks_num; ++mt, ++tp, ++track) {
+      mt->file_pos = tp->file_pos;
+      mt->running_status = tp->running_status;
+      mt->tick = tp->tick;
+    }
+
+    memcpy(chase_value, sp->chase_value, sizeof(chase_value));
+  }
+  memset(chase_tick, 0, sizeof(chase_tick));
+
+  // parse the remaining ticks, only controllers are recorded
+  mid_parser_playevent_callback = MID_PARSER_ChaseEvent;
+  mid_parser_playmeta_callback = NULL;
+  if( tick > start_tick )
+    MID_PARSER_FetchEvents(start_tick, tick - start_tick);
+  mid_parser_playevent_callback = playevent_callback;
+  mid_parser_playmeta_callback = playmeta_callback;
+
+  // play chased controllers
+  if( chase && mid_parser_playevent_callback != NULL ) {
+    u8 chn;
+    for(chn=0; chn<16; ++chn) {
+      u8 *value = &chase_value[chn][0];
+      for(i=0; i<CHASE_NUM; ++i) {
+	if( value[i] == CHASE_NOT_SET )
+	  continue;
+
+	mios32_midi_package_t midi_package;
+	midi_package.ALL = 0;
+	midi_package.chn = chn;
+	switch( chase_event[i] ) {
+	case CHASE_PROGRAM_CHANGE:
+	  midi_package.event = ProgramChange;
+	  midi_package.evnt1 = value[i];
+	  break;
+	case CHASE_PITCHBEND_LSB:
+	  continue; // sent together with MSB
+	case CHASE_PITCHBEND_MSB:
+	  midi_package.event = PitchBend;
+	  midi_package.evnt1 = (value[i-1] == CHASE_NOT_SET) ? 0 : value[i-1];
+	  midi_package.evnt2 = value[i];
+	  break;
+	default:
+	  midi_package.event = CC;
+	  midi_package.evnt1 = chase_event[i];
+	  midi_package.evnt2 = value[i];
+	}
+	midi_package.type = midi_package.event;
+
+	mid_parser_playevent_callback(0, midi_package, tick);
+      }
+    }
+  }
+#else
+  // no seek index: silently parse from the beginning of the song
+  MID_PARSER_RestartSong();
+
+  mid_parser_playevent_callback = NULL;
+  mid_parser_playmeta_callback = NULL;
+  MID_PARSER_FetchEvents(0, tick);
+  mid_parser_playevent_callback = playevent_callback;
+  mid_parser_playmeta_callback = playmeta_callback;
+#endif
+
+  return 0; // no error
+}
+
+
+#if MID_PARSER_SEEK_INDEX_SIZE
+/////////////////////////////////////////////////////////////////////////////
+// Help function: records the controllers which are chased by MID_PARSER_SeekTick()
+// (installed as event callback while the song is parsed silently)
+/////////////////////////////////////////////////////////////////////////////
+static s32 MID_PARSER_ChaseEvent(u8 track, mios32_midi_package_t midi_package, u32 tick)
+{
+  u8 chn = midi_package.chn;
+  int i;
+
+  // events of different tracks are not fetched in chronological order
+  // therefore the tick is stored for each value, and a value is only overwritten by a later event
+  switch( midi_package.event ) {
+  case ProgramChange:
+    for(i=0; i<CHASE_NUM && chase_event[i] != CHASE_PROGRAM_CHANGE; ++i);
+    if( tick >= chase_tick[chn][i] ) {
+      chase_value[chn][i] = midi_package.evnt1;
+      chase_tick[chn][i] = tick;
+    }
+    break;
+
+  case PitchBend:
+    for(i=0; i<CHASE_NUM && chase_event[i] != CHASE_PITCHBEND_LSB; ++i);
+    if( tick >= chase_tick[chn][i] ) {
+      chase_value[chn][i] = midi_package.evnt1;
+      chase_tick[chn][i] = tick;
+      chase_value[chn][i+1] = midi_package.evnt2;
+      chase_tick[chn][i+1] = tick;
+    }
+    break;
+
+  case CC:
+    for(i=0; i<CHASE_NUM; ++i) {
+      if( chase_event[i] == midi_package.evnt1 ) {
+	if( tick >= chase_tick[chn][i] ) {
+	  chase_value[chn][i] = midi_package.evnt2;
+	  chase_tick[chn][i] = tick;
+	}
+	break;
+      }
+    }
+    break;
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Help function: parses the complete song once, and stores checkpoints
+// for MID_PARSER_SeekTick()
+/////////////////////////////////////////////////////////////////////////////
+static s32 MID_PARSER_SeekIndexBuild(void)
+{
+  seek_index_num = 0;
+  seek_index_interval = 4 * (midifile_ppqn ? midifile_ppqn : 384);
+
+  // file positions are stored with 24 bit
+  {
+    u8 track;
+    for(track=0; track<midi_tracks_num; ++track)
+      if( midi_tracks[track].chunk_end >= (1 << 24) )
+	return -1; // no index
+  }
+
+  s32 (*playevent_callback)(u8 track, mios32_midi_package_t midi_package, u32 tick) = mid_parser_playevent_callback;
+  s32 (*playmeta_callback)(u8 track, u8 meta, u32 len, u8 *buffer, u32 tick) = mid_parser_playmeta_callback;
+  mid_parser_playevent_callback = MID_PARSER_ChaseEvent;
+  mid_parser_playmeta_callback = NULL;
+
+  MID_PARSER_RestartSong();
+  memset(chase_value, CHASE_NOT_SET, sizeof(chase_value));
+  memset(chase_tick, 0, sizeof(chase_tick));
+
+  u32 tick = 0;
+  while( 1 ) {
+    // fetch up to the next checkpoint
+    u32 next_tick = (tick / seek_index_interval + 1) * seek_index_interval;
+    if( MID_PARSER_FetchEvents(tick, next_tick - tick) <= 0 )
+      break; // end of song reached
+    tick = next_tick;
+
+    if( seek_index_num >= MID_PARSER_SEEK_INDEX_SIZE ) {
+      // index full: double the interval, only keep the checkpoints at even multiples of the previous interval
+      int i;
+      for(i=1; i<MID_PARSER_SEEK_INDEX_SIZE; i+=2)
+	seek_index[i/2] = seek_index[i];
+      seek_index_num = MID_PARSER_SEEK_INDEX_SIZE / 2;
+      seek_index_interval *= 2;
+    }
+
+    if( (tick % seek_index_interval) == 0 ) {
+      midi_seek_point_t *sp = &seek_index[seek_index_num++];
+      sp->tick = tick;
+
+      u8 track;
+      midi_track_t *mt = &midi_tracks[0];
+      midi_track_pos_t *tp = &sp->track[0];
+      for(track=0; track<midi_tracks_num; ++mt, ++tp, ++track) {
+	tp->file_pos = mt->file_pos;
+	tp->running_status = mt->running_status;
+	tp->tick = mt->tick;
+      }
+
+      memcpy(sp->chase_value, chase_value, sizeof(chase_value));
+    }
+  }
+
+  mid_parser_playevent_callback = playevent_callback;
+  mid_parser_playmeta_callback = playmeta_callback;
+
+  MID_PARSER_RestartSong();
+
+#if DEBUG_VERBOSE_LEVEL >= 1
+  DEBUG_MSG("[MID_PARSER] Seek index: %d checkpoints, interval %u ticks\n\r", seek_index_num, seek_index_interval);
+#endif
+
+  return 0; // no error
+}
+#endif
+
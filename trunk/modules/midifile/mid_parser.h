@@ -27,6 +27,32 @@
 #define MID_PARSER_META_BUFFER_SIZE 80
 #endif
 
+// read-ahead cache for each track (in bytes)
+// MID_PARSER_FetchEvents() accesses the file only if the cache of a track has to be refilled
+// instead of seeking and reading byte by byte for each event.
+// Allocates MID_PARSER_MAX_TRACKS * MID_PARSER_TRACK_CACHE_SIZE bytes, set to 0 to disable the cache
+#ifndef MID_PARSER_TRACK_CACHE_SIZE
+# if defined(MIOS32_FAMILY_STM32F4xx)
+#  define MID_PARSER_TRACK_CACHE_SIZE 256
+# else
+#  define MID_PARSER_TRACK_CACHE_SIZE 0
+# endif
+#endif
+
+// number of checkpoints which are stored by MID_PARSER_Read() for MID_PARSER_SeekTick()
+// A checkpoint contains the position of all tracks, and the chased controllers of all channels.
+// The checkpoint distance starts at one bar (4/4) and is doubled whenever the song doesn't fit.
+// Each checkpoint allocates 4 + 8*MID_PARSER_MAX_TRACKS + 16*12 bytes.
+// Set to 0 to disable the index: MID_PARSER_SeekTick() will parse from the beginning of the song
+// and doesn't chase controllers.
+#ifndef MID_PARSER_SEEK_INDEX_SIZE
+# if defined(MIOS32_FAMILY_STM32F4xx)
+#  define MID_PARSER_SEEK_INDEX_SIZE 16
+# else
+#  define MID_PARSER_SEEK_INDEX_SIZE 0
+# endif
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -46,6 +72,7 @@ extern s32 MID_PARSER_FileIsValid(void);
 extern s32 MID_PARSER_Read(void);
 extern s32 MID_PARSER_FetchEvents(u32 tick_offset, u32 num_ticks);
 extern s32 MID_PARSER_RestartSong(void);
+extern s32 MID_PARSER_SeekTick(u32 tick, u8 chase);
 
 extern s32 MIDI_PARSER_FormatGet(void);
 extern s32 MIDI_PARSER_PPQN_Get(void);
@@ -20,6 +20,13 @@ THUMB_SOURCE += \
 	$(MIOS32_PATH)/modules/msd/STM32F4xx/msd.c
 endif
 
+# no USB device on the host: the dummy driver of STM32F4xx can be used as well
+ifeq ($(FAMILY),HOST)
+C_INCLUDE += -I $(MIOS32_PATH)/modules/msd/STM32F4xx
+THUMB_SOURCE += \
+	$(MIOS32_PATH)/modules/msd/STM32F4xx/msd.c
+endif
+
 ifeq ($(FAMILY),LPC17xx)
 C_INCLUDE += -I $(MIOS32_PATH)/modules/msd/LPC17xx
 THUMB_SOURCE += \
@@ -0,0 +1,15 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host test
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+#define OPL3_COUNT 2
+#define OPL3_CS_PINS  {12,13}
+#define OPL3_CS_MASKS {1<<4,1<<5}
+
+#define DEBUG_MSG MIOS32_MIDI_SendDebugMessage
+
+#endif /* _MIOS32_CONFIG_H */
@@ -0,0 +1,270 @@
+// $Id$
+/*
+ * Host test for the OPL3 register refresh
+ *
+ * Register writes are captured by OPL3EMU_SendAddrData() into a register
+ * log and a register file per chip. Random OPL3_SetX() calls are done
+ * between the frames, and the test checks that OPL3_OnFrame():
+ *   - writes each register at most once per frame
+ *   - writes operators, channels and chip registers in this order, and
+ *     each of them in chip order
+ *   - keeps the register file consistent with a full refresh
+ *   - reports the number of writes in the statistics
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <gnu_test.h>
+
+#include "opl3.h"
+
+extern s32 OPL3_AddOperQueue(u8 op, u8 reg);
+extern s32 OPL3_AddChanQueue(u8 chan, u8 reg);
+extern s32 OPL3_AddChipQueue(u8 chip, u8 reg);
+extern s32 OPL3_RefreshOperator(u8 op, u8 reg);
+extern s32 OPL3_RefreshChannel(u8 chan, u8 reg);
+extern s32 OPL3_RefreshChip(u8 chip, u8 reg);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32 stand-ins
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J10_PinInit(u8 pin, mios32_board_pin_mode_t mode) { return 0; }
+s32 MIOS32_BOARD_J10_PinSet(u8 pin, u8 value) { return 0; }
+
+
+/////////////////////////////////////////////////////////////////////////////
+// register log
+/////////////////////////////////////////////////////////////////////////////
+#define LOG_SIZE 4096
+
+typedef struct {
+  u8 chip;
+  u8 addrhigh;
+  u8 addr;
+  u8 data;
+} log_entry_t;
+
+static log_entry_t reg_log[LOG_SIZE];
+static int reg_log_len;
+static u8 reg_file[OPL3_COUNT][512];
+
+s32 OPL3EMU_SendAddrData(u8 chip, u8 addrhigh, u8 addr, u8 data)
+{
+  if( chip >= OPL3_COUNT ) {
+    printf("FAILED: write to invalid chip %d\n", chip);
+    exit(1);
+  }
+
+  if( reg_log_len < LOG_SIZE ) {
+    log_entry_t *e = &reg_log[reg_log_len++];
+    e->chip = chip;
+    e->addrhigh = addrhigh;
+    e->addr = addr;
+    e->data = data;
+  }
+
+  reg_file[chip][(addrhigh ? 256 : 0) + addr] = data;
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// helpers
+/////////////////////////////////////////////////////////////////////////////
+// 0: operator, 1: channel, 2: chip register
+static int reg_class(const log_entry_t *e)
+{
+  if( (e->addrhigh && (e->addr == 0x04 || e->addr == 0x05)) ||
+      (!e->addrhigh && (e->addr == 0x08 || e->addr == 0xbd)) )
+    return 2;
+  if( e->addr >= 0xa0 && e->addr <= 0xc8 )
+    return 1;
+  return 0;
+}
+
+// refreshes all registers from the driver variables, returns 0 if nothing has changed
+static int full_refresh_differs(void)
+{
+  static u8 prev[OPL3_COUNT][512];
+  int i, j, len = reg_log_len;
+
+  memcpy(prev, reg_file, sizeof(reg_file));
+  for(i=0; i<OPL3_COUNT; ++i)
+    for(j=0; j<4; ++j)
+      OPL3_RefreshChip(i, j);
+  for(i=0; i<36*OPL3_COUNT; ++i)
+    for(j=0; j<5; ++j)
+      OPL3_RefreshOperator(i, j);
+  for(i=0; i<18*OPL3_COUNT; ++i)
+    for(j=0; j<3; ++j)
+      OPL3_RefreshChannel(i, j);
+  reg_log_len = len;
+
+  return memcmp(prev, reg_file, sizeof(reg_file)) != 0;
+}
+
+typedef s32 (*setter_t)(u8 index, u8 value);
+
+static const setter_t op_setters[] = {
+  OPL3_SetFMult, OPL3_SetWaveform, OPL3_SetVibrato, OPL3_SetVolume, OPL3_SetTremelo, OPL3_SetKSL,
+  OPL3_SetAttack, OPL3_SetDecay, OPL3_DoSustain, OPL3_SetSustain, OPL3_SetRelease, OPL3_SetKSR,
+};
+
+static const setter_t chan_setters[] = {
+  OPL3_Gate, OPL3_SetFeedback, OPL3_SetAlgorithm, OPL3_OutLeft, OPL3_OutRight, OPL3_Out3, OPL3_Out4,
+  OPL3_SetDest, OPL3_SetFourOp,
+};
+
+static const setter_t chip_setters[] = {
+  OPL3_SetOpl3Mode, OPL3_SetNoteSel, OPL3_SetCSW, OPL3_SetVibratoDepth, OPL3_SetTremeloDepth,
+  OPL3_SetPercussionMode, OPL3_TriggerBD, OPL3_TriggerSD, OPL3_TriggerTT, OPL3_TriggerHH, OPL3_TriggerCY,
+};
+
+#define NUM(a) (sizeof(a)/sizeof(a[0]))
+
+static void random_set(void)
+{
+  switch( rand() % 4 ) {
+  case 0:
+  case 1:
+    op_setters[rand() % NUM(op_setters)](rand() % (36*OPL3_COUNT), rand());
+    break;
+  case 2:
+    if( rand() & 1 )
+      OPL3_SetFrequency(rand() % (18*OPL3_COUNT), rand() & 0x3ff, rand() & 7);
+    else
+      chan_setters[rand() % NUM(chan_setters)](rand() % (18*OPL3_COUNT), rand());
+    break;
+  default:
+    chip_setters[rand() % NUM(chip_setters)](rand() % OPL3_COUNT, rand());
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  int frame, i, j;
+  opl3_stats_t stats;
+
+  OPL3_Init();
+  CHECK(reg_log_len > 0, "OPL3_Init() didn't write any register");
+
+  // idle frame: no writes
+  OPL3_StatsClear();
+  reg_log_len = 0;
+  OPL3_OnFrame();
+  OPL3_StatsGet(&stats);
+  CHECK(reg_log_len == 0, "idle frame wrote %d registers", reg_log_len);
+  CHECK(stats.frames == 1 && stats.writes == 0 && stats.writes_last_frame == 0, "idle frame statistics");
+
+  // invalid requests are rejected
+  CHECK(OPL3_AddOperQueue(36*OPL3_COUNT, 0) == -9001, "invalid op accepted");
+  CHECK(OPL3_AddOperQueue(0, 5) == -9001, "invalid op reg accepted");
+  CHECK(OPL3_AddChanQueue(18*OPL3_COUNT, 0) == -9001, "invalid chan accepted");
+  CHECK(OPL3_AddChanQueue(0, 3) == -9001, "invalid chan reg accepted");
+  CHECK(OPL3_AddChipQueue(OPL3_COUNT, 0) == -9001, "invalid chip accepted");
+  CHECK(OPL3_AddChipQueue(0, 4) == -9001, "invalid chip reg accepted");
+  OPL3_OnFrame();
+  CHECK(reg_log_len == 0, "invalid requests wrote %d registers", reg_log_len);
+
+  // multiple changes of a register are coalesced into a single write of the last value
+  for(i=0; i<10; ++i)
+    OPL3_SetVolume(40, i);
+  OPL3_SetAttack(40, 3);
+  OPL3_SetDecay(40, 5);
+  OPL3_OnFrame();
+  CHECK(reg_log_len == 2, "coalesced frame wrote %d registers, expected 2", reg_log_len);
+  if( reg_log_len == 2 ) {
+    // operator 40 is operator 4 of the second chip -> OPL3 channel 1, offset 0x01
+    CHECK(reg_log[0].chip == 1 && reg_log[0].addrhigh == 0 && reg_log[0].addr == 0x41 && reg_log[0].data == (63-9),
+	  "volume write %d:%d:%02x:%02x", reg_log[0].chip, reg_log[0].addrhigh, reg_log[0].addr, reg_log[0].data);
+    CHECK(reg_log[1].chip == 1 && reg_log[1].addrhigh == 0 && reg_log[1].addr == 0x61,
+	  "attack/decay write %d:%d:%02x:%02x", reg_log[1].chip, reg_log[1].addrhigh, reg_log[1].addr, reg_log[1].data);
+  }
+
+  // frequency and key on: A0 is written before B0 (channel 20 is OPL3 channel 1 of the second chip)
+  reg_log_len = 0;
+  OPL3_Gate(20, 1);
+  OPL3_SetFrequency(20, 0x2aa, 4);
+  OPL3_OnFrame();
+  CHECK(reg_log_len == 2 && reg_log[0].addr == 0xa1 && reg_log[1].addr == 0xb1 && (reg_log[1].data & 0x20),
+	"frequency/gate writes");
+
+  // random changes, starting from registers which match the driver variables
+  // (OPL3_Init() sent the demo patch directly)
+  full_refresh_differs();
+  srand(1);
+  OPL3_StatsClear();
+  for(frame=0; frame<2000; ++frame) {
+    int num_sets = rand() % 200;
+    u32 requests_before;
+
+    OPL3_StatsGet(&stats);
+    requests_before = stats.requests;
+
+    for(i=0; i<num_sets; ++i)
+      random_set();
+
+    reg_log_len = 0;
+    OPL3_OnFrame();
+    OPL3_StatsGet(&stats);
+
+    CHECK(stats.writes_last_frame == reg_log_len, "frame %d: statistics report %d writes, logged %d",
+	  frame, stats.writes_last_frame, reg_log_len);
+    CHECK(reg_log_len <= stats.requests - requests_before, "frame %d: more writes than requests", frame);
+
+    for(i=0; i<reg_log_len; ++i) {
+      for(j=i+1; j<reg_log_len; ++j) {
+	if( reg_log[i].chip == reg_log[j].chip && reg_log[i].addrhigh == reg_log[j].addrhigh &&
+	    reg_log[i].addr == reg_log[j].addr ) {
+	  CHECK(0, "frame %d: register %d:%d:%02x written twice", frame, reg_log[i].chip, reg_log[i].addrhigh, reg_log[i].addr);
+	}
+      }
+
+      if( i > 0 ) {
+	int c0 = reg_class(&reg_log[i-1]);
+	int c1 = reg_class(&reg_log[i]);
+	CHECK(c0 < c1 || (c0 == c1 && reg_log[i-1].chip <= reg_log[i].chip),
+	      "frame %d: write %d (%d:%d:%02x) out of order", frame, i, reg_log[i].chip, reg_log[i].addrhigh, reg_log[i].addr);
+      }
+    }
+
+    CHECK(!full_refresh_differs(), "frame %d: registers not up to date", frame);
+
+    if( num_errors > 10 )
+      break;
+  }
+
+  OPL3_StatsGet(&stats);
+  printf("%d frames: %d requests, %d register writes (max. %d per frame)\n",
+	 (int)stats.frames, (int)stats.requests, (int)stats.writes, (int)stats.writes_max_frame);
+
+  // benchmark: requests + refresh with all registers changing
+  {
+    clock_t start = clock();
+    int n;
+    for(n=0; n<2000; ++n) {
+      for(i=0; i<36*OPL3_COUNT; ++i) {
+	OPL3_SetVolume(i, n + i);
+	OPL3_SetAttack(i, n);
+      }
+      for(i=0; i<18*OPL3_COUNT; ++i)
+	OPL3_SetFrequency(i, n, 3);
+      reg_log_len = 0;
+      OPL3_OnFrame();
+    }
+    fprintf(stderr, "%d requests + OPL3_OnFrame(): %.1f uS per frame (host)\n",
+	    2*36*OPL3_COUNT + 2*18*OPL3_COUNT, (double)(clock() - start) * 1000000.0 / CLOCKS_PER_SEC / 2000);
+  }
+
+  return GNU_TEST_Result();
+}
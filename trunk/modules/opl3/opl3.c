@@ -29,8 +29,18 @@
 // Help Macros
 /////////////////////////////////////////////////////////////////////////////
 
+#if defined(MIOS32_FAMILY_EMULATION)
+# define OPL3_PIN_RS_0  { }
+# define OPL3_PIN_RS_1  { }
+#else
 # define OPL3_PIN_RS_0  { MIOS32_SYS_STM_PINSET(OPL3_RS_PORT, OPL3_RS_PIN, 0); }
 # define OPL3_PIN_RS_1  { MIOS32_SYS_STM_PINSET(OPL3_RS_PORT, OPL3_RS_PIN, 1); }
+#endif
+
+//Number of words of the dirty bitmaps (one bit per register, index*regs+reg)
+#define OPL3_OP_MAP_SIZE   ((36*5*OPL3_COUNT+31)/32)
+#define OPL3_CHAN_MAP_SIZE ((18*3*OPL3_COUNT+31)/32)
+#define OPL3_CHIP_MAP_SIZE ((4*OPL3_COUNT+31)/32)
 
 /////////////////////////////////////////////////////////////////////////////
 // Global variables
@@ -44,13 +54,15 @@ opl3_chip_t opl3_chip[OPL3_COUNT];
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
 
-// Queues for what registers need to be updated
-static u16 opl3_op_queue[36*5*OPL3_COUNT];
-static u8 opl3_chan_queue[18*3*OPL3_COUNT];
-static u8 opl3_chip_queue[4*OPL3_COUNT];
-static u16 op_queue_idx;
-static u8 chan_queue_idx;
-static u8 chip_queue_idx;
+// Dirty bitmaps for what registers need to be updated
+// Bit 31 of word 0 is register 0 of operator/channel/chip 0, so that the
+// registers are refreshed in chip/address order by OPL3_OnFrame()
+static u32 opl3_op_dirty[OPL3_OP_MAP_SIZE];
+static u32 opl3_chan_dirty[OPL3_CHAN_MAP_SIZE];
+static u32 opl3_chip_dirty[OPL3_CHIP_MAP_SIZE];
+
+// Write statistics
+static opl3_stats_t opl3_stats;
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -59,7 +71,9 @@ static u8 chip_queue_idx;
 
 //Put defined pins/masks from preprocessor into Flash
 static const u32 OPL3CSPins [OPL3_COUNT] = OPL3_CS_PINS;
+#if !defined(MIOS32_FAMILY_EMULATION)
 static const u32 OPL3CSMasks[OPL3_COUNT] = OPL3_CS_MASKS;
+#endif
 
 static const u8 OPL3OperRegBegin[5] = {
   0x20, 0x40, 0x60, 0x80, 0xE0
@@ -110,6 +124,10 @@ static const u8 OPL3ChannelMap[18] = {
 */
 
 s32 OPL3_SendAddrData(u8 chip, u8 addrhigh, u8 addr, u8 data){
+#if defined(MIOS32_FAMILY_EMULATION)
+  //No port E available: forward the write to the emulation
+  return OPL3EMU_SendAddrData(chip, addrhigh, addr, data);
+#else
   //Turn off interrupts
   MIOS32_IRQ_Disable();
   //-------------------------------------------------------------
@@ -159,6 +177,7 @@ s32 OPL3_SendAddrData(u8 chip, u8 addrhigh, u8 addr, u8 data){
   //Turn on interrupts
   MIOS32_IRQ_Enable();
   return 0;
+#endif
 }
 
 s32 OPL3_RefreshOperator(u8 op, u8 reg){
@@ -189,7 +208,8 @@ s32 OPL3_RefreshChannel(u8 chan, u8 reg){
 }
 
 s32 OPL3_RefreshChip(u8 chip, u8 reg){
-  if(reg >= 4*OPL3_COUNT) return -1;
+  if(chip >= OPL3_COUNT) return -1;
+  if(reg >= 4) return -1;
   u8 addrhigh = OPL3ChipRegHigh[reg];
   u8 addr = OPL3ChipReg[reg];
   u8 data = opl3_chip[chip].ALL[reg];
@@ -222,6 +242,7 @@ s32 OPL3_Init(){
   MIOS32_BOARD_J10_PinInit(15, MIOS32_BOARD_PIN_MODE_OUTPUT_PP);
   //RS
   //Copied from MIOS32_BOARD_PinInitHlp(OPL3_RS_PORT, OPL3_RS_PIN, MIOS32_BOARD_PIN_MODE_OUTPUT_PP);
+#if !defined(MIOS32_FAMILY_EMULATION)
   {
     GPIO_InitTypeDef GPIO_InitStructure;
     GPIO_StructInit(&GPIO_InitStructure);
@@ -231,6 +252,7 @@ s32 OPL3_Init(){
     GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
     GPIO_Init(OPL3_RS_PORT, &GPIO_InitStructure);
   }
+#endif
   OPL3_PIN_RS_1;
   //CSes
   for(i=0; i<OPL3_COUNT; i++){
@@ -299,126 +321,114 @@ void OPL3_SendDemoPatch(){
 }
 
 u8 toggle;
-s32 OPL3_OnFrame(){
-  u8 op, chan, chip, reg;
-  u16 val, q=0;
-  while(q < op_queue_idx){
-    if(q >= 36*5*OPL3_COUNT){
-      DEBUG_MSG("PANIC!! [opl3.c] Op queue overflow q==%d!", q);
-    }
-    val = opl3_op_queue[q];
-    op = val / 5;
-    reg = val % 5;
-    OPL3_RefreshOperator(op, reg);
-    q++;
-  }
-  op_queue_idx = 0;
-  q = 0;
-  if(chan_queue_idx > 20){
-    DEBUG_MSG("chan_queue_idx=%d", chan_queue_idx);
-  }
-  while(q < chan_queue_idx){
-    if(q >= 18*3*OPL3_COUNT){
-      DEBUG_MSG("PANIC!! [opl3.c] Chan queue overflow q==%d!", q);
-    }
-    val = opl3_chan_queue[q];
-    chan = val / 3;
-    reg = val % 3;
-    OPL3_RefreshChannel(chan, reg);
-    q++;
-  }
-  chan_queue_idx = 0;
-  q = 0;
-  while(q < chip_queue_idx){
-    if(q >= 4*OPL3_COUNT){
-      DEBUG_MSG("PANIC!! [opl3.c] Chip queue overflow q==%d!", q);
+
+//Refreshes all registers which are flagged in the given dirty bitmap, in ascending order.
+//Returns the number of register writes.
+static u16 OPL3_FlushDirtyMap(u32 *map, u8 map_size, u8 num_regs, s32 (*refresh)(u8 index, u8 reg)){
+  u16 num_writes = 0;
+  u8 w;
+  for(w=0; w<map_size; w++){
+    //Get and clear the flags - must be atomic, since registers could be flagged from an interrupt
+    MIOS32_IRQ_Disable();
+    u32 pending = map[w];
+    map[w] = 0;
+    MIOS32_IRQ_Enable();
+
+    while(pending){
+      u32 bit = __builtin_clz(pending); //Single CLZ instruction on Cortex-M4
+      pending &= ~(0x80000000 >> bit);
+      u16 val = 32*w + bit;
+      refresh(val / num_regs, val % num_regs);
+      num_writes++;
     }
-    val = opl3_chip_queue[q];
-    chip = val / 4;
-    reg = val % 4;
-    OPL3_RefreshChip(chip, reg);
-    q++;
   }
-  chip_queue_idx = 0;
+  return num_writes;
+}
+
+s32 OPL3_OnFrame(){
+  u16 num_writes;
+  //Operators first, then channels (key on), then chip registers (percussion triggers)
+  num_writes  = OPL3_FlushDirtyMap(opl3_op_dirty, OPL3_OP_MAP_SIZE, 5, OPL3_RefreshOperator);
+  num_writes += OPL3_FlushDirtyMap(opl3_chan_dirty, OPL3_CHAN_MAP_SIZE, 3, OPL3_RefreshChannel);
+  num_writes += OPL3_FlushDirtyMap(opl3_chip_dirty, OPL3_CHIP_MAP_SIZE, 4, OPL3_RefreshChip);
+
+  opl3_stats.frames++;
+  opl3_stats.writes += num_writes;
+  opl3_stats.writes_last_frame = num_writes;
+  if(num_writes > opl3_stats.writes_max_frame){
+    opl3_stats.writes_max_frame = num_writes;
+  }
+  return 0;
+}
+
+s32 OPL3_StatsGet(opl3_stats_t *stats){
+  MIOS32_IRQ_Disable();
+  *stats = opl3_stats;
+  MIOS32_IRQ_Enable();
+  return 0;
+}
+
+s32 OPL3_StatsClear(){
+  MIOS32_IRQ_Disable();
+  opl3_stats.frames = 0;
+  opl3_stats.writes = 0;
+  opl3_stats.requests = 0;
+  opl3_stats.writes_last_frame = 0;
+  opl3_stats.writes_max_frame = 0;
+  MIOS32_IRQ_Enable();
   return 0;
 }
 
 
 s32 OPL3_AddOperQueue(u8 op, u8 reg){
   if(op >= 36*OPL3_COUNT){
-    DEBUG_MSG("PANIC!! [opl3.c] Invalid op %d passed to OPL3_AddOperQueue! op_queue_idx=%d", op, op_queue_idx);
+    DEBUG_MSG("PANIC!! [opl3.c] Invalid op %d passed to OPL3_AddOperQueue!", op);
     return -9001;
   }
   if(reg >= 5){
-    DEBUG_MSG("PANIC!! [opl3.c] Invalid reg %d passed to OPL3_AddOperQueue! op_queue_idx=%d", reg, op_queue_idx);
+    DEBUG_MSG("PANIC!! [opl3.c] Invalid reg %d passed to OPL3_AddOperQueue!", reg);
     return -9001;
   }
   u16 val = (0x0005*((u16)op))+reg;
-  //See if it's on the queue
-  u16 q;
-  for(q=0; q<op_queue_idx; q++){
-    if(opl3_op_queue[q] == val){
-      return 0;
-    }
-  }
-  opl3_op_queue[op_queue_idx] = val;
-  op_queue_idx++;
-  if(op_queue_idx >= 36*5*OPL3_COUNT){
-    DEBUG_MSG("PANIC!! [opl3.c] Op queue overflow on write op_queue_idx==%d!", op_queue_idx);
-    op_queue_idx = (36*5*OPL3_COUNT)-1;
-  }
+  //Flag it; a register which is already flagged is only written once
+  MIOS32_IRQ_Disable(); //The read-modify-write must not lose flags set from an interrupt
+  opl3_op_dirty[val >> 5] |= 0x80000000 >> (val & 31);
+  opl3_stats.requests++;
+  MIOS32_IRQ_Enable();
   return 0;
 }
 
 s32 OPL3_AddChanQueue(u8 chan, u8 reg){
   if(chan >= 18*OPL3_COUNT){
-    DEBUG_MSG("PANIC!! [opl3.c] Invalid chan %d passed to OPL3_AddChanQueue! chan_queue_idx=%d", chan, chan_queue_idx);
+    DEBUG_MSG("PANIC!! [opl3.c] Invalid chan %d passed to OPL3_AddChanQueue!", chan);
     return -9001;
   }
   if(reg >= 3){
-    DEBUG_MSG("PANIC!! [opl3.c] Invalid reg %d passed to OPL3_AddChanQueue! chan_queue_idx=%d", reg, chan_queue_idx);
+    DEBUG_MSG("PANIC!! [opl3.c] Invalid reg %d passed to OPL3_AddChanQueue!", reg);
     return -9001;
   }
-  u8 val = (3*chan)+reg;
-  //See if it's on the queue
-  u8 q;
-  for(q=0; q<chan_queue_idx; q++){
-    if(opl3_chan_queue[q] == val){
-      return 0;
-    }
-  }
-  opl3_chan_queue[chan_queue_idx] = val;
-  chan_queue_idx++;
-  if(chan_queue_idx >= 18*3*OPL3_COUNT){
-    DEBUG_MSG("PANIC!! [opl3.c] Chan queue overflow on write chan_queue_idx==%d!", chan_queue_idx);
-    chan_queue_idx = (18*3*OPL3_COUNT)-1;
-  }
+  u16 val = (3*((u16)chan))+reg;
+  MIOS32_IRQ_Disable();
+  opl3_chan_dirty[val >> 5] |= 0x80000000 >> (val & 31);
+  opl3_stats.requests++;
+  MIOS32_IRQ_Enable();
   return 0;
 }
 
 s32 OPL3_AddChipQueue(u8 chip, u8 reg){
   if(chip >= OPL3_COUNT){
-    DEBUG_MSG("PANIC!! [opl3.c] Invalid chip %d passed to OPL3_AddChipQueue! chip_queue_idx=%d", chip, chip_queue_idx);
+    DEBUG_MSG("PANIC!! [opl3.c] Invalid chip %d passed to OPL3_AddChipQueue!", chip);
     return -9001;
   }
   if(reg >= 4){
-    DEBUG_MSG("PANIC!! [opl3.c] Invalid reg %d passed to OPL3_AddChipQueue! chip_queue_idx=%d", reg, chip_queue_idx);
+    DEBUG_MSG("PANIC!! [opl3.c] Invalid reg %d passed to OPL3_AddChipQueue!", reg);
     return -9001;
   }
-  u8 val = (4*chip)+reg;
-  //See if it's on the queue
-  u8 q;
-  for(q=0; q<chip_queue_idx; q++){
-    if(opl3_chip_queue[q] == val){
-      return 0;
-    }
-  }
-  opl3_chip_queue[chip_queue_idx] = val;
-  chip_queue_idx++;
-  if(chip_queue_idx >= 4*OPL3_COUNT){
-    DEBUG_MSG("PANIC!! [opl3.c] Chip queue overflow on write chip_queue_idx==%d!", chip_queue_idx);
-    chip_queue_idx = 4*OPL3_COUNT;
-  }
+  u16 val = (4*((u16)chip))+reg;
+  MIOS32_IRQ_Disable();
+  opl3_chip_dirty[val >> 5] |= 0x80000000 >> (val & 31);
+  opl3_stats.requests++;
+  MIOS32_IRQ_Enable();
   return 0;
 }
 
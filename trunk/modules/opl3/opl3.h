@@ -73,7 +73,7 @@ Chan | 2-Op Mode |   4-Op Mode    |Chan | 2-Op Mode |   4-Op Mode    |
 // Global definitions
 /////////////////////////////////////////////////////////////////////////////
 
-#if !defined(MIOS32_BOARD_STM32F4DISCOVERY) && !defined(MIOS32_BOARD_MBHP_CORE_STM32F4)
+#if !defined(MIOS32_BOARD_STM32F4DISCOVERY) && !defined(MIOS32_BOARD_MBHP_CORE_STM32F4) && !defined(MIOS32_FAMILY_EMULATION)
 #error "OPL3 module only supported for STM32F4 MCU!"
 #endif
 
@@ -186,6 +186,14 @@ typedef union {
   };
 } opl3_chip_t;
 
+typedef struct {
+  u32 frames;            //Number of OPL3_OnFrame() calls
+  u32 writes;            //Number of register writes done by OPL3_OnFrame()
+  u32 requests;          //Number of refresh requests by the OPL3_SetX functions, including the coalesced ones
+  u16 writes_last_frame; //Number of register writes done by the last OPL3_OnFrame() call
+  u16 writes_max_frame;  //Maximum number of register writes done by a single OPL3_OnFrame() call
+} opl3_stats_t;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Export global variables
@@ -221,9 +229,21 @@ extern s32 OPL3_RefreshAll(void);
 extern void OPL3_SendDemoPatch(void);
 
 // Call this after every control refresh. Refreshes any OPL3 registers that have
-// changed since last time.
+// changed since last time. Each register is written at most once per frame,
+// operators first, then channels, then the chip registers, each in chip/address
+// order.
 extern s32 OPL3_OnFrame(void);
 
+// Write statistics of OPL3_OnFrame(), e.g. to check how many of the ~5 uS
+// register writes are done per frame.
+extern s32 OPL3_StatsGet(opl3_stats_t *stats);
+extern s32 OPL3_StatsClear(void);
+
+#if defined(MIOS32_FAMILY_EMULATION)
+// Register writes are forwarded to this function, it has to be provided by the emulation
+extern s32 OPL3EMU_SendAddrData(u8 chip, u8 addrhigh, u8 addr, u8 data);
+#endif
+
 // Convenience functions for interacting with OPL3
 // You MUST use these functions to write data to OPL3 or the OPL3 will not be
 // refreshed with the data on the next frame!
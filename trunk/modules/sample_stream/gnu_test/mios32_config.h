@@ -0,0 +1,15 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host test
+ *
+ * SAMPLE_STREAM_READ_SECTORS and SAMPLE_STREAM_PRELOAD_SECTORS are passed by the makefile
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+#define SAMPLE_STREAM_NUM_STREAMS 16
+#define SAMPLE_STREAM_NUM_VOICES  12
+#define SAMPLE_STREAM_NUM_EXTENTS 8
+
+#endif /* _MIOS32_CONFIG_H */
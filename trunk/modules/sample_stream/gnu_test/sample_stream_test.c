@@ -0,0 +1,446 @@
+// $Id$
+/*
+ * Host test for the sample streaming module
+ *
+ * MIOS32_SDCARD_SectorsRead() is replaced by a file-backed SD Card image,
+ * each 32bit word of the image contains its own sector and word number
+ * (uint32_t, since u32 is 64bit wide on some emulation hosts).
+ * The streams are played like from the audio DMA callback, and each
+ * returned sector is compared against the image:
+ *   - contiguous, fragmented, truncated and very short streams
+ *   - all voices playing at the same time
+ *   - start without prefetched sectors, retrigger, stop
+ *   - underruns and deadline order of the prefetch
+ *   - read errors, and restarts during a read
+ *
+ * Build and run for different configurations with "make test"
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <gnu_test.h>
+
+#include "sample_stream.h"
+
+#define IMAGE_SECTORS 2048
+
+
+/////////////////////////////////////////////////////////////////////////////
+// file-backed SD Card
+/////////////////////////////////////////////////////////////////////////////
+static FILE *image;
+static u32 num_commands;
+static u32 last_read_sector;
+static s32 fail_sector = -1;
+static void (*read_hook)(void);
+
+s32 MIOS32_SDCARD_SectorsRead(u32 sector, u8 *buffer, u32 num_sectors)
+{
+  ++num_commands;
+  last_read_sector = sector;
+
+  if( read_hook ) {
+    void (*hook)(void) = read_hook;
+    read_hook = NULL;
+    hook();
+  }
+
+  if( fail_sector >= (s32)sector && fail_sector < (s32)(sector + num_sectors) )
+    return -257;
+
+  if( sector + num_sectors > IMAGE_SECTORS ||
+      fseek(image, sector*512, SEEK_SET) != 0 ||
+      fread(buffer, 512, num_sectors, image) != num_sectors )
+    return -257;
+
+  return 0;
+}
+
+static void image_create(void)
+{
+  u32 sector, i;
+
+  image = tmpfile();
+  for(sector=0; sector<IMAGE_SECTORS; ++sector)
+    for(i=0; i<128; ++i) {
+      uint32_t word = (sector << 8) | i;
+      fwrite(&word, 4, 1, image);
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// sample files
+/////////////////////////////////////////////////////////////////////////////
+#define MAX_EXTENTS 16
+
+typedef struct {
+  u32 len;
+  u32 num_extents;
+  u32 extent[MAX_EXTENTS][2]; // sector, num_sectors
+} layout_t;
+
+static layout_t layout[SAMPLE_STREAM_NUM_STREAMS];
+static u32 num_layout_sectors[SAMPLE_STREAM_NUM_STREAMS]; // accepted by SAMPLE_STREAM_ExtentAdd
+
+static void layout_add(int stream, u32 sector, u32 num_sectors)
+{
+  layout_t *l = &layout[stream];
+  l->extent[l->num_extents][0] = sector;
+  l->extent[l->num_extents][1] = num_sectors;
+  ++l->num_extents;
+}
+
+static void layouts_create(void)
+{
+  int i;
+
+  // contiguous
+  layout[0].len = 40*512 + 100;
+  layout_add(0, 100, 41);
+
+  // clusters of 8 sectors, partly consecutive
+  layout[1].len = 64*512;
+  layout_add(1, 300, 8);
+  layout_add(1, 308, 8);
+  layout_add(1, 400, 8);
+  layout_add(1, 500, 8);
+  layout_add(1, 508, 8);
+  layout_add(1, 600, 8);
+  layout_add(1, 700, 8);
+  layout_add(1, 800, 8);
+
+  // shorter than a sector
+  layout[2].len = 300;
+  layout_add(2, 900, 1);
+
+  for(i=3; i<12; ++i) {
+    layout[i].len = (20 + 3*i)*512 + 7*i;
+    layout_add(i, 1000 + 100*(i-3), 21 + 3*i);
+  }
+
+  // too many extents: will be truncated
+  layout[12].len = 12*512;
+  for(i=0; i<12; ++i)
+    layout_add(12, 50 + 2*i, 1);
+}
+
+static void streams_open(void)
+{
+  int stream;
+
+  for(stream=0; stream<SAMPLE_STREAM_NUM_STREAMS; ++stream) {
+    layout_t *l = &layout[stream];
+    u32 i;
+
+    if( !l->len )
+      continue;
+
+    SAMPLE_STREAM_Open(stream, l->len);
+    num_layout_sectors[stream] = 0;
+    for(i=0; i<l->num_extents; ++i) {
+      if( SAMPLE_STREAM_ExtentAdd(stream, l->extent[i][0], l->extent[i][1]) < 0 )
+	break;
+      num_layout_sectors[stream] += l->extent[i][1];
+    }
+    SAMPLE_STREAM_Preload(stream);
+  }
+}
+
+static u32 layout_sector(int stream, u32 sector)
+{
+  layout_t *l = &layout[stream];
+  u32 i;
+
+  for(i=0; i<l->num_extents; ++i) {
+    if( sector < l->extent[i][1] )
+      return l->extent[i][0] + sector;
+    sector -= l->extent[i][1];
+  }
+
+  return 0xffffffff;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// player (like the audio DMA callback)
+/////////////////////////////////////////////////////////////////////////////
+static u32 play_pos[SAMPLE_STREAM_NUM_STREAMS]; // next expected sector
+
+// returns the result of SAMPLE_STREAM_Read
+static s32 play(int stream)
+{
+  u8 *buffer;
+  s32 len = SAMPLE_STREAM_Read(stream, &buffer);
+
+  if( len > 0 ) {
+    u32 sector = play_pos[stream]++;
+    u32 phys_sector = layout_sector(stream, sector);
+    u32 expected_len = layout[stream].len - sector*512;
+    uint32_t expected[128];
+    u32 i;
+
+    if( expected_len > 512 )
+      expected_len = 512;
+    CHECK(len == expected_len, "stream %d sector %d: got length %d, expected %d", stream, sector, len, expected_len);
+
+    // bytes behind the end of file are cleared
+    for(i=0; i<128; ++i)
+      expected[i] = (phys_sector << 8) | i;
+    memset((u8 *)expected + expected_len, 0, 512 - expected_len);
+
+    for(i=0; i<512; ++i) {
+      if( buffer[i] != ((u8 *)expected)[i] ) {
+	CHECK(0, "stream %d sector %d byte %d: got 0x%02x, expected 0x%02x", stream, sector, i, buffer[i], ((u8 *)expected)[i]);
+	break;
+      }
+    }
+  }
+
+  return len;
+}
+
+static s32 service_all(void)
+{
+  s32 status;
+  int i;
+
+  for(i=0; i<1000; ++i)
+    if( (status=SAMPLE_STREAM_Service()) <= 0 )
+      return status;
+
+  CHECK(0, "SAMPLE_STREAM_Service() doesn't finish");
+  return 0;
+}
+
+static void start(int stream)
+{
+  s32 voice = SAMPLE_STREAM_Start(stream);
+  CHECK(voice >= 0, "SAMPLE_STREAM_Start(%d) failed with %d", stream, voice);
+  play_pos[stream] = 0;
+}
+
+// plays all streams until they are finished
+static void play_all(void)
+{
+  int stream, playing, period;
+
+  for(period=0; period<1000; ++period) {
+    service_all();
+
+    playing = 0;
+    for(stream=0; stream<SAMPLE_STREAM_NUM_STREAMS; ++stream) {
+      if( SAMPLE_STREAM_IsPlaying(stream) ) {
+	playing = 1;
+	CHECK(play(stream) > 0, "stream %d: sector %d not available", stream, play_pos[stream]);
+      }
+    }
+
+    if( !playing )
+      return;
+  }
+
+  CHECK(0, "streams don't finish");
+}
+
+static u32 stats_reads, stats_sectors, stats_underruns, stats_errors;
+
+static void stats_update(void)
+{
+  sample_stream_stats_t stats;
+  SAMPLE_STREAM_StatsGet(&stats);
+  stats_reads = stats.num_reads;
+  stats_sectors = stats.num_sectors;
+  stats_underruns = stats.num_underruns;
+  stats_errors = stats.num_errors;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// tests
+/////////////////////////////////////////////////////////////////////////////
+static void test_single(void)
+{
+  u32 num_sectors = 41;
+  u32 num_fetched = num_sectors - SAMPLE_STREAM_PRELOAD_SECTORS;
+
+  SAMPLE_STREAM_StatsClear();
+  start(0);
+  play_all();
+  stats_update();
+
+  CHECK(play_pos[0] == num_sectors, "stream 0: played %d sectors, expected %d", play_pos[0], num_sectors);
+  CHECK(stats_sectors == num_fetched, "stream 0: fetched %d sectors, expected %d", stats_sectors, num_fetched);
+  CHECK(stats_reads <= (num_fetched + SAMPLE_STREAM_READ_SECTORS-1) / SAMPLE_STREAM_READ_SECTORS + 1,
+	"stream 0: %d read commands for %d sectors", stats_reads, num_fetched);
+  CHECK(stats_underruns == 0, "stream 0: %d underruns", stats_underruns);
+
+  printf("  single stream: %d sectors fetched with %d read commands\n", stats_sectors, stats_reads);
+}
+
+static void test_all_voices(void)
+{
+  int stream;
+
+  SAMPLE_STREAM_StatsClear();
+  for(stream=0; stream<SAMPLE_STREAM_NUM_VOICES; ++stream)
+    start(stream);
+  CHECK(SAMPLE_STREAM_Start(12) == -1, "SAMPLE_STREAM_Start() should fail if all voices are playing");
+
+  play_all();
+  stats_update();
+
+  for(stream=0; stream<SAMPLE_STREAM_NUM_VOICES; ++stream) {
+    u32 num_sectors = (layout[stream].len + 511) / 512;
+    CHECK(play_pos[stream] == num_sectors, "stream %d: played %d sectors, expected %d", stream, play_pos[stream], num_sectors);
+  }
+  CHECK(stats_underruns == 0, "%d underruns", stats_underruns);
+
+  printf("  %d voices: %d sectors fetched with %d read commands\n", SAMPLE_STREAM_NUM_VOICES, stats_sectors, stats_reads);
+
+  // truncated stream
+  start(12);
+  play_all();
+  CHECK(play_pos[12] == num_layout_sectors[12], "stream 12: played %d sectors, expected %d", play_pos[12], num_layout_sectors[12]);
+}
+
+static void test_start(void)
+{
+  int i;
+
+  // first sector available without prefetch?
+  start(3);
+  s32 len = play(3);
+  if( SAMPLE_STREAM_PRELOAD_SECTORS )
+    CHECK(len == 512, "stream 3: preloaded sector not available");
+  else
+    CHECK(len == 0, "stream 3: sector available without prefetch");
+
+  // play some sectors, and retrigger
+  for(i=0; i<10; ++i) {
+    service_all();
+    play(3);
+  }
+  s32 voice = SAMPLE_STREAM_Start(3);
+  play_pos[3] = 0;
+  CHECK(voice >= 0 && SAMPLE_STREAM_Start(3) == voice, "stream 3: retrigger should keep the voice");
+  service_all();
+  for(i=0; i<10; ++i) {
+    CHECK(play(3) > 0, "stream 3: sector %d not available after retrigger", play_pos[3]);
+    service_all();
+  }
+
+  // stop
+  SAMPLE_STREAM_Stop(3);
+  CHECK(!SAMPLE_STREAM_IsPlaying(3), "stream 3 still playing after stop");
+  CHECK(play(3) == -1, "stream 3: read after stop should fail");
+}
+
+static void test_underrun(void)
+{
+  int i;
+
+  SAMPLE_STREAM_StatsClear();
+  start(4);
+  for(i=0; i<SAMPLE_STREAM_PRELOAD_SECTORS; ++i)
+    CHECK(play(4) == 512, "stream 4: preloaded sector %d not available", i);
+  CHECK(play(4) == 0 && play(4) == 0, "stream 4: sector %d should be missing without prefetch", play_pos[4]);
+  stats_update();
+  CHECK(stats_underruns == 2, "stream 4: got %d underruns, expected 2", stats_underruns);
+
+  // continues without skipping a sector
+  service_all();
+  CHECK(play(4) == 512 && play_pos[4] == SAMPLE_STREAM_PRELOAD_SECTORS+1, "stream 4: sector %d not available after underrun", SAMPLE_STREAM_PRELOAD_SECTORS);
+  SAMPLE_STREAM_Stop(4);
+}
+
+static void test_deadline(void)
+{
+  int i;
+
+  start(5);
+  start(6);
+  service_all();
+
+  // stream 6 has less buffered sectors than stream 5
+  for(i=0; i<6; ++i)
+    play(5);
+  for(i=0; i<7; ++i)
+    play(6);
+
+  CHECK(SAMPLE_STREAM_Service() > 0, "nothing fetched");
+  CHECK(last_read_sector >= layout[6].extent[0][0] && last_read_sector < layout[6].extent[0][0] + layout[6].extent[0][1],
+	"stream 6 should be fetched first");
+  CHECK(SAMPLE_STREAM_Service() > 0, "nothing fetched");
+  CHECK(last_read_sector >= layout[5].extent[0][0] && last_read_sector < layout[5].extent[0][0] + layout[5].extent[0][1],
+	"stream 5 should be fetched next");
+
+  SAMPLE_STREAM_Stop(5);
+  SAMPLE_STREAM_Stop(6);
+  CHECK(service_all() == 0 && SAMPLE_STREAM_Service() == 0, "stopped streams shouldn't be fetched");
+}
+
+static void restart_7(void)
+{
+  SAMPLE_STREAM_Start(7);
+  play_pos[7] = 0;
+}
+
+static void test_errors(void)
+{
+  int i;
+
+  // read error
+  SAMPLE_STREAM_StatsClear();
+  fail_sector = layout_sector(8, SAMPLE_STREAM_PRELOAD_SECTORS + 2);
+  start(8);
+  CHECK(service_all() < 0, "stream 8: read error not reported");
+  CHECK(!SAMPLE_STREAM_IsPlaying(8), "stream 8: should be stopped after read error");
+  stats_update();
+  CHECK(stats_errors == 1, "stream 8: got %d errors, expected 1", stats_errors);
+  fail_sector = -1;
+
+  // restart during read: the fetched sectors are dropped
+  start(7);
+  service_all();
+  for(i=0; i<SAMPLE_STREAM_READ_SECTORS; ++i)
+    play(7);
+  read_hook = restart_7;
+  service_all();
+  for(i=0; i<3*SAMPLE_STREAM_RING_SECTORS; ++i) {
+    CHECK(play(7) > 0, "stream 7: sector %d not available after restart", play_pos[7]);
+    service_all();
+  }
+  SAMPLE_STREAM_Stop(7);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  printf("SAMPLE_STREAM_READ_SECTORS=%d, SAMPLE_STREAM_PRELOAD_SECTORS=%d, SAMPLE_STREAM_RING_SECTORS=%d\n",
+	 SAMPLE_STREAM_READ_SECTORS, SAMPLE_STREAM_PRELOAD_SECTORS, SAMPLE_STREAM_RING_SECTORS);
+
+  image_create();
+  layouts_create();
+
+  SAMPLE_STREAM_Init(0);
+  CHECK(SAMPLE_STREAM_Start(0) == -2, "SAMPLE_STREAM_Start() should fail for a stream which isn't open");
+  streams_open();
+  CHECK(num_layout_sectors[12] == SAMPLE_STREAM_NUM_EXTENTS, "stream 12: %d sectors accepted, expected %d", num_layout_sectors[12], SAMPLE_STREAM_NUM_EXTENTS);
+
+  test_single();
+  test_all_voices();
+  test_start();
+  test_underrun();
+  test_deadline();
+  test_errors();
+
+  return GNU_TEST_Result();
+}
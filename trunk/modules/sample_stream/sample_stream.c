@@ -0,0 +1,498 @@
+// $Id$
+//! \defgroup SAMPLE_STREAM
+//!
+//! Streams sample files from SD Card for multiple voices
+//!
+//! A stream is described by its length and the physical sector ranges
+//! (extents) which are occupied by the file on SD Card. They are determined
+//! by the application while the sample bank is loaded, so that no file system
+//! access is required while the samples are played.
+//!
+//! The first SAMPLE_STREAM_PRELOAD_SECTORS of each stream are preloaded into
+//! RAM, so that a voice can start immediately. The remaining sectors are
+//! fetched into a prefetch buffer of SAMPLE_STREAM_RING_SECTORS per voice by
+//! SAMPLE_STREAM_Service(), which should be called periodically from a task.
+//! Each call fetches up to SAMPLE_STREAM_READ_SECTORS consecutive sectors
+//! with a single multi-block read for the voice with the earliest deadline,
+//! which is the voice with the lowest number of buffered sectors.
+//!
+//! SAMPLE_STREAM_Read() returns the next sector of a playing stream and is
+//! intended to be called from the audio DMA callback.
+//!
+//! Usage Example:
+//!   $MIOS32_PATH/apps/synthesizers/SD card sample player
+//!
+//! \{
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <string.h>
+
+#include "sample_stream.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+#define SECTOR_SIZE 512
+
+#define VOICE_NONE  0xff
+#define STREAM_NONE 0xff
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  u32 sector;
+  u32 num_sectors;
+} extent_t;
+
+typedef struct {
+  u32 len;           // length in bytes
+  u32 num_sectors;   // number of sectors covered by the extents
+  u8  num_extents;
+  u8  num_preloaded; // number of sectors in preload_buffer
+  u8  voice;         // assigned voice, VOICE_NONE if not playing
+  extent_t extent[SAMPLE_STREAM_NUM_EXTENTS];
+} stream_t;
+
+typedef struct {
+  u8  stream;        // assigned stream, STREAM_NONE if voice is free
+  u8  generation;    // incremented whenever the voice is (re)assigned
+  u32 play_sector;   // next sector which will be returned by SAMPLE_STREAM_Read
+  u32 fetch_sector;  // next sector which will be fetched by SAMPLE_STREAM_Service
+} voice_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static stream_t streams[SAMPLE_STREAM_NUM_STREAMS];
+static voice_t voices[SAMPLE_STREAM_NUM_VOICES];
+
+#if SAMPLE_STREAM_PRELOAD_SECTORS
+static u8 preload_buffer[SAMPLE_STREAM_NUM_STREAMS][SAMPLE_STREAM_PRELOAD_SECTORS*SECTOR_SIZE];
+#endif
+static u8 ring_buffer[SAMPLE_STREAM_NUM_VOICES][SAMPLE_STREAM_RING_SECTORS*SECTOR_SIZE];
+
+static sample_stream_stats_t stats;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes the streaming module, closes all streams
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 SAMPLE_STREAM_Init(u32 mode)
+{
+  int i;
+
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  MIOS32_IRQ_Disable();
+  for(i=0; i<SAMPLE_STREAM_NUM_VOICES; ++i) {
+    voices[i].stream = STREAM_NONE;
+    ++voices[i].generation;
+  }
+
+  for(i=0; i<SAMPLE_STREAM_NUM_STREAMS; ++i) {
+    streams[i].len = 0;
+    streams[i].num_sectors = 0;
+    streams[i].num_extents = 0;
+    streams[i].num_preloaded = 0;
+    streams[i].voice = VOICE_NONE;
+  }
+  MIOS32_IRQ_Enable();
+
+  return SAMPLE_STREAM_StatsClear();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! (Re-)opens a stream. The sectors have to be added with
+//! SAMPLE_STREAM_ExtentAdd() afterwards, and the attack can be preloaded
+//! with SAMPLE_STREAM_Preload()
+//! \param[in] stream stream number (0..SAMPLE_STREAM_NUM_STREAMS-1)
+//! \param[in] len length of the sample file in bytes
+//! \return < 0 if invalid stream
+/////////////////////////////////////////////////////////////////////////////
+s32 SAMPLE_STREAM_Open(u8 stream, u32 len)
+{
+  if( stream >= SAMPLE_STREAM_NUM_STREAMS )
+    return -1; // invalid stream
+
+  SAMPLE_STREAM_Stop(stream);
+
+  stream_t *s = &streams[stream];
+  s->len = len;
+  s->num_sectors = 0;
+  s->num_extents = 0;
+  s->num_preloaded = 0;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Adds a range of consecutive sectors to a stream. Has to be called in
+//! the order of the file content (e.g. for each cluster).
+//! Ranges which follow the previous range directly are merged, so that
+//! they can be fetched with a single multi-block read.
+//! \param[in] stream stream number (0..SAMPLE_STREAM_NUM_STREAMS-1)
+//! \param[in] sector first physical sector of the range
+//! \param[in] num_sectors number of sectors
+//! \return < 0 if invalid stream
+//! \return -2 if SAMPLE_STREAM_NUM_EXTENTS exceeded (the stream will be truncated)
+/////////////////////////////////////////////////////////////////////////////
+s32 SAMPLE_STREAM_ExtentAdd(u8 stream, u32 sector, u32 num_sectors)
+{
+  if( stream >= SAMPLE_STREAM_NUM_STREAMS )
+    return -1; // invalid stream
+
+  stream_t *s = &streams[stream];
+
+  // clip to file length
+  u32 required_sectors = (s->len + SECTOR_SIZE - 1) / SECTOR_SIZE;
+  if( s->num_sectors + num_sectors > required_sectors )
+    num_sectors = required_sectors - s->num_sectors;
+
+  if( !num_sectors )
+    return 0; // nothing to add
+
+  if( s->num_extents ) {
+    extent_t *prev = &s->extent[s->num_extents-1];
+    if( prev->sector + prev->num_sectors == sector ) {
+      prev->num_sectors += num_sectors;
+      s->num_sectors += num_sectors;
+      return 0; // no error
+    }
+  }
+
+  if( s->num_extents >= SAMPLE_STREAM_NUM_EXTENTS )
+    return -2; // too many extents
+
+  extent_t *e = &s->extent[s->num_extents++];
+  e->sector = sector;
+  e->num_sectors = num_sectors;
+  s->num_sectors += num_sectors;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Reads up to max_sectors consecutive sectors of a stream.
+// The read is clipped at the end of the extent which contains the first sector.
+// If the last sector of the stream is read, the bytes behind the end of the
+// file will be cleared.
+// Returns the number of read sectors, or < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+static s32 SAMPLE_STREAM_SectorsRead(stream_t *s, u32 sector, u8 *buffer, u32 max_sectors)
+{
+  extent_t *e = &s->extent[0];
+  u32 offset = sector;
+  int i;
+
+  for(i=0; i<s->num_extents && offset >= e->num_sectors; ++i, ++e)
+    offset -= e->num_sectors;
+  if( i >= s->num_extents )
+    return -1; // sector not covered by extents
+
+  u32 num_sectors = e->num_sectors - offset;
+  if( num_sectors > max_sectors )
+    num_sectors = max_sectors;
+
+  ++stats.num_reads;
+  s32 status = MIOS32_SDCARD_SectorsRead(e->sector + offset, buffer, num_sectors);
+  if( status < 0 ) {
+    ++stats.num_errors;
+    return status;
+  }
+  stats.num_sectors += num_sectors;
+
+  if( sector + num_sectors >= s->num_sectors ) {
+    u32 end_offset = s->len - (s->num_sectors - 1) * SECTOR_SIZE;
+    if( end_offset < SECTOR_SIZE )
+      memset(buffer + (num_sectors-1)*SECTOR_SIZE + end_offset, 0, SECTOR_SIZE - end_offset);
+  }
+
+  return num_sectors;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Preloads the first SAMPLE_STREAM_PRELOAD_SECTORS sectors of a stream
+//! into RAM.
+//! \param[in] stream stream number (0..SAMPLE_STREAM_NUM_STREAMS-1)
+//! \return < 0 if invalid stream or read error
+/////////////////////////////////////////////////////////////////////////////
+s32 SAMPLE_STREAM_Preload(u8 stream)
+{
+  if( stream >= SAMPLE_STREAM_NUM_STREAMS )
+    return -1; // invalid stream
+
+#if SAMPLE_STREAM_PRELOAD_SECTORS
+  stream_t *s = &streams[stream];
+  u32 num_sectors = s->num_sectors;
+  if( num_sectors > SAMPLE_STREAM_PRELOAD_SECTORS )
+    num_sectors = SAMPLE_STREAM_PRELOAD_SECTORS;
+
+  s->num_preloaded = 0;
+
+  u32 sector = 0;
+  while( sector < num_sectors ) {
+    s32 status = SAMPLE_STREAM_SectorsRead(s, sector, &preload_buffer[stream][sector*SECTOR_SIZE], num_sectors - sector);
+    if( status < 0 )
+      return status;
+    sector += status;
+  }
+
+  s->num_preloaded = num_sectors;
+#endif
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Starts to play a stream from the beginning. A stream which is already
+//! playing will be restarted with the same voice.
+//! \param[in] stream stream number (0..SAMPLE_STREAM_NUM_STREAMS-1)
+//! \return the assigned voice
+//! \return -1 if no free voice available
+//! \return -2 if invalid or empty stream
+/////////////////////////////////////////////////////////////////////////////
+s32 SAMPLE_STREAM_Start(u8 stream)
+{
+  if( stream >= SAMPLE_STREAM_NUM_STREAMS || !streams[stream].num_sectors )
+    return -2; // invalid or empty stream
+
+  stream_t *s = &streams[stream];
+
+  MIOS32_IRQ_Disable();
+  u8 voice = s->voice;
+  if( voice == VOICE_NONE ) {
+    for(voice=0; voice<SAMPLE_STREAM_NUM_VOICES; ++voice)
+      if( voices[voice].stream == STREAM_NONE )
+	break;
+
+    if( voice >= SAMPLE_STREAM_NUM_VOICES ) {
+      MIOS32_IRQ_Enable();
+      return -1; // no free voice
+    }
+  }
+
+  voice_t *v = &voices[voice];
+  v->stream = stream;
+  ++v->generation;
+  v->play_sector = 0;
+  v->fetch_sector = s->num_preloaded;
+  s->voice = voice;
+  MIOS32_IRQ_Enable();
+
+  return voice;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Stops a stream and frees its voice
+//! \param[in] stream stream number (0..SAMPLE_STREAM_NUM_STREAMS-1)
+//! \return < 0 if invalid stream
+/////////////////////////////////////////////////////////////////////////////
+s32 SAMPLE_STREAM_Stop(u8 stream)
+{
+  if( stream >= SAMPLE_STREAM_NUM_STREAMS )
+    return -1; // invalid stream
+
+  stream_t *s = &streams[stream];
+
+  MIOS32_IRQ_Disable();
+  if( s->voice != VOICE_NONE ) {
+    voice_t *v = &voices[s->voice];
+    v->stream = STREAM_NONE;
+    ++v->generation;
+    s->voice = VOICE_NONE;
+  }
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \return 1 if the stream is playing, 0 if it has been stopped or reached the end
+/////////////////////////////////////////////////////////////////////////////
+s32 SAMPLE_STREAM_IsPlaying(u8 stream)
+{
+  if( stream >= SAMPLE_STREAM_NUM_STREAMS )
+    return 0; // invalid stream
+
+  return streams[stream].voice != VOICE_NONE;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the next sector of a playing stream. The voice will be freed
+//! once the last sector has been returned.
+//!
+//! Should be called from the audio DMA callback, resp. with disabled
+//! interrupts. The buffer content is valid until the callback returns.
+//! \param[in] stream stream number (0..SAMPLE_STREAM_NUM_STREAMS-1)
+//! \param[out] **buffer pointer to the 512 byte sector (bytes behind the end of file are 0)
+//! \return number of valid bytes in the sector
+//! \return 0 if the sector hasn't been fetched yet (underrun), the stream position is kept
+//! \return -1 if the stream isn't playing
+/////////////////////////////////////////////////////////////////////////////
+s32 SAMPLE_STREAM_Read(u8 stream, u8 **buffer)
+{
+  if( stream >= SAMPLE_STREAM_NUM_STREAMS )
+    return -1; // invalid stream
+
+  stream_t *s = &streams[stream];
+  u8 voice = s->voice;
+  if( voice == VOICE_NONE )
+    return -1; // not playing
+
+  voice_t *v = &voices[voice];
+  u32 sector = v->play_sector;
+  if( sector >= v->fetch_sector ) {
+    ++stats.num_underruns;
+    return 0; // not available yet
+  }
+
+#if SAMPLE_STREAM_PRELOAD_SECTORS
+  if( sector < s->num_preloaded )
+    *buffer = &preload_buffer[stream][sector*SECTOR_SIZE];
+  else
+#endif
+    *buffer = &ring_buffer[voice][((sector - s->num_preloaded) % SAMPLE_STREAM_RING_SECTORS) * SECTOR_SIZE];
+
+  u32 len = s->len - sector*SECTOR_SIZE;
+  if( len > SECTOR_SIZE )
+    len = SECTOR_SIZE;
+
+  if( ++v->play_sector >= s->num_sectors ) {
+    // end of stream reached: free voice
+    v->stream = STREAM_NONE;
+    ++v->generation;
+    s->voice = VOICE_NONE;
+  }
+
+  return len;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Fetches sectors for the voice with the earliest deadline.
+//!
+//! Should be called periodically from a task until it returns 0. The caller
+//! has to ensure exclusive access to the SD Card (e.g. with MUTEX_SDCARD_TAKE)
+//! \return number of fetched sectors, 0 if there is nothing to do
+//! \return < 0 on read errors (the affected stream has been stopped)
+/////////////////////////////////////////////////////////////////////////////
+s32 SAMPLE_STREAM_Service(void)
+{
+  u8 best_voice = VOICE_NONE;
+  u32 best_ready = 0xffffffff;
+  u32 best_free = 0;
+  u8 voice;
+
+  // select the voice with the lowest number of buffered sectors which can take a complete read
+  MIOS32_IRQ_Disable();
+  for(voice=0; voice<SAMPLE_STREAM_NUM_VOICES; ++voice) {
+    voice_t *v = &voices[voice];
+    if( v->stream == STREAM_NONE )
+      continue;
+
+    stream_t *s = &streams[v->stream];
+    u32 limit = (v->play_sector > s->num_preloaded) ? v->play_sector : s->num_preloaded;
+    limit += SAMPLE_STREAM_RING_SECTORS;
+    if( limit > s->num_sectors )
+      limit = s->num_sectors;
+
+    u32 free = limit - v->fetch_sector;
+    if( !free || (free < SAMPLE_STREAM_READ_SECTORS && v->fetch_sector + free < s->num_sectors) )
+      continue;
+
+    u32 ready = v->fetch_sector - v->play_sector;
+    if( ready < best_ready ) {
+      best_voice = voice;
+      best_ready = ready;
+      best_free = free;
+    }
+  }
+
+  if( best_voice == VOICE_NONE ) {
+    MIOS32_IRQ_Enable();
+    return 0; // nothing to do
+  }
+
+  voice_t *v = &voices[best_voice];
+  u8 stream = v->stream;
+  u8 generation = v->generation;
+  u32 fetch_sector = v->fetch_sector;
+  MIOS32_IRQ_Enable();
+
+  // read into the free part of the ring buffer (without wrap-around)
+  stream_t *s = &streams[stream];
+  u32 slot = (fetch_sector - s->num_preloaded) % SAMPLE_STREAM_RING_SECTORS;
+  u32 num_sectors = SAMPLE_STREAM_RING_SECTORS - slot;
+  if( num_sectors > best_free )
+    num_sectors = best_free;
+  if( num_sectors > SAMPLE_STREAM_READ_SECTORS )
+    num_sectors = SAMPLE_STREAM_READ_SECTORS;
+
+  s32 status = SAMPLE_STREAM_SectorsRead(s, fetch_sector, &ring_buffer[best_voice][slot*SECTOR_SIZE], num_sectors);
+
+  // take over the sectors if the voice hasn't been stopped or restarted meanwhile
+  MIOS32_IRQ_Disable();
+  if( v->generation == generation ) {
+    if( status < 0 ) {
+      v->stream = STREAM_NONE;
+      ++v->generation;
+      s->voice = VOICE_NONE;
+    } else {
+      v->fetch_sector = fetch_sector + status;
+    }
+  }
+  MIOS32_IRQ_Enable();
+
+  return status;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the streaming statistics
+//! \param[out] *stats copy of the statistic counters
+/////////////////////////////////////////////////////////////////////////////
+s32 SAMPLE_STREAM_StatsGet(sample_stream_stats_t *_stats)
+{
+  MIOS32_IRQ_Disable();
+  *_stats = stats;
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Clears the streaming statistics
+/////////////////////////////////////////////////////////////////////////////
+s32 SAMPLE_STREAM_StatsClear(void)
+{
+  MIOS32_IRQ_Disable();
+  memset(&stats, 0, sizeof(stats));
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+//! \}
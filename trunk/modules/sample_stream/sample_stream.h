@@ -0,0 +1,102 @@
+// $Id$
+/*
+ * Header file for SD Card Sample Streaming Module
+ */
+
+#ifndef _SAMPLE_STREAM_H
+#define _SAMPLE_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// Global definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// maximum number of streams (sample files) which can be opened
+#ifndef SAMPLE_STREAM_NUM_STREAMS
+#define SAMPLE_STREAM_NUM_STREAMS 64
+#endif
+
+// maximum number of streams which can be played at the same time
+#ifndef SAMPLE_STREAM_NUM_VOICES
+#define SAMPLE_STREAM_NUM_VOICES 8
+#endif
+
+// maximum number of contiguous sector ranges (extents) of a stream
+// files which have just been copied to the SD Card typically consist of a single extent
+#ifndef SAMPLE_STREAM_NUM_EXTENTS
+#define SAMPLE_STREAM_NUM_EXTENTS 8
+#endif
+
+// number of sectors which are preloaded into RAM for each stream, so that a
+// voice can start immediately while the remaining sectors are fetched
+// (costs SAMPLE_STREAM_NUM_STREAMS * SAMPLE_STREAM_PRELOAD_SECTORS * 512 bytes)
+#ifndef SAMPLE_STREAM_PRELOAD_SECTORS
+#define SAMPLE_STREAM_PRELOAD_SECTORS 1
+#endif
+
+// size of the prefetch buffer of each voice in sectors
+// (costs SAMPLE_STREAM_NUM_VOICES * SAMPLE_STREAM_RING_SECTORS * 512 bytes)
+#ifndef SAMPLE_STREAM_RING_SECTORS
+#define SAMPLE_STREAM_RING_SECTORS 8
+#endif
+
+// maximum number of sectors which are fetched with a single multi-block read
+// a voice won't be serviced before this number of sectors is free in its prefetch buffer
+#ifndef SAMPLE_STREAM_READ_SECTORS
+#define SAMPLE_STREAM_READ_SECTORS 4
+#endif
+
+#if SAMPLE_STREAM_NUM_STREAMS > 255 || SAMPLE_STREAM_NUM_VOICES > 255
+# error "SAMPLE_STREAM_NUM_STREAMS and SAMPLE_STREAM_NUM_VOICES are limited to 255"
+#endif
+
+#if SAMPLE_STREAM_READ_SECTORS < 1 || SAMPLE_STREAM_READ_SECTORS > SAMPLE_STREAM_RING_SECTORS
+# error "SAMPLE_STREAM_READ_SECTORS has to be in the range 1..SAMPLE_STREAM_RING_SECTORS"
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global Types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  u32 num_reads;     // number of read commands (each can transfer multiple sectors)
+  u32 num_sectors;   // number of transfered sectors
+  u32 num_underruns; // number of sectors which haven't been available in time
+  u32 num_errors;    // number of failed read commands
+} sample_stream_stats_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+extern s32 SAMPLE_STREAM_Init(u32 mode);
+
+extern s32 SAMPLE_STREAM_Open(u8 stream, u32 len);
+extern s32 SAMPLE_STREAM_ExtentAdd(u8 stream, u32 sector, u32 num_sectors);
+extern s32 SAMPLE_STREAM_Preload(u8 stream);
+
+extern s32 SAMPLE_STREAM_Start(u8 stream);
+extern s32 SAMPLE_STREAM_Stop(u8 stream);
+extern s32 SAMPLE_STREAM_IsPlaying(u8 stream);
+extern s32 SAMPLE_STREAM_Read(u8 stream, u8 **buffer);
+
+extern s32 SAMPLE_STREAM_Service(void);
+
+extern s32 SAMPLE_STREAM_StatsGet(sample_stream_stats_t *stats);
+extern s32 SAMPLE_STREAM_StatsClear(void);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Export global variables
+/////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SAMPLE_STREAM_H */
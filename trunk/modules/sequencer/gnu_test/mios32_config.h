@@ -0,0 +1,16 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host test
+ *
+ * SEQ_MIDI_OUT_MALLOC_METHOD and SEQ_MIDI_OUT_QUEUE_METHOD are
+ * passed by the makefile
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+#define SEQ_MIDI_OUT_MAX_EVENTS 256
+
+#define SEQ_MIDI_OUT_MALLOC_ANALYSIS 1
+
+#endif /* _MIOS32_CONFIG_H */
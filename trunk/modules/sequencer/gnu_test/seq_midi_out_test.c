@@ -0,0 +1,288 @@
+// $Id$
+/*
+ * Host test for the MIDI output scheduler
+ *
+ * Hammers SEQ_MIDI_OUT_Send/ReSchedule/Handler/FlushQueue with random
+ * events and checks that
+ *   - events are never played before or after their timestamp
+ *   - no slot leaks: after each FlushQueue all slots can be allocated again
+ *
+ * With "-order", all combinations of 5 events with the same timestamp are
+ * sent instead, and the order in which they are played is printed.
+ *
+ * With "-bench", a song with 16 tracks and sustained notes is played, which
+ * keeps the queue filled, and the consumed CPU time is printed ("make bench").
+ *
+ * Build and run for all allocation/queue methods with "make test", which
+ * also checks that both queue methods play in the same order.
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#define GNU_TEST_OWN_DEBUG_MESSAGE
+#include <gnu_test.h>
+
+#include "seq_midi_out.h"
+
+#define NUM_TICKS 100000
+#define NUM_IDS   (1 << 15)
+
+// each sent event gets an ID, stored in port (8bit) and evnt1 (7bit)
+typedef struct {
+  u32 timestamp;
+  u32 len;
+  u8  event_type;
+  u8  rescheduled;
+} id_info_t;
+
+static id_info_t id_info[NUM_IDS];
+static u32 next_id;
+
+static u32 bpm_tick;
+static u8  flushing;
+static u8  print_order;
+static u32 num_played;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// stand-ins for MIOS32 and SEQ_BPM functions used by seq_midi_out.c
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t package)
+{
+  u32 id = ((u32)port << 7) | package.evnt1;
+  id_info_t *info = &id_info[id];
+
+  ++num_played;
+
+  if( print_order )
+    printf(" %u%s", id, package.velocity ? "" : "o");
+
+  if( flushing )
+    return 0; // timestamp not relevant
+
+  u32 expected = info->timestamp;
+  if( info->event_type == SEQ_MIDI_OUT_OnOffEvent && package.velocity == 0 )
+    expected += info->len;
+
+  if( info->rescheduled ? (bpm_tick > expected) : (bpm_tick != expected) ) {
+    if( ++num_errors < 10 )
+      printf("ERROR: event %u (type %u) played at tick %u, expected %u\n", id, info->event_type, bpm_tick, expected);
+  }
+
+  return 0;
+}
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+  return 0;
+}
+
+s32 SEQ_BPM_IsRunning(void) { return 1; }
+u32 SEQ_BPM_TickGet(void) { return bpm_tick; }
+s32 SEQ_BPM_Set(float bpm) { return 0; }
+
+
+/////////////////////////////////////////////////////////////////////////////
+// helper functions
+/////////////////////////////////////////////////////////////////////////////
+static s32 send_event(seq_midi_out_event_type_t event_type, u8 tag, u32 timestamp, u32 len)
+{
+  u32 id = next_id++ % NUM_IDS;
+
+  mios32_midi_package_t p;
+  p.ALL = 0;
+  p.type = NoteOn;
+  p.event = NoteOn;
+  p.cable = tag;
+  p.evnt1 = id & 0x7f;
+  p.evnt2 = (event_type == SEQ_MIDI_OUT_OffEvent) ? 0 : 100;
+
+  id_info[id].timestamp = timestamp;
+  id_info[id].len = len;
+  id_info[id].event_type = event_type;
+  id_info[id].rescheduled = 0;
+
+  return SEQ_MIDI_OUT_Send(id >> 7, p, event_type, timestamp, len);
+}
+
+static void check_no_leak(void)
+{
+  if( seq_midi_out_allocated != 0 ) {
+    ++num_errors;
+    printf("ERROR: %u slots still allocated after FlushQueue\n", seq_midi_out_allocated);
+  }
+
+  // all slots have to be available again (Off events are not affected by the failsafe limit)
+  int i;
+  for(i=0; i<SEQ_MIDI_OUT_MAX_EVENTS; ++i) {
+    if( send_event(SEQ_MIDI_OUT_OffEvent, 0, bpm_tick + 1000, 0) < 0 ) {
+      ++num_errors;
+      printf("ERROR: only %d of %d slots could be allocated\n", i, SEQ_MIDI_OUT_MAX_EVENTS);
+      break;
+    }
+  }
+  if( send_event(SEQ_MIDI_OUT_OffEvent, 0, bpm_tick + 1000, 0) >= 0 ) {
+    ++num_errors;
+    printf("ERROR: more than %d slots allocated\n", SEQ_MIDI_OUT_MAX_EVENTS);
+  }
+
+  flushing = 1;
+  SEQ_MIDI_OUT_FlushQueue();
+  flushing = 0;
+
+  if( seq_midi_out_allocated != 0 ) {
+    ++num_errors;
+    printf("ERROR: %u slots still allocated after second FlushQueue\n", seq_midi_out_allocated);
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// sends all combinations of 5 Clk/CC/On/Off/OnOff events with the same
+// timestamp, and prints the order in which they are played
+// The Off events of the OnOff events are played together with the next combination.
+/////////////////////////////////////////////////////////////////////////////
+static void play_order(void)
+{
+  static const seq_midi_out_event_type_t types[5] = {
+    SEQ_MIDI_OUT_ClkEvent, SEQ_MIDI_OUT_CCEvent, SEQ_MIDI_OUT_OnEvent, SEQ_MIDI_OUT_OffEvent, SEQ_MIDI_OUT_OnOffEvent
+  };
+  u32 combination;
+
+  print_order = 1;
+  for(combination=0, bpm_tick=0; combination<5*5*5*5*5; ++combination) {
+    u32 c = combination;
+    int i;
+    for(i=0; i<5; ++i, c /= 5)
+      send_event(types[c % 5], 0, bpm_tick + 1, 2);
+
+    for(i=0; i<2; ++i) {
+      ++bpm_tick;
+      printf("%u:", bpm_tick);
+      SEQ_MIDI_OUT_Handler();
+      printf("\n");
+    }
+  }
+  print_order = 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// plays 16 tracks with a step on each 16th note (96 ppqn): each step sends a
+// CC and a note with random length, and every second step a sustained note
+// whose Off event is sent separately, so that the queue stays filled with
+// many events at the same timestamps
+/////////////////////////////////////////////////////////////////////////////
+static void bench(void)
+{
+  u32 max_ticks = 10*NUM_TICKS;
+  clock_t start = clock();
+
+  flushing = 1; // don't check the timestamps
+  for(bpm_tick=0; bpm_tick<max_ticks; ++bpm_tick) {
+    if( (bpm_tick % 24) == 0 ) {
+      u8 track;
+      for(track=0; track<16; ++track) {
+	u32 timestamp = bpm_tick + 24;
+	send_event(SEQ_MIDI_OUT_CCEvent, 0, timestamp, 0);
+	send_event(SEQ_MIDI_OUT_OnOffEvent, 0, timestamp, 1 + (rand() % 96));
+	if( (bpm_tick % 48) == 0 ) {
+	  send_event(SEQ_MIDI_OUT_OnEvent, 1, timestamp, 0);
+	  send_event(SEQ_MIDI_OUT_OffEvent, 1, timestamp + 4*96, 0);
+	}
+      }
+    }
+
+    SEQ_MIDI_OUT_Handler();
+  }
+  flushing = 0;
+
+  printf("SEQ_MIDI_OUT_MALLOC_METHOD %d, SEQ_MIDI_OUT_QUEUE_METHOD %d: %u events played in %u ticks, max %u allocated: %u mS\n",
+	 SEQ_MIDI_OUT_MALLOC_METHOD, SEQ_MIDI_OUT_QUEUE_METHOD,
+	 num_played, max_ticks, seq_midi_out_max_allocated,
+	 (unsigned)((clock() - start) * 1000 / CLOCKS_PER_SEC));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  srand(42);
+
+  if( argc > 1 && strcmp(argv[1], "-order") == 0 ) {
+    SEQ_MIDI_OUT_Init(0);
+    play_order();
+    return num_errors ? 1 : 0;
+  }
+
+  if( argc > 1 && strcmp(argv[1], "-bench") == 0 ) {
+    SEQ_MIDI_OUT_Init(0);
+    bench();
+    return 0;
+  }
+
+  SEQ_MIDI_OUT_Init(0);
+
+  for(bpm_tick=0; bpm_tick<NUM_TICKS; ++bpm_tick) {
+    // events per tick vary, so that the queue runs full from time to time
+    int num_events = ((bpm_tick / 1000) & 1) ? (rand() % 8) : (rand() % 3);
+    int i;
+    for(i=0; i<num_events; ++i) {
+      int r = rand() % 16;
+      u32 timestamp = bpm_tick + (rand() % 96);
+      if( r == 0 )
+	send_event(SEQ_MIDI_OUT_ClkEvent, 0, timestamp, 0);
+      else if( r <= 3 )
+	send_event(SEQ_MIDI_OUT_CCEvent, 0, timestamp, 0);
+      else if( r <= 6 )
+	send_event(SEQ_MIDI_OUT_OnEvent, 0, timestamp, 0);
+      else if( r <= 9 )
+	send_event(SEQ_MIDI_OUT_OffEvent, 1, timestamp + 96, 0); // tag 1: can be re-scheduled
+      else
+	send_event(SEQ_MIDI_OUT_OnOffEvent, 0, timestamp, 1 + (rand() % 96));
+    }
+
+    // release sustained notes from time to time
+    if( (rand() % 64) == 0 ) {
+      u32 id;
+      for(id=0; id<NUM_IDS; ++id) {
+	if( id_info[id].event_type == SEQ_MIDI_OUT_OffEvent && id_info[id].timestamp > bpm_tick )
+	  id_info[id].rescheduled = 1;
+      }
+      SEQ_MIDI_OUT_ReSchedule(1, SEQ_MIDI_OUT_OffEvent, bpm_tick, NULL);
+    }
+
+    SEQ_MIDI_OUT_Handler();
+
+    if( seq_midi_out_allocated > SEQ_MIDI_OUT_MAX_EVENTS ) {
+      ++num_errors;
+      printf("ERROR: %u slots allocated\n", seq_midi_out_allocated);
+    }
+
+    // stop sequencer from time to time
+    if( (bpm_tick % 10000) == 9999 ) {
+      flushing = 1;
+      SEQ_MIDI_OUT_FlushQueue();
+      flushing = 0;
+      check_no_leak();
+    }
+  }
+
+  printf("SEQ_MIDI_OUT_MALLOC_METHOD %d, SEQ_MIDI_OUT_QUEUE_METHOD %d: %u events played, max %u allocated, %u dropouts - %s\n",
+	 SEQ_MIDI_OUT_MALLOC_METHOD, SEQ_MIDI_OUT_QUEUE_METHOD,
+	 num_played, seq_midi_out_max_allocated, seq_midi_out_dropouts,
+	 num_errors ? "FAILED" : "passed");
+
+  return num_errors ? 1 : 0;
+}
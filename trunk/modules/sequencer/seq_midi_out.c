@@ -48,7 +48,13 @@ typedef struct seq_midi_out_queue_item_t {
   u16                   len;
   mios32_midi_package_t package;
   u32                   timestamp;
+#if SEQ_MIDI_OUT_QUEUE_METHOD == 1
+  u32                   seq:30; // sequence number: keeps the send order of events with same timestamp
+  u32                   group:2; // order of events with same timestamp, see SEQ_MIDI_OUT_QueueInsert()
+  struct seq_midi_out_queue_item_t *group_next; // next group 2 item with same hash, see SEQ_MIDI_OUT_HeapGroup()
+#else
   struct seq_midi_out_queue_item_t *next;
+#endif
 } seq_midi_out_queue_item_t;
 
 
@@ -59,6 +65,16 @@ typedef struct seq_midi_out_queue_item_t {
 static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_SlotMalloc(void);
 static void SEQ_MIDI_OUT_SlotFree(seq_midi_out_queue_item_t *item);
 
+static void SEQ_MIDI_OUT_QueueInsert(seq_midi_out_queue_item_t *new_item);
+static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_QueuePeek(void);
+static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_QueuePop(void);
+#if SEQ_MIDI_OUT_QUEUE_METHOD == 1
+static void SEQ_MIDI_OUT_HeapSiftUp(u32 pos);
+static u8 SEQ_MIDI_OUT_HeapGroup(u8 event_type, u32 timestamp);
+static void SEQ_MIDI_OUT_HeapGroupAdd(seq_midi_out_queue_item_t *item);
+static void SEQ_MIDI_OUT_HeapGroupRemove(seq_midi_out_queue_item_t *item);
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global variables
@@ -83,12 +99,24 @@ static s32 (*callback_bpm_is_running)(void);
 static u32 (*callback_bpm_tick_get)(void);
 static s32 (*callback_bpm_set)(float bpm);
 
+#if SEQ_MIDI_OUT_QUEUE_METHOD == 1
+static seq_midi_out_queue_item_t *heap_items[SEQ_MIDI_OUT_MAX_EVENTS];
+static u32 heap_size;
+static u32 heap_seq;
+
+// queued group 2 items, chained by a hash of the timestamp, so that the group
+// of an Off event is found without searching the heap (see SEQ_MIDI_OUT_HeapGroup())
+#define HEAP_GROUP_HASH_SIZE 32 // must be a power of two
+static seq_midi_out_queue_item_t *heap_group_hash[HEAP_GROUP_HASH_SIZE];
+#else
 static seq_midi_out_queue_item_t *midi_queue;
+#endif
 
 
-#if SEQ_MIDI_OUT_MALLOC_METHOD >= 0 && SEQ_MIDI_OUT_MALLOC_METHOD <= 3
+#if (SEQ_MIDI_OUT_MALLOC_METHOD >= 0 && SEQ_MIDI_OUT_MALLOC_METHOD <= 3) || SEQ_MIDI_OUT_MALLOC_METHOD == 6
 
 // determine flag array width and mask
+// (method 6 only uses the flags to detect invalid SlotFree requests)
 #if SEQ_MIDI_OUT_MALLOC_METHOD == 0
 # define SEQ_MIDI_OUT_MALLOC_FLAG_WIDTH 1
 # define SEQ_MIDI_OUT_MALLOC_FLAG_MASK  1
@@ -110,6 +138,12 @@ static seq_midi_out_queue_item_t *midi_queue;
 // Note: we could easily provide an option for static heap allocation as well
 static seq_midi_out_queue_item_t *alloc_heap;
 static u32 alloc_pos;
+
+#if SEQ_MIDI_OUT_MALLOC_METHOD == 6
+// stack of free slot numbers: SlotMalloc pops, SlotFree pushes
+static u16 alloc_free_slots[SEQ_MIDI_OUT_MAX_EVENTS];
+static u32 alloc_free_num;
+#endif
 #endif
 
 #if SEQ_MIDI_OUT_SUPPORT_DELAY
@@ -323,7 +357,6 @@ s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_packag
     new_item->event_type = event_type;
     new_item->timestamp = timestamp;
     new_item->len = len;
-    new_item->next = NULL;
   }
 
 #if DEBUG_VERBOSE_LEVEL >= 2
@@ -333,74 +366,8 @@ s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_packag
   DEBUG_MSG("[SEQ_MIDI_OUT_Send:%u] (tag %d) %02x %02x %02x len:%u @%u\n", timestamp, midi_package.cable, midi_package.evnt0, midi_package.evnt1, midi_package.evnt2, len, SEQ_BPM_TickGet());
 #endif
 
-  // search in queue for last item which has the same (or earlier) timestamp
-  seq_midi_out_queue_item_t *item;
-  if( (item=midi_queue) == NULL ) {
-    // no item in queue -- first element
-    midi_queue = new_item;
-  } else {
-    u8 insert_before_item = 0;
-    seq_midi_out_queue_item_t *last_item = NULL;
-    seq_midi_out_queue_item_t *next_item;
-    do {
-      // Clock and Tempo events are sorted before CC and Note events at a given timestamp
-      if( (event_type == SEQ_MIDI_OUT_ClkEvent || event_type == SEQ_MIDI_OUT_TempoEvent ) && 
-	  item->timestamp >= timestamp &&
-	  (item->event_type == SEQ_MIDI_OUT_OnEvent || 
-	   item->event_type == SEQ_MIDI_OUT_OffEvent || 
-	   item->event_type == SEQ_MIDI_OUT_OnOffEvent || 
-	   item->event_type == SEQ_MIDI_OUT_CCEvent) ) {
-	// found any event with same timestamp, insert clock before these events
-	// note that the Clock event order doesn't get lost if clock events 
-	// are queued at the same timestamp (e.g. MIDI start -> MIDI clock)
-	insert_before_item = 1;
-	break;
-      }
-
-      // CCs are sorted before notes at a given timestamp
-      // (new CC before On events at the same timestamp)
-      // CCs are still played after Off or Clock events
-      if( event_type == SEQ_MIDI_OUT_CCEvent && 
-	  item->timestamp == timestamp &&
-	  (item->event_type == SEQ_MIDI_OUT_OnEvent || item->event_type == SEQ_MIDI_OUT_OnOffEvent) ) {
-	// found On event with same timestamp, play CC before On event
-	insert_before_item = 1;
-	break;
-      }
-
-      if( item->timestamp > timestamp ) {
-	// found entry with later timestamp
-	insert_before_item = 1;
-	break;
-      }
-
-      if( (next_item=item->next) == NULL ) {
-	// end of queue reached, insert new item at the end
-	break;
-      }
-	
-      if( next_item->timestamp > timestamp ) {
-	// found entry with later timestamp
-	break;
-      }
-
-      // switch to next item
-      last_item = item;
-      item = next_item;
-    } while( 1 );
-
-    // insert/add item into/to list
-    if( insert_before_item ) {
-      if( last_item == NULL )
-	midi_queue = new_item;
-      else
-	last_item->next = new_item;
-      new_item->next = item;
-    } else {
-      item->next = new_item;
-      new_item->next = next_item;
-    }
-  }
+  // put item into queue
+  SEQ_MIDI_OUT_QueueInsert(new_item);
 
   // schedule off event now if length > 16bit (since it cannot be stored in event record)
   if( event_type == SEQ_MIDI_OUT_OnOffEvent && len > 0xffff ) {
@@ -408,9 +375,9 @@ s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_packag
   }
 
   // display queue
-#if DEBUG_VERBOSE_LEVEL >= 4
+#if DEBUG_VERBOSE_LEVEL >= 4 && SEQ_MIDI_OUT_QUEUE_METHOD == 0
   DEBUG_MSG("--- vvv ---\n");
-  item=midi_queue;
+  seq_midi_out_queue_item_t *item=midi_queue;
   while( item != NULL ) {
     DEBUG_MSG("[%u] (tag %d) %02x %02x %02x len:%u @%u\n", item->timestamp, item->package.cable, item->package.evnt0, item->package.evnt1, item->package.evnt2, item->len, SEQ_BPM_TickGet());
     item = item->next;
@@ -450,6 +417,46 @@ s32 SEQ_MIDI_OUT_ReSchedule(u8 tag, seq_midi_out_event_type_t event_type, u32 ti
 {
   // search in queue for items with the given tag
 
+#if SEQ_MIDI_OUT_QUEUE_METHOD == 1
+  // the timestamp of matching items is changed in place, so that no memory has to be re-allocated.
+  // Since the new timestamp is always earlier, an item can only move to a lower heap position,
+  // and items which are moved to a higher position have already been checked.
+  u32 i;
+  for(i=0; i<heap_size; ++i) {
+    seq_midi_out_queue_item_t *item = heap_items[i];
+    u8 evnt1 = item->package.evnt1;
+    if( (item->event_type == event_type) && (item->package.cable == tag) &&
+	(reschedule_filter == NULL ||
+	 !(reschedule_filter[evnt1>>5] & (1 << (evnt1 & 0x1f)))) ) {
+
+      u32 delayed_timestamp = timestamp;
+#if SEQ_MIDI_OUT_SUPPORT_DELAY
+      if( item->port < PPQN_DELAY_NUM ) {
+	s8 delay = ppqn_delay[item->port];
+	if( (delay < 0) && (delayed_timestamp < -delay) ) {
+	  delayed_timestamp = 0;
+	} else {
+	  delayed_timestamp += delay;
+	}
+      }
+#endif
+      if( item->timestamp <= delayed_timestamp )
+	continue;
+
+#if DEBUG_VERBOSE_LEVEL >= 2
+      DEBUG_MSG("[SEQ_MIDI_OUT_ReSchedule:%u] (tag %d) %02x %02x %02x @%u\n", timestamp, item->package.cable, item->package.evnt0, item->package.evnt1, item->package.evnt2, SEQ_BPM_TickGet());
+#endif
+
+      // re-schedule item at new timestamp (will be played after all events which have been sent before)
+      SEQ_MIDI_OUT_HeapGroupRemove(item);
+      item->group = SEQ_MIDI_OUT_HeapGroup(item->event_type, delayed_timestamp);
+      item->timestamp = delayed_timestamp;
+      SEQ_MIDI_OUT_HeapGroupAdd(item);
+      item->seq = heap_seq++;
+      SEQ_MIDI_OUT_HeapSiftUp(i);
+    }
+  }
+#else
   seq_midi_out_queue_item_t *prev_item = NULL;
   seq_midi_out_queue_item_t *item = midi_queue;
   while( item != NULL ) {
@@ -535,6 +542,7 @@ s32 SEQ_MIDI_OUT_ReSchedule(u8 tag, seq_midi_out_event_type_t event_type, u32 ti
       item = item->next;
     }
   }
+#endif
 
   return 0; // no error
 }
@@ -547,13 +555,12 @@ s32 SEQ_MIDI_OUT_ReSchedule(u8 tag, seq_midi_out_event_type_t event_type, u32 ti
 s32 SEQ_MIDI_OUT_FlushQueue(void)
 {
   seq_midi_out_queue_item_t *item;
-  while( (item=midi_queue) != NULL ) {
+  while( (item=SEQ_MIDI_OUT_QueuePop()) != NULL ) {
     if( item->event_type == SEQ_MIDI_OUT_OffEvent || item->event_type == SEQ_MIDI_OUT_OnOffEvent ) {
       item->package.velocity = 0; // ensure that velocity is 0
       callback_midi_send_package(item->port, item->package);
     }
 
-    midi_queue = item->next;
     SEQ_MIDI_OUT_SlotFree(item);
   }
 
@@ -569,8 +576,7 @@ s32 SEQ_MIDI_OUT_FreeHeap(void)
 {
   // ensure that all items are delocated
   seq_midi_out_queue_item_t *item;
-  while( (item=midi_queue) != NULL ) {
-    midi_queue = item->next;
+  while( (item=SEQ_MIDI_OUT_QueuePop()) != NULL ) {
     SEQ_MIDI_OUT_SlotFree(item);
   }
 
@@ -591,6 +597,13 @@ s32 SEQ_MIDI_OUT_FreeHeap(void)
   int i;
   for(i=0; i<(SEQ_MIDI_OUT_MAX_EVENTS/SEQ_MIDI_OUT_MALLOC_FLAG_WIDTH); ++i)
     alloc_flags[i] = 0;
+
+#if SEQ_MIDI_OUT_MALLOC_METHOD == 6
+  // the lowest slot number should be taken first
+  for(i=0; i<SEQ_MIDI_OUT_MAX_EVENTS; ++i)
+    alloc_free_slots[i] = SEQ_MIDI_OUT_MAX_EVENTS-1-i;
+  alloc_free_num = SEQ_MIDI_OUT_MAX_EVENTS;
+#endif
 #endif
 
   return 0; // no error
@@ -614,7 +627,7 @@ s32 SEQ_MIDI_OUT_Handler(void)
   // has been found which has to be played later than now
 
   seq_midi_out_queue_item_t *item;
-  while( (item=midi_queue) != NULL && item->timestamp <= callback_bpm_tick_get() ) {
+  while( (item=SEQ_MIDI_OUT_QueuePeek()) != NULL && item->timestamp <= callback_bpm_tick_get() ) {
 #if DEBUG_VERBOSE_LEVEL >= 2
 #if DEBUG_VERBOSE_LEVEL == 2
     if( item->event_type != SEQ_MIDI_OUT_ClkEvent )
@@ -642,12 +655,11 @@ s32 SEQ_MIDI_OUT_Handler(void)
       copy.len = item->len;
       copy.package.ALL = item->package.ALL;
       copy.timestamp = item->timestamp;
-      copy.next = item->next;
 #endif
       copy.package.velocity = 0; // ensure that velocity is 0
 
       // remove item from queue
-      midi_queue = item->next;
+      SEQ_MIDI_OUT_QueuePop();
       SEQ_MIDI_OUT_SlotFree(item);
 
       u32 delayed_timestamp = copy.len + copy.timestamp;
@@ -666,7 +678,7 @@ s32 SEQ_MIDI_OUT_Handler(void)
       SEQ_MIDI_OUT_Send(copy.port, copy.package, SEQ_MIDI_OUT_OffEvent, delayed_timestamp, 0);
     } else {
       // remove item from queue
-      midi_queue = item->next;
+      SEQ_MIDI_OUT_QueuePop();
       SEQ_MIDI_OUT_SlotFree(item);
     }
   }
@@ -675,6 +687,235 @@ s32 SEQ_MIDI_OUT_Handler(void)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local functions to access the queue
+/////////////////////////////////////////////////////////////////////////////
+#if SEQ_MIDI_OUT_QUEUE_METHOD == 1
+
+// returns 1 if item a has to be played before item b
+static inline u8 SEQ_MIDI_OUT_HeapLess(seq_midi_out_queue_item_t *a, seq_midi_out_queue_item_t *b)
+{
+  if( a->timestamp != b->timestamp )
+    return a->timestamp < b->timestamp;
+
+  if( a->group != b->group )
+    return a->group < b->group;
+
+  // same group: play in send order (wrap-around safe for the 30bit sequence number)
+  return (s32)(((u32)a->seq - (u32)b->seq) << 2) < 0;
+}
+
+// hash of a timestamp for heap_group_hash[]
+// (multiplicative, since step timestamps are usually multiples of a power of two)
+static inline u32 SEQ_MIDI_OUT_HeapGroupHash(u32 timestamp)
+{
+  // bit 31..27 of the product for HEAP_GROUP_HASH_SIZE 32
+  return ((timestamp * 2654435761u) >> 27) & (HEAP_GROUP_HASH_SIZE-1);
+}
+
+// returns the group of a new event, which determines the order at a given timestamp
+// like in the list based queue:
+// group 0: Clock and Tempo events
+// group 1: CC events, and Off events sent before any On event
+// group 2: the first On event and all following On/Off events
+// within a group, events are played in send order, so that CCs are still
+// played after Off events which have been sent before (e.g. Sustain after Note Off)
+static u8 SEQ_MIDI_OUT_HeapGroup(u8 event_type, u32 timestamp)
+{
+  switch( event_type ) {
+  case SEQ_MIDI_OUT_ClkEvent:
+  case SEQ_MIDI_OUT_TempoEvent:
+    return 0;
+  case SEQ_MIDI_OUT_CCEvent:
+    return 1;
+  case SEQ_MIDI_OUT_OffEvent: {
+    // group 2 if a group 2 item with the same timestamp is queued
+    seq_midi_out_queue_item_t *item = heap_group_hash[SEQ_MIDI_OUT_HeapGroupHash(timestamp)];
+    for(; item != NULL; item=item->group_next) {
+      if( item->timestamp == timestamp )
+	return 2;
+    }
+    return 1;
+  }
+  }
+  return 2;
+}
+
+// adds a group 2 item to the hash chain of its timestamp
+static void SEQ_MIDI_OUT_HeapGroupAdd(seq_midi_out_queue_item_t *item)
+{
+  if( item->group == 2 ) {
+    seq_midi_out_queue_item_t **head = &heap_group_hash[SEQ_MIDI_OUT_HeapGroupHash(item->timestamp)];
+    item->group_next = *head;
+    *head = item;
+  }
+}
+
+// removes a group 2 item from the hash chain of its timestamp
+static void SEQ_MIDI_OUT_HeapGroupRemove(seq_midi_out_queue_item_t *item)
+{
+  if( item->group == 2 ) {
+    seq_midi_out_queue_item_t **link = &heap_group_hash[SEQ_MIDI_OUT_HeapGroupHash(item->timestamp)];
+    while( *link != item )
+      link = &(*link)->group_next;
+    *link = item->group_next;
+  }
+}
+
+static void SEQ_MIDI_OUT_HeapSiftUp(u32 pos)
+{
+  seq_midi_out_queue_item_t *item = heap_items[pos];
+  while( pos > 0 ) {
+    u32 parent = (pos-1) >> 1;
+    if( !SEQ_MIDI_OUT_HeapLess(item, heap_items[parent]) )
+      break;
+    heap_items[pos] = heap_items[parent];
+    pos = parent;
+  }
+  heap_items[pos] = item;
+}
+
+static void SEQ_MIDI_OUT_HeapSiftDown(u32 pos)
+{
+  seq_midi_out_queue_item_t *item = heap_items[pos];
+  u32 child;
+  while( (child=2*pos+1) < heap_size ) {
+    if( (child+1) < heap_size && SEQ_MIDI_OUT_HeapLess(heap_items[child+1], heap_items[child]) )
+      ++child;
+    if( !SEQ_MIDI_OUT_HeapLess(heap_items[child], item) )
+      break;
+    heap_items[pos] = heap_items[child];
+    pos = child;
+  }
+  heap_items[pos] = item;
+}
+
+static void SEQ_MIDI_OUT_QueueInsert(seq_midi_out_queue_item_t *new_item)
+{
+  // the number of items is limited by SEQ_MIDI_OUT_SlotMalloc, therefore the array can't overflow
+  new_item->seq = heap_seq++;
+  new_item->group = SEQ_MIDI_OUT_HeapGroup(new_item->event_type, new_item->timestamp);
+  SEQ_MIDI_OUT_HeapGroupAdd(new_item);
+
+  heap_items[heap_size] = new_item;
+  SEQ_MIDI_OUT_HeapSiftUp(heap_size++);
+}
+
+static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_QueuePeek(void)
+{
+  return heap_size ? heap_items[0] : NULL;
+}
+
+static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_QueuePop(void)
+{
+  if( !heap_size )
+    return NULL;
+
+  seq_midi_out_queue_item_t *item = heap_items[0];
+  SEQ_MIDI_OUT_HeapGroupRemove(item);
+  if( --heap_size ) {
+    heap_items[0] = heap_items[heap_size];
+    SEQ_MIDI_OUT_HeapSiftDown(0);
+  }
+
+  return item;
+}
+
+#else
+
+static void SEQ_MIDI_OUT_QueueInsert(seq_midi_out_queue_item_t *new_item)
+{
+  u32 timestamp = new_item->timestamp;
+  u8 event_type = new_item->event_type;
+  new_item->next = NULL;
+
+  // search in queue for last item which has the same (or earlier) timestamp
+  seq_midi_out_queue_item_t *item;
+  if( (item=midi_queue) == NULL ) {
+    // no item in queue -- first element
+    midi_queue = new_item;
+  } else {
+    u8 insert_before_item = 0;
+    seq_midi_out_queue_item_t *last_item = NULL;
+    seq_midi_out_queue_item_t *next_item;
+    do {
+      // Clock and Tempo events are sorted before CC and Note events at a given timestamp
+      if( (event_type == SEQ_MIDI_OUT_ClkEvent || event_type == SEQ_MIDI_OUT_TempoEvent ) && 
+	  item->timestamp >= timestamp &&
+	  (item->event_type == SEQ_MIDI_OUT_OnEvent || 
+	   item->event_type == SEQ_MIDI_OUT_OffEvent || 
+	   item->event_type == SEQ_MIDI_OUT_OnOffEvent || 
+	   item->event_type == SEQ_MIDI_OUT_CCEvent) ) {
+	// found any event with same timestamp, insert clock before these events
+	// note that the Clock event order doesn't get lost if clock events 
+	// are queued at the same timestamp (e.g. MIDI start -> MIDI clock)
+	insert_before_item = 1;
+	break;
+      }
+
+      // CCs are sorted before notes at a given timestamp
+      // (new CC before On events at the same timestamp)
+      // CCs are still played after Off or Clock events
+      if( event_type == SEQ_MIDI_OUT_CCEvent && 
+	  item->timestamp == timestamp &&
+	  (item->event_type == SEQ_MIDI_OUT_OnEvent || item->event_type == SEQ_MIDI_OUT_OnOffEvent) ) {
+	// found On event with same timestamp, play CC before On event
+	insert_before_item = 1;
+	break;
+      }
+
+      if( item->timestamp > timestamp ) {
+	// found entry with later timestamp
+	insert_before_item = 1;
+	break;
+      }
+
+      if( (next_item=item->next) == NULL ) {
+	// end of queue reached, insert new item at the end
+	break;
+      }
+	
+      if( next_item->timestamp > timestamp ) {
+	// found entry with later timestamp
+	break;
+      }
+
+      // switch to next item
+      last_item = item;
+      item = next_item;
+    } while( 1 );
+
+    // insert/add item into/to list
+    if( insert_before_item ) {
+      if( last_item == NULL )
+	midi_queue = new_item;
+      else
+	last_item->next = new_item;
+      new_item->next = item;
+    } else {
+      item->next = new_item;
+      new_item->next = next_item;
+    }
+  }
+
+}
+
+static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_QueuePeek(void)
+{
+  return midi_queue;
+}
+
+static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_QueuePop(void)
+{
+  seq_midi_out_queue_item_t *item;
+  if( (item=midi_queue) != NULL )
+    midi_queue = item->next;
+  return item;
+}
+
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local function to allocate memory
 // returns NULL if no memory free
@@ -739,8 +980,14 @@ static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_SlotMalloc(void)
   // search for next free slot
   s32 new_pos = -1;
 
+#if SEQ_MIDI_OUT_MALLOC_METHOD == 6
+  // take the slot from the top of the free stack - constant time, no search required
+  if( alloc_free_num ) {
+    new_pos = alloc_free_slots[--alloc_free_num];
+    alloc_flags[new_pos / 32] |= (1 << (new_pos % 32));
+  }
+#elif SEQ_MIDI_OUT_MALLOC_FLAG_WIDTH == 1
   s32 i;
-#if SEQ_MIDI_OUT_MALLOC_FLAG_WIDTH == 1
   // start with +1, since the chance is higher that this block is free
   s32 ix = (alloc_pos + 1) % SEQ_MIDI_OUT_MAX_EVENTS;
   for(i=0; i<SEQ_MIDI_OUT_MAX_EVENTS; ++i) {
@@ -750,9 +997,10 @@ static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_SlotMalloc(void)
       break;
     }
 
-    ix = ++ix % SEQ_MIDI_OUT_MAX_EVENTS;
+    ix = (ix + 1) % SEQ_MIDI_OUT_MAX_EVENTS;
   }
 #else
+  s32 i;
   s32 ix = ((alloc_pos/SEQ_MIDI_OUT_MAX_EVENTS) + 1) % (SEQ_MIDI_OUT_MAX_EVENTS / SEQ_MIDI_OUT_MALLOC_FLAG_WIDTH);
   u32 mask;
   for(i=0; i<SEQ_MIDI_OUT_MAX_EVENTS; ++i) {
@@ -831,7 +1079,18 @@ static void SEQ_MIDI_OUT_SlotFree(seq_midi_out_queue_item_t *item)
   if( item >= alloc_heap ) {
     u32 pos = item - alloc_heap;
     if( pos < SEQ_MIDI_OUT_MAX_EVENTS ) {
-#if SEQ_MIDI_OUT_MALLOC_FLAG_WIDTH == 1
+#if SEQ_MIDI_OUT_MALLOC_METHOD == 6
+      u32 mask = (1 << (pos % 32));
+      if( !(alloc_flags[pos / 32] & mask) ) {
+	// slot already free - should never happen! (can be checked by setting a breakpoint or printf to this location)
+#if DEBUG_VERBOSE_LEVEL >= 1
+	DEBUG_MSG("[SEQ_MIDI_OUT_SlotFree] Malfunction case #3\n");
+#endif
+	return;
+      }
+      alloc_flags[pos / 32] &= ~mask;
+      alloc_free_slots[alloc_free_num++] = pos;
+#elif SEQ_MIDI_OUT_MALLOC_FLAG_WIDTH == 1
       alloc_flags[pos] = 0;
 #else
       alloc_flags[pos/SEQ_MIDI_OUT_MALLOC_FLAG_WIDTH] &= ~(1 << (pos%SEQ_MIDI_OUT_MALLOC_FLAG_WIDTH));
@@ -30,6 +30,7 @@ extern "C" {
 // 3: internal static allocation with 32bit flags
 // 4: FreeRTOS based pvPortMalloc
 // 5: malloc provided by library
+// 6: internal static allocation with a free slot stack (constant time, independent from number of allocated events)
 #ifndef SEQ_MIDI_OUT_MALLOC_METHOD
 #define SEQ_MIDI_OUT_MALLOC_METHOD 3
 #endif
@@ -41,6 +42,15 @@ extern "C" {
 #define SEQ_MIDI_OUT_MAX_EVENTS 128
 #endif
 
+// queue method:
+// 0: sorted linked list (insertion is O(n) in the number of queued events)
+// 1: binary heap over a preallocated pointer array (O(log n) insert/pop)
+//    Events with the same timestamp are played in the order:
+//    Clock/Tempo -> CC -> On/Off/OnOff, and in the order they have been sent
+#ifndef SEQ_MIDI_OUT_QUEUE_METHOD
+#define SEQ_MIDI_OUT_QUEUE_METHOD 0
+#endif
+
 // enable seq_midi_out_max_allocated and seq_midi_out_dropouts
 #ifndef SEQ_MIDI_OUT_MALLOC_ANALYSIS
 #define SEQ_MIDI_OUT_MALLOC_ANALYSIS 0
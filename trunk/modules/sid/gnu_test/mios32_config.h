@@ -0,0 +1,16 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host test
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+#define SID_NUM 8
+
+// the register writes of the first SID are forwarded to SIDEMU_setRegister()
+#define SIDEMU_ENABLED
+extern void SIDEMU_setRegister(u8 addr, u8 data);
+extern s32 SYNTH_Init(u32 mode);
+
+#endif /* _MIOS32_CONFIG_H */
@@ -0,0 +1,198 @@
+// $Id$
+/*
+ * Host test for SID_Update()
+ *
+ * The register writes of the first SID are recorded via SIDEMU_setRegister(),
+ * the number of writes of all SIDs via SID_PrintStatistics().
+ * Registers of all SIDs are changed randomly, and the writes are compared
+ * against a model of the update rules:
+ *   - only changed registers are written, in the order of update_order[]
+ *   - a register is written to both SIDs of a pair at once if the values are identical
+ *   - idle SIDs aren't written
+ *
+ * Afterwards the time of SID_Update() is measured for idle SIDs and for
+ * a single changed register.
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <time.h>
+
+#define GNU_TEST_OWN_DEBUG_MESSAGE
+#include <gnu_test.h>
+
+#include "sid.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32 stand-ins
+/////////////////////////////////////////////////////////////////////////////
+static char debug_msg[128];
+
+s32 SYNTH_Init(u32 mode) { return 0; }
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  vsnprintf(debug_msg, sizeof(debug_msg), format, args);
+  va_end(args);
+  return 0;
+}
+
+#define MAX_WRITES 1024
+static u8 write_addr[MAX_WRITES];
+static u8 write_data[MAX_WRITES];
+static int num_writes;
+
+void SIDEMU_setRegister(u8 addr, u8 data)
+{
+  if( num_writes < MAX_WRITES ) {
+    write_addr[num_writes] = addr;
+    write_data[num_writes] = data;
+    ++num_writes;
+  }
+}
+
+// the order of register writes (copy of update_order[] in sid.c)
+static const u8 update_order[SID_REGS_NUM] = {
+   0,  1,  2,  3,  5,  6,
+   7,  8,  9, 10, 12, 13,
+  14, 15, 16, 17, 19, 20,
+   4, 11, 18,
+  21, 22, 23, 24,
+  25, 26, 27, 28, 29, 30, 31
+};
+
+// returns the number of register writes since the last call
+static int regs_written(void)
+{
+  int value = 0;
+
+  debug_msg[0] = 0;
+  SID_PrintStatistics(1000);
+  if( debug_msg[0] )
+    CHECK(sscanf(debug_msg, "SID Regs written: %d/s", &value) == 1, "unexpected statistics output '%s'", debug_msg);
+
+  return value;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  static sid_regs_t model[SID_NUM];
+  int i, sid, reg, iteration;
+
+  num_writes = 0;
+  SID_Init(0);
+  regs_written();
+
+  // SID_Init() resets the SIDs (reported as write to register 0), and transfers all registers
+  // (SIDEMU only gets the first 25 registers)
+  CHECK(num_writes == 1+25, "SID_Init(): %d registers written to first SID, expected 1+25", num_writes);
+  for(i=1; i<num_writes; ++i)
+    CHECK(write_addr[i] == update_order[i-1], "SID_Init(): register %d written at position %d, expected %d", write_addr[i], i, update_order[i-1]);
+
+  // nothing changed
+  num_writes = 0;
+  SID_Update(0);
+  CHECK(num_writes == 0 && regs_written() == 0, "idle SID_Update(): registers written");
+
+  // random changes
+  srand(1);
+  for(iteration=0; iteration<2000; ++iteration) {
+    int expected_writes = 0;
+    u8 changed[SID_NUM][SID_REGS_NUM];
+
+    memset(changed, 0, sizeof(changed));
+    for(sid=0; sid<SID_NUM; ++sid) {
+      // some SIDs stay idle, the others change a few registers
+      if( rand() % 3 ) {
+	int n = rand() % 6;
+	for(i=0; i<n; ++i) {
+	  reg = rand() % SID_REGS_NUM;
+	  // pairs often get the same value (stereo patches)
+	  u8 value = ((sid & 1) && (rand() & 1)) ? sid_regs[sid-1].ALL[reg] : rand();
+	  sid_regs[sid].ALL[reg] = value;
+	}
+      }
+    }
+
+    // expected writes
+    for(sid=0; sid<SID_NUM; sid+=2) {
+      for(reg=0; reg<SID_REGS_NUM; ++reg) {
+	u8 l = sid_regs[sid].ALL[reg];
+	u8 r = sid_regs[sid+1].ALL[reg];
+	if( l != model[sid].ALL[reg] ) {
+	  changed[sid][reg] = 1;
+	  model[sid].ALL[reg] = l;
+	  if( l == r ) {
+	    model[sid+1].ALL[reg] = r;
+	    expected_writes += 2;
+	  } else {
+	    ++expected_writes;
+	    if( r != model[sid+1].ALL[reg] ) {
+	      model[sid+1].ALL[reg] = r;
+	      ++expected_writes;
+	    }
+	  }
+	} else if( r != model[sid+1].ALL[reg] ) {
+	  model[sid+1].ALL[reg] = r;
+	  ++expected_writes;
+	}
+      }
+    }
+
+    num_writes = 0;
+    SID_Update(0);
+
+    int written = regs_written();
+    CHECK(written == expected_writes, "iteration %d: %d registers written, expected %d", iteration, written, expected_writes);
+
+    // writes of the first SID in update order
+    int pos = 0;
+    for(i=0; i<SID_REGS_NUM; ++i) {
+      reg = update_order[i];
+      if( changed[0][reg] && reg <= 24 ) {
+	CHECK(pos < num_writes && write_addr[pos] == reg && write_data[pos] == sid_regs[0].ALL[reg],
+	      "iteration %d: register %d of first SID not written at position %d", iteration, reg, pos);
+	++pos;
+      }
+    }
+    CHECK(pos == num_writes, "iteration %d: %d registers written to first SID, expected %d", iteration, num_writes, pos);
+  }
+
+  // forced update
+  num_writes = 0;
+  SID_Update(1);
+  CHECK(regs_written() == SID_NUM*SID_REGS_NUM, "SID_Update(1): not all registers written");
+
+  // measure the update time
+  {
+    clock_t start;
+    int runs = 1000000;
+
+    start = clock();
+    for(i=0; i<runs; ++i)
+      SID_Update(0);
+    double idle_ns = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / runs;
+
+    start = clock();
+    for(i=0; i<runs; ++i) {
+      sid_regs[5].ALL[i & 0x1f] ^= 1;
+      SID_Update(0);
+    }
+    double single_ns = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / runs;
+
+    printf("SID_Update() with %d SIDs: %.1f ns idle, %.1f ns with one changed register\n", SID_NUM, idle_ns, single_ns);
+  }
+
+  return GNU_TEST_Result();
+}
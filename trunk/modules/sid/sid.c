@@ -84,6 +84,9 @@ static const u8 update_order[SID_REGS_NUM] = {
 
 static u8 sid_available;
 
+// statistics
+static u32 sid_regs_written_ctr;
+
 #if SID_USE_MBNET
 static u8 mbnet_tx_state;
 static u8 mbnet_tx_reg_ctr;
@@ -135,6 +138,7 @@ typedef struct {
 // Local Prototypes
 /////////////////////////////////////////////////////////////////////////////
 
+static inline u32 SID_RegsChanged(sid_regs_t *regs, sid_regs_t *regs_shadow);
 #if !SID_USE_MBNET
 static inline void SID_UpdateReg(sid_cs_pin_t *cs_pin0, sid_cs_pin_t *cs_pin1, u8 cs, u8 addr, u8 data, u8 reset);
 #else
@@ -325,7 +329,7 @@ u8 SID_AvailableGet(void)
 #if SID_USE_MBNET
 s32 SID_Update(u32 mode)
 {
-  int sid, reg;
+  int sid;
   // if register update should be forced, just inverse all shadow register values
   if( mode >= 1 ) { // (also for reset mode)
     MIOS32_IRQ_Disable();
@@ -337,13 +341,10 @@ s32 SID_Update(u32 mode)
   // transfer SID registers to shadow registers and check for updates
   MIOS32_IRQ_Disable();
   for(sid=0; sid<SID_NUM; ++sid) {
-    u8 *regs = (u8 *)&sid_regs[sid];
-    u8 *regs_shadow = (u8 *)&sid_regs_shadow[sid];
-
-    for(reg=0; reg<SID_REGS_NUM; ++reg) {
-      if( *regs_shadow != *regs )
-	sid_regs_shadow_updated[sid] |= (1 << reg);
-      *regs_shadow++ = *regs++;
+    u32 changed = SID_RegsChanged(&sid_regs[sid], &sid_regs_shadow[sid]);
+    if( changed ) {
+      sid_regs_shadow_updated[sid] |= changed;
+      sid_regs_shadow[sid] = sid_regs[sid];
     }
   }
   MIOS32_IRQ_Enable();
@@ -439,6 +440,7 @@ s32 SID_MBNET_TxHandler(mbnet_id_t *mbnet_id, mbnet_msg_t *msg, u8 *dlc)
   MIOS32_IRQ_Enable();
 
   ++mbnet_tx_msg_ctr;
+  sid_regs_written_ctr += 8;
 
   return 1;
 }
@@ -470,27 +472,38 @@ s32 SID_Update(u32 mode)
   // this loop should run so fast as possible, 
   // we consider to update two SIDs at once if values are identical
   for(sid=0; sid<SID_NUM; sid+=2) {
+    // determine the changed registers of both SIDs, skip them if nothing has been changed
+    u32 changed = SID_RegsChanged(&sid_regs[sid+0], &sid_regs_shadow[sid+0]) |
+                  SID_RegsChanged(&sid_regs[sid+1], &sid_regs_shadow[sid+1]);
+    if( !changed )
+      continue;
+
     u8 *update_order_ptr = (u8 *)&update_order[0];
     u8 *sidl = (u8 *)&sid_regs[sid+0].ALL[0];
     u8 *sidl_shadow = (u8 *)&sid_regs_shadow[sid+0].ALL[0];
     u8 *sidr = (u8 *)&sid_regs[sid+1].ALL[0];
     u8 *sidr_shadow = (u8 *)&sid_regs_shadow[sid+1].ALL[0];
-    u8 cs_both = (3 << (2*sid));
-    u8 cs_l_only = (1 << (2*sid));
-    u8 cs_r_only = (2 << (2*sid));
+    u8 cs_both = (3 << sid);
+    u8 cs_l_only = (1 << sid);
+    u8 cs_r_only = (2 << sid);
 #if defined(MIOS32_FAMILY_STM32F10x)
-    sid_cs_pin_t *cs_pin0 = (sid_cs_pin_t *)&sid_cs_pin[2*sid+0];
-    sid_cs_pin_t *cs_pin1 = (sid_cs_pin_t *)&sid_cs_pin[2*sid+1];
+    sid_cs_pin_t *cs_pin0 = (sid_cs_pin_t *)&sid_cs_pin[sid+0];
+    sid_cs_pin_t *cs_pin1 = (sid_cs_pin_t *)&sid_cs_pin[sid+1];
 #else
     sid_cs_pin_t *cs_pin0 = NULL;
     sid_cs_pin_t *cs_pin1 = NULL;
 #endif
 
-    for(i=0; i<SID_REGS_NUM; ++i, update_order_ptr++) {
+    for(i=0; i<SID_REGS_NUM && changed; ++i, update_order_ptr++) {
       u8 data;
 
       reg = *update_order_ptr;
 
+      // skip unchanged registers
+      if( !(changed & ((u32)1 << reg)) )
+	continue;
+      changed &= ~((u32)1 << reg);
+
       // check if update of left/right channel SID are required
       // partly duplicated code ensures best performance in all cases!
       if( (data=sidl[reg]) != sidl_shadow[reg] ) {
@@ -499,20 +512,24 @@ s32 SID_Update(u32 mode)
 	  SID_UpdateReg(cs_pin0, cs_pin1, cs_both, reg, data, 0); // CS lines, address, data, reset
 	  sidl_shadow[reg] = data;
 	  sidr_shadow[reg] = data;
+	  sid_regs_written_ctr += 2;
 	} else {
 	  SID_UpdateReg(cs_pin0, NULL, cs_l_only, reg, data, 0); // CS lines, address, data, reset
 	  sidl_shadow[reg] = data;
+	  ++sid_regs_written_ctr;
 
 	  if( (data=sidr[reg]) != sidr_shadow[reg] ) {
 	    // individual update for second SID required
 	    SID_UpdateReg(cs_pin1, NULL, cs_r_only, reg, data, 0); // CS lines, address, data, reset
 	    sidr_shadow[reg] = data;
+	    ++sid_regs_written_ctr;
 	  }
 	}
       } else if( (data=sidr[reg]) != sidr_shadow[reg] ) {
 	// individual update for second SID required
 	SID_UpdateReg(cs_pin1, NULL, cs_r_only, reg, data, 0); // CS lines, address, data, reset
 	sidr_shadow[reg] = data;
+	++sid_regs_written_ctr;
       }
     }
   }
@@ -638,11 +655,43 @@ static inline void SID_UpdateReg(sid_cs_pin_t *cs_pin0, sid_cs_pin_t *cs_pin1, u
 #endif
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Returns a mask of the registers which have been changed since the last
+// transfer to the shadow registers (bit n: register n)
+// Compares a complete word at once, so that unchanged SIDs are skipped fast
+/////////////////////////////////////////////////////////////////////////////
+static inline u32 SID_RegsChanged(sid_regs_t *regs, sid_regs_t *regs_shadow)
+{
+  u32 changed = 0;
+  int word, i;
+
+  for(word=0; word<(SID_REGS_NUM/sizeof(u32)); ++word) {
+    if( regs->ALL32[word] != regs_shadow->ALL32[word] ) {
+      int reg = word * sizeof(u32);
+      for(i=0; i<sizeof(u32); ++i, ++reg)
+	if( regs->ALL[reg] != regs_shadow->ALL[reg] )
+	  changed |= ((u32)1 << reg);
+    }
+  }
+
+  return changed;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Can be called periodically (e.g. each second) to output statistics
+// IN: period_ms: time since the last call in mS
 /////////////////////////////////////////////////////////////////////////////
-s32 SID_PrintStatistics(void)
+s32 SID_PrintStatistics(u32 period_ms)
 {
+  MIOS32_IRQ_Disable();
+  u32 regs_written = sid_regs_written_ctr;
+  sid_regs_written_ctr = 0;
+  MIOS32_IRQ_Enable();
+
+  if( regs_written && period_ms )
+    MIOS32_MIDI_SendDebugMessage("SID Regs written: %d/s", (regs_written * 1000) / period_ms);
+
 #if SID_USE_MBNET
   if( mbnet_tx_msg_ctr_min ) {
     MIOS32_MIDI_SendDebugMessage("MBNET MSG Min:%d Max:%d", mbnet_tx_msg_ctr_min, mbnet_tx_msg_ctr_max);
@@ -157,6 +157,7 @@ typedef union {
 
 typedef union {
   u8 ALL[SID_REGS_NUM];
+  u32 ALL32[SID_REGS_NUM/sizeof(u32)]; // for word-wise comparisons in SID_Update()
 
   struct {
 #if 0
@@ -205,7 +206,7 @@ extern u8  SID_AvailableGet(void);
 
 extern s32 SID_Update(u32 mode);
 
-extern s32 SID_PrintStatistics(void);
+extern s32 SID_PrintStatistics(u32 period_ms);
 
 
 /////////////////////////////////////////////////////////////////////////////
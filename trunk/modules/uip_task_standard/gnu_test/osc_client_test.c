@@ -0,0 +1,252 @@
+// $Id$
+/*
+ * Host test for the bundle output of the OSC client
+ *
+ * OSC_SERVER_SendPacket() is replaced by a function which records the
+ * sent UDP packets. The messages of the packets (bundles are unpacked)
+ * are compared against the packets which are sent without bundle window:
+ *   - messages are collected until the window is over
+ *   - a single message is sent without bundle
+ *   - bundles are sent when the buffer is full
+ *   - SysEx streams, OSC_CLIENT_SendMIDIEventBundled() and disabling the
+ *     window send the collected messages first
+ *   - packets/bytes/messages per second
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <gnu_test.h>
+
+#include "osc_server.h"
+#include "osc_client.h"
+
+mios32_sys_time_t MIOS32_SYS_TimeGet(void)
+{
+  mios32_sys_time_t t = { 1234, 500 };
+  return t;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// recorded packets and messages
+/////////////////////////////////////////////////////////////////////////////
+#define MAX_MESSAGES 256
+#define MAX_MESSAGE_SIZE 128
+
+typedef struct {
+  u8 data[MAX_MESSAGE_SIZE];
+  uint32_t len;
+} message_t;
+
+static message_t messages[MAX_MESSAGES];
+static int num_messages;
+static int num_packets;
+static int num_bundles;
+static uint32_t max_packet_len;
+static mios32_osc_timetag_t last_timetag;
+
+static void add_message(u8 *data, uint32_t len)
+{
+  if( num_messages < MAX_MESSAGES && len <= MAX_MESSAGE_SIZE ) {
+    memcpy(messages[num_messages].data, data, len);
+    messages[num_messages].len = len;
+    ++num_messages;
+  }
+}
+
+s32 OSC_SERVER_SendPacket(u8 con, u8 *packet, u32 len)
+{
+  ++num_packets;
+  if( len > max_packet_len )
+    max_packet_len = len;
+
+  if( len >= 16 && strcmp((char *)packet, "#bundle") == 0 ) {
+    uint32_t pos = 16;
+
+    ++num_bundles;
+    last_timetag = MIOS32_OSC_GetTimetag(packet + 8);
+    while( pos + 4 <= len ) {
+      uint32_t elem_len = MIOS32_OSC_GetWord(packet + pos);
+      CHECK(pos + 4 + elem_len <= len, "invalid element size in bundle");
+      if( pos + 4 + elem_len > len )
+	break;
+      add_message(packet + pos + 4, elem_len);
+      pos += 4 + elem_len;
+    }
+    CHECK(pos == len, "bundle not completely parsed");
+  } else {
+    add_message(packet, len);
+  }
+
+  return 0; // no error
+}
+
+static void clear(void)
+{
+  num_messages = 0;
+  num_packets = 0;
+  num_bundles = 0;
+  max_packet_len = 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// sends a sequence of events
+/////////////////////////////////////////////////////////////////////////////
+static void send_events(int num)
+{
+  int i;
+
+  for(i=0; i<num; ++i) {
+    mios32_midi_package_t p;
+    p.ALL = 0;
+    p.type = (i % 3) ? NoteOn : CC;
+    p.evnt0 = ((i % 3) ? 0x90 : 0xb0) | (i & 0xf);
+    p.evnt1 = i & 0x7f;
+    p.evnt2 = 100;
+    OSC_CLIENT_SendMIDIEvent(0, p);
+
+    if( (i % 7) == 6 )
+      OSC_CLIENT_SendNRPNEvent(0, i & 0xf, 1000 + i, 2000);
+  }
+}
+
+static message_t expected[MAX_MESSAGES];
+static int num_expected;
+
+static void reference(int num)
+{
+  OSC_CLIENT_BundleWindowSet(0, 0);
+  clear();
+  send_events(num);
+  memcpy(expected, messages, sizeof(message_t)*num_messages);
+  num_expected = num_messages;
+  CHECK(num_packets == num_expected, "without window: %d packets sent for %d messages", num_packets, num_expected);
+  CHECK(num_bundles == 0, "without window: bundles sent");
+  clear();
+}
+
+static void compare(const char *name)
+{
+  int i;
+
+  CHECK(num_messages == num_expected, "%s: %d messages sent, expected %d", name, num_messages, num_expected);
+  for(i=0; i<num_messages && i<num_expected; ++i)
+    CHECK(messages[i].len == expected[i].len && memcmp(messages[i].data, expected[i].data, expected[i].len) == 0,
+	  "%s: message %d (%s) differs from %s", name, i, (char *)messages[i].data, (char *)expected[i].data);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  int i;
+
+  OSC_CLIENT_Init(0);
+  OSC_CLIENT_TransferModeSet(0, OSC_CLIENT_TRANSFER_MODE_INT);
+
+  // messages are collected until the window is over
+  reference(5);
+  OSC_CLIENT_BundleWindowSet(0, 3);
+  send_events(5);
+  OSC_CLIENT_Periodic_mS();
+  OSC_CLIENT_Periodic_mS();
+  CHECK(num_packets == 0, "window: %d packets sent before the window is over", num_packets);
+  OSC_CLIENT_Periodic_mS();
+  CHECK(num_packets == 1 && num_bundles == 1, "window: %d packets, %d bundles sent, expected a single bundle", num_packets, num_bundles);
+  CHECK(last_timetag.seconds == 1234 && last_timetag.fraction == 500*4294967, "window: unexpected timetag %u.%u",
+	(unsigned)last_timetag.seconds, (unsigned)last_timetag.fraction);
+  compare("window");
+
+  // a single message is sent without bundle
+  reference(1);
+  OSC_CLIENT_BundleWindowSet(0, 1);
+  send_events(1);
+  OSC_CLIENT_Periodic_mS();
+  CHECK(num_packets == 1 && num_bundles == 0, "single message: %d packets, %d bundles sent", num_packets, num_bundles);
+  compare("single message");
+
+  // bundles are sent when the buffer is full
+  reference(40);
+  OSC_CLIENT_BundleWindowSet(0, 1000);
+  send_events(40);
+  OSC_CLIENT_BundleFlush(0);
+  CHECK(num_packets > 1 && num_packets < num_expected, "full buffer: %d packets sent for %d messages", num_packets, num_expected);
+  CHECK(max_packet_len <= OSC_CLIENT_BUNDLE_SIZE, "full buffer: packet with %u bytes sent", (unsigned)max_packet_len);
+  compare("full buffer");
+
+  // SysEx streams and OSC_CLIENT_SendMIDIEventBundled() send the collected messages first
+  {
+    u8 sysex[] = { 0xf0, 0x00, 0x00, 0x7e, 0x32, 0x00, 0xf7 };
+    mios32_midi_package_t p;
+    mios32_osc_timetag_t timetag = { 0, 1 };
+
+    p.ALL = 0;
+    p.type = NoteOn;
+    p.evnt0 = 0x90;
+    p.evnt1 = 0x3c;
+    p.evnt2 = 0x7f;
+
+    OSC_CLIENT_BundleWindowSet(0, 0);
+    clear();
+    send_events(3);
+    OSC_CLIENT_SendSysEx(0, sysex, sizeof(sysex));
+    OSC_CLIENT_SendMIDIEventBundled(0, &p, 1, timetag);
+    memcpy(expected, messages, sizeof(message_t)*num_messages);
+    num_expected = num_messages;
+    clear();
+
+    OSC_CLIENT_BundleWindowSet(0, 1000);
+    send_events(3);
+    OSC_CLIENT_SendSysEx(0, sysex, sizeof(sysex));
+    OSC_CLIENT_BundleWindowSet(0, 1000);
+    OSC_CLIENT_SendMIDIEventBundled(0, &p, 1, timetag);
+    compare("SysEx");
+  }
+
+  // disabling the window sends the collected messages
+  reference(4);
+  OSC_CLIENT_BundleWindowSet(0, 1000);
+  send_events(4);
+  CHECK(num_packets == 0, "disable: %d packets sent", num_packets);
+  OSC_CLIENT_BundleWindowSet(0, 0);
+  CHECK(num_packets == 1, "disable: %d packets sent, expected 1", num_packets);
+  compare("disable");
+
+  // statistics of the last second
+  {
+    osc_client_stats_t stats;
+    uint32_t bytes = 0;
+
+    OSC_CLIENT_Init(0);
+    OSC_CLIENT_TransferModeSet(0, OSC_CLIENT_TRANSFER_MODE_INT);
+    OSC_CLIENT_BundleWindowSet(0, 10);
+    clear();
+    for(i=0; i<1000; ++i) {
+      if( (i % 100) == 0 )
+	send_events(5); // fits into a single bundle
+      OSC_CLIENT_Periodic_mS();
+    }
+    OSC_CLIENT_StatsGet(0, &stats);
+    for(i=0; i<num_messages; ++i)
+      bytes += messages[i].len + 4;
+    bytes += 16*num_packets;
+
+    CHECK(stats.packets_per_second == 10 && num_packets == 10, "stats: %u packets per second, expected 10", (unsigned)stats.packets_per_second);
+    CHECK(stats.messages_per_second == num_messages, "stats: %u messages per second, expected %d", (unsigned)stats.messages_per_second, num_messages);
+    CHECK(stats.bytes_per_second == bytes, "stats: %u bytes per second, expected %u", (unsigned)stats.bytes_per_second, (unsigned)bytes);
+
+    for(i=0; i<1000; ++i)
+      OSC_CLIENT_Periodic_mS();
+    OSC_CLIENT_StatsGet(0, &stats);
+    CHECK(stats.packets_per_second == 0 && stats.bytes_per_second == 0, "stats: not cleared after idle second");
+  }
+
+  return GNU_TEST_Result();
+}
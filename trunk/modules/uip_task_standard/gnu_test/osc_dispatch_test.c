@@ -0,0 +1,380 @@
+// $Id$
+/*
+ * Host test and benchmark for the compiled OSC dispatch table
+ *
+ * Parses the same packets with MIOS32_OSC_ParsePacket() and
+ * MIOS32_OSC_ParsePacketCompiled(), and compares the method calls
+ * (method, method argument, address parts, arguments) and return values:
+ *   - the search tree of osc_server.c with typical traffic of its clients
+ *     (MIDI events, TouchOSC "/<chn>/note_<key>", Pianist Pro "/mcmpp/...")
+ *   - a tree with overlapping wildcards, duplicated addresses and deep paths
+ *   - random paths with wildcards and unknown address parts
+ *   - tables which are too small
+ *
+ * Afterwards the parse+dispatch time per message is measured for the
+ * osc_server.c traffic.
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <gnu_test.h>
+
+
+/////////////////////////////////////////////////////////////////////////////
+// OSC methods: each call is logged
+/////////////////////////////////////////////////////////////////////////////
+#define LOG_SIZE 64
+
+typedef struct {
+  int method;
+  uint32_t method_arg;
+  int num_path_parts;
+  const char *path_part[MIOS32_OSC_MAX_PATH_PARTS];
+  int num_args;
+  int32_t arg0;
+} log_entry_t;
+
+static log_entry_t log_buffer[LOG_SIZE];
+static int log_len;
+static int log_enabled;
+
+static s32 log_call(int method, mios32_osc_args_t *osc_args, u32 method_arg)
+{
+  if( log_enabled && log_len < LOG_SIZE ) {
+    log_entry_t *e = &log_buffer[log_len++];
+    int i;
+
+    memset(e, 0, sizeof(log_entry_t));
+    e->method = method;
+    e->method_arg = method_arg;
+    e->num_path_parts = osc_args->num_path_parts;
+    for(i=0; i<osc_args->num_path_parts; ++i)
+      e->path_part[i] = osc_args->path_part[i];
+    e->num_args = osc_args->num_args;
+    if( osc_args->num_args && osc_args->arg_type[0] == 'i' )
+      e->arg0 = MIOS32_OSC_GetInt(osc_args->arg_ptr[0]);
+  }
+
+  return 0; // no error
+}
+
+static s32 Method_MIDI(mios32_osc_args_t *osc_args, u32 method_arg)      { return log_call(1, osc_args, method_arg); }
+static s32 Method_Event(mios32_osc_args_t *osc_args, u32 method_arg)     { return log_call(2, osc_args, method_arg); }
+static s32 Method_EventNRPN(mios32_osc_args_t *osc_args, u32 method_arg) { return log_call(3, osc_args, method_arg); }
+static s32 Method_EventPB(mios32_osc_args_t *osc_args, u32 method_arg)   { return log_call(4, osc_args, method_arg); }
+static s32 Method_EventTOSC(mios32_osc_args_t *osc_args, u32 method_arg) { return log_call(5, osc_args, method_arg); }
+static s32 Method_MCMPP(mios32_osc_args_t *osc_args, u32 method_arg)     { return log_call(6, osc_args, method_arg); }
+static s32 Method_A(mios32_osc_args_t *osc_args, u32 method_arg)         { return log_call(7, osc_args, method_arg); }
+static s32 Method_B(mios32_osc_args_t *osc_args, u32 method_arg)         { return log_call(8, osc_args, method_arg); }
+
+
+/////////////////////////////////////////////////////////////////////////////
+// the search tree of osc_server.c
+/////////////////////////////////////////////////////////////////////////////
+static const mios32_osc_search_tree_t parse_mcmpp_value[] = {
+  { "*", NULL, &Method_MCMPP, 0x00000000 },
+  { NULL, NULL, NULL, 0 }
+};
+
+static const mios32_osc_search_tree_t parse_mcmpp[] = {
+  { "key",           parse_mcmpp_value, NULL, 0x00000090 },
+  { "polypressure",  parse_mcmpp_value, NULL, 0x000000a0 },
+  { "cc",            parse_mcmpp_value, NULL, 0x000000b0 },
+  { "programchange", parse_mcmpp_value, NULL, 0x000000c0 },
+  { "aftertouch",    parse_mcmpp_value, NULL, 0x000000d0 },
+  { "pitch",         parse_mcmpp_value, NULL, 0x000000e0 },
+  { NULL, NULL, NULL, 0 }
+};
+
+static const mios32_osc_search_tree_t parse_event[] = {
+  { "note_*",          NULL, &Method_EventTOSC, 0x00000090 },
+  { "polypressure_*",  NULL, &Method_EventTOSC, 0x000000a0 },
+  { "cc_*",            NULL, &Method_EventTOSC, 0x000000b0 },
+  { "programchange_*", NULL, &Method_EventTOSC, 0x000000c0 },
+  { "note",            NULL, &Method_Event,     0x00000090 },
+  { "polypressure",    NULL, &Method_Event,     0x000000a0 },
+  { "cc",              NULL, &Method_Event,     0x000000b0 },
+  { "nrpn",            NULL, &Method_EventNRPN, 0x000000b0 },
+  { "programchange",   NULL, &Method_Event,     0x000000c0 },
+  { "aftertouch",      NULL, &Method_Event,     0x000000b0 },
+  { "pitchbend",       NULL, &Method_EventPB,   0x000000e0 },
+  { NULL, NULL, NULL, 0 }
+};
+
+static const mios32_osc_search_tree_t server_root[] = {
+  { "midi",  NULL, &Method_MIDI, OSC0 },
+  { "midi1", NULL, &Method_MIDI, OSC0 },
+  { "midi2", NULL, &Method_MIDI, OSC1 },
+  { "midi3", NULL, &Method_MIDI, OSC2 },
+  { "midi4", NULL, &Method_MIDI, OSC3 },
+  { "mcmpp", parse_mcmpp, NULL, 0x00000000 },
+  { "1",  parse_event, NULL, 0x00000000 },
+  { "2",  parse_event, NULL, 0x00000001 },
+  { "3",  parse_event, NULL, 0x00000002 },
+  { "4",  parse_event, NULL, 0x00000003 },
+  { "5",  parse_event, NULL, 0x00000004 },
+  { "6",  parse_event, NULL, 0x00000005 },
+  { "7",  parse_event, NULL, 0x00000006 },
+  { "8",  parse_event, NULL, 0x00000007 },
+  { "9",  parse_event, NULL, 0x00000008 },
+  { "10", parse_event, NULL, 0x00000009 },
+  { "11", parse_event, NULL, 0x0000000a },
+  { "12", parse_event, NULL, 0x0000000b },
+  { "13", parse_event, NULL, 0x0000000c },
+  { "14", parse_event, NULL, 0x0000000d },
+  { "15", parse_event, NULL, 0x0000000e },
+  { "16", parse_event, NULL, 0x0000000f },
+  { NULL, NULL, NULL, 0 }
+};
+
+// parse_root[] of osc_server.c: 5 + 1 + 6 + 16 + 16*7 paths without wildcards
+#define SERVER_NUM_PATHS 140
+
+
+/////////////////////////////////////////////////////////////////////////////
+// a search tree with the special cases
+/////////////////////////////////////////////////////////////////////////////
+static const mios32_osc_search_tree_t special_deep[] = {
+  { "d", special_deep, &Method_B, 0x00010000 }, // method and link: the method is called
+  { "e", special_deep, NULL,      0x00020000 }, // endless path: exceeds MIOS32_OSC_MAX_PATH_PARTS
+  { NULL, NULL, NULL, 0 }
+};
+
+static const mios32_osc_search_tree_t special_led[] = {
+  { "set",  NULL, &Method_A, 0x00000001 },
+  { "s*",   NULL, &Method_B, 0x00000002 }, // matches "set" as well
+  { "get",  NULL, &Method_A, 0x00000004 },
+  { "g?t",  NULL, &Method_B, 0x00000008 }, // matches "get" as well
+  { "on",   NULL, &Method_A, 0x00000010 },
+  { "on",   NULL, &Method_B, 0x00000020 }, // duplicated address
+  { "off",  NULL, &Method_A, 0x00000040 },
+  { "dead", NULL, NULL,      0x00000080 }, // neither method nor link
+  { "",     NULL, &Method_A, 0x00000100 }, // empty address
+  { NULL, NULL, NULL, 0 }
+};
+
+static const mios32_osc_search_tree_t special_root[] = {
+  { "led",  special_led,  NULL,      0x00001000 },
+  { "l*",   special_led,  NULL,      0x00002000 },
+  { "cs",   special_led,  NULL,      0x00004000 },
+  { "deep", special_deep, NULL,      0x00008000 },
+  { "x",    NULL,         &Method_A, 0x00100000 },
+  { "x/y",  NULL,         &Method_B, 0x00200000 }, // can't be matched
+  { NULL, NULL, NULL, 0 }
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// OSC packets
+/////////////////////////////////////////////////////////////////////////////
+#define MAX_PACKETS   4000
+#define PACKET_SIZE   256
+
+typedef struct {
+  u8  data[PACKET_SIZE];
+  u32 len;
+} packet_t;
+
+static packet_t packets[MAX_PACKETS];
+static int num_packets;
+
+static u8 *put_message(u8 *buffer, const char *path, int value)
+{
+  buffer = MIOS32_OSC_PutString(buffer, (char *)path);
+  buffer = MIOS32_OSC_PutString(buffer, ",ii");
+  buffer = MIOS32_OSC_PutInt(buffer, value);
+  buffer = MIOS32_OSC_PutInt(buffer, 100);
+  return buffer;
+}
+
+static void add_message(const char *path, int value)
+{
+  packet_t *p = &packets[num_packets++];
+  p->len = (u32)(put_message(p->data, path, value) - p->data);
+}
+
+static void add_bundle(const char **paths, int num)
+{
+  packet_t *p = &packets[num_packets++];
+  mios32_osc_timetag_t timetag = { 1, 2 };
+  u8 *end_ptr = p->data;
+  int i;
+
+  end_ptr = MIOS32_OSC_PutString(end_ptr, "#bundle");
+  end_ptr = MIOS32_OSC_PutTimetag(end_ptr, timetag);
+  for(i=0; i<num; ++i) {
+    u8 *insert_len_ptr = end_ptr;
+    end_ptr = put_message(end_ptr + 4, paths[i], i);
+    MIOS32_OSC_PutWord(insert_len_ptr, (u32)(end_ptr-insert_len_ptr-4));
+  }
+  p->len = (u32)(end_ptr - p->data);
+}
+
+// typical traffic of the osc_server.c clients
+static void create_server_traffic(void)
+{
+  static const char *events[] = { "note", "note", "note", "note", "cc", "cc", "pitchbend", "aftertouch", "polypressure", "programchange", "nrpn" };
+  static const char *mcmpp[] = { "key", "cc", "pitch", "aftertouch" };
+  char path[64];
+  int i;
+
+  num_packets = 0;
+  srand(1);
+  for(i=0; i<1000; ++i) {
+    int chn = 1 + rand() % 16;
+    int key = rand() % 128;
+    int type = rand() % 10;
+
+    if( type < 6 ) // MIDI events
+      sprintf(path, "/%d/%s", chn, events[rand() % (sizeof(events)/sizeof(char *))]);
+    else if( type < 7 )
+      sprintf(path, "/midi%s", (rand() & 1) ? "" : ((const char *[]){ "1", "2", "3", "4" })[rand() % 4]);
+    else if( type < 9 ) // TouchOSC
+      sprintf(path, "/%d/%s_%d", chn, (rand() & 1) ? "note" : "cc", key);
+    else // Pianist Pro
+      sprintf(path, "/mcmpp/%s/%d", mcmpp[rand() % 4], key);
+
+    add_message(path, key);
+  }
+}
+
+// random paths
+static void create_random_traffic(void)
+{
+  static const char *parts[] = {
+    "1", "9", "16", "17", "midi", "midi2", "midi5", "mcmpp", "key", "pitch", "note", "note_60", "cc", "cc_",
+    "nrpn", "pitchbend", "led", "l*", "cs", "set", "get", "got", "on", "off", "dead", "deep", "d", "e", "x", "y",
+    "*", "?", "m?di", "n*", "*e", "", "foo"
+  };
+  int i;
+
+  num_packets = 0;
+  srand(2);
+  for(i=0; i<3000; ++i) {
+    char path[128];
+    int depth = 1 + rand() % 11;
+    int d;
+
+    path[0] = 0;
+    for(d=0; d<depth; ++d) {
+      // deep paths mostly consist of "d" and "e"
+      const char *part = (d > 1 && (rand() & 1)) ? ((rand() & 1) ? "d" : "e") : parts[rand() % (sizeof(parts)/sizeof(char *))];
+      strcat(path, "/");
+      strcat(path, part);
+    }
+
+    if( (i % 10) == 9 ) {
+      const char *paths[3] = { path, "/led/set", "/1/note" };
+      add_bundle(paths, 3);
+    } else {
+      add_message(path, i);
+    }
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// compares the results of MIOS32_OSC_ParsePacket() and MIOS32_OSC_ParsePacketCompiled()
+/////////////////////////////////////////////////////////////////////////////
+static log_entry_t expected_log[LOG_SIZE];
+
+static void compare(const char *name, const mios32_osc_search_tree_t *search_tree, const mios32_osc_dispatch_table_t *table)
+{
+  int i, num_calls = 0, num_failed = 0;
+
+  log_enabled = 1;
+  for(i=0; i<num_packets; ++i) {
+    int expected_len;
+    s32 expected_status, status;
+
+    log_len = 0;
+    expected_status = MIOS32_OSC_ParsePacket(packets[i].data, packets[i].len, search_tree);
+    expected_len = log_len;
+    memcpy(expected_log, log_buffer, sizeof(log_entry_t)*log_len);
+
+    log_len = 0;
+    status = MIOS32_OSC_ParsePacketCompiled(packets[i].data, packets[i].len, table);
+
+    num_calls += expected_len;
+    if( status != expected_status )
+      ++num_failed;
+
+    CHECK(status == expected_status, "%s: packet %d (%s): status %d, expected %d", name, i, (char *)packets[i].data, (int)status, (int)expected_status);
+    CHECK(log_len == expected_len && memcmp(log_buffer, expected_log, sizeof(log_entry_t)*log_len) == 0,
+	  "%s: packet %d (%s): %d method calls differ from %d expected calls", name, i, (char *)packets[i].data, log_len, expected_len);
+  }
+  log_enabled = 0;
+
+  printf("%s: %d packets, %d method calls compared\n", name, num_packets, num_calls);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// measures the parse+dispatch time of the packets
+/////////////////////////////////////////////////////////////////////////////
+#define BENCHMARK_RUNS 500
+
+static double benchmark(const mios32_osc_search_tree_t *search_tree, const mios32_osc_dispatch_table_t *table)
+{
+  struct timespec start, end;
+  int run, i;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(run=0; run<BENCHMARK_RUNS; ++run) {
+    for(i=0; i<num_packets; ++i) {
+      if( table )
+	MIOS32_OSC_ParsePacketCompiled(packets[i].data, packets[i].len, table);
+      else
+	MIOS32_OSC_ParsePacket(packets[i].data, packets[i].len, search_tree);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+  return ns / ((double)BENCHMARK_RUNS * num_packets);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+static mios32_osc_dispatch_entry_t entries[256];
+
+int main(int argc, char *argv[])
+{
+  mios32_osc_dispatch_table_t server_table, special_table, small_table;
+  static mios32_osc_dispatch_entry_t special_entries[64];
+  static mios32_osc_dispatch_entry_t small_entries[128];
+  s32 status;
+
+  status = MIOS32_OSC_CompileSearchTree(&server_table, entries, 256, server_root);
+  CHECK(status == SERVER_NUM_PATHS, "osc_server tree: %d paths compiled, expected %d", (int)status, SERVER_NUM_PATHS);
+
+  // "cs" and "cs/off" ("led" is matched by "l*" as well), "deep" with "d" and "e" (7 levels), "x"
+  status = MIOS32_OSC_CompileSearchTree(&special_table, special_entries, 64, special_root);
+  CHECK(status == 2 + 1 + 7*2 + 1, "special tree: %d paths compiled, expected %d", (int)status, 2 + 1 + 7*2 + 1);
+
+  status = MIOS32_OSC_CompileSearchTree(&small_table, small_entries, 100, server_root);
+  CHECK(status == -1 && small_table.size == 0, "table with invalid size: status %d", (int)status);
+  status = MIOS32_OSC_CompileSearchTree(&small_table, small_entries, 128, server_root);
+  CHECK(status == -2 && small_table.size == 0, "table which is too small: status %d", (int)status);
+
+  create_server_traffic();
+  compare("osc_server traffic", server_root, &server_table);
+  compare("osc_server traffic w/o table", server_root, &small_table);
+
+  create_random_traffic();
+  compare("random paths on osc_server tree", server_root, &server_table);
+  compare("random paths on special tree", special_root, &special_table);
+
+  create_server_traffic();
+  printf("osc_server traffic: MIOS32_OSC_ParsePacket() %.0f ns/msg, MIOS32_OSC_ParsePacketCompiled() %.0f ns/msg\n",
+	 benchmark(server_root, NULL), benchmark(server_root, &server_table));
+
+  return GNU_TEST_Result();
+}
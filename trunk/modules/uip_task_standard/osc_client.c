@@ -35,6 +35,19 @@
 #endif
 
 
+/////////////////////////////////////////////////////////////////////////////
+// the bundle buffers are accessed by the tasks which send events, and by
+// the uIP task which sends them after the bundle window
+/////////////////////////////////////////////////////////////////////////////
+#if !defined(MIOS32_FAMILY_EMULATION)
+# define MUTEX_BUNDLE_TAKE MUTEX_UIP_TAKE
+# define MUTEX_BUNDLE_GIVE MUTEX_UIP_GIVE
+#else
+# define MUTEX_BUNDLE_TAKE { }
+# define MUTEX_BUNDLE_GIVE { }
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Transfer mode names
 // must be aligned with definitions in osc_client.h!!!
@@ -69,6 +82,35 @@ static u16 osc_transfer_mode[OSC_CLIENT_NUM_PORTS];
 static u8 sysex_buffer[OSC_CLIENT_NUM_PORTS][OSC_CLIENT_SYSEX_BUFFER_SIZE];
 static u8 sysex_buffer_len[OSC_CLIENT_NUM_PORTS];
 
+#if OSC_CLIENT_BUNDLE_SIZE
+// the messages of a bundle are collected until the window is over or the buffer is full
+// buffer layout: "#bundle", timetag (16 bytes), followed by size and content of each message
+#define OSC_CLIENT_BUNDLE_HEADER_SIZE 16
+static u8 bundle_buffer[OSC_CLIENT_NUM_PORTS][OSC_CLIENT_BUNDLE_SIZE];
+static u16 bundle_len[OSC_CLIENT_NUM_PORTS]; // 0: no message collected
+static u8 bundle_num_messages[OSC_CLIENT_NUM_PORTS];
+static u16 bundle_window[OSC_CLIENT_NUM_PORTS]; // in mS, 0: messages are sent immediately
+static u16 bundle_timeout[OSC_CLIENT_NUM_PORTS]; // mS until the bundle will be sent
+#endif
+
+// statistics
+static u32 stats_packets[OSC_CLIENT_NUM_PORTS];
+static u32 stats_bytes[OSC_CLIENT_NUM_PORTS];
+static u32 stats_messages[OSC_CLIENT_NUM_PORTS];
+static osc_client_stats_t stats[OSC_CLIENT_NUM_PORTS]; // values of the last second
+static u16 stats_ms_ctr;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static s32 OSC_CLIENT_SendMessage(u8 osc_port, u8 *message, u32 len);
+static s32 OSC_CLIENT_SendPacket(u8 osc_port, u8 *packet, u32 len, u8 num_messages);
+#if OSC_CLIENT_BUNDLE_SIZE
+static s32 OSC_CLIENT_BundleSend(u8 osc_port);
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Initialize the OSC client
@@ -80,7 +122,22 @@ s32 OSC_CLIENT_Init(u32 mode)
   for(i=0; i<OSC_CLIENT_NUM_PORTS; ++i) {
     osc_transfer_mode[i] = OSC_CLIENT_TRANSFER_MODE_MIDI;
     sysex_buffer_len[i] = 0;
+
+#if OSC_CLIENT_BUNDLE_SIZE
+    bundle_len[i] = 0;
+    bundle_num_messages[i] = 0;
+    bundle_window[i] = 0;
+    bundle_timeout[i] = 0;
+#endif
+
+    stats_packets[i] = 0;
+    stats_bytes[i] = 0;
+    stats_messages[i] = 0;
+    stats[i].packets_per_second = 0;
+    stats[i].bytes_per_second = 0;
+    stats[i].messages_per_second = 0;
   }
+  stats_ms_ctr = 0;
 
   return 0; // no error
 }
@@ -400,8 +457,8 @@ s32 OSC_CLIENT_SendMIDIEvent(u8 osc_port, mios32_midi_package_t package)
     }
   }
 
-  // send packet and exit
-  return OSC_SERVER_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
+  // send packet (or add it to the bundle) and exit
+  return OSC_CLIENT_SendMessage(osc_port, packet, (u32)(end_ptr-packet));
 }
 
 
@@ -482,8 +539,8 @@ s32 OSC_CLIENT_SendNRPNEvent(u8 osc_port, u8 chn, u16 nrpn_number, u16 nrpn_valu
     end_ptr = MIOS32_OSC_PutMIDI(end_ptr, p);
   }
 
-  // send packet and exit
-  return OSC_SERVER_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
+  // send packet (or add it to the bundle) and exit
+  return OSC_CLIENT_SendMessage(osc_port, packet, (u32)(end_ptr-packet));
 }
 
 
@@ -502,6 +559,9 @@ s32 OSC_CLIENT_SendSysEx(u8 osc_port, u8 *stream, u32 count)
     return -2; 
 #endif
 
+  // send collected events before the stream
+  OSC_CLIENT_BundleFlush(osc_port);
+
   // we limit the maximum blob size to 64
   // send multiple blobs if required
   int max_bytes = 64;
@@ -520,7 +580,7 @@ s32 OSC_CLIENT_SendSysEx(u8 osc_port, u8 *stream, u32 count)
     end_ptr = MIOS32_OSC_PutString(end_ptr, ",b");
     end_ptr = MIOS32_OSC_PutBlob(end_ptr, (u8 *)&stream[send_offset], bytes_to_send);
 
-    OSC_SERVER_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
+    OSC_CLIENT_SendPacket(osc_port, packet, (u32)(end_ptr-packet), 1);
 
     send_offset += bytes_to_send;
   };
@@ -544,6 +604,9 @@ s32 OSC_CLIENT_SendMIDIEventBundled(u8 osc_port, mios32_midi_package_t *p, u8 nu
     return -2; 
 #endif
 
+  // send collected events before this bundle
+  OSC_CLIENT_BundleFlush(osc_port);
+
   // create the OSC packet
   u8 packet[256];
   u8 *end_ptr = packet;
@@ -562,5 +625,213 @@ s32 OSC_CLIENT_SendMIDIEventBundled(u8 osc_port, mios32_midi_package_t *p, u8 nu
   }
 
   // send packet and exit
-  return OSC_SERVER_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
+  return OSC_CLIENT_SendPacket(osc_port, packet, (u32)(end_ptr-packet), num_events);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Bundle output:
+// If a window is set for a port, the messages sent by OSC_CLIENT_SendMIDIEvent()
+// and OSC_CLIENT_SendNRPNEvent() are collected in a bundle, which is sent
+// when the window is over (see OSC_CLIENT_Periodic_mS()), when the buffer is
+// full, or when OSC_CLIENT_BundleFlush() is called.
+// The bundle gets the timetag of its first message.
+//
+// Sequencers can set a large window, and call OSC_CLIENT_BundleFlush() at
+// each clock tick to send all events of a step in a single UDP packet.
+//
+// Set the window to 0 (default) to send each message immediately.
+/////////////////////////////////////////////////////////////////////////////
+s32 OSC_CLIENT_BundleWindowSet(u8 osc_port, u16 window_ms)
+{
+  if( osc_port >= OSC_CLIENT_NUM_PORTS )
+    return -1; // invalid port
+
+#if OSC_CLIENT_BUNDLE_SIZE
+  MUTEX_BUNDLE_TAKE;
+  bundle_window[osc_port] = window_ms;
+  if( !window_ms && bundle_len[osc_port] )
+    OSC_CLIENT_BundleSend(osc_port);
+  MUTEX_BUNDLE_GIVE;
+
+  return 0; // no error
+#else
+  return window_ms ? -2 : 0; // bundle output disabled with OSC_CLIENT_BUNDLE_SIZE 0
+#endif
+}
+
+u16 OSC_CLIENT_BundleWindowGet(u8 osc_port)
+{
+#if OSC_CLIENT_BUNDLE_SIZE
+  if( osc_port < OSC_CLIENT_NUM_PORTS )
+    return bundle_window[osc_port];
+#endif
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sends the collected messages of a port immediately
+/////////////////////////////////////////////////////////////////////////////
+s32 OSC_CLIENT_BundleFlush(u8 osc_port)
+{
+  if( osc_port >= OSC_CLIENT_NUM_PORTS )
+    return -1; // invalid port
+
+  s32 status = 0;
+#if OSC_CLIENT_BUNDLE_SIZE
+  MUTEX_BUNDLE_TAKE;
+  if( bundle_len[osc_port] )
+    status = OSC_CLIENT_BundleSend(osc_port);
+  MUTEX_BUNDLE_GIVE;
+#endif
+
+  return status;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the number of packets, bytes and messages which have been sent
+// in the last second
+/////////////////////////////////////////////////////////////////////////////
+s32 OSC_CLIENT_StatsGet(u8 osc_port, osc_client_stats_t *_stats)
+{
+  if( osc_port >= OSC_CLIENT_NUM_PORTS )
+    return -1; // invalid port
+
+  MUTEX_BUNDLE_TAKE;
+  *_stats = stats[osc_port];
+  MUTEX_BUNDLE_GIVE;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Should be called each mS (done by the uIP task)
+// Sends bundles when their window is over, and updates the statistics
+/////////////////////////////////////////////////////////////////////////////
+s32 OSC_CLIENT_Periodic_mS(void)
+{
+  int i;
+
+  MUTEX_BUNDLE_TAKE;
+
+#if OSC_CLIENT_BUNDLE_SIZE
+  for(i=0; i<OSC_CLIENT_NUM_PORTS; ++i) {
+    if( bundle_len[i] ) {
+      if( bundle_timeout[i] > 1 )
+	--bundle_timeout[i];
+      else
+	OSC_CLIENT_BundleSend(i);
+    }
+  }
+#endif
+
+  if( ++stats_ms_ctr >= 1000 ) {
+    stats_ms_ctr = 0;
+
+    for(i=0; i<OSC_CLIENT_NUM_PORTS; ++i) {
+      stats[i].packets_per_second = stats_packets[i];
+      stats[i].bytes_per_second = stats_bytes[i];
+      stats[i].messages_per_second = stats_messages[i];
+      stats_packets[i] = 0;
+      stats_bytes[i] = 0;
+      stats_messages[i] = 0;
+    }
+  }
+
+  MUTEX_BUNDLE_GIVE;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// sends a single OSC message, or adds it to the bundle if a window is set
+/////////////////////////////////////////////////////////////////////////////
+static s32 OSC_CLIENT_SendMessage(u8 osc_port, u8 *message, u32 len)
+{
+#if OSC_CLIENT_BUNDLE_SIZE
+  if( bundle_window[osc_port] && (OSC_CLIENT_BUNDLE_HEADER_SIZE + 4 + len) <= OSC_CLIENT_BUNDLE_SIZE ) {
+    s32 status = 0;
+    u8 *buffer = bundle_buffer[osc_port];
+
+    MUTEX_BUNDLE_TAKE;
+
+    // send the bundle if the message doesn't fit anymore
+    if( bundle_len[osc_port] && (bundle_len[osc_port] + 4 + len) > OSC_CLIENT_BUNDLE_SIZE )
+      status = OSC_CLIENT_BundleSend(osc_port);
+
+    // new bundle: the timetag is taken from the first message
+    if( !bundle_len[osc_port] ) {
+      mios32_sys_time_t t = MIOS32_SYS_TimeGet();
+      mios32_osc_timetag_t timetag;
+      timetag.seconds = t.seconds;
+      timetag.fraction = t.fraction_ms * 4294967; // 2^32 / 1000
+
+      u8 *end_ptr = MIOS32_OSC_PutString(buffer, "#bundle");
+      MIOS32_OSC_PutTimetag(end_ptr, timetag);
+      bundle_len[osc_port] = OSC_CLIENT_BUNDLE_HEADER_SIZE;
+      bundle_num_messages[osc_port] = 0;
+      bundle_timeout[osc_port] = bundle_window[osc_port];
+    }
+
+    MIOS32_OSC_PutWord(&buffer[bundle_len[osc_port]], len);
+    memcpy(&buffer[bundle_len[osc_port] + 4], message, len);
+    bundle_len[osc_port] += 4 + len;
+    ++bundle_num_messages[osc_port];
+
+    MUTEX_BUNDLE_GIVE;
+
+    return status;
+  }
+
+  // send collected messages before this one
+  OSC_CLIENT_BundleFlush(osc_port);
+#endif
+
+  return OSC_CLIENT_SendPacket(osc_port, message, len, 1);
+}
+
+
+#if OSC_CLIENT_BUNDLE_SIZE
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// sends the collected messages of a port
+// a single message is sent without bundle
+/////////////////////////////////////////////////////////////////////////////
+static s32 OSC_CLIENT_BundleSend(u8 osc_port)
+{
+  s32 status;
+  u8 *buffer = bundle_buffer[osc_port];
+  u32 len = bundle_len[osc_port];
+
+  if( bundle_num_messages[osc_port] == 1 )
+    status = OSC_CLIENT_SendPacket(osc_port, &buffer[OSC_CLIENT_BUNDLE_HEADER_SIZE + 4], len - OSC_CLIENT_BUNDLE_HEADER_SIZE - 4, 1);
+  else
+    status = OSC_CLIENT_SendPacket(osc_port, buffer, len, bundle_num_messages[osc_port]);
+
+  bundle_len[osc_port] = 0;
+  bundle_num_messages[osc_port] = 0;
+
+  return status;
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// sends an UDP packet and updates the statistics
+/////////////////////////////////////////////////////////////////////////////
+static s32 OSC_CLIENT_SendPacket(u8 osc_port, u8 *packet, u32 len, u8 num_messages)
+{
+  MUTEX_BUNDLE_TAKE;
+  ++stats_packets[osc_port];
+  stats_bytes[osc_port] += len;
+  stats_messages[osc_port] += num_messages;
+  MUTEX_BUNDLE_GIVE;
+
+  return OSC_SERVER_SendPacket(osc_port, packet, len);
 }
@@ -36,10 +36,23 @@ extern "C" {
 #define OSC_CLIENT_TRANSFER_MODE_TOSC  4
 
 
+// size of the buffer which collects the messages of a bundle (for each port)
+// can be overruled in mios32_config.h - 0 disables bundle output and saves RAM
+#ifndef OSC_CLIENT_BUNDLE_SIZE
+#define OSC_CLIENT_BUNDLE_SIZE 256
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
 /////////////////////////////////////////////////////////////////////////////
 
+typedef struct {
+  u32 packets_per_second;  // UDP packets which have been sent in the last second
+  u32 bytes_per_second;    // size of these packets
+  u32 messages_per_second; // OSC messages which have been sent in the last second (bundled or not)
+} osc_client_stats_t;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Prototypes
@@ -58,6 +71,14 @@ extern s32 OSC_CLIENT_SendNRPNEvent(u8 osc_port, u8 chn, u16 nrpn_number, u16 nr
 extern s32 OSC_CLIENT_SendSysEx(u8 osc_port, u8 *stream, u32 count);
 extern s32 OSC_CLIENT_SendMIDIEventBundled(u8 osc_port, mios32_midi_package_t *p, u8 num_events, mios32_osc_timetag_t timetag);
 
+extern s32 OSC_CLIENT_BundleWindowSet(u8 osc_port, u16 window_ms);
+extern u16 OSC_CLIENT_BundleWindowGet(u8 osc_port);
+extern s32 OSC_CLIENT_BundleFlush(u8 osc_port);
+
+extern s32 OSC_CLIENT_StatsGet(u8 osc_port, osc_client_stats_t *stats);
+
+extern s32 OSC_CLIENT_Periodic_mS(void);
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Export global variables
@@ -46,6 +46,11 @@ static struct uip_udp_conn *osc_conn[OSC_SERVER_NUM_CONNECTIONS];
 const static mios32_osc_search_tree_t parse_root[];
 static u8 osc_parsed_from_con;
 
+#if OSC_SERVER_DISPATCH_TABLE_SIZE
+static mios32_osc_dispatch_entry_t osc_dispatch_entries[OSC_SERVER_DISPATCH_TABLE_SIZE];
+static mios32_osc_dispatch_table_t osc_dispatch_table;
+#endif
+
 static u8 *osc_send_packet;
 static u32 osc_send_len;
 
@@ -65,6 +70,18 @@ s32 OSC_SERVER_Init(u32 mode)
   // disable send packet
   osc_send_packet = NULL;
 
+#if OSC_SERVER_DISPATCH_TABLE_SIZE
+  // compile the search tree for faster dispatching of incoming packets
+  // if this fails, the packets are parsed by searching the tree
+  if( MIOS32_OSC_CompileSearchTree(&osc_dispatch_table, osc_dispatch_entries, OSC_SERVER_DISPATCH_TABLE_SIZE, parse_root) < 0 ) {
+#if DEBUG_VERBOSE_LEVEL >= 1
+    UIP_TASK_MUTEX_MIDIOUT_TAKE;
+    DEBUG_MSG("[OSC_SERVER] OSC_SERVER_DISPATCH_TABLE_SIZE too small for search tree!\n");
+    UIP_TASK_MUTEX_MIDIOUT_GIVE;
+#endif
+  }
+#endif
+
   // remove open connections
   for(con=0; con<OSC_SERVER_NUM_CONNECTIONS; ++con)
     if( osc_conn[con] != NULL )
@@ -270,7 +287,11 @@ s32 OSC_SERVER_AppCall(void)
 #endif
 
       osc_parsed_from_con = con; // used by event propagation
+#if OSC_SERVER_DISPATCH_TABLE_SIZE
+      s32 status = MIOS32_OSC_ParsePacketCompiled((u8 *)uip_appdata, uip_len, &osc_dispatch_table);
+#else
       s32 status = MIOS32_OSC_ParsePacket((u8 *)uip_appdata, uip_len, parse_root);
+#endif
       if( status < 0 ) {
 #if DEBUG_VERBOSE_LEVEL >= 2
 	UIP_TASK_MUTEX_MIDIOUT_TAKE;
@@ -751,7 +772,7 @@ static s32 OSC_SERVER_Method_EventTOSC(mios32_osc_args_t *osc_args, u32 method_a
 
 
 /////////////////////////////////////////////////////////////////////////////
-// Search Tree for OSC Methods (used by MIOS32_OSC_ParsePacket())
+// Search Tree for OSC Methods (used by MIOS32_OSC_ParsePacket*())
 /////////////////////////////////////////////////////////////////////////////
 
 
@@ -45,6 +45,12 @@ extern "C" {
 #define OSC_IGNORE_TRANSFER_MODE 0
 #endif
 
+// number of entries in the dispatch table for incoming OSC paths (has to be a power of two)
+// each entry allocates 8 + MIOS32_OSC_MAX_PATH_PARTS bytes (with padding) - 0 disables the table
+#ifndef OSC_SERVER_DISPATCH_TABLE_SIZE
+#define OSC_SERVER_DISPATCH_TABLE_SIZE 256
+#endif
+
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
 /////////////////////////////////////////////////////////////////////////////
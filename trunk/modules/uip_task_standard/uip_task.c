@@ -250,6 +250,9 @@ static void UIP_TASK_Handler(void *pvParameters)
       }
     }
 
+    // send OSC bundles when their window is over
+    OSC_CLIENT_Periodic_mS();
+
     // release exclusive access to UIP functions
     MUTEX_UIP_GIVE;
   }
@@ -0,0 +1,14 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host test
+ *
+ * WS2812_DMA_LEDS is passed by the makefile
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+// odd number, so that the frame doesn't fit into the DMA buffer halves
+#define WS2812_NUM_LEDS 61
+
+#endif /* _MIOS32_CONFIG_H */
@@ -0,0 +1,173 @@
+// $Id$
+/*
+ * Host test for the WS2812 encoder
+ *
+ * The stream which is generated by WS2812_Encode() through the DMA ping-pong
+ * buffer is compared against the previous per-LED encoding, which stored
+ * 24 compare values per LED (+ 2*24 reset values) in a circular DMA buffer:
+ *   - after WS2812_LED_SetRGB() and WS2812_LED_SetHSV() changes
+ *   - with brightness/gamma correction
+ *
+ * Build and run for different DMA buffer sizes with "make test"
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <gnu_test.h>
+
+#include "ws2812.h"
+
+// same timings like in ws2812.c
+#define WS2812_TIM_PERIOD       ((MIOS32_SYS_CPU_FREQUENCY/2) / 800000)
+#define WS2812_TIM_CC_RESET     0
+#define WS2812_TIM_CC_LOW       (u16)((WS2812_TIM_PERIOD - 1) * 0.28)
+#define WS2812_TIM_CC_HIGH      (u16)((WS2812_TIM_PERIOD - 1) * 0.74)
+
+#define NUM_FRAMES 3
+
+
+/////////////////////////////////////////////////////////////////////////////
+// previous encoding: compare values of all LEDs are stored in memory
+/////////////////////////////////////////////////////////////////////////////
+#define REF_BUFFER_SIZE ((WS2812_NUM_LEDS+2)*24)
+static u16 ref_buffer[REF_BUFFER_SIZE];
+
+static void ref_init(void)
+{
+  int i;
+  for(i=0; i<(WS2812_NUM_LEDS*24); ++i)
+    ref_buffer[i] = WS2812_TIM_CC_LOW;
+  for(; i<REF_BUFFER_SIZE; ++i)
+    ref_buffer[i] = WS2812_TIM_CC_RESET;
+}
+
+static void ref_set_rgb(u16 led, u8 colour, u8 value)
+{
+  u8 offset = (colour == 0) ? 1*8 : ((colour == 1) ? 0*8 : 2*8);
+  u8 i, mask;
+  u16 *dst_ptr = &ref_buffer[24*led + offset];
+  for(i=0, mask=0x80; i<8; ++i, mask >>= 1)
+    *(dst_ptr++) = (value & mask) ? WS2812_TIM_CC_HIGH : WS2812_TIM_CC_LOW;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// emulates the circular DMA with HT/TC interrupts, and compares the
+// transfered values with the reference buffer
+/////////////////////////////////////////////////////////////////////////////
+static u16 dma_buffer[2*WS2812_DMA_LEDS*24];
+static u32 dma_pos;    // position in dma_buffer
+static u32 stream_pos; // position in the reference stream
+
+static void dma_start(void)
+{
+  WS2812_Encode(dma_buffer, 2*WS2812_DMA_LEDS);
+  dma_pos = 0;
+  stream_pos = 0;
+}
+
+// transfers the given number of frames, returns number of mismatches
+static u32 dma_transfer_frames(const char *name, int frames, int verbose)
+{
+  u32 mismatches = 0;
+  u32 num = frames * REF_BUFFER_SIZE;
+
+  while( num-- ) {
+    if( dma_buffer[dma_pos] != ref_buffer[stream_pos] ) {
+      if( ++mismatches < 5 && verbose )
+	printf("ERROR: %s: value %d at LED %d, bit %d, expected %d\n", name,
+	       dma_buffer[dma_pos], stream_pos / 24, stream_pos % 24, ref_buffer[stream_pos]);
+    }
+
+    if( ++stream_pos >= REF_BUFFER_SIZE )
+      stream_pos = 0;
+
+    ++dma_pos;
+    if( dma_pos == WS2812_DMA_LEDS*24 ) {
+      // HT interrupt
+      WS2812_Encode(&dma_buffer[0], WS2812_DMA_LEDS);
+    } else if( dma_pos == 2*WS2812_DMA_LEDS*24 ) {
+      // TC interrupt
+      WS2812_Encode(&dma_buffer[WS2812_DMA_LEDS*24], WS2812_DMA_LEDS);
+      dma_pos = 0;
+    }
+  }
+
+  return mismatches;
+}
+
+// changes are taken over with a delay of up to 2*WS2812_DMA_LEDS LEDs,
+// therefore the first frame after a change isn't compared
+static void check(const char *name)
+{
+  dma_transfer_frames(name, 1, 0);
+
+  u32 mismatches = dma_transfer_frames(name, NUM_FRAMES, 1);
+  num_errors += mismatches;
+  printf("  %-28s %s\n", name, mismatches ? "FAILED" : "ok");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  int led, colour;
+
+  printf("WS2812_NUM_LEDS=%d, WS2812_DMA_LEDS=%d: framebuffer %d bytes, DMA buffer %d bytes (previous encoding: %d bytes)\n",
+	 WS2812_NUM_LEDS, WS2812_DMA_LEDS, WS2812_NUM_LEDS*3, (int)sizeof(dma_buffer), (int)sizeof(ref_buffer));
+
+  WS2812_Init(0); // returns -1 (no hardware), but initializes the framebuffer
+  ref_init();
+  dma_start();
+  check("initial");
+
+  srand(1);
+  for(led=0; led<WS2812_NUM_LEDS; ++led) {
+    for(colour=0; colour<3; ++colour) {
+      u8 value = rand();
+      WS2812_LED_SetRGB(led, colour, value);
+      ref_set_rgb(led, colour, value);
+      if( WS2812_LED_GetRGB(led, colour) != value ) {
+	printf("ERROR: WS2812_LED_GetRGB(%d, %d) returned %d, expected %d\n", led, colour, (int)WS2812_LED_GetRGB(led, colour), value);
+	++num_errors;
+      }
+    }
+  }
+  check("random RGB values");
+
+  for(led=0; led<WS2812_NUM_LEDS; ++led) {
+    float h = (360.0 * led) / WS2812_NUM_LEDS;
+    WS2812_LED_SetHSV(led, h, 1.0, 0.5);
+    for(colour=0; colour<3; ++colour)
+      ref_set_rgb(led, colour, WS2812_LED_GetRGB(led, colour));
+  }
+  check("rainbow (HSV)");
+
+  WS2812_BrightnessSet(64);
+  for(led=0; led<WS2812_NUM_LEDS; ++led) {
+    for(colour=0; colour<3; ++colour)
+      ref_set_rgb(led, colour, (u8)(WS2812_LED_GetRGB(led, colour) * 64 / 255.0 + 0.5));
+  }
+  check("brightness 64");
+
+  WS2812_BrightnessSet(255);
+  WS2812_GammaSet(2.2);
+  for(led=0; led<WS2812_NUM_LEDS; ++led) {
+    for(colour=0; colour<3; ++colour)
+      ref_set_rgb(led, colour, (u8)(powf(WS2812_LED_GetRGB(led, colour) / 255.0, 2.2) * 255 + 0.5));
+  }
+  check("gamma 2.2");
+
+  WS2812_GammaSet(1.0);
+  WS2812_Init(1); // clears the LEDs
+  ref_init();
+  check("cleared");
+
+  return GNU_TEST_Result();
+}
@@ -19,14 +19,26 @@
 //!
 //! In order to avoid that the CPU is loaded with switching the duty cycle for each
 //! bit during the serial transfer, we just use the DMA controller to perform the
-//! register write operations in background. This results into a high memory consumption,
-//! because for each bit a 16bit number has to be stored in memory, resulting into 48 bytes
-//! per RGB LED.
+//! register write operations in background. For each bit a 16bit number has to be
+//! transfered, which would result into 48 bytes per RGB LED.
 //!
-//! But the advantages are clearly that the CPU is not involved and can run other
-//! (more useful) tasks. Since the DMA is configured in circular mode, the LED strip
-//! will be periodically loaded with the current RGB values which are stored in the
-//! memory buffer.
+//! Therefore the RGB values are stored in a framebuffer with 3 bytes per LED, and
+//! the DMA controller transfers from a small ping-pong buffer which contains the
+//! compare values of 2*WS2812_DMA_LEDS LEDs. Whenever one half of this buffer
+//! has been transfered, the DMA interrupt encodes the next LEDs into this half.
+//! During the encoding, the RGB values are mapped through a table which applies
+//! the global brightness and gamma correction (see WS2812_BrightnessSet() and
+//! WS2812_GammaSet()).
+//!
+//! Since the DMA is configured in circular mode, the LED strip will be
+//! periodically loaded with the current RGB values which are stored in the
+//! framebuffer.
+//!
+//! If the interrupt is serviced too late (e.g. blocked by an interrupt with
+//! higher priority), the DMA already transfers the half which is encoded.
+//! This is detected after the encoding, the underrun counter is incremented
+//! (see WS2812_UnderrunCtrGet()) and the transfer continues with the RESET
+//! frame, so that the corrupted frame is replaced by a complete new one.
 //!
 //!
 //! Currently this driver is only supported for the MBHP_CORE_STM32F4 module.
@@ -67,6 +79,9 @@
 
 #if defined(MIOS32_FAMILY_STM32F4xx)
 #define WS2812_SUPPORTED 1
+#elif defined(MIOS32_FAMILY_EMULATION)
+// no DMA, only the frame buffer and the encoding are available (see gnu_test)
+#define WS2812_SUPPORTED 0
 #else
 #warning "WS2812 driver not supported for this derivative yet!"
 #define WS2812_SUPPORTED 0
@@ -91,20 +106,48 @@
 // DMA channel (DMA1 Stream 0, Channel 2 - fortunately DMA1_Stream0 not used by any other MIOS32 driver yet...!)
 #define WS2812_DMA_PTR          DMA1_Stream0
 #define WS2812_DMA_CHN          DMA_Channel_2
+#define WS2812_DMA_IRQn         DMA1_Stream0_IRQn
+#define WS2812_DMA_IRQHANDLER   DMA1_Stream0_IRQHandler
+#define WS2812_DMA_IT_HT        DMA_IT_HTIF0
+#define WS2812_DMA_IT_TC        DMA_IT_TCIF0
+#define WS2812_DMA_FLAG_ALL     (DMA_FLAG_HTIF0 | DMA_FLAG_TCIF0 | DMA_FLAG_TEIF0 | DMA_FLAG_DMEIF0 | DMA_FLAG_FEIF0)
+
+// the encoding of a buffer half has to be finished before the other half has been transfered
+// (WS2812_DMA_LEDS * 30 uS)
+#define WS2812_DMA_IRQ_PRIORITY MIOS32_IRQ_PRIO_HIGH
 
 
-#define WS2812_BUFFER_SIZE ((WS2812_NUM_LEDS+2)*24) // +2*24 to insert the RESET frame
+#define WS2812_RESET_SLOTS      2 // 2*24 reset values are inserted after the last LED to get the RESET frame
+#define WS2812_DMA_BUFFER_SIZE  (2*WS2812_DMA_LEDS*24) // ping-pong buffer
 
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
 
-static u16 send_buffer[WS2812_BUFFER_SIZE];
+// RGB values in the order of transmission (G, R, B)
+static u8 led_buffer[WS2812_NUM_LEDS*3];
+
+// maps the RGB values to the transmitted values (brightness and gamma correction)
+static u8 output_table[256];
+static u8 output_brightness = 255;
+static float output_gamma = 1.0;
+
+// the next LED which will be encoded (values >= WS2812_NUM_LEDS: RESET frame)
+static u16 encode_slot;
+
+#if WS2812_SUPPORTED
+static u16 dma_buffer[WS2812_DMA_BUFFER_SIZE];
+#endif
+
+// number of DMA buffer underruns
+static u32 underrun_ctr;
 
 /////////////////////////////////////////////////////////////////////////////
 // Local Prototypes
 /////////////////////////////////////////////////////////////////////////////
 
+static void WS2812_OutputTableUpdate(void);
+
 
 /////////////////////////////////////////////////////////////////////////////
 //! Initializes WS2812 driver
@@ -115,20 +158,24 @@ static u16 send_buffer[WS2812_BUFFER_SIZE];
 /////////////////////////////////////////////////////////////////////////////
 s32 WS2812_Init(u32 mode)
 {
-#if !WS2812_SUPPORTED
-  return -1;
-#else
   {
     int i;
-    for(i=0; i<(WS2812_NUM_LEDS*24); ++i) {
-      send_buffer[i] = WS2812_TIM_CC_LOW;
+    for(i=0; i<(WS2812_NUM_LEDS*3); ++i) {
+      led_buffer[i] = 0;
     }
+  }
 
-    for(;i<WS2812_BUFFER_SIZE; ++i) {
-      send_buffer[i] = WS2812_TIM_CC_RESET;
-    }
+  WS2812_OutputTableUpdate();
+
+  if( mode == 0 ) {
+    // start with the first LED
+    encode_slot = 0;
+    underrun_ctr = 0;
   }
 
+#if !WS2812_SUPPORTED
+  return -1;
+#else
   if( mode == 0 ) {
     // WS2812 coding: see following nice overview page: http://www.mikrocontroller.net/articles/WS2812_Ansteuerung
     // We take the timer based approach since TIM4 isn't used by MIOS32 (yet), and J4B.SC is normally not used by apps
@@ -175,13 +222,16 @@ s32 WS2812_Init(u32 mode)
     {
       DMA_Cmd(WS2812_DMA_PTR, DISABLE);
 
+      // encode the first LEDs into both buffer halves
+      WS2812_Encode(dma_buffer, 2*WS2812_DMA_LEDS);
+
       DMA_InitTypeDef DMA_InitStructure;
       DMA_StructInit(&DMA_InitStructure);
       DMA_InitStructure.DMA_Channel = WS2812_DMA_CHN;
       DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
       DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
-      DMA_InitStructure.DMA_Memory0BaseAddr = (u32)&send_buffer[0];
-      DMA_InitStructure.DMA_BufferSize = WS2812_BUFFER_SIZE;
+      DMA_InitStructure.DMA_Memory0BaseAddr = (u32)&dma_buffer[0];
+      DMA_InitStructure.DMA_BufferSize = WS2812_DMA_BUFFER_SIZE;
       DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)&WS2812_TIM_CCR;
       DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
       DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
@@ -190,6 +240,11 @@ s32 WS2812_Init(u32 mode)
       DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
       DMA_Init(WS2812_DMA_PTR, &DMA_InitStructure);
 
+      // trigger interrupt when transfer half complete/complete
+      DMA_ClearFlag(WS2812_DMA_PTR, WS2812_DMA_FLAG_ALL);
+      DMA_ITConfig(WS2812_DMA_PTR, DMA_IT_HT | DMA_IT_TC, ENABLE);
+      MIOS32_IRQ_Install(WS2812_DMA_IRQn, WS2812_DMA_IRQ_PRIORITY);
+
       DMA_Cmd(WS2812_DMA_PTR, ENABLE);
     }
   }
@@ -208,29 +263,23 @@ s32 WS2812_Init(u32 mode)
 /////////////////////////////////////////////////////////////////////////////
 s32 WS2812_LED_SetRGB(u16 led, u8 colour, u8 value)
 {
-#if !WS2812_SUPPORTED
-  return -1;
-#else
   if( led >= WS2812_NUM_LEDS )
     return -1; // unsupported LED
 
   u8 offset = 0;
   if( colour == 0 )
-    offset = 1*8;
+    offset = 1;
   else if( colour == 1 )
-    offset = 0*8;
+    offset = 0;
   else if( colour == 2 )
-    offset = 2*8;
+    offset = 2;
   else
     return -2; // unsupported colour
 
-  u8 i, mask;
-  u16 *dst_ptr = (u16 *)&send_buffer[24*led + offset];
-  for(i=0, mask=0x80; i<8; ++i, mask >>= 1)
-    *(dst_ptr++) = (value & mask) ? WS2812_TIM_CC_HIGH : WS2812_TIM_CC_LOW;
+  // will be encoded by the DMA interrupt
+  led_buffer[3*led + offset] = value;
 
   return value;
-#endif
 }
 
 
@@ -242,32 +291,20 @@ s32 WS2812_LED_SetRGB(u16 led, u8 colour, u8 value)
 /////////////////////////////////////////////////////////////////////////////
 s32 WS2812_LED_GetRGB(u16 led, u8 colour)
 {
-#if !WS2812_SUPPORTED
-  return -1;
-#else
   if( led >= WS2812_NUM_LEDS )
     return -1; // unsupported LED
 
   u8 offset = 0;
   if( colour == 0 )
-    offset = 1*8;
+    offset = 1;
   else if( colour == 1 )
-    offset = 0*8;
+    offset = 0;
   else if( colour == 2 )
-    offset = 2*8;
+    offset = 2;
   else
     return -2; // unsupported colour
 
-  u8 i, mask;
-  u16 *src_ptr = (u16 *)&send_buffer[24*led + offset];
-  s32 value = 0;
-  for(i=0, mask=0x80; i<8; ++i, mask >>= 1) {
-    if( *(src_ptr++) == WS2812_TIM_CC_HIGH )
-      value |= mask;
-  }
-
-  return value;
-#endif
+  return led_buffer[3*led + offset];
 }
 
 
@@ -399,4 +436,156 @@ s32 WS2812_LED_GetHSV(u16 led, float *h, float *s, float *v)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Sets the global brightness of all LEDs
+//! \param[in] brightness 0..255 (255: RGB values are sent unchanged)
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 WS2812_BrightnessSet(u8 brightness)
+{
+  output_brightness = brightness;
+  WS2812_OutputTableUpdate();
+
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! \return the global brightness
+/////////////////////////////////////////////////////////////////////////////
+s32 WS2812_BrightnessGet(void)
+{
+  return output_brightness;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \return the number of DMA buffer underruns, i.e. how often the DMA
+//! interrupt has been serviced too late, so that a frame had to be restarted.
+//! Should stay 0, otherwise WS2812_DMA_LEDS should be increased.
+/////////////////////////////////////////////////////////////////////////////
+u32 WS2812_UnderrunCtrGet(void)
+{
+  return underrun_ctr;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Sets the gamma correction of all LEDs
+//! \param[in] gamma 1.0: no correction, typical values for LEDs are 2.2..2.8
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 WS2812_GammaSet(float gamma)
+{
+  if( gamma <= 0.0 )
+    return -1; // invalid value
+
+  output_gamma = gamma;
+  WS2812_OutputTableUpdate();
+
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! \return the gamma correction
+/////////////////////////////////////////////////////////////////////////////
+float WS2812_GammaGet(void)
+{
+  return output_gamma;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Updates the table which maps RGB values to transmitted values
+/////////////////////////////////////////////////////////////////////////////
+static void WS2812_OutputTableUpdate(void)
+{
+  int i;
+  for(i=0; i<256; ++i) {
+    float value = (float)i / 255.0;
+    if( output_gamma != 1.0 )
+      value = powf(value, output_gamma);
+    output_table[i] = (u8)(value * output_brightness + 0.5);
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Encodes the next LEDs of the continuous WS2812 stream into timer compare
+//! values: 24 values per LED (G, R, B, MSB first), after the last LED
+//! 2*24 reset values are inserted to get the RESET frame, thereafter the
+//! stream continues with the first LED.
+//!
+//! Called from the DMA interrupt, it's only public for testing the encoding.
+//! \param[out] buffer receives num_leds*24 compare values
+//! \param[in] num_leds number of LEDs (or RESET slots) which should be encoded
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 WS2812_Encode(u16 *buffer, u32 num_leds)
+{
+  while( num_leds-- ) {
+    if( encode_slot < WS2812_NUM_LEDS ) {
+      u8 *src_ptr = (u8 *)&led_buffer[3*encode_slot];
+      int colour;
+      for(colour=0; colour<3; ++colour) {
+	u8 value = output_table[*(src_ptr++)];
+	u8 mask;
+	for(mask=0x80; mask; mask >>= 1)
+	  *(buffer++) = (value & mask) ? WS2812_TIM_CC_HIGH : WS2812_TIM_CC_LOW;
+      }
+    } else {
+      int i;
+      for(i=0; i<24; ++i)
+	*(buffer++) = WS2812_TIM_CC_RESET;
+    }
+
+    if( ++encode_slot >= (WS2812_NUM_LEDS + WS2812_RESET_SLOTS) )
+      encode_slot = 0;
+  }
+
+  return 0; // no error
+}
+
+
+#if WS2812_SUPPORTED
+/////////////////////////////////////////////////////////////////////////////
+//! Called by the DMA interrupt if the DMA already transfers the range which
+//! has just been encoded: the LEDs got (partly) values of the previous pass.
+//! The next encoded LEDs are the RESET frame, so that the LEDs latch and get
+//! a complete new frame.
+/////////////////////////////////////////////////////////////////////////////
+static void WS2812_DMA_Underrun(void)
+{
+  ++underrun_ctr;
+  encode_slot = WS2812_NUM_LEDS;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! DMA interrupt is triggered on HT and TC interrupts
+//! \note shouldn't be called directly from application
+/////////////////////////////////////////////////////////////////////////////
+void WS2812_DMA_IRQHANDLER(void)
+{
+  if( DMA_GetITStatus(WS2812_DMA_PTR, WS2812_DMA_IT_HT) ) {
+    DMA_ClearITPendingBit(WS2812_DMA_PTR, WS2812_DMA_IT_HT);
+    // lower range has been transfered and can be updated
+    WS2812_Encode(&dma_buffer[0], WS2812_DMA_LEDS);
+
+    // the DMA should still transfer the upper range (NDTR counts the remaining transfers down)
+    if( DMA_GetCurrDataCounter(WS2812_DMA_PTR) > (WS2812_DMA_BUFFER_SIZE/2) )
+      WS2812_DMA_Underrun();
+  }
+
+  if( DMA_GetITStatus(WS2812_DMA_PTR, WS2812_DMA_IT_TC) ) {
+    DMA_ClearITPendingBit(WS2812_DMA_PTR, WS2812_DMA_IT_TC);
+    // upper range has been transfered and can be updated
+    WS2812_Encode(&dma_buffer[WS2812_DMA_LEDS*24], WS2812_DMA_LEDS);
+
+    // the DMA should still transfer the lower range
+    if( DMA_GetCurrDataCounter(WS2812_DMA_PTR) <= (WS2812_DMA_BUFFER_SIZE/2) )
+      WS2812_DMA_Underrun();
+  }
+}
+#endif
+
+
 //! \}
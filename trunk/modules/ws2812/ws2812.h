@@ -23,11 +23,20 @@ extern "C" {
 /////////////////////////////////////////////////////////////////////////////
 
 // Maximum number of LEDs connected to the WS2812 chain
-// Each LED will consume 48 bytes!
+// Each LED will consume 3 bytes
 #ifndef WS2812_NUM_LEDS
 #define WS2812_NUM_LEDS 64
 #endif
 
+// Number of LEDs which are encoded into each half of the DMA buffer
+// The DMA buffer consumes 96 bytes per LED, and the DMA interrupt is
+// triggered each WS2812_DMA_LEDS*30 uS
+// This is also the time which is available to service the interrupt, otherwise
+// the transfer is restarted (see WS2812_UnderrunCtrGet())
+#ifndef WS2812_DMA_LEDS
+#define WS2812_DMA_LEDS 16
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -46,6 +55,15 @@ extern s32 WS2812_LED_GetRGB(u16 led, u8 colour);
 extern s32 WS2812_LED_SetHSV(u16 led, float h, float s, float v);
 extern s32 WS2812_LED_GetHSV(u16 led, float *h, float *s, float *v);
 
+extern s32 WS2812_BrightnessSet(u8 brightness);
+extern s32 WS2812_BrightnessGet(void);
+extern s32 WS2812_GammaSet(float gamma);
+extern float WS2812_GammaGet(void);
+
+extern s32 WS2812_Encode(u16 *buffer, u32 num_leds);
+
+extern u32 WS2812_UnderrunCtrGet(void);
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Export global variables
@@ -26,12 +26,18 @@
 #include <task.h>
 #include <queue.h>
 
+#if defined(MIOS32_FAMILY_HOST)
+#include <mios32_host.h>
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // External Prototypes
 /////////////////////////////////////////////////////////////////////////////
 
+#if !defined(MIOS32_FAMILY_HOST)
 extern void __libc_init_array(void);  /* calls CTORS of static objects */
+#endif
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -129,8 +135,10 @@ int main(void)
   MIOS32_I2S_Init(0);
 #endif
 
-  // call C++ constructors
+#if !defined(MIOS32_FAMILY_HOST)
+  // call C++ constructors (on the host this is done by the C runtime)
   __libc_init_array();
+#endif
 
   // initialize application
   APP_Init();
@@ -182,6 +190,11 @@ void SRIO_ServiceFinish(void)
 
 void vApplicationTickHook(void)
 {
+#if defined(MIOS32_FAMILY_HOST)
+  // simulated peripherals (timers, MIDI input, run time limit)
+  MIOS32_HOST_Tick();
+#endif
+
 #if !defined(MIOS32_DONT_USE_TIMESTAMP)
   MIOS32_TIMESTAMP_Inc();
 #endif
@@ -201,6 +214,11 @@ void vApplicationTickHook(void)
 /////////////////////////////////////////////////////////////////////////////
 void vApplicationIdleHook(void)
 {
+#if defined(MIOS32_FAMILY_HOST)
+  // all tasks are waiting: continue with the next tick of the simulated clock
+  vPortSimulatedTick();
+#endif
+
   APP_Background();
 }
 
@@ -294,7 +312,10 @@ static void TASK_Hooks(void *pvParameters)
 /////////////////////////////////////////////////////////////////////////////
 void _abort(void)
 {
-#ifndef MIOS32_DONT_USE_MIDI
+#if defined(MIOS32_FAMILY_HOST)
+  // nothing to keep alive on the host
+  exit(1);
+#elif !defined(MIOS32_DONT_USE_MIDI)
   // keep MIDI alive, so that program code can be updated
   u32 delay_ctr = 0;
   while( 1 ) {
@@ -355,6 +376,7 @@ void vApplicationMallocFailedHook(void)
 }
 
 
+#if !defined(MIOS32_FAMILY_HOST)
 /////////////////////////////////////////////////////////////////////////////
 // _exit() for newer newlib versions
 /////////////////////////////////////////////////////////////////////////////
@@ -455,6 +477,7 @@ void HardFault_Handler(void)
   __asm("MRSNE R0, PSP");
   __asm("B HardFault_Handler_c");
 }
+#endif /* !MIOS32_FAMILY_HOST */
 
 // used if configCHECK_FOR_STACK_OVERFLOW enabled (set to 1 or 2) in FreeRTOSConfig.h
 #if configCHECK_FOR_STACK_OVERFLOW
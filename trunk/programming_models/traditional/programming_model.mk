@@ -7,26 +7,37 @@
 
 FREE_RTOS      =    $(MIOS32_PATH)/FreeRTOS
 
+# the FreeRTOS port: POSIX for the host build, Cortex-M3 for all others
+ifeq ($(FAMILY),HOST)
+FREE_RTOS_PORT = $(FREE_RTOS)/Source/portable/GCC/Posix
+else
+FREE_RTOS_PORT = $(FREE_RTOS)/Source/portable/GCC/ARM_CM3
+
+# required by FreeRTOS to select the port
+CFLAGS    +=    -DGCC_ARMCM3
+endif
+
 # extend include path
 C_INCLUDE += 	-I $(MIOS32_PATH)/programming_models/traditional \
 		-I $(FREE_RTOS)/Source/include \
-		-I $(FREE_RTOS)/Source/portable/GCC/ARM_CM3 \
+		-I $(FREE_RTOS_PORT) \
 		-I $(FREE_RTOS)/Source/portable/MemMang \
 
-# required by FreeRTOS to select the port
-CFLAGS    +=    -DGCC_ARMCM3
-
 # add modules to thumb sources
 THUMB_SOURCE += \
 		$(MIOS32_PATH)/programming_models/traditional/main.c \
-		$(MIOS32_PATH)/programming_models/traditional/strtol.c \
 		$(FREE_RTOS)/Source/tasks.c \
 		$(FREE_RTOS)/Source/list.c \
 		$(FREE_RTOS)/Source/queue.c \
 		$(FREE_RTOS)/Source/timers.c \
-		$(FREE_RTOS)/Source/portable/GCC/ARM_CM3/port.c \
+		$(FREE_RTOS_PORT)/port.c \
 		$(FREE_RTOS)/Source/portable/MemMang/umm_malloc.c 
 
+# on the host, strtol() is provided by the C library
+ifneq ($(FAMILY),HOST)
+THUMB_SOURCE += $(MIOS32_PATH)/programming_models/traditional/strtol.c
+endif
+
 ifeq ($(FAMILY),STM32F10x)
 THUMB_SOURCE += $(MIOS32_PATH)/programming_models/traditional/startup_stm32f10x_hd.c
 endif
@@ -37,8 +48,11 @@ ifeq ($(FAMILY),LPC17xx)
 THUMB_SOURCE += $(MIOS32_PATH)/programming_models/traditional/startup_LPC17xx.c
 endif
 
+# on the host, new/delete and malloc/free are provided by the C++ and C library
+ifneq ($(FAMILY),HOST)
 THUMB_CPP_SOURCE += $(MIOS32_PATH)/programming_models/traditional/mini_cpp.cpp \
 		    $(MIOS32_PATH)/programming_models/traditional/freertos_heap.cpp
+endif
 
 # add MIOS32 sources
 include $(MIOS32_PATH)/mios32/mios32.mk
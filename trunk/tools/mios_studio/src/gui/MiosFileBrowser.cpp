@@ -168,6 +168,9 @@ MiosFileBrowser::MiosFileBrowser(MiosStudio *_miosStudio)
     , currentReadFileBrowserItem(NULL)
     , currentReadFileStream(NULL)
     , currentReadError(false)
+    , currentReadBinary(false)
+    , currentReadBinaryPos(0)
+    , currentReadBinaryRetryPos(0)
     , currentWriteInProgress(false)
     , currentWriteError(false)
     , writeBlockCtrDefault(32) // send 32 blocks (=two 512 byte SD Card Sectors) at once to speed-up write operations
@@ -649,7 +652,8 @@ bool MiosFileBrowser::downloadFileSelection(unsigned selection)
 
         if( openHexEditorAfterRead || openTextEditorAfterRead ) {
             disableFileButtons();
-            sendCommand(T("read ") + currentReadFileName);
+            currentReadBinary = true; // falls back to text mode if not supported by the application
+            sendCommand(T("readbin ") + currentReadFileName);
             return true;
         } else {
             // restore default path
@@ -683,7 +687,8 @@ bool MiosFileBrowser::downloadFileSelection(unsigned selection)
                     setStatus(T("Failed to open ") + currentReadFile.getFullPathName());
                 } else {
                     disableFileButtons();
-                    sendCommand(T("read ") + currentReadFileName);
+                    currentReadBinary = true; // falls back to text mode if not supported by the application
+                    sendCommand(T("readbin ") + currentReadFileName);
                     return true;
                 }
             }
@@ -936,7 +941,12 @@ bool MiosFileBrowser::uploadFinished(void)
 //==============================================================================
 void MiosFileBrowser::timerCallback()
 {
-    if( currentReadInProgress ) {
+    if( currentReadInProgress && currentReadBinary ) {
+        // request the missing blocks again
+        setStatus(T("No response from MIOS32 core during read operation - retrying!"));
+        currentReadBinaryRetryPos = currentReadBinaryPos + 1; // force retry
+        sendReadRetry();
+    } else if( currentReadInProgress ) {
         if( currentReadError ) {
             setStatus(T("Invalid response from MIOS32 core during read operation!"));
         } else {
@@ -961,6 +971,91 @@ void MiosFileBrowser::sendCommand(const String& command)
     startTimer(5000);
 }
 
+//==============================================================================
+void MiosFileBrowser::sendReadRetry(void)
+{
+    // only request a retransmission once per missing position, blocks which are
+    // already on the way will be ignored until the requested one has been received
+    if( currentReadBinaryRetryPos != currentReadBinaryPos ) {
+        currentReadBinaryRetryPos = currentReadBinaryPos;
+        sendCommand(String::formatted(T("readretry %X"), currentReadBinaryPos));
+    } else {
+        startTimer(5000);
+    }
+}
+
+//==============================================================================
+void MiosFileBrowser::receiveBinaryBlock(const uint8 *data, uint32 size)
+{
+    if( !currentReadInProgress || !currentReadBinary )
+        return; // ignore
+
+    stopTimer(); // will be restarted if required
+
+    // header: 4 bytes position, 2 bytes length, 3 bytes CRC16 (7bit each, LSB first)
+    if( size < 9 ) {
+        currentReadError = true;
+        sendReadRetry();
+        return;
+    }
+
+    unsigned address = data[0] | (data[1] << 7) | (data[2] << 14) | (data[3] << 21);
+    unsigned length = data[4] | (data[5] << 7);
+    uint16 crc = data[6] | (data[7] << 7) | (data[8] << 14);
+
+    // payload: each group of 7 bytes is preceded by a byte which contains the MSBs
+    Array<uint8> payload;
+    for(int i=9; i<size && data[i] < 0x80; ) {
+        uint8 msbs = data[i++];
+        for(int j=0; j<7 && i<size && data[i] < 0x80; ++j, ++i)
+            payload.add(data[i] | ((msbs & (1 << j)) ? 0x80 : 0x00));
+    }
+
+    uint16 payloadCrc = 0xffff;
+    for(int i=0; i<payload.size(); ++i) {
+        payloadCrc ^= (uint16)payload[i] << 8;
+        for(int bit=0; bit<8; ++bit)
+            payloadCrc = (payloadCrc & 0x8000) ? ((payloadCrc << 1) ^ 0x1021) : (payloadCrc << 1);
+    }
+
+    if( payload.size() != length || payloadCrc != crc || (address + length) > currentReadSize ) {
+        currentReadError = true;
+        sendReadRetry(); // corrupted block
+    } else if( address < currentReadBinaryPos ) {
+        startTimer(5000); // duplicate block, ignore
+    } else if( address > currentReadBinaryPos ) {
+        sendReadRetry(); // a block is missing
+    } else {
+        currentReadData.addArray(payload.getRawDataPointer(), payload.size());
+        currentReadBinaryPos += length;
+
+        // acknowledge block, this will also send the next block(s)
+        sendCommand(String::formatted(T("readack %X"), currentReadBinaryPos));
+
+        unsigned receivedSize = currentReadData.size();
+        uint32 currentReadFinished = Time::currentTimeMillis();
+        float downloadTime = (float)(currentReadFinished-currentReadStartTime) / 1000.0;
+        float dataRate = ((float)receivedSize/1000.0) / downloadTime;
+        if( receivedSize >= currentReadSize ) {
+            stopTimer(); // no response expected on the last acknowledge
+            String statusMessage(T("Download of ") + currentReadFileName +
+                                 T(" (") + String(receivedSize) + T(" bytes) completed in ") +
+                                 String::formatted(T("%2.1fs (%2.1f kb/s)"), downloadTime, dataRate));
+            currentReadInProgress = false;
+            currentReadBinary = false;
+
+            setStatus(statusMessage);
+            downloadFinished();
+        } else {
+            setStatus(String(T("Downloading ") + currentReadFileName + T(": ") +
+                             String(receivedSize) + T(" bytes received") +
+                             String::formatted(T(" (%d%%, %2.1f kb/s)"),
+                                               (int)(100.0*(float)receivedSize/(float)currentReadSize),
+                                               dataRate)));
+        }
+    }
+}
+
 //==============================================================================
 void MiosFileBrowser::receiveCommand(const String& command)
 {
@@ -973,7 +1068,13 @@ void MiosFileBrowser::receiveCommand(const String& command)
 
         ////////////////////////////////////////////////////////////////////
         case '?': {
-            statusMessage = String(T("Command not supported by MIOS32 application - please check if a firmware update is available!"));
+            if( currentReadBinary && !currentReadInProgress ) {
+                // binary read not supported by the application: fall back to text mode
+                currentReadBinary = false;
+                sendCommand(T("read ") + currentReadFileName);
+            } else {
+                statusMessage = String(T("Command not supported by MIOS32 application - please check if a firmware update is available!"));
+            }
         } break;
 
         ////////////////////////////////////////////////////////////////////
@@ -1026,11 +1127,20 @@ void MiosFileBrowser::receiveCommand(const String& command)
         case 'R': {
             if( command[1] == '!' ) {
                 statusMessage = String(T("SD Card not mounted!"));
+                currentReadBinary = false;
             } else if( command[1] == '-' ) {
                 statusMessage = String(T("Failed to access " + currentReadFileName + "!"));
+                currentReadInProgress = false;
+                currentReadBinary = false;
+            } else if( command[1] == '~' ) {
+                statusMessage = String(T("Read operation of " + currentReadFileName + " has been aborted by MIOS32 core!"));
+                currentReadInProgress = false;
+                currentReadBinary = false;
             } else {
                 currentReadSize = (command.substring(1)).getIntValue();
                 currentReadData.clear();
+                currentReadBinaryPos = 0;
+                currentReadBinaryRetryPos = 0;
                 if( currentReadSize ) {
                     statusMessage = String(T("Receiving ") + currentReadFileName + T(" with ") + String(currentReadSize) + T(" bytes."));
                     currentReadInProgress = true;
@@ -1042,6 +1152,7 @@ void MiosFileBrowser::receiveCommand(const String& command)
                     // ok, we accept this to edit zero-length files
                     // fake transfer:
                     currentReadInProgress = false;
+                    currentReadBinary = false;
                     currentReadData.clear();
                     setStatus(statusMessage);
                     downloadFinished();
@@ -1218,6 +1329,10 @@ void MiosFileBrowser::handleIncomingMidiMessage(const MidiMessage& message, uint
         data[7] == 0x41 ) {
             messageOffset = 8;
             messageReceived = true;
+    } else if( runningStatus == 0xf0 &&
+        SysexHelper::isValidMios32DebugMessage(data, size, -1) &&
+        data[7] == 0x42 ) {
+        receiveBinaryBlock(&data[8], size - 8);
     } else if( runningStatus == 0xf0 &&
         SysexHelper::isValidMios32Error(data, size, -1) &&
         data[7] == 0x10 ) {
@@ -102,6 +102,8 @@ public:
     //==============================================================================
     void sendCommand(const String& command);
     void receiveCommand(const String& command);
+    void receiveBinaryBlock(const uint8 *data, uint32 size);
+    void sendReadRetry(void);
 
     //==============================================================================
     bool uploadFileInProgress(void);
@@ -152,6 +154,9 @@ protected:
     unsigned     currentReadSize;
     Array<uint8> currentReadData;
     uint32       currentReadStartTime;
+    bool         currentReadBinary;
+    unsigned     currentReadBinaryPos;
+    unsigned     currentReadBinaryRetryPos;
 
     bool         currentWriteInProgress;
     bool         currentWriteError;